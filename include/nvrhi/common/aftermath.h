@@ -28,7 +28,10 @@
 #include <deque>
 #include <set>
 #include <unordered_map>
-#include <filesystem>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace nvrhi
 {
@@ -51,17 +54,57 @@ namespace nvrhi
         void popEvent();
 
         ResolvedMarker getEventString(size_t hash);
+        // Finds the event whose hash produces the given breadcrumb marker ID, see BreadcrumbEncoder::getMarkerID
+        ResolvedMarker getEventStringByBreadcrumbID(uint32_t markerID);
     private:
-        // using a filesystem path to track the event stack since that automatically inserts "/" separators
-        // and is easy to push/pop entries
-        std::filesystem::path m_EventStack;
-        
+        // The event stack holds a rolling hash per level, so that push and pop are O(1).
+        // Names and events live in fixed-capacity tables indexed by hash, so nothing is allocated
+        // once a name has been seen. The "/"-separated string is only built when a hash is resolved.
+        static constexpr uint16_t InvalidName = 0xffff;
+
+        struct StackEntry
+        {
+            size_t eventHash;
+            uint16_t nameIndex;
+        };
+
+        struct NameSlot
+        {
+            size_t hash = 0;
+            std::string name;
+            // Number of stack entries and recorded events using the slot; unreferenced slots may be reused
+            uint32_t references = 0;
+        };
+
+        // Events deeper than this are not recorded and can't be resolved
+        const static size_t MaxEventDepth = 32;
+
+        struct EventRecord
+        {
+            size_t hash = 0;
+            uint32_t depth = 0;
+            std::array<uint16_t, MaxEventDepth> nameIndices{};
+            std::string resolvedString;
+        };
+
+        std::vector<StackEntry> m_EventStack;
+
+        // Open-addressed by name hash; lookups compare the stored name, so colliding names get separate slots
+        const static size_t MaxNames = 1024;
+        const static size_t MaxNameProbes = 16;
+        std::array<NameSlot, MaxNames> m_Names;
+
         // Some apps have unique marker text on every frame (for example, by appending the frame number to the marker)
-        // In these cases, we want to cap the max number of strings stored to prevent memory usage from growing
+        // In these cases, we want to cap the max number of strings stored to prevent memory usage from growing.
+        // The events form a ring indexed by the event hash, a new event replaces whatever was in its slot.
         const static size_t MaxEventStrings = 128;
-        std::array<size_t, MaxEventStrings> m_EventHashes;
-        size_t m_OldestHashIndex;
-        std::unordered_map<size_t, std::string> m_EventStrings;
+        std::array<EventRecord, MaxEventStrings> m_Events;
+
+        uint16_t acquireName(std::string_view name, size_t nameHash);
+        void releaseName(uint16_t nameIndex);
+        bool isEventRecorded(const EventRecord& record, size_t hash) const;
+        void recordEvent(EventRecord& record, size_t hash);
+        const std::string& resolveEvent(EventRecord& record);
     };
 
     // AftermathCrashDumpHelper tracks all nvrhi::IDevice-level constructs that we need when generating a crash dump
@@ -81,6 +124,7 @@ namespace nvrhi
         void unRegisterShaderBinaryLookupCallback(void* client);
 
         ResolvedMarker ResolveMarker(size_t markerHash);
+        ResolvedMarker ResolveBreadcrumbMarker(uint32_t markerID);
         BinaryBlob findShaderBinary(uint64_t shaderHash, ShaderHashGeneratorFunction hashGenerator);
     private:
         std::set<AftermathMarkerTracker*> m_MarkerTrackers;
@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace nvrhi
+{
+    // GPU breadcrumbs record which command lists and marker scopes were executing when the device was lost.
+    // Each queue has a small host-visible buffer split into slots, and each command list takes a slot when it's opened.
+    // A slot is an array of 32-bit words:
+    //   [0] command list ID, written when the command list starts
+    //   [1] command list ID, written when the command list finishes
+    //   [2 + 2*depth] marker ID, written when a marker scope at that depth begins
+    //   [3 + 2*depth] marker ID, written when that scope ends
+    // A scope whose end word doesn't match its begin word was executing when the GPU stopped.
+    // Marker IDs are the truncated marker hashes from AftermathMarkerTracker, so the names are resolved
+    // through the same tables that are used for Aftermath crash dumps.
+
+    constexpr uint32_t c_BreadcrumbMaxDepth = 15;
+    constexpr uint32_t c_BreadcrumbSlotWords = 2 + 2 * c_BreadcrumbMaxDepth;
+    constexpr uint32_t c_BreadcrumbSlotSize = c_BreadcrumbSlotWords * sizeof(uint32_t);
+    constexpr uint32_t c_BreadcrumbSlotsPerQueue = 64;
+
+    // One write into the breadcrumb buffer, to be issued as a buffer fill or a buffer marker.
+    // The writes returned by one encoder call never overlap each other.
+    struct BreadcrumbWrite
+    {
+        uint32_t offset = 0; // in bytes
+        uint32_t size = 0; // in bytes, a multiple of 4
+        uint32_t value = 0;
+        // The write marks the completion of previous work and should be ordered after it, as far as the API allows
+        bool completion = false;
+    };
+
+    typedef static_vector<BreadcrumbWrite, 2> BreadcrumbWrites;
+
+    // Produces the buffer writes for one command list; there is no GPU API involved
+    class BreadcrumbEncoder
+    {
+    public:
+        NVRHI_API BreadcrumbWrites begin(uint32_t slot, uint32_t commandListID);
+        NVRHI_API BreadcrumbWrites end();
+        NVRHI_API BreadcrumbWrites pushMarker(size_t markerHash);
+        NVRHI_API BreadcrumbWrites popMarker();
+
+        [[nodiscard]] NVRHI_API static uint32_t getMarkerID(size_t markerHash);
+
+    private:
+        uint32_t m_SlotOffset = 0;
+        uint32_t m_CommandListID = 0;
+        uint32_t m_Depth = 0;
+        uint32_t m_MarkerIDs[c_BreadcrumbMaxDepth] = {};
+    };
+
+    struct BreadcrumbScope
+    {
+        uint32_t markerID = 0;
+        bool finished = false;
+    };
+
+    struct BreadcrumbCommandList
+    {
+        uint32_t commandListID = 0;
+        bool finished = false;
+        // Unfinished scopes from the outermost one, followed by the last finished scope at the next level, if any
+        std::vector<BreadcrumbScope> scopes;
+    };
+
+    // Decodes the contents of a breadcrumb buffer, skipping the slots that were never used
+    NVRHI_API void decodeBreadcrumbs(const uint32_t* data, size_t numWords, std::vector<BreadcrumbCommandList>& outCommandLists);
+
+    // Formats the decoded breadcrumbs, one line per command list and scope.
+    // resolveMarker returns the name of a marker ID, or an empty string if it's unknown.
+    NVRHI_API std::string formatBreadcrumbs(const std::vector<BreadcrumbCommandList>& commandLists,
+        const std::function<std::string(uint32_t)>& resolveMarker);
+} // namespace nvrhi
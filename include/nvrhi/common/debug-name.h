@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+#ifndef NVRHI_API
+#   define NVRHI_API
+#endif
+
+namespace nvrhi
+{
+    // A handle to an interned debug name string.
+    // All distinct names are stored once in a global, lock-free, append-only table and are never freed,
+    // so a DebugName is just a pointer: copying descriptors that contain debug names is trivially cheap,
+    // and comparing two names is a pointer comparison.
+    // DebugName can be assigned from const char*, std::string or std::string_view, and converts implicitly
+    // to const std::string&, so most code that used std::string debug names works unchanged.
+    // Note: because the table is never purged, avoid generating an unbounded number of unique names.
+    class DebugName
+    {
+    public:
+        DebugName() = default;
+        DebugName(const char* name) : m_String(name ? intern(name) : nullptr) { }
+        DebugName(const std::string& name) : m_String(intern(name)) { }
+        DebugName(std::string_view name) : m_String(intern(name)) { }
+
+        [[nodiscard]] const std::string& str() const { return m_String ? *m_String : getEmptyString(); }
+        [[nodiscard]] const char* c_str() const { return str().c_str(); }
+        [[nodiscard]] const char* data() const { return str().data(); }
+        [[nodiscard]] size_t size() const { return m_String ? m_String->size() : 0; }
+        [[nodiscard]] size_t length() const { return size(); }
+        [[nodiscard]] bool empty() const { return m_String == nullptr; }
+        [[nodiscard]] std::string::const_iterator begin() const { return str().begin(); }
+        [[nodiscard]] std::string::const_iterator end() const { return str().end(); }
+
+        operator const std::string&() const { return str(); }
+
+        // Names are interned, so equal names always have equal pointers.
+        bool operator==(const DebugName& other) const { return m_String == other.m_String; }
+        bool operator!=(const DebugName& other) const { return m_String != other.m_String; }
+
+        // Returns a stable pointer that uniquely identifies the name, nullptr for an empty name.
+        [[nodiscard]] const void* getID() const { return m_String; }
+
+    private:
+        const std::string* m_String = nullptr;
+
+        // Returns the table entry for the string, or nullptr if the string is empty.
+        NVRHI_API static const std::string* intern(std::string_view name);
+        NVRHI_API static const std::string& getEmptyString();
+    };
+
+    inline std::string operator+(const DebugName& a, const std::string& b) { return a.str() + b; }
+    inline std::string operator+(const std::string& a, const DebugName& b) { return a + b.str(); }
+    inline std::string operator+(const DebugName& a, const char* b) { return a.str() + b; }
+    inline std::string operator+(const char* a, const DebugName& b) { return a + b.str(); }
+
+    template<typename Traits>
+    std::basic_ostream<char, Traits>& operator<<(std::basic_ostream<char, Traits>& os, const DebugName& name)
+    {
+        return os << name.str();
+    }
+}
+
+namespace std
+{
+    template<> struct hash<nvrhi::DebugName>
+    {
+        std::size_t operator()(const nvrhi::DebugName& name) const noexcept
+        {
+            return std::hash<const void*>()(name.getID());
+        }
+    };
+}
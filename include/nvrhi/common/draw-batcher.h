@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <vector>
+
+namespace nvrhi
+{
+    struct DrawBatcherDesc
+    {
+        // Number of draws that fit into one indirect argument buffer; more buffers are created when one fills up.
+        // Also the largest batch that is issued as one indirect draw.
+        uint32_t drawsPerBuffer = 4096;
+
+        // Batches with fewer draws than this are issued as regular draw calls, which avoids the argument upload
+        uint32_t minIndirectBatchSize = 2;
+
+        DebugName debugName = "DrawBatcher";
+
+        DrawBatcherDesc& setDrawsPerBuffer(uint32_t value) { drawsPerBuffer = value; return *this; }
+        DrawBatcherDesc& setMinIndirectBatchSize(uint32_t value) { minIndirectBatchSize = value; return *this; }
+        DrawBatcherDesc& setDebugName(const DebugName& value) { debugName = value; return *this; }
+    };
+
+    struct DrawBatcherStatistics
+    {
+        uint64_t draws = 0;         // calls to draw and drawIndexed
+        uint64_t indirectCalls = 0; // drawIndirect and drawIndexedIndirect calls issued for batches
+        uint64_t directCalls = 0;   // draw and drawIndexed calls issued for batches below minIndirectBatchSize,
+                                    // or for batches whose argument buffer could not be created
+    };
+
+    // Accumulates draws that share a GraphicsState and submits each run of them as one indirect draw.
+    //
+    // Call begin with an open command list, then setGraphicsState and draw / drawIndexed as with ICommandList.
+    // The pending batch is flushed when the state changes, when switching between indexed and non-indexed draws,
+    // when an indirect argument buffer fills up, and in flush / end. The indirectParams field of the state is
+    // replaced by the batcher's argument buffer.
+    //
+    // Flushing writes the arguments into the command list's upload memory with allocateIndirectArguments and
+    // then sets the graphics state, so batches don't interrupt the render pass. On backends that don't support
+    // that, the arguments go into the batcher's own buffers with writeBuffer instead; those buffers are reused in
+    // every begin/end pair, which relies on command lists that use the same batcher being executed on one queue.
+    // If such a buffer cannot be created, the batch is issued as regular draw calls.
+    // On devices without Feature::MultiDrawIndirect, a batch still uploads its arguments together but is issued
+    // as one indirect call per draw.
+    // Anything that is recorded into the command list directly while a batch is pending, such as
+    // setPushConstants, must be preceded by flush.
+    class DrawBatcher
+    {
+    public:
+        NVRHI_API DrawBatcher(IDevice* device, const DrawBatcherDesc& desc = DrawBatcherDesc());
+
+        DrawBatcher(const DrawBatcher&) = delete;
+        DrawBatcher& operator=(const DrawBatcher&) = delete;
+
+        NVRHI_API void begin(ICommandList* commandList);
+        NVRHI_API void end();
+
+        NVRHI_API void setGraphicsState(const GraphicsState& state);
+        NVRHI_API void draw(const DrawArguments& args);
+        NVRHI_API void drawIndexed(const DrawArguments& args);
+        NVRHI_API void flush();
+
+        [[nodiscard]] const DrawBatcherStatistics& getStatistics() const { return m_Statistics; }
+        void resetStatistics() { m_Statistics = DrawBatcherStatistics(); }
+
+    private:
+        enum class BatchType : uint8_t
+        {
+            None,
+            Draw,
+            DrawIndexed
+        };
+
+        DeviceHandle m_Device;
+        DrawBatcherDesc m_Desc;
+        bool m_MultiDrawIndirect = false;
+        bool m_ArgumentBufferFailureReported = false;
+        CommandListHandle m_CommandList;
+
+        std::vector<BufferHandle> m_ArgumentBuffers;
+        uint32_t m_CurrentBuffer = 0;
+        uint32_t m_CurrentBufferOffset = 0; // in bytes
+
+        GraphicsState m_State;
+        bool m_StateValid = false;
+
+        BatchType m_BatchType = BatchType::None;
+        std::vector<DrawArguments> m_PendingDraws;
+        std::vector<uint8_t> m_ArgumentData;
+
+        DrawBatcherStatistics m_Statistics;
+
+        void addDraw(BatchType type, const DrawArguments& args);
+        IBuffer* allocateArguments(uint32_t byteSize, uint32_t& outOffset);
+        void submitDirect(uint32_t firstDraw, uint32_t drawCount);
+        void submitIndirect(uint32_t firstDraw, uint32_t drawCount);
+    };
+}
@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    struct FrameManagerDesc
+    {
+        // beginFrame blocks when this many frames are still executing on the GPU
+        uint32_t maxFramesInFlight = 2;
+
+        // Queues that the application submits per-frame work to; the end of each frame is marked on all of them.
+        // The graphics queue is listed by default. Queues that are listed more than once are only marked once.
+        static_vector<CommandQueue, size_t(CommandQueue::Count)> queues = { CommandQueue::Graphics };
+
+        // Call IDevice::runGarbageCollection whenever at least one frame has finished on the GPU
+        bool runGarbageCollection = true;
+
+        FrameManagerDesc& setMaxFramesInFlight(uint32_t value) { maxFramesInFlight = value; return *this; }
+        FrameManagerDesc& addQueue(CommandQueue value)
+        {
+            if (std::find(queues.begin(), queues.end(), value) == queues.end())
+                queues.push_back(value);
+            return *this;
+        }
+        FrameManagerDesc& setRunGarbageCollection(bool value) { runGarbageCollection = value; return *this; }
+    };
+
+    struct FrameStatistics
+    {
+        uint64_t framesStarted = 0;
+        uint64_t framesCompleted = 0;
+
+        // Time spent in beginFrame waiting for the GPU to catch up. High values mean the app is GPU-bound.
+        float lastCpuWaitMs = 0.f;
+        float averageCpuWaitMs = 0.f; // exponential moving average
+        double totalCpuWaitMs = 0.0;
+
+        // Estimated GPU starvation: time from the CPU first observing that the GPU had finished all frames
+        // to the end of the next frame (endFrame). Completion is only observed in beginFrame and endFrame,
+        // so this is approximate. High values mean the app is CPU-bound.
+        float lastGpuIdleMs = 0.f;
+        float averageGpuIdleMs = 0.f;
+        double totalGpuIdleMs = 0.0;
+    };
+
+    // Limits the number of frames in flight and runs per-frame maintenance at frame boundaries.
+    //
+    // Call beginFrame before recording a frame and endFrame after submitting all of its command lists.
+    // endFrame marks the last submission on each of the queues in FrameManagerDesc::queues, and beginFrame
+    // waits for the oldest frame only when more than maxFramesInFlight frames would be in flight.
+    // Resources and callbacks passed to deferRelease and deferCallback during a frame are released or called
+    // once that frame has finished on the GPU. The event queries used to track frames are recycled.
+    // beginFrame and endFrame must be called from the same thread; deferRelease and deferCallback may be called
+    // from any thread.
+    class FrameManager
+    {
+    public:
+        NVRHI_API FrameManager(IDevice* device, const FrameManagerDesc& desc = FrameManagerDesc());
+
+        // Waits for all frames in flight and runs their deferred work
+        NVRHI_API ~FrameManager();
+
+        FrameManager(const FrameManager&) = delete;
+        FrameManager& operator=(const FrameManager&) = delete;
+
+        NVRHI_API void beginFrame();
+        NVRHI_API void endFrame();
+
+        // Keeps the resource alive until the current frame has finished on the GPU
+        NVRHI_API void deferRelease(IResource* resource);
+
+        // Calls the function on the thread that calls beginFrame, after the current frame has finished on the GPU
+        NVRHI_API void deferCallback(std::function<void()> callback);
+
+        // Blocks until all frames have finished and runs their deferred work
+        NVRHI_API void waitForAllFrames();
+
+        [[nodiscard]] uint64_t getFrameIndex() const { return m_Statistics.framesStarted; }
+        [[nodiscard]] uint32_t getFramesInFlight() const { return uint32_t(m_PendingFrames.size()); }
+        [[nodiscard]] const FrameStatistics& getStatistics() const { return m_Statistics; }
+        NVRHI_API void resetStatistics();
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Frame
+        {
+            static_vector<EventQueryHandle, size_t(CommandQueue::Count)> queries;
+            std::vector<RefCountPtr<IResource>> releases;
+            std::vector<std::function<void()>> callbacks;
+        };
+
+        DeviceHandle m_Device;
+        FrameManagerDesc m_Desc;
+
+        std::deque<Frame> m_PendingFrames;
+        std::vector<EventQueryHandle> m_FreeQueries;
+
+        std::mutex m_DeferredMutex;
+        Frame m_CurrentFrame;
+        bool m_InFrame = false;
+
+        FrameStatistics m_Statistics;
+        Clock::time_point m_GpuIdleSince;
+        bool m_GpuIdle = false;
+
+        [[nodiscard]] bool isFrameCompleted(const Frame& frame) const;
+        void waitForFrame(const Frame& frame) const;
+        void retireFrame(Frame& frame);
+        uint32_t retireCompletedFrames();
+        void updateGpuIdleState();
+    };
+}
@@ -0,0 +1,232 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <functional>
+#include <vector>
+
+namespace nvrhi
+{
+    // Per-allocation input of planHeapDefragmentation: a placed resource occupying [offset, offset + size) in a heap.
+    struct DefragmentationAllocation
+    {
+        uint32_t heap = 0; // index into the heap capacity array
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint64_t alignment = 1;
+
+        // Immovable allocations stay in place and only block the space they occupy
+        bool movable = true;
+    };
+
+    struct DefragmentationMove
+    {
+        uint32_t allocation = 0; // index into the allocation array
+        uint32_t pass = 0;
+        uint32_t heap = 0;
+        uint64_t offset = 0;
+    };
+
+    // The defragmentation policy, separate from the defragmenter so that it can be tested without a device.
+    //
+    // Heaps are ranked by the number of bytes they hold, fullest first, ties going to the lower index. Allocations
+    // are moved to the first free range, in rank order and then by offset, that is better than their current
+    // placement, which empties the least used heaps and compacts the others towards offset 0. The allocations in
+    // the worst placements are moved first.
+    //
+    // The moves are grouped into passes. The destination of a move never overlaps memory that is in use at the
+    // start of its pass, including the source ranges of the same pass, so the moves of a pass can be copied in
+    // any order. The sources are released at the end of the pass. Planning stops after maxPasses passes or when
+    // no allocation can be moved any more. The output is sorted by pass and is a pure function of the inputs.
+    NVRHI_API void planHeapDefragmentation(const std::vector<uint64_t>& heapCapacities,
+        const std::vector<DefragmentationAllocation>& allocations, uint32_t maxPasses,
+        std::vector<DefragmentationMove>& outMoves);
+
+    typedef uint32_t DefragResourceID;
+    static constexpr DefragResourceID c_InvalidDefragResource = ~0u;
+
+    // Passed to the relocation callback once the copy into the new placement has been submitted.
+    // Exactly one of the buffer or texture pairs is set.
+    struct RelocatedResource
+    {
+        DefragResourceID id = c_InvalidDefragResource;
+        BufferHandle oldBuffer;
+        BufferHandle newBuffer;
+        TextureHandle oldTexture;
+        TextureHandle newTexture;
+        IHeap* heap = nullptr;
+        uint64_t offset = 0;
+    };
+
+    struct HeapDefragmenterDesc
+    {
+        // Copy limit for one call to update. A single resource larger than this is still moved in one update.
+        uint64_t copyBytesPerUpdate = 64ull * 1024 * 1024;
+
+        // Queue for the relocation copies
+        CommandQueue queue = CommandQueue::Graphics;
+
+        uint32_t maxPasses = 8;
+
+        // Called for every relocated resource, from update. The application must replace the old handle with the
+        // new one everywhere, including binding sets and framebuffers that reference it, before it records more
+        // work. The old resource keeps aliasing its original range until the end of the pass and may be released.
+        std::function<void(const RelocatedResource& relocation)> onResourceRelocated;
+
+        HeapDefragmenterDesc& setCopyBytesPerUpdate(uint64_t value) { copyBytesPerUpdate = value; return *this; }
+        HeapDefragmenterDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        HeapDefragmenterDesc& setMaxPasses(uint32_t value) { maxPasses = value; return *this; }
+    };
+
+    struct HeapDefragmenterStatistics
+    {
+        uint64_t copiedBytes = 0; // in the last update
+        uint32_t relocatedResources = 0; // in the last update
+        uint32_t pendingMoves = 0;
+        uint32_t currentPass = 0;
+    };
+
+    // Compacts placed buffers and textures over several frames, so that fragmented heaps can be released.
+    //
+    // The application registers its heaps and the resources it placed in them. beginDefragmentation plans the
+    // moves with planHeapDefragmentation, and each update copies the moves of the current pass within the
+    // byte budget. Resources cannot be rebound in place, so a move creates a new virtual resource with the same
+    // desc, binds it at the destination and copies the contents into it on the defragmenter's command list. The
+    // other queues wait for the copies, then update replaces the registered handles and calls onResourceRelocated,
+    // so all work submitted after update sees the copied contents. A pass is finished once the work submitted
+    // before the last relocation has completed on every queue, at which point the old ranges become free for the
+    // next pass.
+    //
+    // The copies are only correct if the moved resources are quiescent when update is called: the application
+    // must not have open or unsubmitted command lists that reference registered resources, and no work in flight
+    // on a queue other than HeapDefragmenterDesc::queue may write them. Resources that do not meet this, such as
+    // ones written by async compute, must be pinned with setResourceMovable. Multisampled textures cannot be
+    // copied and are never moved.
+    //
+    // Resources must be created with isVirtual and keepInitialState, so that the copies can transition them
+    // and return them to the state the application expects. While isDefragmenting returns true, the application
+    // must not place new resources in the registered heaps. The defragmenter is not thread safe.
+    class HeapDefragmenter
+    {
+    public:
+        NVRHI_API HeapDefragmenter(IDevice* device, const HeapDefragmenterDesc& desc = HeapDefragmenterDesc());
+
+        HeapDefragmenter(const HeapDefragmenter&) = delete;
+        HeapDefragmenter& operator=(const HeapDefragmenter&) = delete;
+
+        // Heaps are added automatically when resources are registered in them
+        NVRHI_API void addHeap(IHeap* heap);
+        // Fails if resources are still registered in the heap
+        NVRHI_API bool removeHeap(IHeap* heap);
+        [[nodiscard]] NVRHI_API bool isHeapEmpty(IHeap* heap) const;
+
+        NVRHI_API DefragResourceID addBuffer(IBuffer* buffer, IHeap* heap, uint64_t offset);
+        NVRHI_API DefragResourceID addTexture(ITexture* texture, IHeap* heap, uint64_t offset);
+        NVRHI_API void removeResource(DefragResourceID resource);
+
+        // Pinned resources stay in place and only block the space they occupy. Pinning a resource while
+        // defragmenting cancels its pending move and the passes after the current one.
+        NVRHI_API void setResourceMovable(DefragResourceID resource, bool movable);
+
+        // Return the current handles, which change when resources are relocated
+        [[nodiscard]] NVRHI_API IBuffer* getBuffer(DefragResourceID resource) const;
+        [[nodiscard]] NVRHI_API ITexture* getTexture(DefragResourceID resource) const;
+
+        NVRHI_API void beginDefragmentation();
+        [[nodiscard]] bool isDefragmenting() const { return m_Defragmenting; }
+
+        NVRHI_API void update();
+
+        [[nodiscard]] const HeapDefragmenterStatistics& getStatistics() const { return m_Statistics; }
+
+    private:
+        struct Slot
+        {
+            BufferHandle buffer;
+            TextureHandle texture;
+            uint32_t heap = 0;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint64_t alignment = 1;
+            uint32_t generation = 0;
+            bool movable = true;
+            bool active = false;
+        };
+
+        struct Move
+        {
+            DefragResourceID resource;
+            uint32_t generation;
+            uint32_t pass;
+            uint32_t heap;
+            uint64_t offset;
+        };
+
+        struct CopiedMove
+        {
+            DefragResourceID resource;
+            uint32_t generation;
+            BufferHandle buffer;
+            TextureHandle texture;
+            uint32_t heap;
+            uint64_t offset;
+        };
+
+        DeviceHandle m_Device;
+        HeapDefragmenterDesc m_Desc;
+        CommandListHandle m_CommandList;
+
+        std::vector<HeapHandle> m_Heaps;
+        std::vector<Slot> m_Slots;
+        std::vector<DefragResourceID> m_FreeSlots;
+
+        std::vector<Move> m_Moves;
+        size_t m_NextMove = 0;
+        bool m_Defragmenting = false;
+
+        // Copies recorded by the current update
+        std::vector<CopiedMove> m_CopiedMoves;
+
+        // Work that may still use the sources of the current pass, one query per queue
+        struct RetireQuery
+        {
+            CommandQueue queue;
+            EventQueryHandle query;
+        };
+
+        std::vector<RetireQuery> m_RetireQueries;
+        bool m_Retiring = false;
+
+        HeapDefragmenterStatistics m_Statistics;
+
+        [[nodiscard]] bool isValid(DefragResourceID resource) const;
+        [[nodiscard]] uint32_t findHeap(IHeap* heap) const;
+        DefragResourceID addResource(IBuffer* buffer, ITexture* texture, IHeap* heap, uint64_t offset, const MemoryRequirements& memReq, bool movable);
+        void warning(const char* message) const;
+        void relocateCopiedMoves();
+        bool recordMove(const Move& move);
+        void cancelLaterPasses(uint32_t pass);
+    };
+}
@@ -0,0 +1,161 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    struct QueueWait
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t submissionID = 0;
+    };
+
+    struct QueueSchedulerNode
+    {
+        CommandListHandle commandList;
+        CommandQueue queue = CommandQueue::Graphics;
+
+        // Earlier nodes of the same execute call on other queues that this node has a hazard with
+        std::vector<uint32_t> dependencies;
+
+        // Waits that were inserted on this node's queue before its batch, after removing redundant ones.
+        // Dependencies on work submitted by earlier execute calls only show up here.
+        std::vector<QueueWait> waits;
+
+        uint32_t batch = 0;
+        uint64_t submissionID = 0;
+    };
+
+    struct QueueSchedulerBatch
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        std::vector<uint32_t> nodes;
+        uint64_t submissionID = 0;
+    };
+
+    // Submits command lists to the graphics, compute and copy queues with the minimal set of cross-queue waits.
+    //
+    // Each command list is added with the resources it reads and writes, in the order in which its work would
+    // execute on a single queue. execute walks that order, finds read-after-write, write-after-read and
+    // write-after-write hazards between queues, and places a queueWaitForCommandList before the first batch
+    // that needs it. A wait is skipped when the queue has already waited for the same or a later submission on the
+    // other queue. Consecutive command lists on one queue are submitted in one executeCommandLists call, and
+    // a batch is only split where a wait has to be inserted or where another queue needs its results.
+    //
+    // Resources are identified by their IResource pointers, like the state tracker does, and tracking is per whole
+    // resource. Hazards with submissions from earlier execute calls are tracked as well. The scheduler holds a
+    // reference to every resource it tracks, so a released resource's address cannot be reused by a new one while
+    // the old accesses are remembered. Accesses are forgotten once an event query set after their submission has
+    // signalled, which execute checks every time, or when reset is called.
+    // Resource state transitions are still recorded by the command lists themselves.
+    class QueueScheduler
+    {
+    public:
+        NVRHI_API explicit QueueScheduler(IDevice* device);
+
+        // Returns the node index of the command list in the graph of the next execute call
+        NVRHI_API uint32_t addCommandList(ICommandList* commandList,
+            const std::vector<IResource*>& reads, const std::vector<IResource*>& writes);
+
+        // Submits all added command lists. The graph that was built stays available until the next addCommandList
+        // or execute call; calling execute with no command lists added submits nothing and leaves an empty graph.
+        NVRHI_API void execute();
+
+        // Forgets the resource accesses from earlier execute calls
+        NVRHI_API void reset();
+
+        [[nodiscard]] const std::vector<QueueSchedulerNode>& getNodes() const { return m_Nodes; }
+        [[nodiscard]] const std::vector<QueueSchedulerBatch>& getBatches() const { return m_Batches; }
+        [[nodiscard]] size_t getNumTrackedResources() const { return m_Resources.size(); }
+
+        // Returns the graph of the last execute call in Graphviz DOT format, with one cluster per queue
+        [[nodiscard]] NVRHI_API std::string getGraphviz() const;
+
+    private:
+        static constexpr uint32_t c_NoNode = ~0u;
+        static constexpr size_t c_NumQueues = size_t(CommandQueue::Count);
+
+        // Either a node of the current execute call or a submission from an earlier one
+        struct Access
+        {
+            uint32_t node = c_NoNode;
+            uint64_t submissionID = 0;
+
+            [[nodiscard]] bool valid() const { return node != c_NoNode || submissionID != 0; }
+        };
+
+        struct ResourceAccesses
+        {
+            ResourceHandle resource;
+            CommandQueue writeQueue = CommandQueue::Graphics;
+            Access write;
+            std::array<Access, c_NumQueues> reads; // since the last write
+        };
+
+        struct PendingNode
+        {
+            std::vector<IResource*> reads;
+            std::vector<IResource*> writes;
+        };
+
+        DeviceHandle m_Device;
+
+        std::vector<QueueSchedulerNode> m_Nodes;
+        std::vector<PendingNode> m_Pending;
+        std::vector<QueueSchedulerBatch> m_Batches;
+        bool m_Executed = false;
+
+        std::unordered_map<IResource*, ResourceAccesses> m_Resources;
+
+        // m_Known[q][p] is the last submission on queue p that queue q has waited for
+        std::array<std::array<uint64_t, c_NumQueues>, c_NumQueues> m_Known{};
+
+        std::array<std::vector<uint32_t>, c_NumQueues> m_OpenBatches;
+
+        // Event queries set after the last submission of each execute call, to find out when accesses can be dropped
+        struct SubmissionQuery
+        {
+            EventQueryHandle query;
+            CommandQueue queue = CommandQueue::Graphics;
+            uint64_t submissionID = 0;
+        };
+
+        std::vector<SubmissionQuery> m_SubmissionQueries;
+        std::vector<EventQueryHandle> m_FreeQueries;
+        std::array<uint64_t, c_NumQueues> m_Completed{};
+
+        void clearGraph();
+        void pruneCompletedAccesses();
+        ResourceAccesses& getAccesses(IResource* resource);
+        void flushQueue(CommandQueue queue);
+        uint64_t resolveAccess(CommandQueue queue, const Access& access);
+        void addHazard(uint32_t node, CommandQueue queue, const Access& access, std::array<uint64_t, c_NumQueues>& required);
+    };
+}
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Shader blobs produced by the shader compiler (tools/shaderCompiler) contain multiple permutations of a shader.
+    // The blob starts with the "NVSP" signature, followed by a sequence of entries, each consisting of
+    // a ShaderBlobEntry header, the permutation string (permutationSize bytes), and the binary (dataSize bytes).
+    // The permutation string is the list of defines used to compile the binary, each followed by a space: "A=1 B=0 "
+
+    struct ShaderConstant
+    {
+        const char* name;
+        const char* value;
+    };
+
+    struct ShaderBlobEntry
+    {
+        uint32_t permutationSize;
+        uint32_t dataSize;
+    };
+
+    // A non-owning reference to one permutation inside a blob
+    struct ShaderBinaryView
+    {
+        std::string_view permutation;
+        const void* data = nullptr;
+        size_t size = 0;
+    };
+
+    // Finds the binary for the permutation defined by 'constants'.
+    // If the blob is not a permutation blob and no constants are given, the whole blob is returned.
+    NVRHI_API bool findPermutationInBlob(const void* blob, size_t blobSize, const ShaderConstant* constants, uint32_t numConstants, ShaderBinaryView& outView);
+    NVRHI_API bool findPermutationInBlob(const void* blob, size_t blobSize, const ShaderConstant* constants, uint32_t numConstants, const void** pBinary, size_t* pSize);
+    NVRHI_API void enumeratePermutationsInBlob(const void* blob, size_t blobSize, std::vector<ShaderBinaryView>& permutations);
+    NVRHI_API ShaderHandle createShaderPermutation(IDevice* device, const ShaderDesc& desc, const void* blob, size_t blobSize,
+        const ShaderConstant* constants, uint32_t numConstants);
+
+    // A shader blob file mapped into memory.
+    // Permutations are handed out as views into the mapping, so nothing is read from disk until a permutation is used,
+    // except for the entry headers which are read once to build the permutation index.
+    // The package must stay open while the views are in use; shaders created from it don't reference the package.
+    class ShaderPackage
+    {
+    public:
+        ShaderPackage() = default;
+        NVRHI_API ~ShaderPackage();
+
+        ShaderPackage(const ShaderPackage&) = delete;
+        ShaderPackage& operator=(const ShaderPackage&) = delete;
+
+        // Maps the file and indexes its permutations. Returns false if the file cannot be opened or mapped.
+        NVRHI_API bool open(const char* fileName);
+        NVRHI_API void close();
+
+        [[nodiscard]] bool isOpen() const { return m_Data != nullptr; }
+        [[nodiscard]] const void* getData() const { return m_Data; }
+        [[nodiscard]] size_t getSize() const { return m_Size; }
+        [[nodiscard]] const std::vector<ShaderBinaryView>& getPermutations() const { return m_Permutations; }
+
+        NVRHI_API bool findPermutation(const ShaderConstant* constants, uint32_t numConstants, ShaderBinaryView& outView) const;
+
+        // Hint to the OS that the whole package or one permutation will be used soon, so that its pages are read ahead
+        NVRHI_API void prefetch() const;
+        NVRHI_API void prefetch(const ShaderBinaryView& view) const;
+
+        // Creates the shader straight from the mapped memory. Returns null if the permutation is not found.
+        NVRHI_API ShaderHandle createShader(IDevice* device, const ShaderDesc& desc, const ShaderConstant* constants, uint32_t numConstants) const;
+
+    private:
+        const void* m_Data = nullptr;
+        size_t m_Size = 0;
+        std::vector<ShaderBinaryView> m_Permutations;
+        std::unordered_map<std::string_view, size_t> m_PermutationIndex;
+    };
+} // namespace nvrhi
@@ -0,0 +1,203 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/shader-blob.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Reports files that were created or modified in a set of watched directories.
+    // Uses inotify on Linux; elsewhere, or if inotify cannot be initialized, the directories are scanned
+    // and the modification times are compared, no more often than the polling interval.
+    // Subdirectories that exist when a directory is added are watched too.
+    class FileWatcher
+    {
+    public:
+        NVRHI_API FileWatcher();
+        NVRHI_API ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        NVRHI_API bool addDirectory(const std::filesystem::path& path);
+
+        // Appends the absolute paths of the files changed since the previous call, each path once
+        NVRHI_API void getChangedFiles(std::vector<std::filesystem::path>& outFiles);
+
+        void setPollingInterval(std::chrono::milliseconds value) { m_PollingInterval = value; }
+        [[nodiscard]] bool isUsingNotifications() const { return m_NotifyDescriptor >= 0; }
+
+    private:
+        std::vector<std::filesystem::path> m_Directories;
+        std::unordered_map<int, std::filesystem::path> m_WatchedPaths; // inotify watch descriptor -> directory
+        std::unordered_map<std::string, std::filesystem::file_time_type> m_FileTimes;
+        int m_NotifyDescriptor = -1;
+        std::chrono::milliseconds m_PollingInterval = std::chrono::milliseconds(500);
+        std::chrono::steady_clock::time_point m_LastPollTime;
+
+        void addWatch(const std::filesystem::path& path);
+        void readNotifications(std::vector<std::filesystem::path>& outFiles);
+        void scanDirectory(const std::filesystem::path& path, std::vector<std::filesystem::path>* outFiles);
+    };
+
+    // Holds the current version of a pipeline managed by ShaderReloader.
+    // The pipeline is only replaced inside ShaderReloader::update, so it's safe to read between update calls.
+    template<typename PipelineHandle>
+    struct ReloadablePipeline
+    {
+        PipelineHandle pipeline;
+        uint32_t version = 0; // incremented every time the pipeline is replaced
+    };
+
+    typedef std::shared_ptr<ReloadablePipeline<GraphicsPipelineHandle>> ReloadableGraphicsPipelineHandle;
+    typedef std::shared_ptr<ReloadablePipeline<ComputePipelineHandle>> ReloadableComputePipelineHandle;
+    typedef std::shared_ptr<ReloadablePipeline<MeshletPipelineHandle>> ReloadableMeshletPipelineHandle;
+
+    // Reloads shaders when their binaries change on disk and rebuilds the pipelines that use them.
+    //
+    // Shaders are loaded through loadShader, which remembers the file, desc and permutation, and pipelines are
+    // registered with the desc they were created from. When a file changes and the bytes of a loaded permutation
+    // hash differently from the last load, a new shader object is created for that permutation, and every
+    // pipeline referencing the old one is rebuilt with the regular create*Pipeline calls, as jobs on the device's
+    // task scheduler (IDevice::getTaskScheduler), or on the calling thread if the device has none.
+    // Other permutations in the same file are left alone. Finished pipelines are swapped into their
+    // ReloadablePipeline slots together in update(), which should be called once per frame, at a frame boundary.
+    // If a shader or pipeline fails to build, the previous version is kept and a warning is reported
+    // through the device message callback.
+    // Shaders that are no longer referenced by the application or by a tracked pipeline stop being watched.
+    // Ray tracing pipelines are not tracked.
+    class ShaderReloader
+    {
+    public:
+        NVRHI_API explicit ShaderReloader(IDevice* device);
+        NVRHI_API ~ShaderReloader();
+
+        ShaderReloader(const ShaderReloader&) = delete;
+        ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+        NVRHI_API bool watchDirectory(const std::filesystem::path& path);
+
+        // Loads a shader binary or a permutation from a shader blob. Returns null if the file or permutation is missing.
+        // The returned object is the initial version; pipelines created from it pick up later versions automatically.
+        NVRHI_API ShaderHandle loadShader(const std::filesystem::path& fileName, const ShaderDesc& desc,
+            const ShaderConstant* constants = nullptr, uint32_t numConstants = 0);
+
+        // Creates a pipeline and tracks it for rebuilding. Returns null if the initial creation fails.
+        NVRHI_API ReloadableGraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb);
+        NVRHI_API ReloadableComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc);
+        NVRHI_API ReloadableMeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb);
+
+        // Picks up changed files, schedules the rebuilds, and publishes the pipelines finished since the last call.
+        // Returns the number of pipelines that were replaced.
+        NVRHI_API uint32_t update();
+
+        // Blocks until all scheduled rebuilds are finished; they are published by the next update()
+        NVRHI_API void waitForRebuilds();
+
+        [[nodiscard]] FileWatcher& getFileWatcher() { return m_Watcher; }
+
+        // Returns the number of shader -> pipeline links being tracked, including ones for pipelines released since the last update()
+        [[nodiscard]] NVRHI_API size_t getNumDependencies() const;
+
+        // Returns the number of shaders being watched, including ones released since the last update()
+        [[nodiscard]] size_t getNumShaders() const { return m_Shaders.size(); }
+
+    private:
+        struct ShaderEntry
+        {
+            std::string fileName;
+            ShaderDesc desc;
+            std::vector<std::string> constantNames;
+            std::vector<std::string> constantValues;
+            // Hash of the permutation's bytes, not of the whole file, so that rebuilding one permutation of a blob
+            // doesn't recreate the others
+            uint64_t contentHash[2] = {};
+            ShaderHandle shader;
+        };
+
+        struct PipelineEntry
+        {
+            // Only one of the descs is used, depending on which slot is set
+            GraphicsPipelineDesc graphicsDesc;
+            ComputePipelineDesc computeDesc;
+            MeshletPipelineDesc meshletDesc;
+            FramebufferHandle framebuffer;
+
+            ReloadableGraphicsPipelineHandle graphicsSlot;
+            ReloadableComputePipelineHandle computeSlot;
+            ReloadableMeshletPipelineHandle meshletSlot;
+
+            // Generation of the last scheduled rebuild, so that an older rebuild that finishes late doesn't win
+            uint32_t scheduledGeneration = 0;
+            uint32_t publishedGeneration = 0;
+        };
+
+        struct CompletedRebuild
+        {
+            uint64_t job = 0;
+            std::shared_ptr<PipelineEntry> entry;
+            uint32_t generation = 0;
+            GraphicsPipelineHandle graphicsPipeline;
+            ComputePipelineHandle computePipeline;
+            MeshletPipelineHandle meshletPipeline;
+        };
+
+        DeviceHandle m_Device;
+        FileWatcher m_Watcher;
+
+        std::vector<std::unique_ptr<ShaderEntry>> m_Shaders;
+        std::unordered_multimap<std::string, ShaderEntry*> m_ShadersByFile;
+        std::vector<std::shared_ptr<PipelineEntry>> m_Pipelines;
+        // Shader object -> pipelines created from it
+        std::unordered_map<IShader*, std::vector<std::weak_ptr<PipelineEntry>>> m_Dependents;
+
+        // Rebuild jobs that have not been waited for yet, by job number. Every task is waited for exactly once,
+        // either when its result is picked up by update or in waitForRebuilds.
+        ITaskScheduler* m_TaskScheduler = nullptr;
+        std::unordered_map<uint64_t, ITaskScheduler::TaskID> m_Tasks;
+        uint64_t m_NextJob = 1;
+
+        std::mutex m_CompletedMutex;
+        std::vector<CompletedRebuild> m_Completed;
+
+        template<typename BuildFunc>
+        void submitRebuild(const std::shared_ptr<PipelineEntry>& entry, uint32_t generation, BuildFunc&& build);
+        bool reloadShader(ShaderEntry& entry, std::unordered_map<IShader*, ShaderHandle>& replacements);
+        void addDependency(IShader* shader, const std::shared_ptr<PipelineEntry>& entry);
+        void pruneDependents();
+        void pruneShaders();
+        static bool isReleased(const PipelineEntry& entry);
+        static void removeReleasedEntries(std::vector<std::weak_ptr<PipelineEntry>>& entries);
+        void scheduleRebuild(const std::shared_ptr<PipelineEntry>& entry);
+        void warning(const std::string& message);
+    };
+} // namespace nvrhi
@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define NVRHI_WITH_COROUTINES 1
+#else
+#define NVRHI_WITH_COROUTINES 0
+#endif
+
+namespace nvrhi
+{
+    // An awaitable handle to a command list submission that becomes ready when the GPU has finished executing it.
+    // Futures are created by the device (see vulkan::IDevice::getSubmissionFuture) and can be copied freely.
+    // Continuations registered with 'then' and resumed coroutines run on the device's completion thread,
+    // or on the calling thread if the submission has already completed.
+    // A future whose submission can never complete, e.g. after a device loss, becomes ready in the failed state.
+    class SubmissionFuture
+    {
+    public:
+        SubmissionFuture() = default;
+
+        SubmissionFuture(CommandQueue queue, uint64_t submissionID)
+            : m_State(std::make_shared<State>())
+            , m_Queue(queue)
+            , m_SubmissionID(submissionID)
+        { }
+
+        [[nodiscard]] bool isValid() const { return m_State != nullptr; }
+        [[nodiscard]] CommandQueue getQueue() const { return m_Queue; }
+        [[nodiscard]] uint64_t getSubmissionID() const { return m_SubmissionID; }
+
+        [[nodiscard]] bool isReady() const
+        {
+            if (!m_State)
+                return true;
+
+            std::lock_guard lock(m_State->mutex);
+            return m_State->completed;
+        }
+
+        // True if the future is ready because its submission will never complete
+        [[nodiscard]] bool hasFailed() const
+        {
+            if (!m_State)
+                return false;
+
+            std::lock_guard lock(m_State->mutex);
+            return m_State->failed;
+        }
+
+        // Blocks until the future is ready, returns false if the submission has failed
+        bool wait() const
+        {
+            if (!m_State)
+                return true;
+
+            std::unique_lock lock(m_State->mutex);
+            m_State->completedCondition.wait(lock, [this] { return m_State->completed; });
+            return !m_State->failed;
+        }
+
+        // Calls the continuation when the future is ready, immediately if it already is. Use hasFailed to tell
+        // whether the submission has completed.
+        void then(std::function<void()> continuation) const
+        {
+            if (m_State)
+            {
+                std::unique_lock lock(m_State->mutex);
+                if (!m_State->completed)
+                {
+                    m_State->continuations.push_back(std::move(continuation));
+                    return;
+                }
+            }
+
+            continuation();
+        }
+
+        // Returns the function that the device calls to make the future ready, with 'completed' set to false
+        // if the submission has failed
+        [[nodiscard]] std::function<void(bool completed)> getCompletionCallback() const
+        {
+            return [state = m_State](bool completed)
+            {
+                std::vector<std::function<void()>> continuations;
+                {
+                    std::lock_guard lock(state->mutex);
+                    state->completed = true;
+                    state->failed = !completed;
+                    continuations = std::move(state->continuations);
+                }
+                state->completedCondition.notify_all();
+
+                for (const auto& continuation : continuations)
+                    continuation();
+            };
+        }
+
+#if NVRHI_WITH_COROUTINES
+        // co_await support: the coroutine is resumed on the completion thread, co_await returns false if
+        // the submission has failed
+        [[nodiscard]] bool await_ready() const { return isReady(); }
+        void await_suspend(std::coroutine_handle<> handle) const { then([handle]() { handle.resume(); }); }
+        bool await_resume() const { return !hasFailed(); }
+#endif
+
+    private:
+        struct State
+        {
+            std::mutex mutex;
+            std::condition_variable completedCondition;
+            bool completed = false; // or failed
+            bool failed = false;
+            std::vector<std::function<void()>> continuations;
+        };
+
+        std::shared_ptr<State> m_State;
+        CommandQueue m_Queue = CommandQueue::Graphics;
+        uint64_t m_SubmissionID = 0;
+    };
+}
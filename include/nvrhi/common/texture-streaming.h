@@ -0,0 +1,215 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace nvrhi
+{
+    // Per-texture input of planTextureStreaming. Mip levels are counted from the most detailed one, so a lower
+    // mip index means more detail; a mip value equal to mipSizes.size() means that no mips are resident.
+    struct StreamingTextureState
+    {
+        // Size of each mip level in bytes, including all array slices
+        std::vector<uint64_t> mipSizes;
+
+        // Most detailed mip that can be sampled; all less detailed mips are resident too
+        MipLevel residentMip = 0;
+
+        // Most detailed mip that is resident or being uploaded. Uploads go from less to more detailed mips,
+        // so the mips between pendingMip and residentMip are in flight.
+        MipLevel pendingMip = 0;
+
+        // Most detailed mip that the renderer asked for
+        MipLevel requestedMip = 0;
+
+        // Mips starting from this one are always kept resident and uploaded regardless of the budgets
+        MipLevel lockedMip = 0;
+
+        // Higher values are uploaded first and evicted last
+        float priority = 0.f;
+
+        bool active = false;
+    };
+
+    struct StreamingAction
+    {
+        enum class Type : uint8_t
+        {
+            Upload, // make mipLevel resident, it is one level more detailed than the texture's pendingMip
+            Evict   // drop mipLevel, which is the texture's residentMip
+        };
+
+        Type type = Type::Upload;
+        uint32_t texture = 0; // index into the state array
+        MipLevel mipLevel = 0;
+    };
+
+    // The streaming policy, separate from the manager so that it can be tested without a device.
+    // Produces the uploads for one update in the order in which they should be issued, under the memory
+    // budget and the per-update upload budget. Locked mips come first, then the textures with the highest
+    // priority, each going from less to more detailed mips. When an upload doesn't fit into the memory budget,
+    // resident mips are evicted in this order: mips more detailed than requested, then mips of textures with
+    // a lower priority than the upload's one, lowest priority first. Textures with uploads in flight are not
+    // evicted from, and nothing is evicted for an upload that doesn't fit even then. Every Evict action precedes
+    // the Upload that it makes room for, and no Upload is planned for a texture after one of its mips was evicted.
+    NVRHI_API void planTextureStreaming(const std::vector<StreamingTextureState>& textures,
+        uint64_t memoryBudget, uint64_t uploadBudget, std::vector<StreamingAction>& outActions);
+
+    struct StreamingSubresourceData
+    {
+        const void* data = nullptr;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+    };
+
+    typedef uint32_t StreamedTextureID;
+    static constexpr StreamedTextureID c_InvalidStreamedTexture = ~0u;
+
+    struct StreamedTextureDesc
+    {
+        TextureHandle texture;
+
+        // Number of least detailed mips that are always resident
+        uint32_t lockedMips = 1;
+
+        // Returns the texel data of one subresource, or false if it is not available yet, in which case the
+        // upload is retried in a later update. The data only needs to stay valid until the function returns.
+        std::function<bool(MipLevel mipLevel, ArraySlice arraySlice, StreamingSubresourceData& outData)> loadSubresource;
+
+        StreamedTextureDesc& setTexture(ITexture* value) { texture = value; return *this; }
+        StreamedTextureDesc& setLockedMips(uint32_t value) { lockedMips = value; return *this; }
+    };
+
+    struct TextureStreamingDesc
+    {
+        // Total size of the resident mips of all streamed textures
+        uint64_t memoryBudget = 256ull * 1024 * 1024;
+
+        // Upload limits for one call to update
+        uint64_t uploadBytesPerUpdate = 16ull * 1024 * 1024;
+        float uploadTimeBudgetMs = 2.f;
+
+        // Falls back to the graphics queue if the device has no copy queue
+        CommandQueue uploadQueue = CommandQueue::Copy;
+
+        // Called when the resident mip range of a texture changes, after uploads complete and when mips are evicted.
+        // Evicted mips are no longer sampled after the clamp is applied, but their memory stays allocated
+        // unless the callback releases it, for example by unmapping tiles of a virtual texture.
+        std::function<void(StreamedTextureID texture, MipLevel residentMip)> onResidencyChanged;
+
+        TextureStreamingDesc& setMemoryBudget(uint64_t value) { memoryBudget = value; return *this; }
+        TextureStreamingDesc& setUploadBytesPerUpdate(uint64_t value) { uploadBytesPerUpdate = value; return *this; }
+        TextureStreamingDesc& setUploadTimeBudgetMs(float value) { uploadTimeBudgetMs = value; return *this; }
+        TextureStreamingDesc& setUploadQueue(CommandQueue value) { uploadQueue = value; return *this; }
+    };
+
+    struct TextureStreamingStatistics
+    {
+        uint64_t residentBytes = 0; // including uploads in flight
+        uint64_t uploadedBytes = 0; // in the last update
+        uint32_t uploadedMips = 0;
+        uint32_t evictedMips = 0;
+        uint32_t pendingBatches = 0;
+    };
+
+    // Streams the mip levels of textures according to the feedback given by the renderer.
+    //
+    // Textures are created with all of their mips, and the manager tracks which mips hold valid data.
+    // Each frame, the renderer reports the most detailed mip it needs and a priority for each texture with
+    // setFeedback, and calls update. update uploads mips through its own command list on the upload queue,
+    // following planTextureStreaming, and publishes them once the GPU has finished the copies. Sampling must be
+    // limited to the resident mips, using getMinLod as the LOD clamp in the shader or getResidentSubresources
+    // for the shader resource view.
+    //
+    // With the copy queue, streamed textures should have ResourceStates::Common as their initial state with
+    // keepInitialState, because copy queues cannot transition textures into shader resource states.
+    // The manager is not thread safe.
+    class TextureStreamingManager
+    {
+    public:
+        NVRHI_API TextureStreamingManager(IDevice* device, const TextureStreamingDesc& desc = TextureStreamingDesc());
+
+        TextureStreamingManager(const TextureStreamingManager&) = delete;
+        TextureStreamingManager& operator=(const TextureStreamingManager&) = delete;
+
+        NVRHI_API StreamedTextureID addTexture(const StreamedTextureDesc& desc);
+        NVRHI_API void removeTexture(StreamedTextureID texture);
+
+        // requestedMip is the most detailed mip that the texture needs. The values are kept until changed.
+        NVRHI_API void setFeedback(StreamedTextureID texture, MipLevel requestedMip, float priority);
+
+        NVRHI_API void update();
+
+        [[nodiscard]] NVRHI_API MipLevel getResidentMip(StreamedTextureID texture) const;
+        [[nodiscard]] float getMinLod(StreamedTextureID texture) const { return float(getResidentMip(texture)); }
+        [[nodiscard]] NVRHI_API TextureSubresourceSet getResidentSubresources(StreamedTextureID texture) const;
+
+        [[nodiscard]] const TextureStreamingStatistics& getStatistics() const { return m_Statistics; }
+
+    private:
+        struct Slot
+        {
+            StreamedTextureDesc desc;
+            uint32_t generation = 0;
+        };
+
+        struct Upload
+        {
+            StreamedTextureID texture;
+            uint32_t generation;
+            MipLevel mipLevel;
+        };
+
+        struct Batch
+        {
+            EventQueryHandle query;
+            std::vector<Upload> uploads;
+        };
+
+        DeviceHandle m_Device;
+        TextureStreamingDesc m_Desc;
+        CommandListHandle m_CommandList;
+
+        // Parallel arrays indexed by StreamedTextureID
+        std::vector<Slot> m_Slots;
+        std::vector<StreamingTextureState> m_States;
+        std::vector<StreamedTextureID> m_FreeSlots;
+
+        std::deque<Batch> m_PendingBatches;
+        std::vector<EventQueryHandle> m_FreeQueries;
+        std::vector<StreamingAction> m_Actions;
+
+        TextureStreamingStatistics m_Statistics;
+
+        [[nodiscard]] bool isValid(StreamedTextureID texture) const;
+        void retireCompletedBatches();
+        void notifyResidencyChanged(StreamedTextureID texture);
+        bool uploadMip(StreamedTextureID texture, MipLevel mipLevel);
+    };
+}
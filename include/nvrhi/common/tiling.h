@@ -0,0 +1,61 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi
+{
+    // CPU-side tile math for tiled textures, used by the backends and usable by applications
+    // to find the tiles they need to map.
+
+    // Returns the number of mips that have at least one full tile in every dimension.
+    // The remaining mips would be packed into the mip tail. Backends report the actual value in PackedMipDesc.
+    NVRHI_API uint32_t computeNumStandardMips(const TextureDesc& desc, const TileShape& tileShape);
+
+    // Fills the tilings of the standard mips of one array slice, numbering the tiles mip by mip in row-major order
+    // starting from firstTileIndex. Returns the number of tiles of these mips.
+    NVRHI_API uint32_t computeSubresourceTilings(const TextureDesc& desc, const TileShape& tileShape,
+        uint32_t numStandardMips, SubresourceTiling* outTilings, uint32_t firstTileIndex = 0);
+
+    // Returns the tile coordinate and region that cover the texels of a slice in a standard mip.
+    // The region is empty if the tile shape has a zero width or height.
+    NVRHI_API void getTilesForTexels(const TextureDesc& desc, const TileShape& tileShape, const TextureSlice& slice,
+        TiledTextureCoordinate& outCoordinate, TiledTextureRegion& outRegion);
+
+    // Returns the texels covered by a tile region in a standard mip, clamped to the mip dimensions
+    NVRHI_API TextureSlice getTexelsForTiles(const TextureDesc& desc, const TileShape& tileShape,
+        const TiledTextureCoordinate& coordinate, const TiledTextureRegion& region);
+
+    // Returns the index of a tile within the resource, from the tiling of its mip level
+    [[nodiscard]] inline uint32_t getTileIndex(const SubresourceTiling& tiling, uint32_t x, uint32_t y, uint32_t z)
+    {
+        return tiling.startTileIndexInOverallResource + x + tiling.widthInTiles * (y + tiling.heightInTiles * z);
+    }
+
+    [[nodiscard]] inline bool isPackedMip(const PackedMipDesc& packedMips, MipLevel mipLevel)
+    {
+        return mipLevel >= packedMips.numStandardMips;
+    }
+}
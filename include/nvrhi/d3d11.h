@@ -42,6 +42,13 @@ namespace nvrhi::d3d11
         IMessageCallback* messageCallback = nullptr;
         ID3D11DeviceContext* context = nullptr;
         bool aftermathEnabled = false;
+
+        // Allocator for NVRHI's internal CPU-side containers, or null to use the global heap
+        IAllocator* allocator = nullptr;
+
+        // Job system returned by IDevice::getTaskScheduler. If null, NVRHI starts its own worker threads
+        // the first time it is needed.
+        ITaskScheduler* taskScheduler = nullptr;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
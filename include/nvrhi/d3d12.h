@@ -118,6 +118,13 @@ namespace nvrhi::d3d12
         uint32_t samplerHeapSize = 1024;
         uint32_t maxTimerQueries = 256;
         bool aftermathEnabled = false;
+
+        // Allocator for NVRHI's internal CPU-side containers, or null to use the global heap
+        IAllocator* allocator = nullptr;
+
+        // Job system used for large internal CPU operations. If null, NVRHI starts its own worker threads
+        // the first time such an operation is performed.
+        ITaskScheduler* taskScheduler = nullptr;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
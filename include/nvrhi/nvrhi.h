@@ -28,6 +28,7 @@
 #include <cstdint>
 #include <cmath>
 #include <cstring>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -58,11 +59,13 @@
 #   define NVRHI_API
 #endif
 
+#include <nvrhi/common/debug-name.h>
+
 namespace nvrhi
 {
     // Version of the public API provided by NVRHI.
     // Increment this when any changes to the API are made.
-    static constexpr uint32_t c_HeaderVersion = 14;
+    static constexpr uint32_t c_HeaderVersion = 32;
 
     // Verifies that the version of the implementation matches the version of the header.
     // Returns true if they match. Use this when initializing apps using NVRHI as a shared library.
@@ -76,6 +79,7 @@ namespace nvrhi
     static constexpr uint32_t c_MaxVolatileConstantBuffersPerLayout = 6;
     static constexpr uint32_t c_MaxVolatileConstantBuffers = 32;
     static constexpr uint32_t c_MaxPushConstantSize = 128; // D3D12: root signature is 256 bytes max., Vulkan: 128 bytes of push constants guaranteed
+    static constexpr uint32_t c_MaxPushConstantBufferSize = 4096; // Larger push constant blocks are written into upload memory and bound as a constant buffer
     static constexpr uint32_t c_ConstantBufferOffsetSizeAlignment = 256; // Partially bound constant buffers must have offsets aligned to this and sizes multiple of this
 
     //////////////////////////////////////////////////////////////////////////
@@ -296,11 +300,11 @@ namespace nvrhi
     {
         uint64_t capacity = 0;
         HeapType type;
-        std::string debugName;
+        DebugName debugName;
 
         constexpr HeapDesc& setCapacity(uint64_t value) { capacity = value; return *this; }
         constexpr HeapDesc& setType(HeapType value) { type = value; return *this; }
-                  HeapDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+                  HeapDesc& setDebugName(const DebugName& value) { debugName = value; return *this; }
     };
 
     class IHeap : public IResource
@@ -407,7 +411,7 @@ namespace nvrhi
         uint32_t sampleQuality = 0;
         Format format = Format::UNKNOWN;
         TextureDimension dimension = TextureDimension::Texture2D;
-        std::string debugName;
+        DebugName debugName;
 
         bool isShaderResource = true; // Note: isShaderResource is initialized to 'true' for backward compatibility
         bool isRenderTarget = false;
@@ -422,6 +426,11 @@ namespace nvrhi
         // On DX12, the texture resource is created at the time of memory binding.
         bool isVirtual = false;
 
+        // Indicates that the texture is created as a tiled (sparse) resource without backing memory,
+        // and memory is mapped to individual tiles using updateTextureTileMappings.
+        // Requires Feature::TiledResources.
+        bool isTiled = false;
+
         Color clearValue;
         bool useClearValue = false;
 
@@ -441,11 +450,12 @@ namespace nvrhi
         constexpr TextureDesc& setSampleQuality(uint32_t value) { sampleQuality = value; return *this; }
         constexpr TextureDesc& setFormat(Format value) { format = value; return *this; }
         constexpr TextureDesc& setDimension(TextureDimension value) { dimension = value; return *this; }
-                  TextureDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+                  TextureDesc& setDebugName(const DebugName& value) { debugName = value; return *this; }
         constexpr TextureDesc& setIsRenderTarget(bool value) { isRenderTarget = value; return *this; }
         constexpr TextureDesc& setIsUAV(bool value) { isUAV = value; return *this; }
         constexpr TextureDesc& setIsTypeless(bool value) { isTypeless = value; return *this; }
         constexpr TextureDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+        constexpr TextureDesc& setIsTiled(bool value) { isTiled = value; return *this; }
         constexpr TextureDesc& setClearValue(const Color& value) { clearValue = value; useClearValue = true; return *this; }
         constexpr TextureDesc& setUseClearValue(bool value) { useClearValue = value; return *this; }
         constexpr TextureDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
@@ -523,6 +533,67 @@ namespace nvrhi
 
     static const TextureSubresourceSet AllSubresources = TextureSubresourceSet(0, TextureSubresourceSet::AllMipLevels, 0, TextureSubresourceSet::AllArraySlices);
 
+    //////////////////////////////////////////////////////////////////////////
+    // Tiled resources
+    //////////////////////////////////////////////////////////////////////////
+
+    // The least detailed mips of a tiled texture, which are smaller than a tile, are packed into a mip tail
+    // that is mapped as a whole. Each array slice has its own mip tail.
+    struct PackedMipDesc
+    {
+        uint32_t numStandardMips = 0;
+        uint32_t numPackedMips = 0;
+        uint32_t numTilesForPackedMips = 0; // per array slice
+        uint32_t startTileIndexInOverallResource = 0;
+    };
+
+    struct TileShape
+    {
+        uint32_t widthInTexels = 0;
+        uint32_t heightInTexels = 0;
+        uint32_t depthInTexels = 0;
+    };
+
+    // Tiling of one standard mip level
+    struct SubresourceTiling
+    {
+        uint32_t widthInTiles = 0;
+        uint32_t heightInTiles = 0;
+        uint32_t depthInTiles = 0;
+        uint32_t startTileIndexInOverallResource = 0;
+    };
+
+    // Position of a tile, in tiles, within a mip level and array slice
+    struct TiledTextureCoordinate
+    {
+        uint16_t mipLevel = 0;
+        uint16_t arrayLevel = 0;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t z = 0;
+    };
+
+    // Box of tiles starting at a TiledTextureCoordinate. For a coordinate in the mip tail, the region is the whole
+    // mip tail of the array slice and the box is ignored. tilesNum is the number of tiles in the box.
+    struct TiledTextureRegion
+    {
+        uint32_t tilesNum = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 0;
+    };
+
+    // Maps numTextureRegions regions to the heap, each one starting at its byteOffset in the heap.
+    // The tiles of a region use consecutive memory. If heap is null, the regions are unmapped.
+    struct TextureTilesMapping
+    {
+        TiledTextureCoordinate* tiledTextureCoordinates = nullptr;
+        TiledTextureRegion* tiledTextureRegions = nullptr;
+        uint64_t* byteOffsets = nullptr;
+        uint32_t numTextureRegions = 0;
+        IHeap* heap = nullptr;
+    };
+
     class ITexture : public IResource
     {
     public:
@@ -563,6 +634,18 @@ namespace nvrhi
         constexpr VertexAttributeDesc& setOffset(uint32_t value) { offset = value; return *this; }
         constexpr VertexAttributeDesc& setElementStride(uint32_t value) { elementStride = value; return *this; }
         constexpr VertexAttributeDesc& setIsInstanced(bool value) { isInstanced = value; return *this; }
+
+        bool operator ==(const VertexAttributeDesc& b) const
+        {
+            return name == b.name
+                && format == b.format
+                && arraySize == b.arraySize
+                && bufferIndex == b.bufferIndex
+                && offset == b.offset
+                && elementStride == b.elementStride
+                && isInstanced == b.isInstanced;
+        }
+        bool operator !=(const VertexAttributeDesc& b) const { return !(*this == b); }
     };
 
     class IInputLayout : public IResource
@@ -583,7 +666,7 @@ namespace nvrhi
         uint64_t byteSize = 0;
         uint32_t structStride = 0; // if non-zero it's structured
         uint32_t maxVersions = 0; // only valid and required to be nonzero for volatile buffers on Vulkan
-        std::string debugName;
+        DebugName debugName;
         Format format = Format::UNKNOWN; // for typed buffer views
         bool canHaveUAVs = false;
         bool canHaveTypedViews = false;
@@ -616,7 +699,7 @@ namespace nvrhi
         constexpr BufferDesc& setByteSize(uint64_t value) { byteSize = value; return *this; }
         constexpr BufferDesc& setStructStride(uint32_t value) { structStride = value; return *this; }
         constexpr BufferDesc& setMaxVersions(uint32_t value) { maxVersions = value; return *this; }
-                  BufferDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+                  BufferDesc& setDebugName(const DebugName& value) { debugName = value; return *this; }
         constexpr BufferDesc& setFormat(Format value) { format = value; return *this; }
         constexpr BufferDesc& setCanHaveUAVs(bool value) { canHaveUAVs = value; return *this; }
         constexpr BufferDesc& setCanHaveTypedViews(bool value) { canHaveTypedViews = value; return *this; }
@@ -724,7 +807,7 @@ namespace nvrhi
     struct ShaderDesc
     {
         ShaderType shaderType = ShaderType::None;
-        std::string debugName;
+        DebugName debugName;
         std::string entryName = "main";
 
         int hlslExtensionsUAV = -1;
@@ -1046,6 +1129,15 @@ namespace nvrhi
             constexpr StencilOpDesc& setDepthFailOp(StencilOp value) { depthFailOp = value; return *this; }
             constexpr StencilOpDesc& setPassOp(StencilOp value) { passOp = value; return *this; }
             constexpr StencilOpDesc& setStencilFunc(ComparisonFunc value) { stencilFunc = value; return *this; }
+
+            constexpr bool operator ==(const StencilOpDesc& other) const
+            {
+                return failOp == other.failOp
+                    && depthFailOp == other.depthFailOp
+                    && passOp == other.passOp
+                    && stencilFunc == other.stencilFunc;
+            }
+            constexpr bool operator !=(const StencilOpDesc& other) const { return !(*this == other); }
         };
 
         bool            depthTestEnable = true;
@@ -1151,6 +1243,21 @@ namespace nvrhi
         SamplerDesc& setAddressW(SamplerAddressMode mode) { addressW = mode; return *this; }
         SamplerDesc& setAllAddressModes(SamplerAddressMode mode) { addressU = addressV = addressW = mode; return *this; }
         SamplerDesc& setReductionType(SamplerReductionType type) { reductionType = type; return *this; }
+
+        bool operator ==(const SamplerDesc& b) const
+        {
+            return borderColor == b.borderColor
+                && maxAnisotropy == b.maxAnisotropy
+                && mipBias == b.mipBias
+                && minFilter == b.minFilter
+                && magFilter == b.magFilter
+                && mipFilter == b.mipFilter
+                && addressU == b.addressU
+                && addressV == b.addressV
+                && addressW == b.addressW
+                && reductionType == b.reductionType;
+        }
+        bool operator !=(const SamplerDesc& b) const { return !(*this == b); }
     };
 
     class ISampler : public IResource 
@@ -1290,7 +1397,7 @@ namespace nvrhi
 
         struct OpacityMicromapDesc
         {
-            std::string debugName;
+            DebugName debugName;
             bool trackLiveness = true;
 
             // OMM flags. Applies to all OMMs in array.
@@ -1308,7 +1415,7 @@ namespace nvrhi
             IBuffer* perOmmDescs = nullptr;
             uint64_t perOmmDescsOffset = 0;
 
-            OpacityMicromapDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+            OpacityMicromapDesc& setDebugName(const DebugName& value) { debugName = value; return *this; }
             OpacityMicromapDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
             OpacityMicromapDesc& setFlags(OpacityMicromapBuildFlags value) { flags = value; return *this; }
             OpacityMicromapDesc& setCounts(const std::vector<OpacityMicromapUsageCount>& value) { counts = value; return *this; }
@@ -1510,7 +1617,7 @@ namespace nvrhi
             size_t topLevelMaxInstances = 0; // only applies when isTopLevel = true
             std::vector<GeometryDesc> bottomLevelGeometries; // only applies when isTopLevel = false
             AccelStructBuildFlags buildFlags = AccelStructBuildFlags::None;
-            std::string debugName;
+            DebugName debugName;
             bool trackLiveness = true;
             bool isTopLevel = false;
             bool isVirtual = false;
@@ -1518,7 +1625,7 @@ namespace nvrhi
             AccelStructDesc& setTopLevelMaxInstances(size_t value) { topLevelMaxInstances = value; isTopLevel = true; return *this; }
             AccelStructDesc& addBottomLevelGeometry(const GeometryDesc& value) { bottomLevelGeometries.push_back(value); isTopLevel = false; return *this; }
             AccelStructDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
-            AccelStructDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+            AccelStructDesc& setDebugName(const DebugName& value) { debugName = value; return *this; }
             AccelStructDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
             AccelStructDesc& setIsTopLevel(bool value) { isTopLevel = value; return *this; }
             AccelStructDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
@@ -2034,6 +2141,58 @@ namespace nvrhi
         constexpr RenderState& setSinglePassStereoState(const SinglePassStereoState& value) { singlePassStereo = value; return *this; }
     };
 
+    // Groups of render state that a graphics pipeline can leave to be set per draw through GraphicsState::dynamicRenderState.
+    // Pipelines that differ only in these groups can be shared, which reduces the number of permutations.
+    // Requires Feature::ExtendedDynamicState.
+    enum class DynamicRenderStateFlags : uint8_t
+    {
+        None            = 0x00,
+        CullMode        = 0x01,
+        FrontFace       = 0x02,
+        DepthTest       = 0x04,
+        DepthWrite      = 0x08,
+        DepthCompare    = 0x10,
+        Stencil         = 0x20  // stencilEnable and the front/back stencil ops
+    };
+
+    NVRHI_ENUM_CLASS_FLAG_OPERATORS(DynamicRenderStateFlags)
+
+    // Values for the render state groups marked as dynamic in GraphicsPipelineDesc::dynamicRenderState.
+    // Fields of groups that are not dynamic in the bound pipeline are ignored.
+    struct DynamicRenderState
+    {
+        RasterCullMode cullMode = RasterCullMode::Back;
+        bool frontCounterClockwise = false;
+        bool depthTestEnable = true;
+        bool depthWriteEnable = true;
+        ComparisonFunc depthFunc = ComparisonFunc::Less;
+        bool stencilEnable = false;
+        DepthStencilState::StencilOpDesc frontFaceStencil;
+        DepthStencilState::StencilOpDesc backFaceStencil;
+
+        constexpr DynamicRenderState& setCullMode(RasterCullMode value) { cullMode = value; return *this; }
+        constexpr DynamicRenderState& setFrontCounterClockwise(bool value) { frontCounterClockwise = value; return *this; }
+        constexpr DynamicRenderState& setDepthTestEnable(bool value) { depthTestEnable = value; return *this; }
+        constexpr DynamicRenderState& setDepthWriteEnable(bool value) { depthWriteEnable = value; return *this; }
+        constexpr DynamicRenderState& setDepthFunc(ComparisonFunc value) { depthFunc = value; return *this; }
+        constexpr DynamicRenderState& setStencilEnable(bool value) { stencilEnable = value; return *this; }
+        constexpr DynamicRenderState& setFrontFaceStencil(const DepthStencilState::StencilOpDesc& value) { frontFaceStencil = value; return *this; }
+        constexpr DynamicRenderState& setBackFaceStencil(const DepthStencilState::StencilOpDesc& value) { backFaceStencil = value; return *this; }
+
+        constexpr bool operator ==(const DynamicRenderState& other) const
+        {
+            return cullMode == other.cullMode
+                && frontCounterClockwise == other.frontCounterClockwise
+                && depthTestEnable == other.depthTestEnable
+                && depthWriteEnable == other.depthWriteEnable
+                && depthFunc == other.depthFunc
+                && stencilEnable == other.stencilEnable
+                && frontFaceStencil == other.frontFaceStencil
+                && backFaceStencil == other.backFaceStencil;
+        }
+        constexpr bool operator !=(const DynamicRenderState& other) const { return !(*this == other); }
+    };
+
     enum class VariableShadingRate : uint8_t
     {
         e1x1,
@@ -2093,6 +2252,9 @@ namespace nvrhi
         RenderState renderState;
         VariableRateShadingState shadingRateState;
 
+        // Render state groups that are taken from GraphicsState::dynamicRenderState instead of renderState.
+        DynamicRenderStateFlags dynamicRenderState = DynamicRenderStateFlags::None;
+
         BindingLayoutVector bindingLayouts;
         
         GraphicsPipelineDesc& setPrimType(PrimitiveType value) { primType = value; return *this; }
@@ -2108,6 +2270,7 @@ namespace nvrhi
         GraphicsPipelineDesc& setFragmentShader(IShader* value) { PS = value; return *this; }
         GraphicsPipelineDesc& setRenderState(const RenderState& value) { renderState = value; return *this; }
         GraphicsPipelineDesc& setVariableRateShadingState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
+        GraphicsPipelineDesc& setDynamicRenderState(DynamicRenderStateFlags value) { dynamicRenderState = value; return *this; }
         GraphicsPipelineDesc& addBindingLayout(IBindingLayout* layout) { bindingLayouts.push_back(layout); return *this; }
     };
 
@@ -2228,6 +2391,7 @@ namespace nvrhi
         VariableRateShadingState shadingRateState;
         Color blendConstantColor{};
         uint8_t dynamicStencilRefValue = 0;
+        DynamicRenderState dynamicRenderState; // used for the groups listed in GraphicsPipelineDesc::dynamicRenderState
 
         BindingSetVector bindings;
 
@@ -2235,6 +2399,7 @@ namespace nvrhi
         IndexBufferBinding indexBuffer;
 
         IBuffer* indirectParams = nullptr;
+        IBuffer* indirectCountBuffer = nullptr; // draw count for drawIndirectCount and drawIndexedIndirectCount
 
         GraphicsState& setPipeline(IGraphicsPipeline* value) { pipeline = value; return *this; }
         GraphicsState& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
@@ -2242,10 +2407,12 @@ namespace nvrhi
         GraphicsState& setShadingRateState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
         GraphicsState& setBlendColor(const Color& value) { blendConstantColor = value; return *this; }
         GraphicsState& setDynamicStencilRefValue(uint8_t value) { dynamicStencilRefValue = value; return *this; }
+        GraphicsState& setDynamicRenderState(const DynamicRenderState& value) { dynamicRenderState = value; return *this; }
         GraphicsState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         GraphicsState& addVertexBuffer(const VertexBufferBinding& value) { vertexBuffers.push_back(value); return *this; }
         GraphicsState& setIndexBuffer(const IndexBufferBinding& value) { indexBuffer = value; return *this; }
         GraphicsState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        GraphicsState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
     };
 
     struct DrawArguments
@@ -2315,6 +2482,7 @@ namespace nvrhi
         BindingSetVector bindings;
 
         IBuffer* indirectParams = nullptr;
+        IBuffer* indirectCountBuffer = nullptr; // dispatch count for dispatchMeshIndirectCount
 
         MeshletState& setPipeline(IMeshletPipeline* value) { pipeline = value; return *this; }
         MeshletState& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
@@ -2322,6 +2490,7 @@ namespace nvrhi
         MeshletState& setBlendColor(const Color& value) { blendConstantColor = value; return *this; }
         MeshletState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         MeshletState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        MeshletState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
         MeshletState& setDynamicStencilRefValue(uint8_t value) { dynamicStencilRefValue = value; return *this; }
     };
 
@@ -2448,7 +2617,25 @@ namespace nvrhi
         VirtualResources,
         ComputeQueue,
         CopyQueue,
-        ConstantBufferRanges
+        ConstantBufferRanges,
+        DrawIndirectCount,
+        TiledResources,
+        ExtendedDynamicState,
+        MultiDrawIndirect
+    };
+
+    // Counters of a table that deduplicates objects created from identical descriptors
+    struct InterningStatistics
+    {
+        uint64_t numRequests = 0;   // number of create calls
+        uint64_t numReused = 0;     // number of create calls that returned an existing object
+        size_t numObjects = 0;      // number of distinct objects currently in the table
+
+        // Fraction of create calls that did not create a new object
+        [[nodiscard]] float getDeduplicationRatio() const
+        {
+            return numRequests ? float(numReused) / float(numRequests) : 0.f;
+        }
     };
 
     enum class MessageSeverity : uint8_t
@@ -2490,6 +2677,92 @@ namespace nvrhi
         IMessageCallback& operator=(const IMessageCallback&) = delete;
         IMessageCallback& operator=(const IMessageCallback&&) = delete;
     };
+
+    enum class AllocationCategory : uint8_t
+    {
+        StateTracking,  // resource state tracking in command lists
+        Caches,         // render pass, framebuffer and other object caches
+        Upload,         // upload and scratch buffer bookkeeping
+        Validation,     // the validation layer
+        Objects,        // pooled NVRHI objects, only used with setObjectAllocator
+        Other,
+
+        Count
+    };
+
+    // Allocator for the CPU memory used by NVRHI, see DeviceDesc::allocator and setObjectAllocator.
+    // deallocate receives the same size, alignment and category that were passed to allocate.
+    // Both functions may be called from any thread.
+    class IAllocator
+    {
+    protected:
+        IAllocator() = default;
+        virtual ~IAllocator() = default;
+
+    public:
+        virtual void* allocate(size_t size, size_t alignment, AllocationCategory category) = 0;
+        virtual void deallocate(void* pointer, size_t size, size_t alignment, AllocationCategory category) = 0;
+    };
+
+    // Binding sets, buffers, textures, queries and command buffers are allocated from per-type slab pools
+    // with per-thread caches, because transient objects are created and destroyed from many threads every frame.
+    // An application can provide its own allocator for these objects instead, using setObjectAllocator;
+    // the objects are then allocated under AllocationCategory::Objects.
+    //
+    // Sets the allocator used instead of the slab pools; null selects the slab pools. The allocator can only be
+    // set or cleared before the first pooled object is created, because objects are freed by the allocator that
+    // created them: after that, the call returns false and leaves the current allocator in place, so a null
+    // argument does not switch back to the slab pools either. Call it before creating any device.
+    // The allocator must outlive all NVRHI objects.
+    NVRHI_API bool setObjectAllocator(IAllocator* allocator);
+
+    // Counts the CPU memory that a device allocates through DeviceDesc::allocator, which is:
+    // - the command list resource state tracking, including the per-resource states;
+    // - the upload and scratch buffer chunk lists and their chunk records;
+    // - the device caches: render passes, framebuffer objects, pipeline libraries, samplers, shader modules,
+    //   shader specializations and input layouts on Vulkan, root signatures on D3D12, state objects on D3D11;
+    // - the containers of the validation layer, when it is used.
+    // Not counted are the NVRHI objects themselves (see setObjectAllocator), the per-object view caches of
+    // textures and buffers, the pipeline and shader table descriptions kept by the objects, the Vulkan and
+    // D3D drivers' own allocations, and temporary storage that only lives for the duration of a call.
+    struct AllocationStatistics
+    {
+        // Bytes currently allocated by the device's internal containers, indexed by AllocationCategory
+        uint64_t bytesInUse[size_t(AllocationCategory::Count)] = {};
+
+        [[nodiscard]] uint64_t getBytesInUse(AllocationCategory category) const { return bytesInUse[size_t(category)]; }
+        [[nodiscard]] uint64_t getTotalBytesInUse() const
+        {
+            uint64_t total = 0;
+            for (uint64_t bytes : bytesInUse)
+                total += bytes;
+            return total;
+        }
+    };
+
+    // Interface to the application's job system, see DeviceDesc::taskScheduler.
+    // NVRHI uses it to split large CPU-side operations, such as packing top-level acceleration structure
+    // instances or copying big writeTexture payloads, into parallel jobs. Small operations always run inline.
+    // All functions may be called from any thread, including from within tasks.
+    class ITaskScheduler
+    {
+    protected:
+        ITaskScheduler() = default;
+        virtual ~ITaskScheduler() = default;
+
+    public:
+        typedef uint64_t TaskID;
+
+        // Calls function(begin, end) for consecutive ranges covering [0, count), each at most grainSize long,
+        // and returns when all of them have completed. The calling thread may execute some of the ranges.
+        virtual void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function) = 0;
+
+        // Schedules the task for asynchronous execution and returns an ID that can be passed to wait.
+        virtual TaskID runAsync(std::function<void()> task) = 0;
+
+        // Blocks until the task has completed. Each ID is waited on exactly once.
+        virtual void wait(TaskID task) = 0;
+    };
     
     class IDevice;
 
@@ -2546,8 +2819,18 @@ namespace nvrhi
         virtual void clearBufferUInt(IBuffer* b, uint32_t clearValue) = 0;
         virtual void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) = 0;
 
+        // Returns space for byteSize bytes of indirect arguments in the command list's upload memory, which the CPU
+        // writes through outCpuAddress before the command list is executed. The buffer can be used as indirectParams
+        // at the returned offset until the command list has finished executing. Unlike writeBuffer, this records
+        // no commands, so it doesn't end a Vulkan render pass. Returns nullptr if the backend doesn't expose its
+        // upload memory as buffers (D3D11, D3D12); writeBuffer has no such cost there.
+        virtual IBuffer* allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress) = 0;
+
         // Sets the push constants block on the command list, aka "root constants" on DX12.
         // Only valid after setGraphicsState or setComputeState etc.
+        // Blocks larger than c_MaxPushConstantSize, up to c_MaxPushConstantBufferSize, are copied into upload memory
+        // and bound as a constant buffer at the same slot with a new offset, so shaders declare them as a regular cbuffer.
+        // On Vulkan, such a block takes one of the layout's c_MaxVolatileConstantBuffersPerLayout dynamic buffer slots.
         virtual void setPushConstants(const void* data, size_t byteSize) = 0;
 
         virtual void setGraphicsState(const GraphicsState& state) = 0;
@@ -2555,6 +2838,12 @@ namespace nvrhi
         virtual void drawIndexed(const DrawArguments& args) = 0;
         virtual void drawIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
         virtual void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
+
+        // GPU-driven versions of drawIndirect and drawIndexedIndirect: the number of draws is a uint32 read from
+        // GraphicsState::indirectCountBuffer at countOffsetBytes, clamped to maxDrawCount.
+        // Requires Feature::DrawIndirectCount.
+        virtual void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
+        virtual void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
         
         virtual void setComputeState(const ComputeState& state) = 0;
         virtual void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
@@ -2563,6 +2852,12 @@ namespace nvrhi
         virtual void setMeshletState(const MeshletState& state) = 0;
         virtual void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
 
+        // Reads the dispatch arguments from MeshletState::indirectParams and the number of dispatches
+        // from MeshletState::indirectCountBuffer. Requires Feature::Meshlets and Feature::DrawIndirectCount.
+        // The argument layout is native to the backend: D3D12_DISPATCH_MESH_ARGUMENTS on DX12,
+        // VkDrawMeshTasksIndirectCommandNV on Vulkan.
+        virtual void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) = 0;
+
         virtual void setRayTracingState(const rt::State& state) = 0;
         virtual void dispatchRays(const rt::DispatchRaysArguments& args) = 0;
 
@@ -2646,6 +2941,18 @@ namespace nvrhi
         virtual MemoryRequirements getTextureMemoryRequirements(ITexture* texture) = 0;
         virtual bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) = 0;
 
+        // Returns the tiling of a texture created with isTiled = true. Any of the output pointers can be null.
+        // subresourceTilingsNum is the capacity of subresourceTilings on input, and receives the number of
+        // standard mips of one array slice on output.
+        virtual void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape,
+            uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) = 0;
+
+        // Maps tiles of a tiled texture to heap memory. The mapping takes effect for command lists executed on the queue afterwards.
+        // On Vulkan, all updates for a queue are collected and issued in one vkQueueBindSparse right before
+        // the next executeCommandLists call on that queue, which must support sparse binding.
+        virtual void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings,
+            CommandQueue executionQueue = CommandQueue::Graphics) = 0;
+
         virtual TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) = 0;
 
         virtual StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) = 0;
@@ -2731,6 +3038,13 @@ namespace nvrhi
         virtual bool isAftermathEnabled() = 0;
         virtual AftermathCrashDumpHelper& getAftermathCrashDumpHelper() = 0;
 
+        // Returns the amount of CPU memory held by the internal containers, per category
+        virtual AllocationStatistics getAllocationStatistics() = 0;
+
+        // Returns the scheduler for CPU-side jobs: DeviceDesc::taskScheduler, or the worker pool that NVRHI creates
+        // on first use when there is none. Utilities such as ShaderReloader submit their work to it as well.
+        virtual ITaskScheduler* getTaskScheduler() = 0;
+
         // Front-end for executeCommandLists(..., 1) for compatibility and convenience
         uint64_t executeCommandList(ICommandList* commandList, CommandQueue executionQueue = CommandQueue::Graphics)
         {
@@ -2826,6 +3140,44 @@ namespace std
         }
     };
 
+    template<> struct hash<nvrhi::SamplerDesc>
+    {
+        std::size_t operator()(nvrhi::SamplerDesc const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.borderColor.r);
+            nvrhi::hash_combine(hash, s.borderColor.g);
+            nvrhi::hash_combine(hash, s.borderColor.b);
+            nvrhi::hash_combine(hash, s.borderColor.a);
+            nvrhi::hash_combine(hash, s.maxAnisotropy);
+            nvrhi::hash_combine(hash, s.mipBias);
+            nvrhi::hash_combine(hash, s.minFilter);
+            nvrhi::hash_combine(hash, s.magFilter);
+            nvrhi::hash_combine(hash, s.mipFilter);
+            nvrhi::hash_combine(hash, s.addressU);
+            nvrhi::hash_combine(hash, s.addressV);
+            nvrhi::hash_combine(hash, s.addressW);
+            nvrhi::hash_combine(hash, s.reductionType);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::VertexAttributeDesc>
+    {
+        std::size_t operator()(nvrhi::VertexAttributeDesc const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.name);
+            nvrhi::hash_combine(hash, s.format);
+            nvrhi::hash_combine(hash, s.arraySize);
+            nvrhi::hash_combine(hash, s.bufferIndex);
+            nvrhi::hash_combine(hash, s.offset);
+            nvrhi::hash_combine(hash, s.elementStride);
+            nvrhi::hash_combine(hash, s.isInstanced);
+            return hash;
+        }
+    };
+
     template<> struct hash<nvrhi::BlendState::RenderTarget>
     {
         std::size_t operator()(nvrhi::BlendState::RenderTarget const& s) const noexcept
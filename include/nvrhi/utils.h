@@ -91,10 +91,16 @@ namespace nvrhi::utils
         nvrhi::FormatSupport requiredFeatures,
         const nvrhi::Format* requestedFormats,
         size_t requestedFormatCount);
+
+    // Resets the render state fields covered by desc.dynamicRenderState to their defaults.
+    // Applications that cache pipelines by their descriptors should key the cache on the result,
+    // so that descriptors which differ only in dynamic render state map to a single pipeline.
+    NVRHI_API GraphicsPipelineDesc RemoveDynamicRenderState(
+        const GraphicsPipelineDesc& desc);
     
     NVRHI_API const char* GraphicsAPIToString(GraphicsAPI api);
     NVRHI_API const char* TextureDimensionToString(TextureDimension dimension);
-    NVRHI_API const char* DebugNameToString(const std::string& debugName);
+    NVRHI_API const char* DebugNameToString(const DebugName& debugName);
     NVRHI_API const char* ShaderStageToString(ShaderType stage);
     NVRHI_API const char* ResourceTypeToString(ResourceType type);
     NVRHI_API const char* FormatToString(Format format);
@@ -26,5 +26,6 @@
 
 namespace nvrhi::validation
 {
-    NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice);
+    // The optional allocator is used for the validation layer's own containers, reported as AllocationCategory::Validation
+    NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice, IAllocator* allocator = nullptr);
 }
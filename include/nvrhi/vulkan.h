@@ -24,6 +24,7 @@
 
 #include <vulkan/vulkan.h>
 #include <nvrhi/nvrhi.h>
+#include <nvrhi/common/submission-future.h>
 
 namespace nvrhi 
 {
@@ -35,6 +36,16 @@ namespace nvrhi
 
 namespace nvrhi::vulkan
 {
+    // A submission on a queue's timeline: an allocation-free alternative to event queries.
+    // Points are plain values that can be stored and copied freely; resetting one means assigning a default point.
+    struct EventTimelinePoint
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t submissionID = 0; // 0 means the point is not set
+
+        [[nodiscard]] bool isSet() const { return submissionID != 0; }
+    };
+
     class IDevice : public nvrhi::IDevice
     {
     public:
@@ -45,6 +56,48 @@ namespace nvrhi::vulkan
         virtual uint64_t queueGetCompletedInstance(CommandQueue queue) = 0;
         virtual FramebufferHandle createHandleForNativeFramebuffer(VkRenderPass renderPass, 
             VkFramebuffer framebuffer, const FramebufferDesc& desc, bool transferOwnership) = 0;
+
+        // Samplers and input layouts created from identical descriptors are shared.
+        // Unused shared objects are released in runGarbageCollection.
+        virtual InterningStatistics getSamplerInterningStatistics() = 0;
+        virtual InterningStatistics getInputLayoutInterningStatistics() = 0;
+
+        // Returns the command lists and marker scopes that were in progress on each queue according to the breadcrumbs.
+        // Intended to be called after a device loss. Returns an empty string if breadcrumbs are not enabled.
+        virtual std::string getBreadcrumbReport() = 0;
+
+        // Calls the callback once the submission with the given ID (returned by executeCommandLists) has completed.
+        // Callbacks run on a background thread that waits on all queue semaphores at once with vkWaitSemaphores,
+        // or immediately on the calling thread if the submission has already completed.
+        // Every callback is called exactly once: with 'completed' set to false if the submission cannot complete,
+        // i.e. the ID is invalid, waiting failed (most likely a device loss) or the device is being destroyed.
+        // Callbacks must be short and must not destroy the device.
+        virtual void registerCompletionCallback(CommandQueue queue, uint64_t submissionID, std::function<void(bool completed)> callback) = 0;
+
+        SubmissionFuture getSubmissionFuture(CommandQueue queue, uint64_t submissionID)
+        {
+            SubmissionFuture future(queue, submissionID);
+            registerCompletionCallback(queue, submissionID, future.getCompletionCallback());
+            return future;
+        }
+
+        // Returns the point that marks the last submission on the queue, same as setEventQuery
+        virtual EventTimelinePoint getEventTimelinePoint(CommandQueue queue) = 0;
+
+        // Batched versions of pollEventQuery: results[i] is set to true if the i-th point or query has completed.
+        // The completed value of each queue's semaphore is read at most once per call.
+        // Points or queries that are not set are reported as not completed.
+        virtual void pollEventTimelinePoints(const EventTimelinePoint* points, size_t numPoints, bool* results) = 0;
+        virtual void pollEventQueries(IEventQuery* const* queries, size_t numQueries, bool* results) = 0;
+
+        virtual void waitEventTimelinePoint(const EventTimelinePoint& point) = 0;
+
+        // Front-end for executeCommandLists that returns an awaitable handle to the submission
+        SubmissionFuture executeCommandListsAsync(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics)
+        {
+            uint64_t submissionID = executeCommandLists(pCommandLists, numCommandLists, executionQueue);
+            return getSubmissionFuture(executionQueue, submissionID);
+        }
     };
 
     typedef RefCountPtr<IDevice> DeviceHandle;
@@ -67,6 +120,13 @@ namespace nvrhi::vulkan
 
         VkAllocationCallbacks *allocationCallbacks = nullptr;
 
+        // Allocator for NVRHI's internal CPU-side containers, or null to use the global heap
+        IAllocator* allocator = nullptr;
+
+        // Job system used for large internal CPU operations. If null, NVRHI starts its own worker threads
+        // the first time such an operation is performed.
+        ITaskScheduler* taskScheduler = nullptr;
+
         const char **instanceExtensions = nullptr;
         size_t numInstanceExtensions = 0;
         
@@ -77,7 +137,58 @@ namespace nvrhi::vulkan
 
         // Indicates if VkPhysicalDeviceVulkan12Features::bufferDeviceAddress was set to 'true' at device creation time
         bool bufferDeviceAddressSupported = false;
+
+        // Indicates if VkPhysicalDeviceVulkan12Features::drawIndirectCount was set to 'true' at device creation time
+        bool drawIndirectCountSupported = false;
         bool aftermathEnabled = false;
+
+        // Indicates if VkPhysicalDeviceFeatures::sparseBinding and sparseResidencyImage2D were set to 'true' at device
+        // creation time. Tiled textures are supported if this is set and one of the queues has
+        // VK_QUEUE_SPARSE_BINDING_BIT; updateTextureTileMappings only accepts such queues.
+        bool sparseResidencySupported = false;
+
+        // Indicates if VkPhysicalDeviceVulkan13Features::dynamicRendering was set to 'true' at device creation time
+        bool dynamicRenderingSupported = false;
+
+        // Indicates if VkPhysicalDeviceFeatures::multiDrawIndirect was set to 'true' at device creation time.
+        // Without it, drawIndirect and drawIndexedIndirect accept at most one draw per call.
+        bool multiDrawIndirectSupported = false;
+
+        // Use VK_KHR_dynamic_rendering instead of render pass and framebuffer objects for framebuffers created with createFramebuffer.
+        // Requires VkPhysicalDeviceDynamicRenderingFeatures::dynamicRendering to be set to 'true' at device creation time,
+        // and either VK_KHR_dynamic_rendering in the device extensions or dynamicRenderingSupported to be set.
+        // Framebuffers with a shading rate attachment still use render passes.
+        bool enableDynamicRendering = false;
+
+        // Resources are created with VK_SHARING_MODE_EXCLUSIVE. When the graphics, compute and transfer queues come
+        // from different families and a resource is used on more than one of them, its ownership must be transferred.
+        // With this option, executeCommandLists submits a release on the queue that used the resource last and
+        // an acquire before the command lists, and makes the queue wait for the release.
+        // The uses are also recorded in command lists with automatic barriers disabled; the transfers of such
+        // resources keep the state that the last command list with a known state left them in.
+        // Synchronization between the command lists themselves is still up to the application.
+        bool enableQueueOwnershipTransfers = false;
+
+        // Maximum number of framebuffer objects kept in the device cache, 0 disables the cache.
+        // Cached framebuffer objects keep their attachment textures alive until evicted.
+        uint32_t maxCachedFramebuffers = 0;
+
+        // Keep a copy of the SPIR-V binaries passed to createShader so that IShader::getBytecode can return them.
+        // The copy is shared between all shaders created from identical binaries.
+        bool retainShaderBytecode = false;
+
+        // Record GPU breadcrumbs for command lists and markers into a host-visible buffer per queue,
+        // see IDevice::getBreadcrumbReport. Uses VK_AMD_buffer_marker when it's enabled, vkCmdFillBuffer otherwise.
+        // vkCmdFillBuffer is not allowed in render passes, so without buffer markers the marker scopes that begin or end
+        // inside a render pass are not recorded, and the last recorded scope is the one around the pass.
+        bool enableBreadcrumbs = false;
+
+        // Build graphics pipelines from separately compiled vertex input, pre-rasterization, fragment shader and
+        // fragment output parts that are cached by the device. createGraphicsPipeline returns a fast-linked pipeline,
+        // and a link-time optimized one is created on the task scheduler and used once it's ready.
+        // Requires VK_KHR_pipeline_library and VK_EXT_graphics_pipeline_library, with
+        // VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT::graphicsPipelineLibrary set to 'true' at device creation time.
+        bool enableGraphicsPipelineLibraries = false;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
@@ -21,45 +21,141 @@
 */
 
 #include <nvrhi/common/aftermath.h>
+#include <nvrhi/common/breadcrumbs.h>
 
 namespace nvrhi
 {
     AftermathMarkerTracker::AftermathMarkerTracker() :
         m_EventStack{},
-        m_EventHashes{},
-        m_OldestHashIndex(0),
-        m_EventStrings{}
+        m_Names{},
+        m_Events{}
     {
+        m_EventStack.reserve(MaxEventDepth);
     }
 
     size_t AftermathMarkerTracker::pushEvent(const char* name)
     {
-        m_EventStack.append(name);
-        std::string eventString = m_EventStack.generic_string();
-        size_t hash = std::hash<std::string>{}(eventString);
-        if (m_EventStrings.find(hash) == m_EventStrings.end())
-        {
-            m_EventStrings.erase(m_EventHashes[m_OldestHashIndex]);
-            m_EventStrings[hash] = eventString;
-            m_EventHashes[m_OldestHashIndex] = hash;
-            m_OldestHashIndex = (m_OldestHashIndex + 1) % MaxEventStrings;
-        }
+        const std::string_view nameView(name);
+        const size_t nameHash = std::hash<std::string_view>{}(nameView);
+        const uint16_t nameIndex = acquireName(nameView, nameHash);
+
+        size_t hash = m_EventStack.empty() ? 0 : m_EventStack.back().eventHash;
+        hash_combine(hash, nameHash);
+        m_EventStack.push_back({ hash, nameIndex });
+
+        EventRecord& record = m_Events[hash % MaxEventStrings];
+        if (!isEventRecorded(record, hash))
+            recordEvent(record, hash);
+
         return hash;
     }
 
     void AftermathMarkerTracker::popEvent()
     {
-        m_EventStack = m_EventStack.parent_path();
+        if (m_EventStack.empty())
+            return;
+
+        releaseName(m_EventStack.back().nameIndex);
+        m_EventStack.pop_back();
+    }
+
+    uint16_t AftermathMarkerTracker::acquireName(std::string_view name, size_t nameHash)
+    {
+        uint16_t freeSlot = InvalidName;
+
+        for (size_t probe = 0; probe < MaxNameProbes; ++probe)
+        {
+            const uint16_t index = uint16_t((nameHash + probe) % MaxNames);
+            NameSlot& slot = m_Names[index];
+
+            if (slot.hash == nameHash && slot.name == name)
+            {
+                ++slot.references;
+                return index;
+            }
+
+            if (slot.references == 0 && freeSlot == InvalidName)
+                freeSlot = index;
+        }
+
+        // All slots near this hash are in use by the stack or by recorded events; the event won't be resolvable
+        if (freeSlot == InvalidName)
+            return InvalidName;
+
+        NameSlot& slot = m_Names[freeSlot];
+        slot.hash = nameHash;
+        slot.name.assign(name);
+        slot.references = 1;
+        return freeSlot;
+    }
+
+    void AftermathMarkerTracker::releaseName(uint16_t nameIndex)
+    {
+        if (nameIndex != InvalidName && m_Names[nameIndex].references != 0)
+            --m_Names[nameIndex].references;
+    }
+
+    bool AftermathMarkerTracker::isEventRecorded(const EventRecord& record, size_t hash) const
+    {
+        if (record.depth == 0 || record.hash != hash || record.depth != m_EventStack.size())
+            return false;
+
+        for (size_t level = 0; level < m_EventStack.size(); ++level)
+        {
+            if (record.nameIndices[level] != m_EventStack[level].nameIndex)
+                return false;
+        }
+
+        return true;
+    }
+
+    void AftermathMarkerTracker::recordEvent(EventRecord& record, size_t hash)
+    {
+        if (m_EventStack.size() > MaxEventDepth)
+            return;
+
+        for (const StackEntry& entry : m_EventStack)
+        {
+            if (entry.nameIndex == InvalidName)
+                return;
+        }
+
+        for (uint32_t level = 0; level < record.depth; ++level)
+            releaseName(record.nameIndices[level]);
+
+        record.hash = hash;
+        record.depth = uint32_t(m_EventStack.size());
+        record.resolvedString.clear();
+        for (uint32_t level = 0; level < record.depth; ++level)
+        {
+            const uint16_t nameIndex = m_EventStack[level].nameIndex;
+            record.nameIndices[level] = nameIndex;
+            ++m_Names[nameIndex].references;
+        }
+    }
+
+    const std::string& AftermathMarkerTracker::resolveEvent(EventRecord& record)
+    {
+        if (record.resolvedString.empty())
+        {
+            for (uint32_t level = 0; level < record.depth; ++level)
+            {
+                if (level != 0)
+                    record.resolvedString += '/';
+                record.resolvedString += m_Names[record.nameIndices[level]].name;
+            }
+        }
+        return record.resolvedString;
     }
 
     const static std::string NotFoundMarkerString = "ERROR: could not resolve marker";
 
     std::pair<bool, std::reference_wrapper<const std::string>> AftermathMarkerTracker::getEventString(size_t hash)
     {
-        auto const& found = m_EventStrings.find(hash);
-        if (found != m_EventStrings.end())
+        EventRecord& record = m_Events[hash % MaxEventStrings];
+        if (record.depth != 0 && record.hash == hash)
         {
-            return std::make_pair<bool, std::reference_wrapper<const std::string>>(true, found->second);
+            return std::make_pair<bool, std::reference_wrapper<const std::string>>(true, resolveEvent(record));
         }
         else
         {
@@ -68,6 +164,16 @@ namespace nvrhi
         }
     }
 
+    ResolvedMarker AftermathMarkerTracker::getEventStringByBreadcrumbID(uint32_t markerID)
+    {
+        for (EventRecord& record : m_Events)
+        {
+            if (record.depth != 0 && BreadcrumbEncoder::getMarkerID(record.hash) == markerID)
+                return std::make_pair<bool, std::reference_wrapper<const std::string>>(true, resolveEvent(record));
+        }
+        return std::make_pair(false, NotFoundMarkerString);
+    }
+
     AftermathCrashDumpHelper::AftermathCrashDumpHelper():
         m_MarkerTrackers{},
         m_ShaderBinaryLookupCallbacks{}
@@ -120,6 +226,23 @@ namespace nvrhi
         return std::make_pair(false, NotFoundMarkerString);
     }
 
+    ResolvedMarker AftermathCrashDumpHelper::ResolveBreadcrumbMarker(uint32_t markerID)
+    {
+        for (auto markerTracker : m_MarkerTrackers)
+        {
+            auto [found, markerString] = markerTracker->getEventStringByBreadcrumbID(markerID);
+            if (found)
+                return std::make_pair(found, markerString);
+        }
+        for (auto& markerTracker : m_DestroyedMarkerTrackers)
+        {
+            auto [found, markerString] = markerTracker.getEventStringByBreadcrumbID(markerID);
+            if (found)
+                return std::make_pair(found, markerString);
+        }
+        return std::make_pair(false, NotFoundMarkerString);
+    }
+
     BinaryBlob AftermathCrashDumpHelper::findShaderBinary(uint64_t shaderHash, ShaderHashGeneratorFunction hashGenerator)
     {
         for (auto shaderLookupClientCallback : m_ShaderBinaryLookupCallbacks)
@@ -0,0 +1,152 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Routes the allocations of a device's internal containers to the application's IAllocator,
+    // or to the global heap if there is none, and counts the bytes in use per category.
+    class AllocationTracker
+    {
+    public:
+        explicit AllocationTracker(IAllocator* allocator = nullptr)
+            : m_Allocator(allocator)
+        { }
+
+        AllocationTracker(const AllocationTracker&) = delete;
+        AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+        void* allocate(size_t size, size_t alignment, AllocationCategory category)
+        {
+            void* pointer = m_Allocator
+                ? m_Allocator->allocate(size, alignment, category)
+                : (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                    ? ::operator new(size, std::align_val_t(alignment))
+                    : ::operator new(size));
+
+            m_BytesInUse[size_t(category)].fetch_add(size, std::memory_order_relaxed);
+            return pointer;
+        }
+
+        void deallocate(void* pointer, size_t size, size_t alignment, AllocationCategory category)
+        {
+            m_BytesInUse[size_t(category)].fetch_sub(size, std::memory_order_relaxed);
+
+            if (m_Allocator)
+                m_Allocator->deallocate(pointer, size, alignment, category);
+            else if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ::operator delete(pointer, std::align_val_t(alignment));
+            else
+                ::operator delete(pointer);
+        }
+
+        [[nodiscard]] AllocationStatistics getStatistics() const
+        {
+            AllocationStatistics statistics;
+            for (size_t category = 0; category < size_t(AllocationCategory::Count); category++)
+                statistics.bytesInUse[category] = m_BytesInUse[category].load(std::memory_order_relaxed);
+            return statistics;
+        }
+
+    private:
+        IAllocator* m_Allocator;
+        std::array<std::atomic<uint64_t>, size_t(AllocationCategory::Count)> m_BytesInUse{};
+    };
+
+    // Standard allocator that allocates through an AllocationTracker under a fixed category.
+    // A default-constructed TrackedAllocator uses the global heap and counts nothing, so that containers
+    // that are not given a tracker keep working.
+    template<typename T>
+    class TrackedAllocator
+    {
+    public:
+        typedef T value_type;
+
+        TrackedAllocator() = default;
+        TrackedAllocator(AllocationTracker* tracker, AllocationCategory category)
+            : m_Tracker(tracker)
+            , m_Category(category)
+        { }
+
+        template<typename U>
+        TrackedAllocator(const TrackedAllocator<U>& other)
+            : m_Tracker(other.getTracker())
+            , m_Category(other.getCategory())
+        { }
+
+        T* allocate(size_t count)
+        {
+            if (!m_Tracker)
+                return std::allocator<T>().allocate(count);
+
+            return static_cast<T*>(m_Tracker->allocate(count * sizeof(T), alignof(T), m_Category));
+        }
+
+        void deallocate(T* pointer, size_t count)
+        {
+            if (!m_Tracker)
+                std::allocator<T>().deallocate(pointer, count);
+            else
+                m_Tracker->deallocate(pointer, count * sizeof(T), alignof(T), m_Category);
+        }
+
+        [[nodiscard]] AllocationTracker* getTracker() const { return m_Tracker; }
+        [[nodiscard]] AllocationCategory getCategory() const { return m_Category; }
+
+        // Memory must be freed under the category it was counted in, so allocators of different categories are not interchangeable
+        template<typename U> bool operator==(const TrackedAllocator<U>& other) const
+        {
+            return m_Tracker == other.getTracker() && m_Category == other.getCategory();
+        }
+        template<typename U> bool operator!=(const TrackedAllocator<U>& other) const { return !(*this == other); }
+
+    private:
+        AllocationTracker* m_Tracker = nullptr;
+        AllocationCategory m_Category = AllocationCategory::Other;
+    };
+
+    template<typename T>
+    using tracked_vector = std::vector<T, TrackedAllocator<T>>;
+
+    template<typename T>
+    using tracked_list = std::list<T, TrackedAllocator<T>>;
+
+    template<typename Key, typename Value, typename Hash = std::hash<Key>>
+    using tracked_unordered_map = std::unordered_map<Key, Value, Hash, std::equal_to<Key>, TrackedAllocator<std::pair<const Key, Value>>>;
+
+    template<typename T, typename... Args>
+    std::shared_ptr<T> make_tracked_shared(AllocationTracker* tracker, AllocationCategory category, Args&&... args)
+    {
+        return std::allocate_shared<T>(TrackedAllocator<T>(tracker, category), std::forward<Args>(args)...);
+    }
+} // namespace nvrhi
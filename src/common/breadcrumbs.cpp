@@ -0,0 +1,144 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/breadcrumbs.h>
+
+namespace nvrhi
+{
+    uint32_t BreadcrumbEncoder::getMarkerID(size_t markerHash)
+    {
+        // Zero means "never written", keep it out of the ID space
+        const uint32_t id = uint32_t(markerHash ^ (uint64_t(markerHash) >> 32));
+        return id ? id : 1;
+    }
+
+    BreadcrumbWrites BreadcrumbEncoder::begin(uint32_t slot, uint32_t commandListID)
+    {
+        m_SlotOffset = slot * c_BreadcrumbSlotSize;
+        m_CommandListID = commandListID ? commandListID : 1;
+        m_Depth = 0;
+
+        BreadcrumbWrites writes;
+        // Record the start and clear the rest of the slot to drop the scopes left by its previous user.
+        // The two ranges don't overlap, so the writes don't have to be ordered against each other.
+        writes.push_back(BreadcrumbWrite{ m_SlotOffset, sizeof(uint32_t), m_CommandListID, false });
+        writes.push_back(BreadcrumbWrite{ m_SlotOffset + uint32_t(sizeof(uint32_t)), c_BreadcrumbSlotSize - uint32_t(sizeof(uint32_t)), 0, false });
+        return writes;
+    }
+
+    BreadcrumbWrites BreadcrumbEncoder::end()
+    {
+        BreadcrumbWrites writes;
+        writes.push_back(BreadcrumbWrite{ m_SlotOffset + uint32_t(sizeof(uint32_t)), sizeof(uint32_t), m_CommandListID, true });
+        return writes;
+    }
+
+    BreadcrumbWrites BreadcrumbEncoder::pushMarker(size_t markerHash)
+    {
+        BreadcrumbWrites writes;
+        const uint32_t depth = m_Depth++;
+        if (depth >= c_BreadcrumbMaxDepth)
+            return writes;
+
+        const uint32_t markerID = getMarkerID(markerHash);
+        m_MarkerIDs[depth] = markerID;
+
+        const uint32_t offset = m_SlotOffset + (2 + 2 * depth) * uint32_t(sizeof(uint32_t));
+        writes.push_back(BreadcrumbWrite{ offset, sizeof(uint32_t), markerID, false });
+        // The end word may hold the same ID from an earlier scope with the same name
+        writes.push_back(BreadcrumbWrite{ offset + uint32_t(sizeof(uint32_t)), sizeof(uint32_t), 0, false });
+        return writes;
+    }
+
+    BreadcrumbWrites BreadcrumbEncoder::popMarker()
+    {
+        BreadcrumbWrites writes;
+        if (m_Depth == 0)
+            return writes;
+
+        const uint32_t depth = --m_Depth;
+        if (depth >= c_BreadcrumbMaxDepth)
+            return writes;
+
+        const uint32_t offset = m_SlotOffset + (3 + 2 * depth) * uint32_t(sizeof(uint32_t));
+        writes.push_back(BreadcrumbWrite{ offset, sizeof(uint32_t), m_MarkerIDs[depth], true });
+        return writes;
+    }
+
+    void decodeBreadcrumbs(const uint32_t* data, size_t numWords, std::vector<BreadcrumbCommandList>& outCommandLists)
+    {
+        for (size_t slotStart = 0; slotStart + c_BreadcrumbSlotWords <= numWords; slotStart += c_BreadcrumbSlotWords)
+        {
+            const uint32_t* slot = data + slotStart;
+            if (slot[0] == 0)
+                continue;
+
+            BreadcrumbCommandList commandList;
+            commandList.commandListID = slot[0];
+            commandList.finished = slot[1] == slot[0];
+
+            for (uint32_t depth = 0; depth < c_BreadcrumbMaxDepth; depth++)
+            {
+                const uint32_t begin = slot[2 + 2 * depth];
+                const uint32_t end = slot[3 + 2 * depth];
+                if (begin == 0)
+                    break;
+
+                BreadcrumbScope scope;
+                scope.markerID = begin;
+                scope.finished = end == begin;
+                commandList.scopes.push_back(scope);
+
+                // Anything deeper belongs to this scope or to its earlier siblings and is not interesting
+                if (scope.finished)
+                    break;
+            }
+
+            outCommandLists.push_back(std::move(commandList));
+        }
+    }
+
+    std::string formatBreadcrumbs(const std::vector<BreadcrumbCommandList>& commandLists,
+        const std::function<std::string(uint32_t)>& resolveMarker)
+    {
+        std::string result;
+
+        for (const BreadcrumbCommandList& commandList : commandLists)
+        {
+            result += "Command list " + std::to_string(commandList.commandListID);
+            result += commandList.finished ? ": finished\n" : ": not finished\n";
+
+            for (const BreadcrumbScope& scope : commandList.scopes)
+            {
+                std::string name = resolveMarker ? resolveMarker(scope.markerID) : std::string();
+                if (name.empty())
+                    name = "<unknown marker " + std::to_string(scope.markerID) + ">";
+
+                result += "    " + name;
+                result += scope.finished ? " (finished)\n" : " (in progress)\n";
+            }
+        }
+
+        return result;
+    }
+} // namespace nvrhi
@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "content-hash.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nvrhi
+{
+    static uint64_t rotl64(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t fmix64(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdull;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ull;
+        k ^= k >> 33;
+        return k;
+    }
+
+    ContentHash hashContents(const void* data, size_t size)
+    {
+        constexpr uint64_t c1 = 0x87c37b91114253d5ull;
+        constexpr uint64_t c2 = 0x4cf5ad432745937full;
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        const size_t numBlocks = size / 16;
+
+        uint64_t h1 = 0;
+        uint64_t h2 = 0;
+
+        for (size_t block = 0; block < numBlocks; ++block)
+        {
+            // memcpy avoids unaligned loads, the input is read as little-endian like on all supported platforms
+            uint64_t k1, k2;
+            memcpy(&k1, bytes + block * 16, sizeof(k1));
+            memcpy(&k2, bytes + block * 16 + 8, sizeof(k2));
+
+            k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+            h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+            k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+            h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+        }
+
+        const uint8_t* tail = bytes + numBlocks * 16;
+        const size_t tailSize = size & 15;
+
+        uint64_t k1 = 0;
+        uint64_t k2 = 0;
+
+        for (size_t i = tailSize; i > 8; --i)
+            k2 ^= uint64_t(tail[i - 1]) << ((i - 9) * 8);
+
+        if (tailSize > 8)
+        {
+            k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        }
+
+        for (size_t i = std::min<size_t>(tailSize, 8); i > 0; --i)
+            k1 ^= uint64_t(tail[i - 1]) << ((i - 1) * 8);
+
+        if (tailSize > 0)
+        {
+            k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        }
+
+        h1 ^= uint64_t(size);
+        h2 ^= uint64_t(size);
+
+        h1 += h2;
+        h2 += h1;
+
+        h1 = fmix64(h1);
+        h2 = fmix64(h2);
+
+        h1 += h2;
+        h2 += h1;
+
+        ContentHash hash;
+        hash.low = h1;
+        hash.high = h2;
+        return hash;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace nvrhi
+{
+    // A 128-bit hash of a block of memory (MurmurHash3 x64_128), for identifying large binaries such as
+    // shader bytecode by their contents when keeping a copy to compare against would cost too much memory.
+    // It is not a cryptographic hash, but accidental collisions between different inputs are negligible.
+    struct ContentHash
+    {
+        uint64_t low = 0;
+        uint64_t high = 0;
+
+        bool operator==(const ContentHash& other) const { return low == other.low && high == other.high; }
+        bool operator!=(const ContentHash& other) const { return !(*this == other); }
+    };
+
+    [[nodiscard]] ContentHash hashContents(const void* data, size_t size);
+}
+
+namespace std
+{
+    template<> struct hash<nvrhi::ContentHash>
+    {
+        std::size_t operator()(nvrhi::ContentHash const& s) const noexcept
+        {
+            // The bits are already well mixed
+            return size_t(s.low ^ s.high);
+        }
+    };
+}
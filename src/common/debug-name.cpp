@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/debug-name.h>
+
+#include <array>
+#include <atomic>
+
+namespace nvrhi
+{
+    namespace
+    {
+        struct InternedName
+        {
+            size_t hash;
+            std::string string;
+            InternedName* next;
+        };
+
+        constexpr size_t c_NumBuckets = 4096;
+
+        // Each bucket is a singly linked list that only ever grows at the head, so readers can walk
+        // it without locking while writers publish new entries with a compare-and-swap.
+        // The table is intentionally leaked to keep the names valid during static destruction.
+        std::array<std::atomic<InternedName*>, c_NumBuckets>& getBuckets()
+        {
+            static auto* buckets = new std::array<std::atomic<InternedName*>, c_NumBuckets>();
+            return *buckets;
+        }
+
+        InternedName* findName(InternedName* head, InternedName* stop, size_t hash, std::string_view name)
+        {
+            for (InternedName* entry = head; entry != stop; entry = entry->next)
+            {
+                if (entry->hash == hash && entry->string == name)
+                    return entry;
+            }
+            return nullptr;
+        }
+    }
+
+    const std::string* DebugName::intern(std::string_view name)
+    {
+        if (name.empty())
+            return nullptr;
+
+        const size_t hash = std::hash<std::string_view>()(name);
+        std::atomic<InternedName*>& bucket = getBuckets()[hash % c_NumBuckets];
+
+        InternedName* head = bucket.load(std::memory_order_acquire);
+        if (InternedName* existing = findName(head, nullptr, hash, name))
+            return &existing->string;
+
+        auto* entry = new InternedName{ hash, std::string(name), head };
+        while (!bucket.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_acquire))
+        {
+            // Another thread has published new entries since we looked - check only those.
+            if (InternedName* existing = findName(entry->next, head, hash, name))
+            {
+                delete entry;
+                return &existing->string;
+            }
+            head = entry->next;
+        }
+
+        return &entry->string;
+    }
+
+    const std::string& DebugName::getEmptyString()
+    {
+        static const std::string empty;
+        return empty;
+    }
+}
@@ -0,0 +1,277 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/draw-batcher.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cstring>
+
+namespace nvrhi
+{
+    namespace
+    {
+        // Indexed and non-indexed argument records share the buffers, so size them for the larger record
+        constexpr uint32_t c_MaxArgumentSize = uint32_t(std::max(sizeof(DrawIndirectArguments), sizeof(DrawIndexedIndirectArguments)));
+
+        bool statesAreEqual(const GraphicsState& a, const GraphicsState& b)
+        {
+            // indirectParams is owned by the batcher and not compared
+            return a.pipeline == b.pipeline
+                && a.framebuffer == b.framebuffer
+                && !arraysAreDifferent(a.viewport.viewports, b.viewport.viewports)
+                && !arraysAreDifferent(a.viewport.scissorRects, b.viewport.scissorRects)
+                && a.shadingRateState == b.shadingRateState
+                && a.blendConstantColor == b.blendConstantColor
+                && a.dynamicStencilRefValue == b.dynamicStencilRefValue
+                && a.dynamicRenderState == b.dynamicRenderState
+                && !arraysAreDifferent(a.bindings, b.bindings)
+                && !arraysAreDifferent(a.vertexBuffers, b.vertexBuffers)
+                && a.indexBuffer == b.indexBuffer
+                && a.indirectCountBuffer == b.indirectCountBuffer;
+        }
+    }
+
+    DrawBatcher::DrawBatcher(IDevice* device, const DrawBatcherDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_MultiDrawIndirect(device->queryFeatureSupport(Feature::MultiDrawIndirect))
+    {
+        if (m_Desc.drawsPerBuffer == 0)
+            m_Desc.drawsPerBuffer = 1;
+    }
+
+    void DrawBatcher::begin(ICommandList* commandList)
+    {
+        m_CommandList = commandList;
+        m_CurrentBuffer = 0;
+        m_CurrentBufferOffset = 0;
+        m_StateValid = false;
+        m_BatchType = BatchType::None;
+        m_PendingDraws.clear();
+    }
+
+    void DrawBatcher::end()
+    {
+        flush();
+        m_CommandList = nullptr;
+        m_StateValid = false;
+        m_State = GraphicsState();
+    }
+
+    void DrawBatcher::setGraphicsState(const GraphicsState& state)
+    {
+        if (m_StateValid && statesAreEqual(m_State, state))
+            return;
+
+        flush();
+
+        m_State = state;
+        m_State.indirectParams = nullptr;
+        m_StateValid = true;
+    }
+
+    void DrawBatcher::draw(const DrawArguments& args)
+    {
+        addDraw(BatchType::Draw, args);
+    }
+
+    void DrawBatcher::drawIndexed(const DrawArguments& args)
+    {
+        addDraw(BatchType::DrawIndexed, args);
+    }
+
+    void DrawBatcher::addDraw(BatchType type, const DrawArguments& args)
+    {
+        if (!m_CommandList || !m_StateValid)
+        {
+            if (IMessageCallback* messageCallback = m_Device->getMessageCallback())
+                messageCallback->message(MessageSeverity::Error, "DrawBatcher: draw called before begin or setGraphicsState");
+            return;
+        }
+
+        if (type != m_BatchType)
+        {
+            flush();
+            m_BatchType = type;
+        }
+
+        m_PendingDraws.push_back(args);
+        ++m_Statistics.draws;
+    }
+
+    void DrawBatcher::flush()
+    {
+        if (m_PendingDraws.empty())
+            return;
+
+        const uint32_t drawCount = uint32_t(m_PendingDraws.size());
+
+        if (drawCount < m_Desc.minIndirectBatchSize)
+        {
+            submitDirect(0, drawCount);
+        }
+        else
+        {
+            for (uint32_t firstDraw = 0; firstDraw < drawCount; firstDraw += m_Desc.drawsPerBuffer)
+            {
+                submitIndirect(firstDraw, std::min(drawCount - firstDraw, m_Desc.drawsPerBuffer));
+            }
+        }
+
+        m_PendingDraws.clear();
+    }
+
+    void DrawBatcher::submitDirect(uint32_t firstDraw, uint32_t drawCount)
+    {
+        m_CommandList->setGraphicsState(m_State);
+
+        for (uint32_t i = firstDraw; i < firstDraw + drawCount; ++i)
+        {
+            if (m_BatchType == BatchType::DrawIndexed)
+                m_CommandList->drawIndexed(m_PendingDraws[i]);
+            else
+                m_CommandList->draw(m_PendingDraws[i]);
+        }
+
+        m_Statistics.directCalls += drawCount;
+    }
+
+    void DrawBatcher::submitIndirect(uint32_t firstDraw, uint32_t drawCount)
+    {
+        const bool indexed = m_BatchType == BatchType::DrawIndexed;
+        const uint32_t stride = indexed ? uint32_t(sizeof(DrawIndexedIndirectArguments)) : uint32_t(sizeof(DrawIndirectArguments));
+        const uint32_t byteSize = drawCount * stride;
+
+        // Write the arguments straight into upload memory where the backend allows it, which keeps the render pass
+        // going on Vulkan. Otherwise, stage them for writeBuffer into one of the batcher's argument buffers.
+        uint64_t offset = 0;
+        void* cpuAddress = nullptr;
+        IBuffer* buffer = m_CommandList->allocateIndirectArguments(byteSize, &offset, &cpuAddress);
+        const bool staged = !buffer;
+
+        if (staged)
+        {
+            uint32_t bufferOffset = 0;
+            buffer = allocateArguments(byteSize, bufferOffset);
+            if (!buffer)
+            {
+                if (!m_ArgumentBufferFailureReported)
+                {
+                    if (IMessageCallback* messageCallback = m_Device->getMessageCallback())
+                        messageCallback->message(MessageSeverity::Warning, "DrawBatcher: cannot create an indirect argument buffer, issuing the draws one at a time");
+                    m_ArgumentBufferFailureReported = true;
+                }
+
+                submitDirect(firstDraw, drawCount);
+                return;
+            }
+
+            offset = bufferOffset;
+            m_ArgumentData.resize(byteSize);
+        }
+
+        uint8_t* dest = staged ? m_ArgumentData.data() : static_cast<uint8_t*>(cpuAddress);
+
+        for (uint32_t i = firstDraw; i < firstDraw + drawCount; ++i)
+        {
+            const DrawArguments& args = m_PendingDraws[i];
+
+            if (indexed)
+            {
+                DrawIndexedIndirectArguments record;
+                record.indexCount = args.vertexCount;
+                record.instanceCount = args.instanceCount;
+                record.startIndexLocation = args.startIndexLocation;
+                record.baseVertexLocation = int32_t(args.startVertexLocation);
+                record.startInstanceLocation = args.startInstanceLocation;
+                memcpy(dest, &record, sizeof(record));
+            }
+            else
+            {
+                DrawIndirectArguments record;
+                record.vertexCount = args.vertexCount;
+                record.instanceCount = args.instanceCount;
+                record.startVertexLocation = args.startVertexLocation;
+                record.startInstanceLocation = args.startInstanceLocation;
+                memcpy(dest, &record, sizeof(record));
+            }
+
+            dest += stride;
+        }
+
+        if (staged)
+            m_CommandList->writeBuffer(buffer, m_ArgumentData.data(), byteSize, offset);
+
+        m_State.indirectParams = buffer;
+        m_CommandList->setGraphicsState(m_State);
+        m_State.indirectParams = nullptr;
+
+        // More than one draw per indirect call needs the multiDrawIndirect feature on Vulkan
+        const uint32_t drawsPerCall = m_MultiDrawIndirect ? drawCount : 1;
+
+        for (uint32_t first = 0; first < drawCount; first += drawsPerCall)
+        {
+            const uint32_t callOffset = uint32_t(offset) + first * stride;
+
+            if (indexed)
+                m_CommandList->drawIndexedIndirect(callOffset, drawsPerCall);
+            else
+                m_CommandList->drawIndirect(callOffset, drawsPerCall);
+
+            ++m_Statistics.indirectCalls;
+        }
+    }
+
+    IBuffer* DrawBatcher::allocateArguments(uint32_t byteSize, uint32_t& outOffset)
+    {
+        const uint32_t bufferSize = m_Desc.drawsPerBuffer * c_MaxArgumentSize;
+        assert(byteSize <= bufferSize);
+
+        if (m_CurrentBuffer < uint32_t(m_ArgumentBuffers.size()) && m_CurrentBufferOffset + byteSize > bufferSize)
+        {
+            ++m_CurrentBuffer;
+            m_CurrentBufferOffset = 0;
+        }
+
+        if (m_CurrentBuffer == uint32_t(m_ArgumentBuffers.size()))
+        {
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = bufferSize;
+            bufferDesc.isDrawIndirectArgs = true;
+            bufferDesc.initialState = ResourceStates::IndirectArgument;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = m_Desc.debugName;
+
+            BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+            if (!buffer)
+                return nullptr;
+
+            m_ArgumentBuffers.push_back(buffer);
+        }
+
+        outOffset = m_CurrentBufferOffset;
+        m_CurrentBufferOffset += byteSize;
+
+        return m_ArgumentBuffers[m_CurrentBuffer];
+    }
+}
@@ -0,0 +1,254 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/frame-manager.h>
+
+namespace nvrhi
+{
+    namespace
+    {
+        constexpr float c_StatisticsSmoothing = 0.1f;
+
+        float toMilliseconds(std::chrono::steady_clock::duration duration)
+        {
+            return std::chrono::duration<float, std::milli>(duration).count();
+        }
+
+        void updateAverage(float& average, float value, bool firstSample)
+        {
+            average = firstSample ? value : average + (value - average) * c_StatisticsSmoothing;
+        }
+    }
+
+    FrameManager::FrameManager(IDevice* device, const FrameManagerDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        if (m_Desc.maxFramesInFlight == 0)
+            m_Desc.maxFramesInFlight = 1;
+
+        // The queues may have been listed directly rather than through addQueue
+        m_Desc.queues.resize(0);
+        for (CommandQueue queue : desc.queues)
+            m_Desc.addQueue(queue);
+    }
+
+    FrameManager::~FrameManager()
+    {
+        waitForAllFrames();
+    }
+
+    bool FrameManager::isFrameCompleted(const Frame& frame) const
+    {
+        for (const EventQueryHandle& query : frame.queries)
+        {
+            if (!m_Device->pollEventQuery(query))
+                return false;
+        }
+
+        return true;
+    }
+
+    void FrameManager::waitForFrame(const Frame& frame) const
+    {
+        for (const EventQueryHandle& query : frame.queries)
+        {
+            m_Device->waitEventQuery(query);
+        }
+    }
+
+    void FrameManager::retireFrame(Frame& frame)
+    {
+        for (const auto& callback : frame.callbacks)
+        {
+            callback();
+        }
+
+        frame.callbacks.clear();
+        frame.releases.clear();
+
+        for (const EventQueryHandle& query : frame.queries)
+        {
+            m_Device->resetEventQuery(query);
+            m_FreeQueries.push_back(query);
+        }
+
+        frame.queries.resize(0);
+
+        ++m_Statistics.framesCompleted;
+    }
+
+    uint32_t FrameManager::retireCompletedFrames()
+    {
+        uint32_t retired = 0;
+
+        while (!m_PendingFrames.empty() && isFrameCompleted(m_PendingFrames.front()))
+        {
+            retireFrame(m_PendingFrames.front());
+            m_PendingFrames.pop_front();
+            ++retired;
+        }
+
+        updateGpuIdleState();
+
+        return retired;
+    }
+
+    void FrameManager::updateGpuIdleState()
+    {
+        if (m_PendingFrames.empty() && !m_GpuIdle)
+        {
+            m_GpuIdle = true;
+            m_GpuIdleSince = Clock::now();
+        }
+    }
+
+    void FrameManager::beginFrame()
+    {
+        uint32_t retired = retireCompletedFrames();
+
+        const Clock::time_point waitStart = Clock::now();
+        bool waited = false;
+
+        while (m_PendingFrames.size() >= m_Desc.maxFramesInFlight)
+        {
+            waitForFrame(m_PendingFrames.front());
+            retireFrame(m_PendingFrames.front());
+            m_PendingFrames.pop_front();
+            ++retired;
+            waited = true;
+        }
+
+        updateGpuIdleState();
+
+        const float waitMs = waited ? toMilliseconds(Clock::now() - waitStart) : 0.f;
+        m_Statistics.lastCpuWaitMs = waitMs;
+        m_Statistics.totalCpuWaitMs += double(waitMs);
+        updateAverage(m_Statistics.averageCpuWaitMs, waitMs, m_Statistics.framesStarted == 0);
+
+        if (m_Desc.runGarbageCollection && retired > 0)
+            m_Device->runGarbageCollection();
+
+        ++m_Statistics.framesStarted;
+        m_InFrame = true;
+    }
+
+    void FrameManager::endFrame()
+    {
+        if (!m_InFrame)
+        {
+            if (IMessageCallback* messageCallback = m_Device->getMessageCallback())
+                messageCallback->message(MessageSeverity::Warning, "FrameManager::endFrame called without a matching beginFrame");
+            return;
+        }
+
+        // Observe the completion of earlier frames before this one is added, for the GPU idle estimate
+        retireCompletedFrames();
+
+        Frame frame;
+
+        for (CommandQueue queue : m_Desc.queues)
+        {
+            EventQueryHandle query;
+            if (m_FreeQueries.empty())
+            {
+                query = m_Device->createEventQuery();
+            }
+            else
+            {
+                query = std::move(m_FreeQueries.back());
+                m_FreeQueries.pop_back();
+            }
+
+            m_Device->setEventQuery(query, queue);
+            frame.queries.push_back(query);
+        }
+
+        {
+            std::lock_guard lock(m_DeferredMutex);
+            frame.releases = std::move(m_CurrentFrame.releases);
+            frame.callbacks = std::move(m_CurrentFrame.callbacks);
+            m_CurrentFrame.releases.clear();
+            m_CurrentFrame.callbacks.clear();
+        }
+
+        float idleMs = 0.f;
+        if (m_GpuIdle)
+        {
+            idleMs = toMilliseconds(Clock::now() - m_GpuIdleSince);
+            m_GpuIdle = false;
+        }
+
+        m_Statistics.lastGpuIdleMs = idleMs;
+        m_Statistics.totalGpuIdleMs += double(idleMs);
+        updateAverage(m_Statistics.averageGpuIdleMs, idleMs, m_Statistics.framesStarted == 1);
+
+        m_PendingFrames.push_back(std::move(frame));
+        m_InFrame = false;
+    }
+
+    void FrameManager::deferRelease(IResource* resource)
+    {
+        if (!resource)
+            return;
+
+        std::lock_guard lock(m_DeferredMutex);
+        m_CurrentFrame.releases.emplace_back(resource);
+    }
+
+    void FrameManager::deferCallback(std::function<void()> callback)
+    {
+        if (!callback)
+            return;
+
+        std::lock_guard lock(m_DeferredMutex);
+        m_CurrentFrame.callbacks.push_back(std::move(callback));
+    }
+
+    void FrameManager::waitForAllFrames()
+    {
+        if (m_PendingFrames.empty())
+            return;
+
+        while (!m_PendingFrames.empty())
+        {
+            waitForFrame(m_PendingFrames.front());
+            retireFrame(m_PendingFrames.front());
+            m_PendingFrames.pop_front();
+        }
+
+        updateGpuIdleState();
+
+        if (m_Desc.runGarbageCollection)
+            m_Device->runGarbageCollection();
+    }
+
+    void FrameManager::resetStatistics()
+    {
+        const uint64_t framesStarted = m_Statistics.framesStarted;
+        const uint64_t framesCompleted = m_Statistics.framesCompleted;
+
+        m_Statistics = FrameStatistics();
+        m_Statistics.framesStarted = framesStarted;
+        m_Statistics.framesCompleted = framesCompleted;
+    }
+}
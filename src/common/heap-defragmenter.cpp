@@ -0,0 +1,637 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/heap-defragmenter.h>
+#include <algorithm>
+#include <numeric>
+
+namespace nvrhi
+{
+    namespace
+    {
+        struct Range
+        {
+            uint64_t begin;
+            uint64_t end;
+
+            bool operator<(const Range& other) const
+            {
+                return begin < other.begin || (begin == other.begin && end < other.end);
+            }
+        };
+
+        uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+        }
+
+        void insertRange(std::vector<Range>& ranges, Range range)
+        {
+            ranges.insert(std::upper_bound(ranges.begin(), ranges.end(), range), range);
+        }
+
+        // Returns the lowest aligned offset of a free range that fits size, or capacity if there is none.
+        // The ranges are sorted by begin and may overlap.
+        uint64_t findFreeRange(const std::vector<Range>& ranges, uint64_t capacity, uint64_t size, uint64_t alignment)
+        {
+            uint64_t cursor = 0;
+            for (const Range& range : ranges)
+            {
+                const uint64_t offset = alignUp(cursor, alignment);
+                if (offset + size <= range.begin)
+                    return offset;
+
+                cursor = std::max(cursor, range.end);
+            }
+
+            const uint64_t offset = alignUp(cursor, alignment);
+            if (offset + size <= capacity)
+                return offset;
+
+            return capacity;
+        }
+    }
+
+    void planHeapDefragmentation(const std::vector<uint64_t>& heapCapacities,
+        const std::vector<DefragmentationAllocation>& allocations, uint32_t maxPasses,
+        std::vector<DefragmentationMove>& outMoves)
+    {
+        const uint32_t numHeaps = uint32_t(heapCapacities.size());
+        const uint32_t numAllocations = uint32_t(allocations.size());
+
+        std::vector<uint64_t> usedBytes(numHeaps, 0);
+        for (const DefragmentationAllocation& allocation : allocations)
+        {
+            if (allocation.heap < numHeaps)
+                usedBytes[allocation.heap] += allocation.size;
+        }
+
+        // Fullest heaps first, they are the ones that the others are emptied into
+        std::vector<uint32_t> heapsByRank(numHeaps);
+        std::iota(heapsByRank.begin(), heapsByRank.end(), 0);
+        std::stable_sort(heapsByRank.begin(), heapsByRank.end(), [&usedBytes](uint32_t a, uint32_t b)
+        {
+            return usedBytes[a] > usedBytes[b];
+        });
+
+        std::vector<uint32_t> heapRanks(numHeaps);
+        for (uint32_t rank = 0; rank < numHeaps; ++rank)
+            heapRanks[heapsByRank[rank]] = rank;
+
+        std::vector<uint32_t> heaps(numAllocations);
+        std::vector<uint64_t> offsets(numAllocations);
+        std::vector<bool> movable(numAllocations);
+
+        for (uint32_t index = 0; index < numAllocations; ++index)
+        {
+            const DefragmentationAllocation& allocation = allocations[index];
+            heaps[index] = allocation.heap;
+            offsets[index] = allocation.offset;
+            movable[index] = allocation.movable && allocation.size != 0 && allocation.heap < numHeaps;
+        }
+
+        // Aliased allocations would stop sharing memory if they were moved separately, so they stay in place
+        {
+            std::vector<uint32_t> byPlacement(numAllocations);
+            std::iota(byPlacement.begin(), byPlacement.end(), 0);
+            std::sort(byPlacement.begin(), byPlacement.end(), [&](uint32_t a, uint32_t b)
+            {
+                if (heaps[a] != heaps[b])
+                    return heaps[a] < heaps[b];
+                if (offsets[a] != offsets[b])
+                    return offsets[a] < offsets[b];
+                return a < b;
+            });
+
+            uint32_t previous = numAllocations;
+            for (uint32_t index : byPlacement)
+            {
+                if (allocations[index].size == 0)
+                    continue;
+
+                if (previous != numAllocations && heaps[previous] == heaps[index] &&
+                    offsets[previous] + allocations[previous].size > offsets[index])
+                {
+                    movable[previous] = false;
+                    movable[index] = false;
+                }
+
+                // Keep the allocation that reaches the furthest, it is the one that later ones can overlap
+                if (previous == numAllocations || heaps[previous] != heaps[index] ||
+                    offsets[index] + allocations[index].size > offsets[previous] + allocations[previous].size)
+                    previous = index;
+            }
+        }
+
+        std::vector<std::vector<Range>> ranges(numHeaps);
+        std::vector<uint32_t> order;
+        std::vector<DefragmentationMove> passMoves;
+
+        for (uint32_t pass = 0; pass < maxPasses; ++pass)
+        {
+            for (std::vector<Range>& heapRanges : ranges)
+                heapRanges.clear();
+
+            for (uint32_t index = 0; index < numAllocations; ++index)
+            {
+                if (heaps[index] < numHeaps && allocations[index].size != 0)
+                    insertRange(ranges[heaps[index]], Range{ offsets[index], offsets[index] + allocations[index].size });
+            }
+
+            // Worst placements first: least used heaps, highest offsets
+            order.clear();
+            for (uint32_t index = 0; index < numAllocations; ++index)
+            {
+                if (movable[index])
+                    order.push_back(index);
+            }
+
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+            {
+                if (heapRanks[heaps[a]] != heapRanks[heaps[b]])
+                    return heapRanks[heaps[a]] > heapRanks[heaps[b]];
+                if (offsets[a] != offsets[b])
+                    return offsets[a] > offsets[b];
+                return a < b;
+            });
+
+            passMoves.clear();
+
+            for (uint32_t index : order)
+            {
+                const DefragmentationAllocation& allocation = allocations[index];
+                const uint32_t currentRank = heapRanks[heaps[index]];
+
+                for (uint32_t rank = 0; rank <= currentRank; ++rank)
+                {
+                    const uint32_t heap = heapsByRank[rank];
+                    const uint64_t capacity = heapCapacities[heap];
+                    const uint64_t offset = findFreeRange(ranges[heap], capacity, allocation.size, allocation.alignment);
+
+                    if (offset == capacity)
+                        continue;
+
+                    // The current placement is as good as it gets
+                    if (rank == currentRank && offset >= offsets[index])
+                        break;
+
+                    // Sources stay in use until the end of the pass, so only the destination is added
+                    insertRange(ranges[heap], Range{ offset, offset + allocation.size });
+                    passMoves.push_back(DefragmentationMove{ index, pass, heap, offset });
+                    break;
+                }
+            }
+
+            if (passMoves.empty())
+                break;
+
+            for (const DefragmentationMove& move : passMoves)
+            {
+                heaps[move.allocation] = move.heap;
+                offsets[move.allocation] = move.offset;
+            }
+
+            outMoves.insert(outMoves.end(), passMoves.begin(), passMoves.end());
+        }
+    }
+
+    HeapDefragmenter::HeapDefragmenter(IDevice* device, const HeapDefragmenterDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        m_CommandList = m_Device->createCommandList(CommandListParameters()
+            .setQueueType(m_Desc.queue)
+            .setEnableImmediateExecution(false));
+
+        // The application may use the old resources on any queue
+        m_RetireQueries.push_back(RetireQuery{ CommandQueue::Graphics, m_Device->createEventQuery() });
+        if (m_Device->queryFeatureSupport(Feature::ComputeQueue))
+            m_RetireQueries.push_back(RetireQuery{ CommandQueue::Compute, m_Device->createEventQuery() });
+        if (m_Device->queryFeatureSupport(Feature::CopyQueue))
+            m_RetireQueries.push_back(RetireQuery{ CommandQueue::Copy, m_Device->createEventQuery() });
+    }
+
+    void HeapDefragmenter::warning(const char* message) const
+    {
+        if (IMessageCallback* messageCallback = m_Device->getMessageCallback())
+            messageCallback->message(MessageSeverity::Warning, message);
+    }
+
+    bool HeapDefragmenter::isValid(DefragResourceID resource) const
+    {
+        return resource < DefragResourceID(m_Slots.size()) && m_Slots[resource].active;
+    }
+
+    uint32_t HeapDefragmenter::findHeap(IHeap* heap) const
+    {
+        for (uint32_t index = 0; index < uint32_t(m_Heaps.size()); ++index)
+        {
+            if (m_Heaps[index] == heap)
+                return index;
+        }
+
+        return uint32_t(m_Heaps.size());
+    }
+
+    void HeapDefragmenter::addHeap(IHeap* heap)
+    {
+        if (!heap || findHeap(heap) != uint32_t(m_Heaps.size()))
+            return;
+
+        // Reuse a removed entry so that the indices in the slots stay valid
+        const uint32_t index = findHeap(nullptr);
+        if (index != uint32_t(m_Heaps.size()))
+            m_Heaps[index] = heap;
+        else
+            m_Heaps.push_back(heap);
+    }
+
+    bool HeapDefragmenter::removeHeap(IHeap* heap)
+    {
+        const uint32_t index = findHeap(heap);
+        if (!heap || index == uint32_t(m_Heaps.size()))
+            return false;
+
+        if (m_Defragmenting || !isHeapEmpty(heap))
+            return false;
+
+        m_Heaps[index] = nullptr;
+        return true;
+    }
+
+    bool HeapDefragmenter::isHeapEmpty(IHeap* heap) const
+    {
+        const uint32_t index = findHeap(heap);
+        if (!heap || index == uint32_t(m_Heaps.size()))
+            return true;
+
+        for (const Slot& slot : m_Slots)
+        {
+            if (slot.active && slot.heap == index)
+                return false;
+        }
+
+        for (size_t moveIndex = m_NextMove; moveIndex < m_Moves.size(); ++moveIndex)
+        {
+            if (m_Moves[moveIndex].heap == index)
+                return false;
+        }
+
+        return true;
+    }
+
+    DefragResourceID HeapDefragmenter::addResource(IBuffer* buffer, ITexture* texture, IHeap* heap, uint64_t offset, const MemoryRequirements& memReq, bool movable)
+    {
+        addHeap(heap);
+
+        DefragResourceID id;
+        if (!m_FreeSlots.empty())
+        {
+            id = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            id = DefragResourceID(m_Slots.size());
+            m_Slots.emplace_back();
+        }
+
+        Slot& slot = m_Slots[id];
+        slot.buffer = buffer;
+        slot.texture = texture;
+        slot.heap = findHeap(heap);
+        slot.offset = offset;
+        slot.size = memReq.size;
+        slot.alignment = std::max<uint64_t>(memReq.alignment, 1);
+        ++slot.generation;
+        slot.movable = movable;
+        slot.active = true;
+
+        return id;
+    }
+
+    DefragResourceID HeapDefragmenter::addBuffer(IBuffer* buffer, IHeap* heap, uint64_t offset)
+    {
+        if (!buffer || !heap)
+            return c_InvalidDefragResource;
+
+        const BufferDesc& desc = buffer->getDesc();
+        if (!desc.isVirtual || !desc.keepInitialState)
+        {
+            warning("HeapDefragmenter: buffers must be created with isVirtual and keepInitialState");
+            return c_InvalidDefragResource;
+        }
+
+        return addResource(buffer, nullptr, heap, offset, m_Device->getBufferMemoryRequirements(buffer), true);
+    }
+
+    DefragResourceID HeapDefragmenter::addTexture(ITexture* texture, IHeap* heap, uint64_t offset)
+    {
+        if (!texture || !heap)
+            return c_InvalidDefragResource;
+
+        const TextureDesc& desc = texture->getDesc();
+        if (!desc.isVirtual || !desc.keepInitialState)
+        {
+            warning("HeapDefragmenter: textures must be created with isVirtual and keepInitialState");
+            return c_InvalidDefragResource;
+        }
+
+        // copyTexture doesn't support multisampled textures
+        const bool movable = desc.sampleCount <= 1;
+
+        return addResource(nullptr, texture, heap, offset, m_Device->getTextureMemoryRequirements(texture), movable);
+    }
+
+    void HeapDefragmenter::removeResource(DefragResourceID resource)
+    {
+        if (!isValid(resource))
+            return;
+
+        // Moves that are planned or in flight are recognized by the generation and dropped
+        Slot& slot = m_Slots[resource];
+        slot.buffer = nullptr;
+        slot.texture = nullptr;
+        slot.active = false;
+        m_FreeSlots.push_back(resource);
+    }
+
+    void HeapDefragmenter::setResourceMovable(DefragResourceID resource, bool movable)
+    {
+        if (!isValid(resource))
+            return;
+
+        Slot& slot = m_Slots[resource];
+        slot.movable = movable;
+
+        if (movable || !m_Defragmenting)
+            return;
+
+        // The pending move is skipped by update, and the passes after it assume that the resource has moved
+        for (size_t moveIndex = m_NextMove; moveIndex < m_Moves.size(); ++moveIndex)
+        {
+            const Move& move = m_Moves[moveIndex];
+            if (move.resource == resource && move.generation == slot.generation)
+            {
+                cancelLaterPasses(move.pass);
+                break;
+            }
+        }
+    }
+
+    void HeapDefragmenter::cancelLaterPasses(uint32_t pass)
+    {
+        m_Moves.erase(std::remove_if(m_Moves.begin() + m_NextMove, m_Moves.end(),
+            [pass](const Move& other) { return other.pass > pass; }), m_Moves.end());
+
+        m_Statistics.pendingMoves = uint32_t(m_Moves.size() - m_NextMove);
+    }
+
+    IBuffer* HeapDefragmenter::getBuffer(DefragResourceID resource) const
+    {
+        return isValid(resource) ? m_Slots[resource].buffer.Get() : nullptr;
+    }
+
+    ITexture* HeapDefragmenter::getTexture(DefragResourceID resource) const
+    {
+        return isValid(resource) ? m_Slots[resource].texture.Get() : nullptr;
+    }
+
+    void HeapDefragmenter::beginDefragmentation()
+    {
+        if (m_Defragmenting)
+            return;
+
+        std::vector<uint64_t> capacities(m_Heaps.size(), 0);
+        for (size_t index = 0; index < m_Heaps.size(); ++index)
+        {
+            if (m_Heaps[index])
+                capacities[index] = m_Heaps[index]->getDesc().capacity;
+        }
+
+        std::vector<DefragmentationAllocation> allocations;
+        std::vector<DefragResourceID> resources;
+        for (DefragResourceID id = 0; id < DefragResourceID(m_Slots.size()); ++id)
+        {
+            const Slot& slot = m_Slots[id];
+            if (!slot.active)
+                continue;
+
+            DefragmentationAllocation allocation;
+            allocation.heap = slot.heap;
+            allocation.offset = slot.offset;
+            allocation.size = slot.size;
+            allocation.alignment = slot.alignment;
+            allocation.movable = slot.movable;
+            allocations.push_back(allocation);
+            resources.push_back(id);
+        }
+
+        std::vector<DefragmentationMove> moves;
+        planHeapDefragmentation(capacities, allocations, m_Desc.maxPasses, moves);
+
+        m_Moves.clear();
+        for (const DefragmentationMove& move : moves)
+        {
+            const DefragResourceID id = resources[move.allocation];
+            m_Moves.push_back(Move{ id, m_Slots[id].generation, move.pass, move.heap, move.offset });
+        }
+
+        m_NextMove = 0;
+        m_Defragmenting = !m_Moves.empty();
+        m_Statistics.pendingMoves = uint32_t(m_Moves.size());
+        m_Statistics.currentPass = 0;
+    }
+
+    bool HeapDefragmenter::recordMove(const Move& move)
+    {
+        const Slot& slot = m_Slots[move.resource];
+        IHeap* heap = m_Heaps[move.heap];
+
+        CopiedMove copied{ move.resource, move.generation, nullptr, nullptr, move.heap, move.offset };
+
+        if (slot.buffer)
+        {
+            const BufferDesc& desc = slot.buffer->getDesc();
+
+            copied.buffer = m_Device->createBuffer(desc);
+            if (!copied.buffer || !m_Device->bindBufferMemory(copied.buffer, heap, move.offset))
+                return false;
+
+            m_CommandList->copyBuffer(copied.buffer, 0, slot.buffer, 0, desc.byteSize);
+        }
+        else
+        {
+            const TextureDesc& desc = slot.texture->getDesc();
+
+            copied.texture = m_Device->createTexture(desc);
+            if (!copied.texture || !m_Device->bindTextureMemory(copied.texture, heap, move.offset))
+                return false;
+
+            // Default slices cover the whole mip level, including all depth slices of 3D textures
+            const ArraySlice arraySize = desc.dimension == TextureDimension::Texture3D ? 1 : desc.arraySize;
+            for (MipLevel mipLevel = 0; mipLevel < desc.mipLevels; ++mipLevel)
+            {
+                for (ArraySlice arraySlice = 0; arraySlice < arraySize; ++arraySlice)
+                {
+                    const TextureSlice textureSlice = TextureSlice().setMipLevel(mipLevel).setArraySlice(arraySlice);
+                    m_CommandList->copyTexture(copied.texture, textureSlice, slot.texture, textureSlice);
+                }
+            }
+        }
+
+        m_CopiedMoves.push_back(std::move(copied));
+        return true;
+    }
+
+    void HeapDefragmenter::relocateCopiedMoves()
+    {
+        for (CopiedMove& copied : m_CopiedMoves)
+        {
+            if (!isValid(copied.resource) || m_Slots[copied.resource].generation != copied.generation)
+                continue;
+
+            Slot& slot = m_Slots[copied.resource];
+
+            RelocatedResource relocation;
+            relocation.id = copied.resource;
+            relocation.oldBuffer = std::move(slot.buffer);
+            relocation.newBuffer = copied.buffer;
+            relocation.oldTexture = std::move(slot.texture);
+            relocation.newTexture = copied.texture;
+            relocation.heap = m_Heaps[copied.heap];
+            relocation.offset = copied.offset;
+
+            slot.buffer = std::move(copied.buffer);
+            slot.texture = std::move(copied.texture);
+            slot.heap = copied.heap;
+            slot.offset = copied.offset;
+
+            ++m_Statistics.relocatedResources;
+
+            if (m_Desc.onResourceRelocated)
+                m_Desc.onResourceRelocated(relocation);
+        }
+
+        m_CopiedMoves.clear();
+    }
+
+    void HeapDefragmenter::update()
+    {
+        m_Statistics.copiedBytes = 0;
+        m_Statistics.relocatedResources = 0;
+
+        if (!m_Defragmenting)
+            return;
+
+        const bool passFinished = m_NextMove == m_Moves.size() || m_Moves[m_NextMove].pass != m_Statistics.currentPass;
+
+        if (passFinished && !m_Retiring)
+        {
+            // The work submitted so far may still use the old resources; the relocations are visible to the
+            // application from here on, so everything it submits later uses the new ones
+            for (const RetireQuery& retire : m_RetireQueries)
+                m_Device->setEventQuery(retire.query, retire.queue);
+
+            m_Retiring = true;
+        }
+
+        if (m_Retiring)
+        {
+            for (const RetireQuery& retire : m_RetireQueries)
+            {
+                if (!m_Device->pollEventQuery(retire.query))
+                    return;
+            }
+
+            for (const RetireQuery& retire : m_RetireQueries)
+                m_Device->resetEventQuery(retire.query);
+
+            m_Retiring = false;
+        }
+
+        if (m_NextMove == m_Moves.size())
+        {
+            m_Moves.clear();
+            m_NextMove = 0;
+            m_Defragmenting = false;
+            m_Statistics.pendingMoves = 0;
+            return;
+        }
+
+        const uint32_t pass = m_Moves[m_NextMove].pass;
+        m_Statistics.currentPass = pass;
+
+        m_CommandList->open();
+
+        uint64_t copiedBytes = 0;
+        while (m_NextMove < m_Moves.size() && m_Moves[m_NextMove].pass == pass)
+        {
+            const Move& move = m_Moves[m_NextMove];
+
+            if (!isValid(move.resource) || m_Slots[move.resource].generation != move.generation ||
+                !m_Slots[move.resource].movable)
+            {
+                ++m_NextMove;
+                continue;
+            }
+
+            const uint64_t size = m_Slots[move.resource].size;
+            if (copiedBytes != 0 && copiedBytes + size > m_Desc.copyBytesPerUpdate)
+                break;
+
+            ++m_NextMove;
+
+            if (!recordMove(move))
+            {
+                // Later passes assume that this resource has left its range, so they cannot run
+                warning("HeapDefragmenter: failed to create a relocated resource, defragmentation stops after this pass");
+
+                cancelLaterPasses(pass);
+                continue;
+            }
+
+            copiedBytes += size;
+        }
+
+        m_CommandList->close();
+
+        if (!m_CopiedMoves.empty())
+        {
+            const uint64_t instance = m_Device->executeCommandList(m_CommandList, m_Desc.queue);
+
+            // Relocate right away, with the other queues waiting for the copies, so that no work that the
+            // application submits from now on can write the old resources after they have been copied
+            for (const RetireQuery& retire : m_RetireQueries)
+            {
+                if (retire.queue != m_Desc.queue)
+                    m_Device->queueWaitForCommandList(retire.queue, m_Desc.queue, instance);
+            }
+
+            relocateCopiedMoves();
+        }
+
+        m_Statistics.copiedBytes = copiedBytes;
+        m_Statistics.pendingMoves = uint32_t(m_Moves.size() - m_NextMove);
+    }
+}
@@ -0,0 +1,140 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include "allocator.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace nvrhi
+{
+    // Hash function for keys that are arrays of hashable elements, such as lists of vertex attributes
+    template<typename T>
+    struct ArrayHash
+    {
+        std::size_t operator()(T const& s) const noexcept
+        {
+            size_t hash = 0;
+            for (const auto& element : s)
+                hash_combine(hash, element);
+            return hash;
+        }
+    };
+
+    // Deduplicates immutable objects that are created from identical descriptors.
+    //
+    // The table holds a reference to every object it has returned, but that reference does not keep
+    // the object alive indefinitely: collectUnused() releases all entries that are no longer referenced
+    // by anything except the table itself.
+    //
+    // Key must be equality comparable and hashable with Hash; Handle is a RefCountPtr to the object.
+    template<typename Key, typename Handle, typename Hash = std::hash<Key>>
+    class InterningTable
+    {
+    public:
+        // The entries are allocated through the tracker under AllocationCategory::Caches, if one is given
+        explicit InterningTable(AllocationTracker* allocationTracker = nullptr)
+            : m_Entries(typename EntryMap::allocator_type(allocationTracker, AllocationCategory::Caches))
+        { }
+
+        // Returns the object registered for 'key', or calls 'create' to make a new one and registers it.
+        // A null object returned by 'create' is not registered.
+        template<typename CreateFunc>
+        Handle findOrCreate(const Key& key, CreateFunc&& create)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            ++m_NumRequests;
+
+            auto it = m_Entries.find(key);
+            if (it != m_Entries.end())
+            {
+                ++m_NumReused;
+                return it->second;
+            }
+
+            Handle object = create();
+            if (object)
+                m_Entries[key] = object;
+
+            return object;
+        }
+
+        // Releases the entries that are only referenced by the table, returns the number of released entries.
+        size_t collectUnused()
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            size_t numReleased = 0;
+            for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+            {
+                // No other references can be created concurrently: new references to the object
+                // are only obtained through the table, which is locked.
+                if (isReferencedByTableOnly(it->second))
+                {
+                    it = m_Entries.erase(it);
+                    ++numReleased;
+                }
+                else
+                    ++it;
+            }
+
+            return numReleased;
+        }
+
+        void clear()
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            m_Entries.clear();
+        }
+
+        [[nodiscard]] InterningStatistics getStatistics()
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            InterningStatistics stats;
+            stats.numRequests = m_NumRequests;
+            stats.numReused = m_NumReused;
+            stats.numObjects = m_Entries.size();
+            return stats;
+        }
+
+    private:
+        typedef tracked_unordered_map<Key, Handle, Hash> EntryMap;
+
+        std::mutex m_Mutex;
+        EntryMap m_Entries;
+        uint64_t m_NumRequests = 0;
+        uint64_t m_NumReused = 0;
+
+        static bool isReferencedByTableOnly(const Handle& object)
+        {
+            // AddRef and Release return the updated reference count
+            object->AddRef();
+            return object->Release() == 1;
+        }
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,176 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "object-pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace nvrhi
+{
+    static constexpr uint32_t c_BlocksPerSlab = 64;
+
+    static std::atomic<IAllocator*> g_ObjectAllocator = nullptr;
+    static std::atomic<bool> g_ObjectAllocatorLocked = false;
+    static std::mutex g_ObjectAllocatorMutex;
+
+    bool setObjectAllocator(IAllocator* allocator)
+    {
+        std::lock_guard lockGuard(g_ObjectAllocatorMutex);
+
+        // Objects that already exist would be freed by a different allocator than the one that created them
+        if (g_ObjectAllocatorLocked.load())
+            return false;
+
+        g_ObjectAllocator = allocator;
+        return true;
+    }
+
+    IAllocator* getObjectAllocator()
+    {
+        return g_ObjectAllocator.load(std::memory_order_relaxed);
+    }
+
+    IAllocator* lockObjectAllocator()
+    {
+        // Only the first allocation takes the mutex, so that it can't interleave with setObjectAllocator
+        if (!g_ObjectAllocatorLocked.load(std::memory_order_acquire))
+        {
+            std::lock_guard lockGuard(g_ObjectAllocatorMutex);
+            g_ObjectAllocatorLocked.store(true, std::memory_order_release);
+        }
+
+        return g_ObjectAllocator.load(std::memory_order_relaxed);
+    }
+
+    SlabPool::SlabPool(size_t blockSize, size_t blockAlignment)
+        : m_BlockAlignment(std::max(blockAlignment, alignof(FreeBlock)))
+    {
+        // Every block has to hold a free list link and keep the next block aligned
+        const size_t size = std::max(blockSize, sizeof(FreeBlock));
+        m_BlockSize = (size + m_BlockAlignment - 1) / m_BlockAlignment * m_BlockAlignment;
+    }
+
+    uint32_t SlabPool::takeBatch(FreeBlock*& outList)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_FreeList)
+        {
+            char* slab = static_cast<char*>(::operator new(m_BlockSize * c_BlocksPerSlab, std::align_val_t(m_BlockAlignment)));
+            m_Slabs.push_back(slab);
+
+            for (uint32_t i = c_BlocksPerSlab; i > 0; i--)
+            {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * m_BlockSize);
+                block->next = m_FreeList;
+                m_FreeList = block;
+            }
+        }
+
+        uint32_t count = 0;
+        while (m_FreeList && count < BatchSize)
+        {
+            FreeBlock* block = m_FreeList;
+            m_FreeList = block->next;
+            block->next = outList;
+            outList = block;
+            ++count;
+        }
+
+        return count;
+    }
+
+    void SlabPool::returnBlocks(FreeBlock* list)
+    {
+        if (!list)
+            return;
+
+        FreeBlock* last = list;
+        while (last->next)
+            last = last->next;
+
+        std::lock_guard lockGuard(m_Mutex);
+        last->next = m_FreeList;
+        m_FreeList = list;
+    }
+
+    void* ObjectPoolCache::allocate(SlabPool& pool)
+    {
+        if (m_Flushed)
+        {
+            SlabPool::FreeBlock* list = nullptr;
+            pool.takeBatch(list);
+            pool.returnBlocks(list->next);
+            return list;
+        }
+
+        if (!m_FreeList)
+            m_Count += pool.takeBatch(m_FreeList);
+
+        SlabPool::FreeBlock* block = m_FreeList;
+        m_FreeList = block->next;
+        --m_Count;
+        return block;
+    }
+
+    void ObjectPoolCache::deallocate(SlabPool& pool, void* pointer)
+    {
+        SlabPool::FreeBlock* block = static_cast<SlabPool::FreeBlock*>(pointer);
+
+        if (m_Flushed)
+        {
+            block->next = nullptr;
+            pool.returnBlocks(block);
+            return;
+        }
+
+        block->next = m_FreeList;
+        m_FreeList = block;
+        ++m_Count;
+
+        // Threads that mostly release objects created elsewhere would hoard blocks, give a batch back
+        if (m_Count > 2 * SlabPool::BatchSize)
+        {
+            SlabPool::FreeBlock* batch = nullptr;
+            for (uint32_t i = 0; i < SlabPool::BatchSize; i++)
+            {
+                block = m_FreeList;
+                m_FreeList = block->next;
+                block->next = batch;
+                batch = block;
+            }
+            m_Count -= SlabPool::BatchSize;
+            pool.returnBlocks(batch);
+        }
+    }
+
+    void ObjectPoolCache::flush(SlabPool& pool)
+    {
+        pool.returnBlocks(m_FreeList);
+        m_FreeList = nullptr;
+        m_Count = 0;
+        m_Flushed = true;
+    }
+} // namespace nvrhi
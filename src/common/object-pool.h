@@ -0,0 +1,186 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // A pool of fixed-size memory blocks carved out of larger slabs.
+    // Free blocks are kept on a shared free list; threads take and return them in batches through ObjectPoolCache,
+    // so that the mutex is only touched once per batch. Slabs are never returned to the system.
+    class SlabPool
+    {
+    public:
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        static constexpr uint32_t BatchSize = 32;
+
+        SlabPool(size_t blockSize, size_t blockAlignment);
+
+        // Moves up to BatchSize blocks to the list, allocating a new slab if necessary. Returns the number of blocks.
+        uint32_t takeBatch(FreeBlock*& outList);
+        void returnBlocks(FreeBlock* list);
+
+        [[nodiscard]] size_t getBlockSize() const { return m_BlockSize; }
+        [[nodiscard]] size_t getBlockAlignment() const { return m_BlockAlignment; }
+
+    private:
+        std::mutex m_Mutex;
+        FreeBlock* m_FreeList = nullptr;
+        size_t m_BlockSize;
+        size_t m_BlockAlignment;
+        std::vector<void*> m_Slabs;
+    };
+
+    // Per-thread list of free blocks for one pool.
+    // It's trivially destructible so that it stays usable while the thread exits: objects can be released
+    // from thread_local or static destructors after the cache has been flushed, and go straight to the pool then.
+    class ObjectPoolCache
+    {
+    public:
+        void* allocate(SlabPool& pool);
+        void deallocate(SlabPool& pool, void* pointer);
+
+        // Returns all blocks to the pool and stops caching
+        void flush(SlabPool& pool);
+
+    private:
+        SlabPool::FreeBlock* m_FreeList = nullptr;
+        uint32_t m_Count = 0;
+        bool m_Flushed = false;
+    };
+
+    // Flushes a thread's cache when the thread exits
+    class ObjectPoolCacheGuard
+    {
+    public:
+        ObjectPoolCacheGuard(ObjectPoolCache& cache, SlabPool& pool) : m_Cache(cache), m_Pool(pool) { }
+        ~ObjectPoolCacheGuard() { m_Cache.flush(m_Pool); }
+
+    private:
+        ObjectPoolCache& m_Cache;
+        SlabPool& m_Pool;
+    };
+
+    IAllocator* getObjectAllocator();
+    // Returns the allocator for a new object and prevents setObjectAllocator from replacing it from now on
+    IAllocator* lockObjectAllocator();
+
+    // Allocation functions for objects of type T; blocks are shared by all devices.
+    // Allocations of a different size, e.g. from a class derived from T, go to the global operator new.
+    template<typename T>
+    class ObjectPool
+    {
+    public:
+        static void* allocate(size_t size)
+        {
+            if (IAllocator* allocator = lockObjectAllocator())
+                return allocator->allocate(size, alignof(T), AllocationCategory::Objects);
+
+            if (size != sizeof(T))
+                return ::operator new(size);
+
+            return getThreadCache().allocate(getPool());
+        }
+
+        static void deallocate(void* pointer, size_t size)
+        {
+            if (!pointer)
+                return;
+
+            if (IAllocator* allocator = getObjectAllocator())
+            {
+                allocator->deallocate(pointer, size, alignof(T), AllocationCategory::Objects);
+                return;
+            }
+
+            if (size != sizeof(T))
+            {
+                ::operator delete(pointer);
+                return;
+            }
+
+            getThreadCache().deallocate(getPool(), pointer);
+        }
+
+    private:
+        static SlabPool& getPool()
+        {
+            // Intentionally never destroyed: objects held in static handles may be released after static destructors run
+            static SlabPool* pool = new SlabPool(sizeof(T), alignof(T));
+            return *pool;
+        }
+
+        static ObjectPoolCache& getThreadCache()
+        {
+            static thread_local ObjectPoolCache cache;
+            static thread_local ObjectPoolCacheGuard guard(cache, getPool());
+            return cache;
+        }
+    };
+
+    // Derive a class from PooledObject<Class> to allocate its instances from ObjectPool<Class>
+    template<typename T>
+    class PooledObject
+    {
+    public:
+        static void* operator new(size_t size) { return ObjectPool<T>::allocate(size); }
+        static void operator delete(void* pointer, size_t size) { ObjectPool<T>::deallocate(pointer, size); }
+    };
+
+    // Standard allocator over ObjectPool, for use with std::allocate_shared
+    template<typename T>
+    class PoolAllocator
+    {
+    public:
+        typedef T value_type;
+
+        PoolAllocator() = default;
+        template<typename U> PoolAllocator(const PoolAllocator<U>&) { }
+
+        T* allocate(size_t count)
+        {
+            return static_cast<T*>(count == 1 ? ObjectPool<T>::allocate(sizeof(T)) : ::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t count)
+        {
+            if (count == 1)
+                ObjectPool<T>::deallocate(pointer, sizeof(T));
+            else
+                ::operator delete(pointer);
+        }
+
+        template<typename U> bool operator==(const PoolAllocator<U>&) const { return true; }
+        template<typename U> bool operator!=(const PoolAllocator<U>&) const { return false; }
+    };
+} // namespace nvrhi
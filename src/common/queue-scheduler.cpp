@@ -0,0 +1,337 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/queue-scheduler.h>
+#include <nvrhi/utils.h>
+#include <algorithm>
+#include <sstream>
+
+namespace nvrhi
+{
+    QueueScheduler::QueueScheduler(IDevice* device)
+        : m_Device(device)
+    {
+    }
+
+    uint32_t QueueScheduler::addCommandList(ICommandList* commandList,
+        const std::vector<IResource*>& reads, const std::vector<IResource*>& writes)
+    {
+        if (m_Executed)
+            clearGraph();
+
+        QueueSchedulerNode node;
+        node.commandList = commandList;
+        node.queue = commandList->getDesc().queueType;
+        m_Nodes.push_back(std::move(node));
+
+        PendingNode pending;
+        pending.reads = reads;
+        pending.writes = writes;
+        m_Pending.push_back(std::move(pending));
+
+        return uint32_t(m_Nodes.size() - 1);
+    }
+
+    void QueueScheduler::clearGraph()
+    {
+        m_Nodes.clear();
+        m_Batches.clear();
+        m_Executed = false;
+    }
+
+    void QueueScheduler::pruneCompletedAccesses()
+    {
+        bool anyCompleted = false;
+
+        for (auto it = m_SubmissionQueries.begin(); it != m_SubmissionQueries.end(); )
+        {
+            if (!m_Device->pollEventQuery(it->query))
+            {
+                ++it;
+                continue;
+            }
+
+            uint64_t& completed = m_Completed[size_t(it->queue)];
+            completed = std::max(completed, it->submissionID);
+            anyCompleted = true;
+
+            m_Device->resetEventQuery(it->query);
+            m_FreeQueries.push_back(std::move(it->query));
+            it = m_SubmissionQueries.erase(it);
+        }
+
+        if (!anyCompleted)
+            return;
+
+        // Between execute calls, all accesses refer to submissions
+        auto isCompleted = [this](CommandQueue queue, const Access& access)
+        {
+            return !access.valid() || access.submissionID <= m_Completed[size_t(queue)];
+        };
+
+        for (auto it = m_Resources.begin(); it != m_Resources.end(); )
+        {
+            const ResourceAccesses& accesses = it->second;
+
+            bool completed = isCompleted(accesses.writeQueue, accesses.write);
+            for (size_t queue = 0; queue < c_NumQueues && completed; ++queue)
+                completed = isCompleted(CommandQueue(queue), accesses.reads[queue]);
+
+            if (completed)
+                it = m_Resources.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    QueueScheduler::ResourceAccesses& QueueScheduler::getAccesses(IResource* resource)
+    {
+        ResourceAccesses& accesses = m_Resources[resource];
+        if (!accesses.resource)
+            accesses.resource = resource;
+        return accesses;
+    }
+
+    void QueueScheduler::flushQueue(CommandQueue queue)
+    {
+        std::vector<uint32_t>& openBatch = m_OpenBatches[size_t(queue)];
+        if (openBatch.empty())
+            return;
+
+        std::vector<ICommandList*> commandLists;
+        commandLists.reserve(openBatch.size());
+        for (uint32_t node : openBatch)
+            commandLists.push_back(m_Nodes[node].commandList);
+
+        QueueSchedulerBatch batch;
+        batch.queue = queue;
+        batch.nodes = openBatch;
+        batch.submissionID = m_Device->executeCommandLists(commandLists.data(), commandLists.size(), queue);
+
+        for (uint32_t node : openBatch)
+        {
+            m_Nodes[node].batch = uint32_t(m_Batches.size());
+            m_Nodes[node].submissionID = batch.submissionID;
+        }
+
+        m_Batches.push_back(std::move(batch));
+        openBatch.clear();
+    }
+
+    uint64_t QueueScheduler::resolveAccess(CommandQueue queue, const Access& access)
+    {
+        if (access.node == c_NoNode)
+            return access.submissionID;
+
+        // The other queue is needed by this one now, so its open batch cannot grow any further
+        if (m_Nodes[access.node].submissionID == 0)
+            flushQueue(queue);
+
+        return m_Nodes[access.node].submissionID;
+    }
+
+    void QueueScheduler::addHazard(uint32_t node, CommandQueue queue, const Access& access, std::array<uint64_t, c_NumQueues>& required)
+    {
+        if (access.node != c_NoNode)
+            m_Nodes[node].dependencies.push_back(access.node);
+
+        uint64_t& submissionID = required[size_t(queue)];
+        submissionID = std::max(submissionID, resolveAccess(queue, access));
+    }
+
+    void QueueScheduler::execute()
+    {
+        // Nothing was added since the last call, so its graph must not be submitted again
+        if (m_Executed)
+            clearGraph();
+
+        pruneCompletedAccesses();
+
+        for (uint32_t index = 0; index < uint32_t(m_Nodes.size()); ++index)
+        {
+            const CommandQueue queue = m_Nodes[index].queue;
+            const PendingNode& pending = m_Pending[index];
+            std::array<uint64_t, c_NumQueues> required{};
+
+            for (IResource* resource : pending.reads)
+            {
+                ResourceAccesses& accesses = getAccesses(resource);
+
+                if (accesses.write.valid() && accesses.writeQueue != queue)
+                    addHazard(index, accesses.writeQueue, accesses.write, required);
+            }
+
+            for (IResource* resource : pending.writes)
+            {
+                ResourceAccesses& accesses = getAccesses(resource);
+
+                if (accesses.write.valid() && accesses.writeQueue != queue)
+                    addHazard(index, accesses.writeQueue, accesses.write, required);
+
+                for (size_t readQueue = 0; readQueue < c_NumQueues; ++readQueue)
+                {
+                    if (readQueue != size_t(queue) && accesses.reads[readQueue].valid())
+                        addHazard(index, CommandQueue(readQueue), accesses.reads[readQueue], required);
+                }
+            }
+
+            QueueSchedulerNode& node = m_Nodes[index];
+            std::sort(node.dependencies.begin(), node.dependencies.end());
+            node.dependencies.erase(std::unique(node.dependencies.begin(), node.dependencies.end()), node.dependencies.end());
+
+            std::array<uint64_t, c_NumQueues>& known = m_Known[size_t(queue)];
+            bool needsWait = false;
+            for (size_t otherQueue = 0; otherQueue < c_NumQueues; ++otherQueue)
+            {
+                if (required[otherQueue] > known[otherQueue])
+                    needsWait = true;
+            }
+
+            if (needsWait)
+            {
+                // Submit the work that does not depend on the other queues before the wait, so that it can overlap
+                flushQueue(queue);
+
+                for (size_t otherQueue = 0; otherQueue < c_NumQueues; ++otherQueue)
+                {
+                    if (required[otherQueue] <= known[otherQueue])
+                        continue;
+
+                    m_Device->queueWaitForCommandList(queue, CommandQueue(otherQueue), required[otherQueue]);
+                    known[otherQueue] = required[otherQueue];
+                    node.waits.push_back(QueueWait{ CommandQueue(otherQueue), required[otherQueue] });
+                }
+            }
+
+            m_OpenBatches[size_t(queue)].push_back(index);
+
+            for (IResource* resource : pending.reads)
+            {
+                getAccesses(resource).reads[size_t(queue)] = Access{ index, 0 };
+            }
+
+            for (IResource* resource : pending.writes)
+            {
+                ResourceAccesses& accesses = getAccesses(resource);
+                accesses.writeQueue = queue;
+                accesses.write = Access{ index, 0 };
+                accesses.reads.fill(Access());
+            }
+        }
+
+        for (size_t queue = 0; queue < c_NumQueues; ++queue)
+            flushQueue(CommandQueue(queue));
+
+        // Everything has been submitted, so later execute calls refer to these accesses by submission
+        auto resolve = [this](Access& access)
+        {
+            if (access.node != c_NoNode)
+            {
+                access.submissionID = m_Nodes[access.node].submissionID;
+                access.node = c_NoNode;
+            }
+        };
+
+        for (auto& entry : m_Resources)
+        {
+            resolve(entry.second.write);
+            for (Access& access : entry.second.reads)
+                resolve(access);
+        }
+
+        std::array<uint64_t, c_NumQueues> lastSubmission{};
+        for (const QueueSchedulerBatch& batch : m_Batches)
+            lastSubmission[size_t(batch.queue)] = std::max(lastSubmission[size_t(batch.queue)], batch.submissionID);
+
+        for (size_t queue = 0; queue < c_NumQueues; ++queue)
+        {
+            if (lastSubmission[queue] == 0)
+                continue;
+
+            SubmissionQuery submissionQuery;
+            if (!m_FreeQueries.empty())
+            {
+                submissionQuery.query = std::move(m_FreeQueries.back());
+                m_FreeQueries.pop_back();
+            }
+            else
+            {
+                submissionQuery.query = m_Device->createEventQuery();
+                if (!submissionQuery.query)
+                    continue;
+            }
+
+            m_Device->setEventQuery(submissionQuery.query, CommandQueue(queue));
+            submissionQuery.queue = CommandQueue(queue);
+            submissionQuery.submissionID = lastSubmission[queue];
+            m_SubmissionQueries.push_back(std::move(submissionQuery));
+        }
+
+        m_Pending.clear();
+        m_Executed = true;
+    }
+
+    void QueueScheduler::reset()
+    {
+        m_Resources.clear();
+    }
+
+    std::string QueueScheduler::getGraphviz() const
+    {
+        std::stringstream ss;
+        ss << "digraph QueueScheduler {\n";
+
+        for (size_t queue = 0; queue < c_NumQueues; ++queue)
+        {
+            ss << "  subgraph cluster_" << queue << " {\n";
+            ss << "    label=\"" << utils::CommandQueueToString(CommandQueue(queue)) << "\";\n";
+
+            uint32_t previous = c_NoNode;
+            for (uint32_t index = 0; index < uint32_t(m_Nodes.size()); ++index)
+            {
+                const QueueSchedulerNode& node = m_Nodes[index];
+                if (size_t(node.queue) != queue)
+                    continue;
+
+                ss << "    n" << index << " [label=\"" << index << "\\nbatch " << node.batch
+                    << "\\nsubmission " << node.submissionID << "\"];\n";
+
+                // Queue order
+                if (previous != c_NoNode)
+                    ss << "    n" << previous << " -> n" << index << " [style=dotted];\n";
+                previous = index;
+            }
+
+            ss << "  }\n";
+        }
+
+        for (uint32_t index = 0; index < uint32_t(m_Nodes.size()); ++index)
+        {
+            for (uint32_t dependency : m_Nodes[index].dependencies)
+                ss << "  n" << dependency << " -> n" << index << ";\n";
+        }
+
+        ss << "}\n";
+        return ss.str();
+    }
+}
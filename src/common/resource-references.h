@@ -0,0 +1,117 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <algorithm>
+#include <vector>
+
+namespace nvrhi
+{
+    // Keeps the resources used by a command list alive until it finishes executing on the GPU.
+    //
+    // Each resource is referenced at most once per set, no matter how many times it's added, so that binding
+    // the same pipeline or binding set for every draw doesn't cost an atomic increment and decrement per draw.
+    // The membership test is an open-addressing hash table of raw pointers whose storage is kept across clear(),
+    // so a set that is reused for every recording stops allocating once it has grown to the working size.
+    class ResourceReferenceSet
+    {
+    public:
+        ResourceReferenceSet() = default;
+        ~ResourceReferenceSet() { clear(); }
+
+        ResourceReferenceSet(const ResourceReferenceSet&) = delete;
+        ResourceReferenceSet& operator=(const ResourceReferenceSet&) = delete;
+
+        void add(IResource* resource)
+        {
+            // Consecutive adds of the same object are the common case, e.g. the pipeline in setGraphicsState
+            if (!resource || resource == m_LastAdded)
+                return;
+
+            m_LastAdded = resource;
+
+            if ((m_Resources.size() + 1) * 2 > m_Table.size())
+                grow();
+
+            if (!insert(resource))
+                return;
+
+            resource->AddRef();
+            m_Resources.push_back(resource);
+        }
+
+        // Releases all references in one pass
+        void clear()
+        {
+            for (IResource* resource : m_Resources)
+                resource->Release();
+
+            if (!m_Resources.empty())
+                std::fill(m_Table.begin(), m_Table.end(), nullptr);
+
+            m_Resources.clear();
+            m_LastAdded = nullptr;
+        }
+
+        [[nodiscard]] size_t size() const { return m_Resources.size(); }
+        [[nodiscard]] bool empty() const { return m_Resources.empty(); }
+
+    private:
+        std::vector<IResource*> m_Resources;
+        std::vector<IResource*> m_Table; // size is zero or a power of 2, at most half full
+        IResource* m_LastAdded = nullptr;
+
+        static size_t hashPointer(const IResource* resource)
+        {
+            // Objects are at least 8-byte aligned, mix the upper bits down
+            const uint64_t value = uint64_t(reinterpret_cast<uintptr_t>(resource));
+            return size_t((value >> 4) ^ (value >> 17) ^ (value * 0x9e3779b97f4a7c15ull >> 32));
+        }
+
+        // Returns false if the resource is already in the table
+        bool insert(IResource* resource)
+        {
+            const size_t mask = m_Table.size() - 1;
+            for (size_t index = hashPointer(resource) & mask; ; index = (index + 1) & mask)
+            {
+                if (m_Table[index] == resource)
+                    return false;
+
+                if (!m_Table[index])
+                {
+                    m_Table[index] = resource;
+                    return true;
+                }
+            }
+        }
+
+        void grow()
+        {
+            m_Table.assign(std::max<size_t>(m_Table.size() * 2, 64), nullptr);
+            for (IResource* resource : m_Resources)
+                insert(resource);
+        }
+    };
+} // namespace nvrhi
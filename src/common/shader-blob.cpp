@@ -0,0 +1,303 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/shader-blob.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nvrhi
+{
+    static const char* g_BlobSignature = "NVSP";
+    static constexpr size_t g_BlobSignatureSize = 4;
+
+    static std::string makePermutationString(const ShaderConstant* constants, uint32_t numConstants)
+    {
+        // must match the format used by the shader compiler
+        std::stringstream ss;
+        for (uint32_t n = 0; n < numConstants; n++)
+        {
+            ss << constants[n].name;
+            if (constants[n].value)
+            {
+                ss << "=" << constants[n].value;
+            }
+            ss << " ";
+        }
+        return ss.str();
+    }
+
+    void enumeratePermutationsInBlob(const void* blob, size_t blobSize, std::vector<ShaderBinaryView>& permutations)
+    {
+        if (!blob || blobSize < g_BlobSignatureSize)
+            return;
+
+        if (memcmp(blob, g_BlobSignature, g_BlobSignatureSize) != 0)
+            return;
+
+        const char* current = static_cast<const char*>(blob) + g_BlobSignatureSize;
+        const char* const end = static_cast<const char*>(blob) + blobSize;
+
+        while (current + sizeof(ShaderBlobEntry) <= end)
+        {
+            ShaderBlobEntry header;
+            memcpy(&header, current, sizeof(header));
+            current += sizeof(header);
+
+            if (size_t(end - current) < size_t(header.permutationSize) + size_t(header.dataSize))
+                break; // truncated blob
+
+            ShaderBinaryView view;
+            view.permutation = std::string_view(current, header.permutationSize);
+            view.data = current + header.permutationSize;
+            view.size = header.dataSize;
+            permutations.push_back(view);
+
+            current += header.permutationSize + header.dataSize;
+        }
+    }
+
+    bool findPermutationInBlob(const void* blob, size_t blobSize, const ShaderConstant* constants, uint32_t numConstants, ShaderBinaryView& outView)
+    {
+        if (!blob || blobSize < g_BlobSignatureSize)
+            return false;
+
+        if (memcmp(blob, g_BlobSignature, g_BlobSignatureSize) != 0)
+        {
+            // not a permutation blob, which is fine when no permutation is requested
+            if (numConstants != 0)
+                return false;
+
+            outView = ShaderBinaryView();
+            outView.data = blob;
+            outView.size = blobSize;
+            return true;
+        }
+
+        const std::string permutation = makePermutationString(constants, numConstants);
+
+        std::vector<ShaderBinaryView> permutations;
+        enumeratePermutationsInBlob(blob, blobSize, permutations);
+
+        for (const ShaderBinaryView& view : permutations)
+        {
+            if (view.permutation == permutation)
+            {
+                outView = view;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool findPermutationInBlob(const void* blob, size_t blobSize, const ShaderConstant* constants, uint32_t numConstants, const void** pBinary, size_t* pSize)
+    {
+        ShaderBinaryView view;
+        if (!findPermutationInBlob(blob, blobSize, constants, numConstants, view))
+            return false;
+
+        if (pBinary) *pBinary = view.data;
+        if (pSize) *pSize = view.size;
+        return true;
+    }
+
+    static ShaderHandle createShaderFromView(IDevice* device, const ShaderDesc& desc, const ShaderBinaryView& view)
+    {
+        // SPIR-V consumers require the code to be 4-byte aligned, but permutation payloads
+        // follow variable-length strings in the blob, so make an aligned copy when needed
+        if ((reinterpret_cast<uintptr_t>(view.data) & 3) != 0)
+        {
+            std::vector<uint32_t> alignedCopy((view.size + 3) / 4);
+            memcpy(alignedCopy.data(), view.data, view.size);
+            return device->createShader(desc, alignedCopy.data(), view.size);
+        }
+
+        return device->createShader(desc, view.data, view.size);
+    }
+
+    ShaderHandle createShaderPermutation(IDevice* device, const ShaderDesc& desc, const void* blob, size_t blobSize,
+        const ShaderConstant* constants, uint32_t numConstants)
+    {
+        ShaderBinaryView view;
+        if (!findPermutationInBlob(blob, blobSize, constants, numConstants, view))
+            return nullptr;
+
+        return createShaderFromView(device, desc, view);
+    }
+
+    static void prefetchMemory(const void* data, size_t size)
+    {
+        if (!data || size == 0)
+            return;
+
+#ifdef _WIN32
+#if defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0602) // PrefetchVirtualMemory requires Windows 8
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<void*>(data);
+        range.NumberOfBytes = size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+        // madvise requires a page-aligned address
+        const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+    }
+
+    ShaderPackage::~ShaderPackage()
+    {
+        close();
+    }
+
+    bool ShaderPackage::open(const char* fileName)
+    {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+
+        // the view keeps the mapping object alive
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!data)
+            return false;
+
+        m_Data = data;
+        m_Size = size_t(fileSize.QuadPart);
+#else
+        int fd = ::open(fileName, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat fileStat{};
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        void* data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        m_Data = data;
+        m_Size = size_t(fileStat.st_size);
+#endif
+
+        enumeratePermutationsInBlob(m_Data, m_Size, m_Permutations);
+
+        for (size_t index = 0; index < m_Permutations.size(); index++)
+        {
+            m_PermutationIndex[m_Permutations[index].permutation] = index;
+        }
+
+        return true;
+    }
+
+    void ShaderPackage::close()
+    {
+        if (!m_Data)
+            return;
+
+        m_PermutationIndex.clear();
+        m_Permutations.clear();
+
+#ifdef _WIN32
+        UnmapViewOfFile(m_Data);
+#else
+        munmap(const_cast<void*>(m_Data), m_Size);
+#endif
+
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    bool ShaderPackage::findPermutation(const ShaderConstant* constants, uint32_t numConstants, ShaderBinaryView& outView) const
+    {
+        if (!m_Data)
+            return false;
+
+        // packages that are not permutation blobs contain a single binary
+        if (memcmp(m_Data, g_BlobSignature, std::min(m_Size, g_BlobSignatureSize)) != 0)
+            return findPermutationInBlob(m_Data, m_Size, constants, numConstants, outView);
+
+        const std::string permutation = makePermutationString(constants, numConstants);
+
+        auto it = m_PermutationIndex.find(permutation);
+        if (it == m_PermutationIndex.end())
+            return false;
+
+        outView = m_Permutations[it->second];
+        return true;
+    }
+
+    void ShaderPackage::prefetch() const
+    {
+        prefetchMemory(m_Data, m_Size);
+    }
+
+    void ShaderPackage::prefetch(const ShaderBinaryView& view) const
+    {
+        prefetchMemory(view.data, view.size);
+    }
+
+    ShaderHandle ShaderPackage::createShader(IDevice* device, const ShaderDesc& desc, const ShaderConstant* constants, uint32_t numConstants) const
+    {
+        ShaderBinaryView view;
+        if (!findPermutation(constants, numConstants, view))
+            return nullptr;
+
+        return createShaderFromView(device, desc, view);
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,642 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/shader-reload.h>
+#include "content-hash.h"
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace nvrhi
+{
+    static std::filesystem::path normalizePath(const std::filesystem::path& path)
+    {
+        std::error_code ec;
+        std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+        if (ec)
+            return path.lexically_normal();
+        return absolute.lexically_normal();
+    }
+
+    static bool readFile(const std::string& fileName, std::vector<char>& outData)
+    {
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+
+        const std::streamoff size = file.tellg();
+        if (size < 0)
+            return false;
+
+        outData.resize(size_t(size));
+        file.seekg(0);
+        file.read(outData.data(), size);
+        return bool(file);
+    }
+
+    FileWatcher::FileWatcher()
+    {
+#ifdef __linux__
+        m_NotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+#ifdef __linux__
+        if (m_NotifyDescriptor >= 0)
+            ::close(m_NotifyDescriptor);
+#endif
+    }
+
+    bool FileWatcher::addDirectory(const std::filesystem::path& path)
+    {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(path, ec))
+            return false;
+
+        const std::filesystem::path directory = normalizePath(path);
+        m_Directories.push_back(directory);
+
+        // Record the current state so that only later modifications are reported by the polling path
+        scanDirectory(directory, nullptr);
+
+        if (m_NotifyDescriptor >= 0)
+        {
+            addWatch(directory);
+
+            for (auto it = std::filesystem::recursive_directory_iterator(directory,
+                    std::filesystem::directory_options::skip_permission_denied, ec);
+                !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+            {
+                if (it->is_directory(ec))
+                    addWatch(it->path());
+            }
+        }
+
+        return true;
+    }
+
+    void FileWatcher::addWatch(const std::filesystem::path& path)
+    {
+#ifdef __linux__
+        if (m_NotifyDescriptor < 0)
+            return;
+
+        const int wd = inotify_add_watch(m_NotifyDescriptor, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd >= 0)
+        {
+            m_WatchedPaths[wd] = path;
+        }
+        else
+        {
+            // Out of watches or an unsupported file system: switch to polling for everything
+            ::close(m_NotifyDescriptor);
+            m_NotifyDescriptor = -1;
+            m_WatchedPaths.clear();
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    void FileWatcher::readNotifications(std::vector<std::filesystem::path>& outFiles)
+    {
+#ifdef __linux__
+        alignas(inotify_event) char buffer[4096];
+
+        while (m_NotifyDescriptor >= 0)
+        {
+            const ssize_t length = ::read(m_NotifyDescriptor, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+
+            for (const char* ptr = buffer; ptr < buffer + length; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                if (event->len == 0)
+                    continue;
+
+                auto directory = m_WatchedPaths.find(event->wd);
+                if (directory == m_WatchedPaths.end())
+                    continue;
+
+                std::filesystem::path path = directory->second / event->name;
+
+                if (event->mask & IN_ISDIR)
+                {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                        addWatch(path);
+                }
+                else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    outFiles.push_back(std::move(path));
+                }
+            }
+        }
+#else
+        (void)outFiles;
+#endif
+    }
+
+    void FileWatcher::scanDirectory(const std::filesystem::path& path, std::vector<std::filesystem::path>* outFiles)
+    {
+        std::error_code ec;
+        for (auto it = std::filesystem::recursive_directory_iterator(path,
+                std::filesystem::directory_options::skip_permission_denied, ec);
+            !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (!it->is_regular_file(ec))
+                continue;
+
+            const std::filesystem::file_time_type time = it->last_write_time(ec);
+            if (ec)
+                continue;
+
+            auto [entry, inserted] = m_FileTimes.try_emplace(it->path().string(), time);
+            if (!inserted && entry->second == time)
+                continue;
+
+            entry->second = time;
+            if (outFiles)
+                outFiles->push_back(it->path());
+        }
+    }
+
+    void FileWatcher::getChangedFiles(std::vector<std::filesystem::path>& outFiles)
+    {
+        std::vector<std::filesystem::path> files;
+
+        if (m_NotifyDescriptor >= 0)
+        {
+            readNotifications(files);
+        }
+        else
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - m_LastPollTime < m_PollingInterval)
+                return;
+            m_LastPollTime = now;
+
+            for (const auto& directory : m_Directories)
+                scanDirectory(directory, &files);
+        }
+
+        // Compilers often write a file in several steps, report it once
+        std::unordered_set<std::string> reported;
+        for (auto& file : files)
+        {
+            if (reported.insert(file.string()).second)
+                outFiles.push_back(std::move(file));
+        }
+    }
+
+    ShaderReloader::ShaderReloader(IDevice* device)
+        : m_Device(device)
+        , m_TaskScheduler(device->getTaskScheduler())
+    {
+    }
+
+    ShaderReloader::~ShaderReloader()
+    {
+        // The jobs reference this object
+        waitForRebuilds();
+    }
+
+    bool ShaderReloader::watchDirectory(const std::filesystem::path& path)
+    {
+        return m_Watcher.addDirectory(path);
+    }
+
+    ShaderHandle ShaderReloader::loadShader(const std::filesystem::path& fileName, const ShaderDesc& desc,
+        const ShaderConstant* constants, uint32_t numConstants)
+    {
+        auto entry = std::make_unique<ShaderEntry>();
+        entry->fileName = normalizePath(fileName).string();
+        entry->desc = desc;
+        for (uint32_t i = 0; i < numConstants; i++)
+        {
+            entry->constantNames.push_back(constants[i].name);
+            entry->constantValues.push_back(constants[i].value);
+        }
+
+        std::unordered_map<IShader*, ShaderHandle> replacements;
+        if (!reloadShader(*entry, replacements))
+            return nullptr;
+
+        ShaderHandle shader = entry->shader;
+        m_ShadersByFile.emplace(entry->fileName, entry.get());
+        m_Shaders.push_back(std::move(entry));
+        return shader;
+    }
+
+    bool ShaderReloader::reloadShader(ShaderEntry& entry, std::unordered_map<IShader*, ShaderHandle>& replacements)
+    {
+        std::vector<char> data;
+        if (!readFile(entry.fileName, data))
+        {
+            warning("ShaderReloader: cannot read " + entry.fileName);
+            return false;
+        }
+
+        std::vector<ShaderConstant> constants;
+        for (size_t i = 0; i < entry.constantNames.size(); i++)
+            constants.push_back(ShaderConstant{ entry.constantNames[i].c_str(), entry.constantValues[i].c_str() });
+
+        ShaderBinaryView view;
+        if (!findPermutationInBlob(data.data(), data.size(), constants.data(), uint32_t(constants.size()), view))
+        {
+            warning("ShaderReloader: cannot find the shader permutation in " + entry.fileName);
+            return false;
+        }
+
+        // Build systems touch outputs that didn't change, and a blob is rewritten as a whole when only some of
+        // its permutations changed; skip the shaders whose own bytes are the same
+        const ContentHash contentHash = hashContents(view.data, view.size);
+        if (entry.shader && contentHash.low == entry.contentHash[0] && contentHash.high == entry.contentHash[1])
+            return false;
+
+        ShaderHandle shader = createShaderPermutation(m_Device, entry.desc, data.data(), data.size(),
+            constants.data(), uint32_t(constants.size()));
+
+        if (!shader)
+        {
+            warning("ShaderReloader: cannot create a shader from " + entry.fileName);
+            return false;
+        }
+
+        entry.contentHash[0] = contentHash.low;
+        entry.contentHash[1] = contentHash.high;
+
+        if (entry.shader)
+            replacements[entry.shader.Get()] = shader;
+        entry.shader = shader;
+        return true;
+    }
+
+    bool ShaderReloader::isReleased(const PipelineEntry& entry)
+    {
+        // The application dropped its last reference to the slot
+        return (entry.graphicsSlot && entry.graphicsSlot.use_count() == 1)
+            || (entry.computeSlot && entry.computeSlot.use_count() == 1)
+            || (entry.meshletSlot && entry.meshletSlot.use_count() == 1);
+    }
+
+    void ShaderReloader::removeReleasedEntries(std::vector<std::weak_ptr<PipelineEntry>>& entries)
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](const std::weak_ptr<PipelineEntry>& weakEntry)
+        {
+            std::shared_ptr<PipelineEntry> entry = weakEntry.lock();
+            return !entry || isReleased(*entry);
+        }), entries.end());
+    }
+
+    void ShaderReloader::addDependency(IShader* shader, const std::shared_ptr<PipelineEntry>& entry)
+    {
+        if (!shader)
+            return;
+
+        // Released pipelines leave their entries behind; drop them before the list has to grow,
+        // which keeps shaders shared by many short-lived pipelines from accumulating them
+        auto& dependents = m_Dependents[shader];
+        if (dependents.size() == dependents.capacity())
+            removeReleasedEntries(dependents);
+
+        dependents.push_back(entry);
+    }
+
+    void ShaderReloader::pruneDependents()
+    {
+        for (auto it = m_Dependents.begin(); it != m_Dependents.end(); )
+        {
+            removeReleasedEntries(it->second);
+            if (it->second.empty())
+                it = m_Dependents.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void ShaderReloader::pruneShaders()
+    {
+        for (auto it = m_Shaders.begin(); it != m_Shaders.end(); )
+        {
+            ShaderEntry* entry = it->get();
+
+            // Nothing but the entry references the shader: the application released it, and so did every
+            // pipeline and pending rebuild that used it
+            entry->shader->AddRef();
+            if (entry->shader->Release() > 1)
+            {
+                ++it;
+                continue;
+            }
+
+            auto range = m_ShadersByFile.equal_range(entry->fileName);
+            for (auto fileIt = range.first; fileIt != range.second; ++fileIt)
+            {
+                if (fileIt->second == entry)
+                {
+                    m_ShadersByFile.erase(fileIt);
+                    break;
+                }
+            }
+
+            m_Dependents.erase(entry->shader.Get());
+            it = m_Shaders.erase(it);
+        }
+    }
+
+    size_t ShaderReloader::getNumDependencies() const
+    {
+        size_t count = 0;
+        for (const auto& [shader, dependents] : m_Dependents)
+            count += dependents.size();
+        return count;
+    }
+
+    ReloadableGraphicsPipelineHandle ShaderReloader::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        GraphicsPipelineHandle pipeline = m_Device->createGraphicsPipeline(desc, fb);
+        if (!pipeline)
+            return nullptr;
+
+        auto entry = std::make_shared<PipelineEntry>();
+        entry->graphicsDesc = desc;
+        entry->framebuffer = fb;
+        entry->graphicsSlot = std::make_shared<ReloadablePipeline<GraphicsPipelineHandle>>();
+        entry->graphicsSlot->pipeline = pipeline;
+
+        addDependency(desc.VS, entry);
+        addDependency(desc.HS, entry);
+        addDependency(desc.DS, entry);
+        addDependency(desc.GS, entry);
+        addDependency(desc.PS, entry);
+
+        m_Pipelines.push_back(entry);
+        return entry->graphicsSlot;
+    }
+
+    ReloadableComputePipelineHandle ShaderReloader::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        ComputePipelineHandle pipeline = m_Device->createComputePipeline(desc);
+        if (!pipeline)
+            return nullptr;
+
+        auto entry = std::make_shared<PipelineEntry>();
+        entry->computeDesc = desc;
+        entry->computeSlot = std::make_shared<ReloadablePipeline<ComputePipelineHandle>>();
+        entry->computeSlot->pipeline = pipeline;
+
+        addDependency(desc.CS, entry);
+
+        m_Pipelines.push_back(entry);
+        return entry->computeSlot;
+    }
+
+    ReloadableMeshletPipelineHandle ShaderReloader::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        MeshletPipelineHandle pipeline = m_Device->createMeshletPipeline(desc, fb);
+        if (!pipeline)
+            return nullptr;
+
+        auto entry = std::make_shared<PipelineEntry>();
+        entry->meshletDesc = desc;
+        entry->framebuffer = fb;
+        entry->meshletSlot = std::make_shared<ReloadablePipeline<MeshletPipelineHandle>>();
+        entry->meshletSlot->pipeline = pipeline;
+
+        addDependency(desc.AS, entry);
+        addDependency(desc.MS, entry);
+        addDependency(desc.PS, entry);
+
+        m_Pipelines.push_back(entry);
+        return entry->meshletSlot;
+    }
+
+    template<typename BuildFunc>
+    void ShaderReloader::submitRebuild(const std::shared_ptr<PipelineEntry>& entry, uint32_t generation, BuildFunc&& build)
+    {
+        const uint64_t job = m_NextJob++;
+
+        auto task = [this, job, entry, generation, build = std::forward<BuildFunc>(build)]()
+        {
+            CompletedRebuild result;
+            result.job = job;
+            result.entry = entry;
+            result.generation = generation;
+            build(result);
+
+            std::lock_guard lockGuard(m_CompletedMutex);
+            m_Completed.push_back(std::move(result));
+        };
+
+        if (!m_TaskScheduler)
+        {
+            task();
+            return;
+        }
+
+        // Results are only collected on this thread, so the ID is recorded before update() can look for it
+        m_Tasks[job] = m_TaskScheduler->runAsync(std::move(task));
+    }
+
+    void ShaderReloader::scheduleRebuild(const std::shared_ptr<PipelineEntry>& entry)
+    {
+        const uint32_t generation = ++entry->scheduledGeneration;
+
+        // The job works on copies of the descs because the entry may be updated again before it runs
+        if (entry->graphicsSlot)
+        {
+            submitRebuild(entry, generation, [this, desc = entry->graphicsDesc, fb = entry->framebuffer](CompletedRebuild& result)
+            {
+                result.graphicsPipeline = m_Device->createGraphicsPipeline(desc, fb);
+            });
+        }
+        else if (entry->computeSlot)
+        {
+            submitRebuild(entry, generation, [this, desc = entry->computeDesc](CompletedRebuild& result)
+            {
+                result.computePipeline = m_Device->createComputePipeline(desc);
+            });
+        }
+        else if (entry->meshletSlot)
+        {
+            submitRebuild(entry, generation, [this, desc = entry->meshletDesc, fb = entry->framebuffer](CompletedRebuild& result)
+            {
+                result.meshletPipeline = m_Device->createMeshletPipeline(desc, fb);
+            });
+        }
+    }
+
+    uint32_t ShaderReloader::update()
+    {
+        // Drop the pipelines that the application no longer references
+        const size_t numPipelines = m_Pipelines.size();
+        m_Pipelines.erase(std::remove_if(m_Pipelines.begin(), m_Pipelines.end(), [](const std::shared_ptr<PipelineEntry>& entry)
+        {
+            return isReleased(*entry);
+        }), m_Pipelines.end());
+
+        if (m_Pipelines.size() != numPipelines)
+            pruneDependents();
+
+        pruneShaders();
+
+        std::vector<std::filesystem::path> changedFiles;
+        m_Watcher.getChangedFiles(changedFiles);
+
+        std::unordered_map<IShader*, ShaderHandle> replacements;
+        for (const auto& file : changedFiles)
+        {
+            auto range = m_ShadersByFile.equal_range(normalizePath(file).string());
+            for (auto it = range.first; it != range.second; ++it)
+                reloadShader(*it->second, replacements);
+        }
+
+        if (!replacements.empty())
+        {
+            // Collect each affected pipeline once, even if several of its shaders changed,
+            // and move the dependency lists over to the new shader objects
+            std::vector<std::shared_ptr<PipelineEntry>> affected;
+            std::unordered_set<PipelineEntry*> affectedSet;
+
+            for (const auto& [oldShader, newShader] : replacements)
+            {
+                auto dependents = m_Dependents.find(oldShader);
+                if (dependents == m_Dependents.end())
+                    continue;
+
+                auto& newDependents = m_Dependents[newShader.Get()];
+                for (const auto& weakEntry : dependents->second)
+                {
+                    std::shared_ptr<PipelineEntry> entry = weakEntry.lock();
+                    if (!entry)
+                        continue;
+
+                    newDependents.push_back(entry);
+                    if (affectedSet.insert(entry.get()).second)
+                        affected.push_back(entry);
+                }
+
+                m_Dependents.erase(oldShader);
+            }
+
+            auto replace = [&replacements](ShaderHandle& shader)
+            {
+                if (!shader)
+                    return;
+                auto it = replacements.find(shader.Get());
+                if (it != replacements.end())
+                    shader = it->second;
+            };
+
+            for (const auto& entry : affected)
+            {
+                replace(entry->graphicsDesc.VS);
+                replace(entry->graphicsDesc.HS);
+                replace(entry->graphicsDesc.DS);
+                replace(entry->graphicsDesc.GS);
+                replace(entry->graphicsDesc.PS);
+                replace(entry->computeDesc.CS);
+                replace(entry->meshletDesc.AS);
+                replace(entry->meshletDesc.MS);
+                replace(entry->meshletDesc.PS);
+
+                scheduleRebuild(entry);
+            }
+        }
+
+        std::vector<CompletedRebuild> completed;
+        {
+            std::lock_guard lockGuard(m_CompletedMutex);
+            completed.swap(m_Completed);
+        }
+
+        uint32_t numReplaced = 0;
+        for (auto& result : completed)
+        {
+            auto task = m_Tasks.find(result.job);
+            if (task != m_Tasks.end())
+            {
+                // The result is in, but the scheduler still needs its wait
+                m_TaskScheduler->wait(task->second);
+                m_Tasks.erase(task);
+            }
+
+            PipelineEntry& entry = *result.entry;
+            if (result.generation <= entry.publishedGeneration)
+                continue;
+
+            if (!result.graphicsPipeline && !result.computePipeline && !result.meshletPipeline)
+            {
+                warning("ShaderReloader: pipeline rebuild failed, keeping the previous version");
+                continue;
+            }
+
+            entry.publishedGeneration = result.generation;
+
+            if (entry.graphicsSlot)
+            {
+                entry.graphicsSlot->pipeline = std::move(result.graphicsPipeline);
+                ++entry.graphicsSlot->version;
+            }
+            else if (entry.computeSlot)
+            {
+                entry.computeSlot->pipeline = std::move(result.computePipeline);
+                ++entry.computeSlot->version;
+            }
+            else if (entry.meshletSlot)
+            {
+                entry.meshletSlot->pipeline = std::move(result.meshletPipeline);
+                ++entry.meshletSlot->version;
+            }
+
+            ++numReplaced;
+        }
+
+        return numReplaced;
+    }
+
+    void ShaderReloader::waitForRebuilds()
+    {
+        for (const auto& [job, task] : m_Tasks)
+            m_TaskScheduler->wait(task);
+        m_Tasks.clear();
+    }
+
+    void ShaderReloader::warning(const std::string& message)
+    {
+        if (IMessageCallback* callback = m_Device->getMessageCallback())
+            callback->message(MessageSeverity::Warning, message.c_str());
+    }
+} // namespace nvrhi
@@ -28,7 +28,57 @@
 
 namespace nvrhi
 {
-    bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback)
+    void QueueOwnershipTracker::commandListSubmitted(CommandQueue queue, CommandListResourceStateTracker& stateTracker,
+        std::vector<QueueOwnershipTransfer>& outTransfers)
+    {
+        const uint32_t family = getQueueFamily(queue);
+
+        for (const auto& [texture, tracking] : stateTracker.m_TextureStates)
+        {
+            // Nothing to preserve if the texture has never been left in a known state
+            const bool hasContents = texture->ownerState != ResourceStates::Unknown || !texture->ownerSubresourceStates.empty();
+
+            if (texture->ownerQueue != CommandQueue::Count && getQueueFamily(texture->ownerQueue) != family && hasContents)
+            {
+                QueueOwnershipTransfer transfer;
+                transfer.texture = texture;
+                transfer.srcQueue = texture->ownerQueue;
+                transfer.dstQueue = queue;
+                transfer.state = texture->ownerState;
+                transfer.subresourceStates = texture->ownerSubresourceStates;
+                outTransfers.push_back(std::move(transfer));
+            }
+
+            texture->ownerQueue = queue;
+
+            if (tracking.state != ResourceStates::Unknown || !tracking.subresourceStates.empty())
+            {
+                texture->ownerState = tracking.state;
+                texture->ownerSubresourceStates.assign(tracking.subresourceStates.begin(), tracking.subresourceStates.end());
+            }
+        }
+
+        for (const auto& [buffer, tracking] : stateTracker.m_BufferStates)
+        {
+            if (buffer->ownerQueue != CommandQueue::Count && getQueueFamily(buffer->ownerQueue) != family
+                && buffer->ownerState != ResourceStates::Unknown)
+            {
+                QueueOwnershipTransfer transfer;
+                transfer.buffer = buffer;
+                transfer.srcQueue = buffer->ownerQueue;
+                transfer.dstQueue = queue;
+                transfer.state = buffer->ownerState;
+                outTransfers.push_back(std::move(transfer));
+            }
+
+            buffer->ownerQueue = queue;
+
+            if (tracking.state != ResourceStates::Unknown)
+                buffer->ownerState = tracking.state;
+        }
+    }
+
+    bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const DebugName& debugName, IMessageCallback* messageCallback)
     {
         if ((permanentState & requiredState) != requiredState)
         {
@@ -158,6 +208,10 @@ namespace nvrhi
         if (texture->permanentState != 0)
         {
             verifyPermanentResourceState(texture->permanentState, state, true, texture->descRef.debugName, m_MessageCallback);
+
+            if (m_TrackPermanentResourceUses)
+                getTextureStateTracking(texture, true)->state = texture->permanentState;
+
             return;
         }
 
@@ -260,6 +314,32 @@ namespace nvrhi
         }
     }
 
+    void CommandListResourceStateTracker::recordTextureUse(TextureStateExtension* texture)
+    {
+        if (!m_TrackPermanentResourceUses)
+            return;
+
+        TextureState* tracking = getTextureStateTracking(texture, true);
+
+        if (texture->permanentState != 0)
+            tracking->state = texture->permanentState;
+    }
+
+    void CommandListResourceStateTracker::recordBufferUse(BufferStateExtension* buffer)
+    {
+        if (!m_TrackPermanentResourceUses)
+            return;
+
+        // Same exclusions as in requireBufferState
+        if (buffer->descRef.isVolatile || (buffer->permanentState == 0 && buffer->descRef.cpuAccess != CpuAccessMode::None))
+            return;
+
+        BufferState* tracking = getBufferStateTracking(buffer, true);
+
+        if (buffer->permanentState != 0)
+            tracking->state = buffer->permanentState;
+    }
+
     void CommandListResourceStateTracker::requireBufferState(BufferStateExtension* buffer, ResourceStates state)
     {
         if (buffer->descRef.isVolatile)
@@ -269,6 +349,9 @@ namespace nvrhi
         {
             verifyPermanentResourceState(buffer->permanentState, state, false, buffer->descRef.debugName, m_MessageCallback);
 
+            if (m_TrackPermanentResourceUses)
+                getBufferStateTracking(buffer, true)->state = buffer->permanentState;
+
             return;
         }
 
@@ -333,7 +416,7 @@ namespace nvrhi
             if (buffer->descRef.keepInitialState && 
                 !buffer->permanentState &&
                 !buffer->descRef.isVolatile &&
-                !tracking->permanentTransition)
+                !tracking.permanentTransition)
             {
                 requireBufferState(buffer, buffer->descRef.initialState);
             }
@@ -346,7 +429,7 @@ namespace nvrhi
         {
             if (texture->descRef.keepInitialState && 
                 !texture->permanentState && 
-                !tracking->permanentTransition)
+                !tracking.permanentTransition)
             {
                 requireTextureState(texture, AllSubresources, texture->descRef.initialState);
             }
@@ -401,16 +484,13 @@ namespace nvrhi
 
         if (it != m_TextureStates.end())
         {
-            return it->second.get();
+            return &it->second;
         }
 
         if (!allowCreate)
             return nullptr;
         
-        std::unique_ptr<TextureState> trackingRef = std::make_unique<TextureState>();
-
-        TextureState* tracking = trackingRef.get();
-        m_TextureStates.insert(std::make_pair(texture, std::move(trackingRef)));
+        TextureState* tracking = &m_TextureStates.try_emplace(texture, TrackedAllocator<ResourceStates>(m_TextureStates.get_allocator())).first->second;
         
         if (texture->descRef.keepInitialState)
         {
@@ -426,16 +506,13 @@ namespace nvrhi
 
         if (it != m_BufferStates.end())
         {
-            return it->second.get();
+            return &it->second;
         }
 
         if (!allowCreate)
             return nullptr;
 
-        std::unique_ptr<BufferState> trackingRef = std::make_unique<BufferState>();
-
-        BufferState* tracking = trackingRef.get();
-        m_BufferStates.insert(std::make_pair(buffer, std::move(trackingRef)));
+        BufferState* tracking = &m_BufferStates[buffer];
                                                    
         if (buffer->descRef.keepInitialState)
         {
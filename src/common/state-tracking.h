@@ -23,6 +23,8 @@
 #pragma once
 
 #include <nvrhi/nvrhi.h>
+#include "allocator.h"
+#include <array>
 #include <memory>
 #include <unordered_map>
 
@@ -33,6 +35,10 @@ namespace nvrhi
         const BufferDesc& descRef;
         ResourceStates permanentState = ResourceStates::Unknown;
 
+        // Queue that last used the buffer and the state it was left in, see QueueOwnershipTracker
+        CommandQueue ownerQueue = CommandQueue::Count;
+        ResourceStates ownerState = ResourceStates::Unknown;
+
         explicit BufferStateExtension(const BufferDesc& desc)
             : descRef(desc)
         { }
@@ -44,6 +50,11 @@ namespace nvrhi
         ResourceStates permanentState = ResourceStates::Unknown;
         bool stateInitialized = false;
 
+        // Queue that last used the texture and the state it was left in, see QueueOwnershipTracker
+        CommandQueue ownerQueue = CommandQueue::Count;
+        ResourceStates ownerState = ResourceStates::Unknown;
+        std::vector<ResourceStates> ownerSubresourceStates;
+
         explicit TextureStateExtension(const TextureDesc& desc)
             : descRef(desc)
         { }
@@ -51,11 +62,15 @@ namespace nvrhi
 
     struct TextureState
     {
-        std::vector<ResourceStates> subresourceStates;
+        tracked_vector<ResourceStates> subresourceStates;
         ResourceStates state = ResourceStates::Unknown;
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
         bool permanentTransition = false;
+
+        explicit TextureState(const TrackedAllocator<ResourceStates>& allocator)
+            : subresourceStates(allocator)
+        { }
     };
 
     struct BufferState
@@ -83,11 +98,32 @@ namespace nvrhi
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
 
+    struct QueueOwnershipTransfer
+    {
+        TextureStateExtension* texture = nullptr;
+        BufferStateExtension* buffer = nullptr;
+        CommandQueue srcQueue = CommandQueue::Graphics;
+        CommandQueue dstQueue = CommandQueue::Graphics;
+
+        // The state is kept through the transfer, the release and acquire barriers only change the owner.
+        // If subresourceStates is not empty, it has the state of each texture subresource, like TextureState.
+        ResourceStates state = ResourceStates::Unknown;
+        std::vector<ResourceStates> subresourceStates;
+    };
+
     class CommandListResourceStateTracker
     {
+        friend class QueueOwnershipTracker;
+
     public:
-        explicit CommandListResourceStateTracker(IMessageCallback* messageCallback)
+        CommandListResourceStateTracker(IMessageCallback* messageCallback, AllocationTracker* allocationTracker = nullptr)
             : m_MessageCallback(messageCallback)
+            , m_TextureStates(TextureStateMap::allocator_type(allocationTracker, AllocationCategory::StateTracking))
+            , m_BufferStates(BufferStateMap::allocator_type(allocationTracker, AllocationCategory::StateTracking))
+            , m_PermanentTextureStates(TrackedAllocator<std::pair<TextureStateExtension*, ResourceStates>>(allocationTracker, AllocationCategory::StateTracking))
+            , m_PermanentBufferStates(TrackedAllocator<std::pair<BufferStateExtension*, ResourceStates>>(allocationTracker, AllocationCategory::StateTracking))
+            , m_TextureBarriers(TrackedAllocator<TextureBarrier>(allocationTracker, AllocationCategory::StateTracking))
+            , m_BufferBarriers(TrackedAllocator<BufferBarrier>(allocationTracker, AllocationCategory::StateTracking))
         { }
 
         // ICommandList-like interface
@@ -109,32 +145,71 @@ namespace nvrhi
         void requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state);
         void requireBufferState(BufferStateExtension* buffer, ResourceStates state);
 
+        // Also record the resources with permanent states that the command list uses, for QueueOwnershipTracker
+        void setTrackPermanentResourceUses(bool enable) { m_TrackPermanentResourceUses = enable; }
+
+        // Records that the command list uses the resource without requiring a state, for QueueOwnershipTracker.
+        // Used instead of require*State when automatic barriers are disabled. Does nothing unless
+        // permanent resource uses are tracked, which is the case when ownership transfers are enabled.
+        void recordTextureUse(TextureStateExtension* texture);
+        void recordBufferUse(BufferStateExtension* buffer);
+
         void keepBufferInitialStates();
         void keepTextureInitialStates();
         void commandListSubmitted();
 
-        [[nodiscard]] const std::vector<TextureBarrier>& getTextureBarriers() const { return m_TextureBarriers; }
-        [[nodiscard]] const std::vector<BufferBarrier>& getBufferBarriers() const { return m_BufferBarriers; }
+        [[nodiscard]] const tracked_vector<TextureBarrier>& getTextureBarriers() const { return m_TextureBarriers; }
+        [[nodiscard]] const tracked_vector<BufferBarrier>& getBufferBarriers() const { return m_BufferBarriers; }
         void clearBarriers() { m_TextureBarriers.clear(); m_BufferBarriers.clear(); }
 
     private:
+        // The states are stored in the map nodes, which don't move when the maps grow
+        typedef tracked_unordered_map<TextureStateExtension*, TextureState> TextureStateMap;
+        typedef tracked_unordered_map<BufferStateExtension*, BufferState> BufferStateMap;
+
         IMessageCallback* m_MessageCallback;
+        bool m_TrackPermanentResourceUses = false;
 
-        std::unordered_map<TextureStateExtension*, std::unique_ptr<TextureState>> m_TextureStates;
-        std::unordered_map<BufferStateExtension*, std::unique_ptr<BufferState>> m_BufferStates;
+        TextureStateMap m_TextureStates;
+        BufferStateMap m_BufferStates;
 
         // Deferred transitions of textures and buffers to permanent states.
         // They are executed only when the command list is executed, not when the app calls setPermanentTextureState or setPermanentBufferState.
-        std::vector<std::pair<TextureStateExtension*, ResourceStates>> m_PermanentTextureStates;
-        std::vector<std::pair<BufferStateExtension*, ResourceStates>> m_PermanentBufferStates;
+        tracked_vector<std::pair<TextureStateExtension*, ResourceStates>> m_PermanentTextureStates;
+        tracked_vector<std::pair<BufferStateExtension*, ResourceStates>> m_PermanentBufferStates;
 
-        std::vector<TextureBarrier> m_TextureBarriers;
-        std::vector<BufferBarrier> m_BufferBarriers;
+        tracked_vector<TextureBarrier> m_TextureBarriers;
+        tracked_vector<BufferBarrier> m_BufferBarriers;
 
         TextureState* getTextureStateTracking(TextureStateExtension* texture, bool allowCreate);
         BufferState* getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate);
     };
 
-    bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback);
+    // Pairs the queue family ownership release and acquire operations needed for exclusive-mode resources
+    // when they are used by command lists on queues from different families.
+    // The resources remember which queue used them last, and in which state. When a command list that uses
+    // a resource is submitted to a queue of another family, a transfer from the previous queue is produced.
+    // The backend must record the release on the source queue and the acquire on the destination queue,
+    // and make the destination queue wait for the release before the command list executes.
+    class QueueOwnershipTracker
+    {
+    public:
+        QueueOwnershipTracker() { m_QueueFamilies.fill(0); }
+
+        void setQueueFamily(CommandQueue queue, uint32_t family) { m_QueueFamilies[size_t(queue)] = family; }
+        [[nodiscard]] uint32_t getQueueFamily(CommandQueue queue) const { return m_QueueFamilies[size_t(queue)]; }
+
+        // Appends the transfers needed before the command list can execute on the queue and makes the queue
+        // the new owner of its resources. Must be called before CommandListResourceStateTracker::commandListSubmitted.
+        // Resources that the command list used without leaving them in a known state, which happens when
+        // automatic barriers are disabled, keep the state they were left in by the previous owner.
+        void commandListSubmitted(CommandQueue queue, CommandListResourceStateTracker& stateTracker,
+            std::vector<QueueOwnershipTransfer>& outTransfers);
+
+    private:
+        std::array<uint32_t, size_t(CommandQueue::Count)> m_QueueFamilies;
+    };
+
+    bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const DebugName& debugName, IMessageCallback* messageCallback);
 
 } // namespace nvrhi
\ No newline at end of file
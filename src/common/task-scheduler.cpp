@@ -0,0 +1,217 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "task-scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace nvrhi
+{
+    WorkerPoolTaskScheduler::WorkerPoolTaskScheduler(uint32_t numThreads)
+    {
+        m_Threads.reserve(numThreads);
+        for (uint32_t i = 0; i < numThreads; i++)
+            m_Threads.emplace_back(&WorkerPoolTaskScheduler::workerThreadProc, this);
+    }
+
+    WorkerPoolTaskScheduler::~WorkerPoolTaskScheduler()
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Terminate = true;
+        }
+        m_TaskAvailable.notify_all();
+
+        for (std::thread& thread : m_Threads)
+            thread.join();
+    }
+
+    void WorkerPoolTaskScheduler::runTask(Task& task, std::unique_lock<std::mutex>& lock)
+    {
+        lock.unlock();
+        task.function();
+        task.function = nullptr;
+        lock.lock();
+
+        if (task.id == 0)
+            return;
+
+        m_CompletedTasks.insert(task.id);
+        m_TaskCompleted.notify_all();
+    }
+
+    void WorkerPoolTaskScheduler::workerThreadProc()
+    {
+        std::unique_lock lock(m_Mutex);
+
+        while (true)
+        {
+            m_TaskAvailable.wait(lock, [this] { return m_Terminate || !m_Queue.empty(); });
+
+            if (m_Queue.empty())
+                return; // m_Terminate is set and there is no more work
+
+            Task task = std::move(m_Queue.front());
+            m_Queue.pop_front();
+            runTask(task, lock);
+        }
+    }
+
+    ITaskScheduler::TaskID WorkerPoolTaskScheduler::runAsync(std::function<void()> task)
+    {
+        TaskID id;
+        {
+            std::lock_guard lock(m_Mutex);
+            id = m_NextTaskID++;
+            m_Queue.push_back(Task{ id, std::move(task) });
+        }
+        m_TaskAvailable.notify_one();
+        return id;
+    }
+
+    void WorkerPoolTaskScheduler::wait(TaskID task)
+    {
+        std::unique_lock lock(m_Mutex);
+
+        // Run the task here if it hasn't started, a nested wait on a busy pool would deadlock otherwise
+        auto queued = std::find_if(m_Queue.begin(), m_Queue.end(), [task](const Task& other) { return other.id == task; });
+        if (queued != m_Queue.end())
+        {
+            Task queuedTask = std::move(*queued);
+            m_Queue.erase(queued);
+            runTask(queuedTask, lock);
+        }
+
+        m_TaskCompleted.wait(lock, [this, task] { return m_CompletedTasks.find(task) != m_CompletedTasks.end(); });
+        m_CompletedTasks.erase(task);
+    }
+
+    void WorkerPoolTaskScheduler::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function)
+    {
+        grainSize = std::max<size_t>(grainSize, 1);
+        const size_t numRanges = (count + grainSize - 1) / grainSize;
+
+        if (numRanges <= 1 || m_Threads.empty())
+        {
+            if (count > 0)
+                function(0, count);
+            return;
+        }
+
+        // The ranges are claimed through a shared counter by this thread and by the helper tasks.
+        // Helpers that start after all ranges are claimed exit immediately without touching 'function',
+        // so the call can return before they have run; the counters outlive it.
+        struct Counters
+        {
+            std::atomic<size_t> nextRange = 0;
+            std::atomic<size_t> completedRanges = 0;
+        };
+
+        auto counters = std::make_shared<Counters>();
+
+        auto processRanges = [this, counters, numRanges, count, grainSize, &function]()
+        {
+            size_t range;
+            while ((range = counters->nextRange.fetch_add(1)) < numRanges)
+            {
+                const size_t begin = range * grainSize;
+                function(begin, std::min(begin + grainSize, count));
+
+                if (counters->completedRanges.fetch_add(1) + 1 == numRanges)
+                {
+                    // Taking the lock orders this with the waiter's check of the counter
+                    {
+                        std::lock_guard lock(m_Mutex);
+                    }
+                    m_TaskCompleted.notify_all();
+                }
+            }
+        };
+
+        const size_t numHelpers = std::min(numRanges - 1, m_Threads.size());
+        {
+            std::lock_guard lock(m_Mutex);
+            for (size_t i = 0; i < numHelpers; i++)
+                m_Queue.push_back(Task{ 0, processRanges });
+        }
+        m_TaskAvailable.notify_all();
+
+        processRanges();
+
+        // All ranges are claimed, the ones that are not complete yet are running on other threads
+        std::unique_lock lock(m_Mutex);
+        m_TaskCompleted.wait(lock, [&counters, numRanges] { return counters->completedRanges.load() == numRanges; });
+    }
+
+    void TaskDispatcher::parallelFor(size_t count, size_t grainSize, size_t parallelThreshold, const std::function<void(size_t begin, size_t end)>& function)
+    {
+        if (count == 0)
+            return;
+
+        if (count < parallelThreshold)
+        {
+            function(0, count);
+            return;
+        }
+
+        getScheduler()->parallelFor(count, grainSize, function);
+    }
+
+    void TaskDispatcher::copyRows(void* dst, size_t dstRowPitch, size_t dstSlicePitch,
+        const void* src, size_t srcRowPitch, size_t srcSlicePitch,
+        size_t rowSize, size_t numRows, size_t numSlices)
+    {
+        if (rowSize == 0 || numRows == 0)
+            return;
+
+        const size_t grainSize = std::max<size_t>(c_ParallelCopyGrainSize / rowSize, 1);
+        const size_t parallelThreshold = std::max<size_t>(c_ParallelCopyThreshold / rowSize, 1);
+
+        parallelFor(numRows * numSlices, grainSize, parallelThreshold, [=](size_t begin, size_t end)
+        {
+            for (size_t index = begin; index < end; index++)
+            {
+                const size_t slice = index / numRows;
+                const size_t row = index % numRows;
+                memcpy(static_cast<uint8_t*>(dst) + dstSlicePitch * slice + dstRowPitch * row,
+                    static_cast<const uint8_t*>(src) + srcSlicePitch * slice + srcRowPitch * row,
+                    rowSize);
+            }
+        });
+    }
+
+    ITaskScheduler* TaskDispatcher::getScheduler()
+    {
+        if (m_Scheduler)
+            return m_Scheduler;
+
+        std::call_once(m_FallbackCreated, [this]()
+        {
+            const uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+            m_FallbackScheduler = std::make_unique<WorkerPoolTaskScheduler>(numThreads);
+        });
+
+        return m_FallbackScheduler.get();
+    }
+}
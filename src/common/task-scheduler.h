@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace nvrhi
+{
+    // Operations below these sizes run inline because scheduling would cost more than it saves.
+    constexpr size_t c_ParallelInstanceThreshold = 4096;        // TLAS instances
+    constexpr size_t c_ParallelInstanceGrainSize = 1024;
+    constexpr size_t c_ParallelCopyThreshold = 4 * 1024 * 1024; // bytes
+    constexpr size_t c_ParallelCopyGrainSize = 1024 * 1024;     // bytes
+
+    // The fallback task scheduler used when the application doesn't provide one.
+    // Threads never run unrelated tasks while they wait: parallelFor executes the ranges of its own call until
+    // all are claimed, and wait runs the awaited task inline if no worker has picked it up yet. Either way,
+    // whatever is left is already running on other threads, so nested use doesn't deadlock.
+    class WorkerPoolTaskScheduler final : public ITaskScheduler
+    {
+    public:
+        explicit WorkerPoolTaskScheduler(uint32_t numThreads);
+        ~WorkerPoolTaskScheduler() override;
+
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function) override;
+        TaskID runAsync(std::function<void()> task) override;
+        void wait(TaskID task) override;
+
+    private:
+        struct Task
+        {
+            TaskID id; // 0 for the internal tasks of parallelFor, which are not waited on
+            std::function<void()> function;
+        };
+
+        std::mutex m_Mutex;
+        std::condition_variable m_TaskAvailable;
+        std::condition_variable m_TaskCompleted;
+        std::deque<Task> m_Queue;
+        std::unordered_set<TaskID> m_CompletedTasks;
+        TaskID m_NextTaskID = 1;
+        bool m_Terminate = false;
+        std::vector<std::thread> m_Threads;
+
+        void workerThreadProc();
+        void runTask(Task& task, std::unique_lock<std::mutex>& lock);
+    };
+
+    // Routes the internal bulk operations of a device to the application's task scheduler,
+    // or to a WorkerPoolTaskScheduler that is created on first use.
+    class TaskDispatcher
+    {
+    public:
+        explicit TaskDispatcher(ITaskScheduler* scheduler)
+            : m_Scheduler(scheduler)
+        { }
+
+        // Calls function(begin, end) over [0, count), in parallel if count is at least parallelThreshold.
+        void parallelFor(size_t count, size_t grainSize, size_t parallelThreshold, const std::function<void(size_t begin, size_t end)>& function);
+
+        // Copies numSlices * numRows rows of rowSize bytes between two differently pitched images,
+        // such as from user memory into an upload buffer. Large copies are split by rows.
+        void copyRows(void* dst, size_t dstRowPitch, size_t dstSlicePitch,
+            const void* src, size_t srcRowPitch, size_t srcSlicePitch,
+            size_t rowSize, size_t numRows, size_t numSlices);
+
+        [[nodiscard]] ITaskScheduler* getScheduler();
+
+    private:
+        ITaskScheduler* m_Scheduler;
+        std::unique_ptr<WorkerPoolTaskScheduler> m_FallbackScheduler;
+        std::once_flag m_FallbackCreated;
+    };
+}
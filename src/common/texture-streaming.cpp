@@ -0,0 +1,461 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/texture-streaming.h>
+#include <algorithm>
+#include <queue>
+
+namespace nvrhi
+{
+    namespace
+    {
+        struct UploadCandidate
+        {
+            uint32_t texture;
+            MipLevel mipLevel;
+            bool locked;
+            float priority;
+        };
+
+        // Orders the priority queue so that the best candidate is on top
+        struct UploadCandidateWorse
+        {
+            bool operator()(const UploadCandidate& a, const UploadCandidate& b) const
+            {
+                if (a.locked != b.locked)
+                    return b.locked;
+                if (a.priority != b.priority)
+                    return a.priority < b.priority;
+                return a.mipLevel < b.mipLevel; // less detailed mips first
+            }
+        };
+
+        uint64_t getMipSize(const TextureDesc& desc, MipLevel mipLevel)
+        {
+            const FormatInfo& formatInfo = getFormatInfo(desc.format);
+            const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+            const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+            const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+            const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+            const uint64_t blocksX = (width + blockSize - 1) / blockSize;
+            const uint64_t blocksY = (height + blockSize - 1) / blockSize;
+
+            return blocksX * blocksY * depth * formatInfo.bytesPerBlock * desc.arraySize;
+        }
+    }
+
+    void planTextureStreaming(const std::vector<StreamingTextureState>& textures,
+        uint64_t memoryBudget, uint64_t uploadBudget, std::vector<StreamingAction>& outActions)
+    {
+        const uint32_t numTextures = uint32_t(textures.size());
+
+        // Residency as it will be after the actions planned so far
+        std::vector<MipLevel> residentMips(numTextures);
+        std::vector<MipLevel> pendingMips(numTextures);
+
+        uint64_t residentBytes = 0;
+        std::priority_queue<UploadCandidate, std::vector<UploadCandidate>, UploadCandidateWorse> candidates;
+
+        auto addNextCandidate = [&](uint32_t index)
+        {
+            const StreamingTextureState& state = textures[index];
+            const MipLevel pendingMip = pendingMips[index];
+            const MipLevel wantedMip = std::min(state.requestedMip, state.lockedMip);
+
+            if (pendingMip == 0 || pendingMip - 1 < wantedMip)
+                return;
+
+            const MipLevel mipLevel = pendingMip - 1;
+            candidates.push(UploadCandidate{ index, mipLevel, mipLevel >= state.lockedMip, state.priority });
+        };
+
+        for (uint32_t index = 0; index < numTextures; ++index)
+        {
+            const StreamingTextureState& state = textures[index];
+            if (!state.active)
+                continue;
+
+            residentMips[index] = state.residentMip;
+            pendingMips[index] = state.pendingMip;
+
+            for (MipLevel mipLevel = state.pendingMip; mipLevel < MipLevel(state.mipSizes.size()); ++mipLevel)
+                residentBytes += state.mipSizes[mipLevel];
+
+            addNextCandidate(index);
+        }
+
+        // Returns the texture to evict the most detailed resident mip from, or numTextures if there is none
+        auto findVictim = [&](uint32_t uploadTexture, float uploadPriority)
+        {
+            uint32_t victim = numTextures;
+            bool victimUnneeded = false;
+
+            for (uint32_t index = 0; index < numTextures; ++index)
+            {
+                const StreamingTextureState& state = textures[index];
+                const MipLevel residentMip = residentMips[index];
+
+                if (!state.active || index == uploadTexture)
+                    continue;
+
+                // Uploads in flight or locked mips
+                if (pendingMips[index] != residentMip || residentMip >= state.lockedMip)
+                    continue;
+
+                const bool unneeded = residentMip < state.requestedMip;
+                if (!unneeded && state.priority >= uploadPriority)
+                    continue;
+
+                if (victim != numTextures)
+                {
+                    if (victimUnneeded && !unneeded)
+                        continue;
+                    if (victimUnneeded == unneeded && textures[victim].priority <= state.priority)
+                        continue;
+                }
+
+                victim = index;
+                victimUnneeded = unneeded;
+            }
+
+            return victim;
+        };
+
+        uint64_t uploadedBytes = 0;
+
+        while (!candidates.empty())
+        {
+            const UploadCandidate candidate = candidates.top();
+            candidates.pop();
+
+            // The texture was evicted after this candidate was queued, uploading it would leave a hole in the mip chain
+            if (candidate.mipLevel + 1 != pendingMips[candidate.texture])
+                continue;
+
+            const StreamingTextureState& state = textures[candidate.texture];
+            const uint64_t mipSize = state.mipSizes[candidate.mipLevel];
+
+            if (!candidate.locked)
+            {
+                // Let a single mip that is larger than the upload budget through, or it would never be streamed in
+                if (uploadedBytes != 0 && uploadedBytes + mipSize > uploadBudget)
+                    continue;
+
+                const size_t firstEviction = outActions.size();
+                uint64_t freedBytes = 0;
+
+                while (residentBytes - freedBytes + mipSize > memoryBudget)
+                {
+                    const uint32_t victim = findVictim(candidate.texture, candidate.priority);
+                    if (victim == numTextures)
+                        break;
+
+                    const MipLevel evictedMip = residentMips[victim];
+                    outActions.push_back(StreamingAction{ StreamingAction::Type::Evict, victim, evictedMip });
+
+                    freedBytes += textures[victim].mipSizes[evictedMip];
+                    residentMips[victim] = evictedMip + 1;
+                    pendingMips[victim] = evictedMip + 1;
+                }
+
+                if (residentBytes - freedBytes + mipSize > memoryBudget)
+                {
+                    // Evicting everything that can go does not make room, so keep it
+                    while (outActions.size() > firstEviction)
+                    {
+                        const StreamingAction& eviction = outActions.back();
+                        residentMips[eviction.texture] = eviction.mipLevel;
+                        pendingMips[eviction.texture] = eviction.mipLevel;
+                        outActions.pop_back();
+                    }
+                    continue;
+                }
+
+                residentBytes -= freedBytes;
+            }
+
+            outActions.push_back(StreamingAction{ StreamingAction::Type::Upload, candidate.texture, candidate.mipLevel });
+
+            residentBytes += mipSize;
+            uploadedBytes += mipSize;
+            pendingMips[candidate.texture] = candidate.mipLevel;
+
+            addNextCandidate(candidate.texture);
+        }
+    }
+
+    TextureStreamingManager::TextureStreamingManager(IDevice* device, const TextureStreamingDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        if (m_Desc.uploadQueue != CommandQueue::Graphics)
+        {
+            const Feature queueFeature = m_Desc.uploadQueue == CommandQueue::Copy ? Feature::CopyQueue : Feature::ComputeQueue;
+            if (!m_Device->queryFeatureSupport(queueFeature))
+                m_Desc.uploadQueue = CommandQueue::Graphics;
+        }
+
+        m_CommandList = m_Device->createCommandList(CommandListParameters()
+            .setQueueType(m_Desc.uploadQueue)
+            .setEnableImmediateExecution(false));
+    }
+
+    bool TextureStreamingManager::isValid(StreamedTextureID texture) const
+    {
+        return texture < StreamedTextureID(m_States.size()) && m_States[texture].active;
+    }
+
+    StreamedTextureID TextureStreamingManager::addTexture(const StreamedTextureDesc& desc)
+    {
+        if (!desc.texture || !desc.loadSubresource)
+            return c_InvalidStreamedTexture;
+
+        StreamedTextureID id;
+        if (!m_FreeSlots.empty())
+        {
+            id = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            id = StreamedTextureID(m_Slots.size());
+            m_Slots.emplace_back();
+            m_States.emplace_back();
+        }
+
+        const TextureDesc& textureDesc = desc.texture->getDesc();
+        const MipLevel mipLevels = textureDesc.mipLevels;
+
+        Slot& slot = m_Slots[id];
+        slot.desc = desc;
+        ++slot.generation;
+
+        StreamingTextureState& state = m_States[id];
+        state.mipSizes.resize(mipLevels);
+        for (MipLevel mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
+            state.mipSizes[mipLevel] = getMipSize(textureDesc, mipLevel);
+
+        state.residentMip = mipLevels;
+        state.pendingMip = mipLevels;
+        state.requestedMip = mipLevels;
+        state.lockedMip = mipLevels - std::min(desc.lockedMips, mipLevels);
+        state.priority = 0.f;
+        state.active = true;
+
+        return id;
+    }
+
+    void TextureStreamingManager::removeTexture(StreamedTextureID texture)
+    {
+        if (!isValid(texture))
+            return;
+
+        // Uploads still in flight are recognized by the generation and ignored
+        m_Slots[texture].desc = StreamedTextureDesc();
+        m_States[texture].active = false;
+        m_States[texture].mipSizes.clear();
+        m_FreeSlots.push_back(texture);
+    }
+
+    void TextureStreamingManager::setFeedback(StreamedTextureID texture, MipLevel requestedMip, float priority)
+    {
+        if (!isValid(texture))
+            return;
+
+        StreamingTextureState& state = m_States[texture];
+        state.requestedMip = std::min(requestedMip, MipLevel(state.mipSizes.size()));
+        state.priority = priority;
+    }
+
+    MipLevel TextureStreamingManager::getResidentMip(StreamedTextureID texture) const
+    {
+        if (!isValid(texture))
+            return 0;
+
+        return m_States[texture].residentMip;
+    }
+
+    TextureSubresourceSet TextureStreamingManager::getResidentSubresources(StreamedTextureID texture) const
+    {
+        if (!isValid(texture))
+            return TextureSubresourceSet();
+
+        const StreamingTextureState& state = m_States[texture];
+        const MipLevel mipLevels = MipLevel(state.mipSizes.size());
+
+        // A texture without resident mips has nothing valid to sample, keep the least detailed mip in the view
+        const MipLevel baseMip = std::min(state.residentMip, mipLevels - 1);
+
+        return TextureSubresourceSet(baseMip, mipLevels - baseMip, 0, TextureSubresourceSet::AllArraySlices);
+    }
+
+    void TextureStreamingManager::notifyResidencyChanged(StreamedTextureID texture)
+    {
+        if (m_Desc.onResidencyChanged)
+            m_Desc.onResidencyChanged(texture, m_States[texture].residentMip);
+    }
+
+    void TextureStreamingManager::retireCompletedBatches()
+    {
+        while (!m_PendingBatches.empty())
+        {
+            Batch& batch = m_PendingBatches.front();
+            if (!m_Device->pollEventQuery(batch.query))
+                break;
+
+            for (const Upload& upload : batch.uploads)
+            {
+                if (!isValid(upload.texture) || m_Slots[upload.texture].generation != upload.generation)
+                    continue;
+
+                StreamingTextureState& state = m_States[upload.texture];
+
+                // The mip may have been evicted again while it was in flight
+                if (upload.mipLevel < state.pendingMip || upload.mipLevel >= state.residentMip)
+                    continue;
+
+                state.residentMip = upload.mipLevel;
+                notifyResidencyChanged(upload.texture);
+            }
+
+            m_Device->resetEventQuery(batch.query);
+            m_FreeQueries.push_back(batch.query);
+            m_PendingBatches.pop_front();
+        }
+    }
+
+    bool TextureStreamingManager::uploadMip(StreamedTextureID texture, MipLevel mipLevel)
+    {
+        const StreamedTextureDesc& desc = m_Slots[texture].desc;
+        const TextureDesc& textureDesc = desc.texture->getDesc();
+
+        // Load all slices first so that a missing one doesn't leave the mip partially written
+        std::vector<StreamingSubresourceData> slices(textureDesc.arraySize);
+        for (ArraySlice arraySlice = 0; arraySlice < textureDesc.arraySize; ++arraySlice)
+        {
+            if (!desc.loadSubresource(mipLevel, arraySlice, slices[arraySlice]) || !slices[arraySlice].data)
+                return false;
+        }
+
+        for (ArraySlice arraySlice = 0; arraySlice < textureDesc.arraySize; ++arraySlice)
+        {
+            const StreamingSubresourceData& data = slices[arraySlice];
+            m_CommandList->writeTexture(desc.texture, arraySlice, mipLevel, data.data, data.rowPitch, data.depthPitch);
+        }
+
+        return true;
+    }
+
+    void TextureStreamingManager::update()
+    {
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point startTime = Clock::now();
+
+        retireCompletedBatches();
+
+        m_Actions.clear();
+        planTextureStreaming(m_States, m_Desc.memoryBudget, m_Desc.uploadBytesPerUpdate, m_Actions);
+
+        m_Statistics.uploadedBytes = 0;
+        m_Statistics.uploadedMips = 0;
+        m_Statistics.evictedMips = 0;
+
+        Batch batch;
+        std::vector<bool> stalled(m_States.size(), false);
+        bool commandListOpen = false;
+
+        for (const StreamingAction& action : m_Actions)
+        {
+            StreamingTextureState& state = m_States[action.texture];
+
+            if (action.type == StreamingAction::Type::Evict)
+            {
+                state.residentMip = action.mipLevel + 1;
+                state.pendingMip = state.residentMip;
+                ++m_Statistics.evictedMips;
+                notifyResidencyChanged(action.texture);
+                continue;
+            }
+
+            // A less detailed mip of this texture could not be loaded, so the more detailed ones have to wait
+            if (stalled[action.texture])
+                continue;
+
+            if (!commandListOpen)
+            {
+                m_CommandList->open();
+                commandListOpen = true;
+            }
+
+            if (!uploadMip(action.texture, action.mipLevel))
+            {
+                stalled[action.texture] = true;
+                continue;
+            }
+
+            state.pendingMip = action.mipLevel;
+            batch.uploads.push_back(Upload{ action.texture, m_Slots[action.texture].generation, action.mipLevel });
+
+            m_Statistics.uploadedBytes += state.mipSizes[action.mipLevel];
+            ++m_Statistics.uploadedMips;
+
+            const float elapsedMs = std::chrono::duration<float, std::milli>(Clock::now() - startTime).count();
+            if (elapsedMs >= m_Desc.uploadTimeBudgetMs)
+                break;
+        }
+
+        if (commandListOpen)
+        {
+            m_CommandList->close();
+            m_Device->executeCommandList(m_CommandList, m_Desc.uploadQueue);
+        }
+
+        if (!batch.uploads.empty())
+        {
+            if (!m_FreeQueries.empty())
+            {
+                batch.query = m_FreeQueries.back();
+                m_FreeQueries.pop_back();
+            }
+            else
+            {
+                batch.query = m_Device->createEventQuery();
+            }
+
+            m_Device->setEventQuery(batch.query, m_Desc.uploadQueue);
+            m_PendingBatches.push_back(std::move(batch));
+        }
+
+        uint64_t residentBytes = 0;
+        for (const StreamingTextureState& state : m_States)
+        {
+            for (MipLevel mipLevel = state.pendingMip; mipLevel < MipLevel(state.mipSizes.size()); ++mipLevel)
+                residentBytes += state.mipSizes[mipLevel];
+        }
+
+        m_Statistics.residentBytes = residentBytes;
+        m_Statistics.pendingBatches = uint32_t(m_PendingBatches.size());
+    }
+}
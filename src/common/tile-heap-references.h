@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Keeps the heaps that back the mapped tiles of a tiled texture alive, so that releasing a heap handle
+    // in the application doesn't free memory that the texture still uses. Each standard tile and each packed
+    // mip tail holds a reference to its heap until it's unmapped or remapped, or the texture is destroyed.
+    // Not thread safe; the backends update it from updateTextureTileMappings.
+    class TileHeapReferences
+    {
+    public:
+        // Sets the heap of every tile in the region, or of the array slice's packed mips if 'packed' is true.
+        // A null heap unmaps the tiles. The heaps that the tiles used before are appended to outReplacedHeaps
+        // if it's provided, so that the caller can keep them alive until the GPU stops using the old mapping.
+        void map(const TiledTextureCoordinate& coordinate, const TiledTextureRegion& region, bool packed, IHeap* heap,
+            std::vector<HeapHandle>* outReplacedHeaps = nullptr)
+        {
+            if (packed)
+            {
+                set(getKey(coordinate.arrayLevel, c_PackedMipKey, 0, 0, 0), heap, outReplacedHeaps);
+                return;
+            }
+
+            for (uint32_t z = 0; z < region.depth; ++z)
+            {
+                for (uint32_t y = 0; y < region.height; ++y)
+                {
+                    for (uint32_t x = 0; x < region.width; ++x)
+                    {
+                        set(getKey(coordinate.arrayLevel, coordinate.mipLevel,
+                            coordinate.x + x, coordinate.y + y, coordinate.z + z), heap, outReplacedHeaps);
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] size_t getMappedTileCount() const { return m_Tiles.size(); }
+
+    private:
+        static constexpr uint32_t c_PackedMipKey = 0xff;
+
+        // Tile coordinates fit into 14 bits for x and y and 12 bits for z: 16K texels with tiles at least 4 texels
+        // wide, and 2K slices of a 3D texture.
+        static uint64_t getKey(uint32_t arraySlice, uint32_t mipLevel, uint32_t x, uint32_t y, uint32_t z)
+        {
+            return (uint64_t(arraySlice) << 48) | (uint64_t(mipLevel & 0xff) << 40) |
+                (uint64_t(z & 0xfff) << 28) | (uint64_t(y & 0x3fff) << 14) | uint64_t(x & 0x3fff);
+        }
+
+        void set(uint64_t key, IHeap* heap, std::vector<HeapHandle>* outReplacedHeaps)
+        {
+            auto found = m_Tiles.find(key);
+            if (found != m_Tiles.end() && found->second != heap && outReplacedHeaps)
+            {
+                // Neighbouring tiles usually come from the same heap, store it once per run
+                if (outReplacedHeaps->empty() || outReplacedHeaps->back() != found->second)
+                    outReplacedHeaps->push_back(found->second);
+            }
+
+            if (heap)
+            {
+                if (found != m_Tiles.end())
+                    found->second = heap;
+                else
+                    m_Tiles.emplace(key, heap);
+            }
+            else if (found != m_Tiles.end())
+            {
+                m_Tiles.erase(found);
+            }
+        }
+
+        std::unordered_map<uint64_t, HeapHandle> m_Tiles;
+    };
+}
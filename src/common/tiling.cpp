@@ -0,0 +1,137 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/tiling.h>
+#include <algorithm>
+
+namespace nvrhi
+{
+    namespace
+    {
+        uint32_t divideRoundUp(uint32_t value, uint32_t divisor)
+        {
+            return divisor ? (value + divisor - 1) / divisor : 0;
+        }
+
+        void getMipDimensions(const TextureDesc& desc, MipLevel mipLevel, uint32_t& width, uint32_t& height, uint32_t& depth)
+        {
+            width = std::max(desc.width >> mipLevel, 1u);
+            height = std::max(desc.height >> mipLevel, 1u);
+            depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+        }
+
+        uint32_t getTileDepth(const TileShape& tileShape)
+        {
+            return std::max(tileShape.depthInTexels, 1u);
+        }
+    }
+
+    uint32_t computeNumStandardMips(const TextureDesc& desc, const TileShape& tileShape)
+    {
+        if (tileShape.widthInTexels == 0 || tileShape.heightInTexels == 0)
+            return 0;
+
+        uint32_t numStandardMips = 0;
+        for (MipLevel mipLevel = 0; mipLevel < desc.mipLevels; ++mipLevel)
+        {
+            uint32_t width, height, depth;
+            getMipDimensions(desc, mipLevel, width, height, depth);
+
+            if (width < tileShape.widthInTexels || height < tileShape.heightInTexels || depth < getTileDepth(tileShape))
+                break;
+
+            ++numStandardMips;
+        }
+
+        return numStandardMips;
+    }
+
+    uint32_t computeSubresourceTilings(const TextureDesc& desc, const TileShape& tileShape,
+        uint32_t numStandardMips, SubresourceTiling* outTilings, uint32_t firstTileIndex)
+    {
+        uint32_t tileIndex = firstTileIndex;
+
+        for (MipLevel mipLevel = 0; mipLevel < numStandardMips; ++mipLevel)
+        {
+            uint32_t width, height, depth;
+            getMipDimensions(desc, mipLevel, width, height, depth);
+
+            SubresourceTiling& tiling = outTilings[mipLevel];
+            tiling.widthInTiles = divideRoundUp(width, tileShape.widthInTexels);
+            tiling.heightInTiles = divideRoundUp(height, tileShape.heightInTexels);
+            tiling.depthInTiles = divideRoundUp(depth, getTileDepth(tileShape));
+            tiling.startTileIndexInOverallResource = tileIndex;
+
+            tileIndex += tiling.widthInTiles * tiling.heightInTiles * tiling.depthInTiles;
+        }
+
+        return tileIndex - firstTileIndex;
+    }
+
+    void getTilesForTexels(const TextureDesc& desc, const TileShape& tileShape, const TextureSlice& slice,
+        TiledTextureCoordinate& outCoordinate, TiledTextureRegion& outRegion)
+    {
+        const TextureSlice resolved = slice.resolve(desc);
+        const uint32_t tileDepth = getTileDepth(tileShape);
+
+        outCoordinate.mipLevel = uint16_t(resolved.mipLevel);
+        outCoordinate.arrayLevel = uint16_t(resolved.arraySlice);
+
+        // Not a tiled texture, or the shape hasn't been queried
+        if (tileShape.widthInTexels == 0 || tileShape.heightInTexels == 0)
+        {
+            outCoordinate.x = outCoordinate.y = outCoordinate.z = 0;
+            outRegion = TiledTextureRegion();
+            return;
+        }
+        outCoordinate.x = resolved.x / tileShape.widthInTexels;
+        outCoordinate.y = resolved.y / tileShape.heightInTexels;
+        outCoordinate.z = resolved.z / tileDepth;
+
+        outRegion.width = divideRoundUp(resolved.x + resolved.width, tileShape.widthInTexels) - outCoordinate.x;
+        outRegion.height = divideRoundUp(resolved.y + resolved.height, tileShape.heightInTexels) - outCoordinate.y;
+        outRegion.depth = divideRoundUp(resolved.z + resolved.depth, tileDepth) - outCoordinate.z;
+        outRegion.tilesNum = outRegion.width * outRegion.height * outRegion.depth;
+    }
+
+    TextureSlice getTexelsForTiles(const TextureDesc& desc, const TileShape& tileShape,
+        const TiledTextureCoordinate& coordinate, const TiledTextureRegion& region)
+    {
+        uint32_t width, height, depth;
+        getMipDimensions(desc, coordinate.mipLevel, width, height, depth);
+
+        const uint32_t tileDepth = getTileDepth(tileShape);
+
+        TextureSlice slice;
+        slice.mipLevel = coordinate.mipLevel;
+        slice.arraySlice = coordinate.arrayLevel;
+        slice.x = std::min(coordinate.x * tileShape.widthInTexels, width);
+        slice.y = std::min(coordinate.y * tileShape.heightInTexels, height);
+        slice.z = std::min(coordinate.z * tileDepth, depth);
+        slice.width = std::min((coordinate.x + region.width) * tileShape.widthInTexels, width) - slice.x;
+        slice.height = std::min((coordinate.y + region.height) * tileShape.heightInTexels, height) - slice.y;
+        slice.depth = std::min((coordinate.z + region.depth) * tileDepth, depth) - slice.z;
+
+        return slice;
+    }
+}
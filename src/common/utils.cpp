@@ -162,6 +162,35 @@ namespace nvrhi::utils
         return Format::UNKNOWN;
     }
 
+    GraphicsPipelineDesc RemoveDynamicRenderState(const GraphicsPipelineDesc& desc)
+    {
+        GraphicsPipelineDesc result = desc;
+        const DynamicRenderStateFlags groups = desc.dynamicRenderState;
+        const RasterState defaultRasterState;
+        const DepthStencilState defaultDepthStencilState;
+        RasterState& rasterState = result.renderState.rasterState;
+        DepthStencilState& depthStencilState = result.renderState.depthStencilState;
+
+        if ((groups & DynamicRenderStateFlags::CullMode) != 0)
+            rasterState.cullMode = defaultRasterState.cullMode;
+        if ((groups & DynamicRenderStateFlags::FrontFace) != 0)
+            rasterState.frontCounterClockwise = defaultRasterState.frontCounterClockwise;
+        if ((groups & DynamicRenderStateFlags::DepthTest) != 0)
+            depthStencilState.depthTestEnable = defaultDepthStencilState.depthTestEnable;
+        if ((groups & DynamicRenderStateFlags::DepthWrite) != 0)
+            depthStencilState.depthWriteEnable = defaultDepthStencilState.depthWriteEnable;
+        if ((groups & DynamicRenderStateFlags::DepthCompare) != 0)
+            depthStencilState.depthFunc = defaultDepthStencilState.depthFunc;
+        if ((groups & DynamicRenderStateFlags::Stencil) != 0)
+        {
+            depthStencilState.stencilEnable = defaultDepthStencilState.stencilEnable;
+            depthStencilState.frontFaceStencil = defaultDepthStencilState.frontFaceStencil;
+            depthStencilState.backFaceStencil = defaultDepthStencilState.backFaceStencil;
+        }
+
+        return result;
+    }
+
     const char* GraphicsAPIToString(GraphicsAPI api)
     {
         switch (api)
@@ -191,7 +220,7 @@ namespace nvrhi::utils
         }
     }
 
-    const char* DebugNameToString(const std::string& debugName)
+    const char* DebugNameToString(const DebugName& debugName)
     {
         return debugName.empty() ? "<UNNAMED>" : debugName.c_str();
     }
@@ -25,6 +25,9 @@
 #include <nvrhi/d3d11.h>
 #include <nvrhi/common/resourcebindingmap.h>
 #include "../common/dxgi-format.h"
+#include "../common/object-pool.h"
+#include "../common/allocator.h"
+#include "../common/task-scheduler.h"
 
 #include <d3d11_1.h>
 #include <map>
@@ -62,6 +65,8 @@ namespace nvrhi::d3d11
         RefCountPtr<ID3D11DeviceContext> immediateContext;
         RefCountPtr<ID3D11DeviceContext1> immediateContext1;
         RefCountPtr<ID3D11Buffer> pushConstantBuffer;
+        // dynamic buffer for push constant blocks larger than c_MaxPushConstantSize, renamed by the driver on each write
+        RefCountPtr<ID3D11Buffer> largePushConstantBuffer;
         IMessageCallback* messageCallback = nullptr;
         bool nvapiAvailable = false;
 #if NVRHI_WITH_AFTERMATH
@@ -71,7 +76,7 @@ namespace nvrhi::d3d11
         void error(const std::string& message) const;
     };
 
-    class Texture : public RefCounter<ITexture>
+    class Texture : public RefCounter<ITexture>, public PooledObject<Texture>
     {
     public:
         TextureDesc desc;
@@ -106,7 +111,7 @@ namespace nvrhi::d3d11
         const TextureDesc& getDesc() const override { return texture->getDesc(); }
     };
 
-    class Buffer : public RefCounter<IBuffer>
+    class Buffer : public RefCounter<IBuffer>, public PooledObject<Buffer>
     {
     public:
         BufferDesc desc;
@@ -152,14 +157,14 @@ namespace nvrhi::d3d11
         const SamplerDesc& getDesc() const override { return desc; }
     };
 
-    class EventQuery : public RefCounter<IEventQuery>
+    class EventQuery : public RefCounter<IEventQuery>, public PooledObject<EventQuery>
     {
     public:
         RefCountPtr<ID3D11Query> query;
         bool resolved = false;
     };
 
-    class TimerQuery : public RefCounter<ITimerQuery>
+    class TimerQuery : public RefCounter<ITimerQuery>, public PooledObject<TimerQuery>
     {
     public:
         RefCountPtr<ID3D11Query> start;
@@ -249,7 +254,7 @@ namespace nvrhi::d3d11
         const BindlessLayoutDesc* getBindlessDesc() const override { return nullptr; }
     };
 
-    class BindingSet : public RefCounter<IBindingSet>
+    class BindingSet : public RefCounter<IBindingSet>, public PooledObject<BindingSet>
     {
     public:
         BindingSetDesc desc;
@@ -310,6 +315,7 @@ namespace nvrhi::d3d11
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        IBuffer* allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
 
@@ -318,6 +324,8 @@ namespace nvrhi::d3d11
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -325,6 +333,7 @@ namespace nvrhi::d3d11
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
@@ -435,6 +444,8 @@ namespace nvrhi::d3d11
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
@@ -508,15 +519,19 @@ namespace nvrhi::d3d11
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+        AllocationStatistics getAllocationStatistics() override { return m_AllocationTracker.getStatistics(); }
+        ITaskScheduler* getTaskScheduler() override { return m_TaskDispatcher.getScheduler(); }
 
     private:
         Context m_Context;
+        AllocationTracker m_AllocationTracker;
+        TaskDispatcher m_TaskDispatcher;
         EventQueryHandle m_WaitForIdleQuery;
         CommandListHandle m_ImmediateCommandList;
 
-        std::unordered_map<size_t, RefCountPtr<ID3D11BlendState>> m_BlendStates;
-        std::unordered_map<size_t, RefCountPtr<ID3D11DepthStencilState>> m_DepthStencilStates;
-        std::unordered_map<size_t, RefCountPtr<ID3D11RasterizerState>> m_RasterizerStates;
+        tracked_unordered_map<size_t, RefCountPtr<ID3D11BlendState>> m_BlendStates;
+        tracked_unordered_map<size_t, RefCountPtr<ID3D11DepthStencilState>> m_DepthStencilStates;
+        tracked_unordered_map<size_t, RefCountPtr<ID3D11RasterizerState>> m_RasterizerStates;
 
         bool m_SinglePassStereoSupported = false;
         bool m_FastGeometryShaderSupported = false;
@@ -180,6 +180,16 @@ namespace nvrhi::d3d11
         }
     }
 
+    IBuffer* CommandList::allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress)
+    {
+        (void)byteSize;
+        (void)outOffset;
+        (void)outCpuAddress;
+
+        // Writes go through UpdateSubresource, use writeBuffer
+        return nullptr;
+    }
+
     void CommandList::clearBufferUInt(IBuffer* buffer, uint32_t clearValue)
     {
         const BufferDesc& bufferDesc = buffer->getDesc();
@@ -168,8 +168,19 @@ namespace nvrhi::d3d11
 
     void CommandList::setPushConstants(const void* data, size_t byteSize)
     {
+        if (byteSize > c_MaxPushConstantBufferSize)
+            return;
+
         if (byteSize > c_MaxPushConstantSize)
+        {
+            D3D11_MAPPED_SUBRESOURCE mappedResource;
+            if (FAILED(m_Context.immediateContext->Map(m_Context.largePushConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+                return;
+
+            memcpy(mappedResource.pData, data, byteSize);
+            m_Context.immediateContext->Unmap(m_Context.largePushConstantBuffer, 0);
             return;
+        }
 
         memcpy(g_PushConstantPaddingBuffer, data, byteSize);
 
@@ -188,6 +199,11 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::dispatchMeshIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::setRayTracingState(const rt::State&)
     {
         utils::NotSupported();
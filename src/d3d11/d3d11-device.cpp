@@ -45,6 +45,11 @@ namespace nvrhi::d3d11
     }
 
     Device::Device(const DeviceDesc& desc)
+        : m_AllocationTracker(desc.allocator)
+        , m_TaskDispatcher(desc.taskScheduler)
+        , m_BlendStates(decltype(m_BlendStates)::allocator_type(&m_AllocationTracker, AllocationCategory::Caches))
+        , m_DepthStencilStates(decltype(m_DepthStencilStates)::allocator_type(&m_AllocationTracker, AllocationCategory::Caches))
+        , m_RasterizerStates(decltype(m_RasterizerStates)::allocator_type(&m_AllocationTracker, AllocationCategory::Caches))
     {
         m_Context.messageCallback = desc.messageCallback;
         m_Context.immediateContext = desc.context;
@@ -102,7 +107,7 @@ namespace nvrhi::d3d11
         bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
         bufferDesc.Usage = D3D11_USAGE_DEFAULT;
         bufferDesc.CPUAccessFlags = 0;
-        const HRESULT res = m_Context.device->CreateBuffer(&bufferDesc, nullptr, &m_Context.pushConstantBuffer);
+        HRESULT res = m_Context.device->CreateBuffer(&bufferDesc, nullptr, &m_Context.pushConstantBuffer);
 
         if (FAILED(res))
         {
@@ -111,6 +116,18 @@ namespace nvrhi::d3d11
             m_Context.error(ss.str());
         }
 
+        bufferDesc.ByteWidth = c_MaxPushConstantBufferSize;
+        bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+        bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        res = m_Context.device->CreateBuffer(&bufferDesc, nullptr, &m_Context.largePushConstantBuffer);
+
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateBuffer call failed for the large push constants buffer, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+        }
+
         m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, CommandListParameters()));   
     }
 
@@ -193,6 +210,8 @@ namespace nvrhi::d3d11
 #endif
         case Feature::ConstantBufferRanges:
             return m_Context.immediateContext1 != nullptr;
+        case Feature::MultiDrawIndirect:
+            return true; // emulated with a loop in drawIndirect
         default:
             return false;
         }
@@ -406,6 +406,17 @@ namespace nvrhi::d3d11
         }
     }
 
+    void CommandList::drawIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        // D3D11 has no GPU-side draw count; the count buffer would have to be read back to emulate it.
+        utils::NotSupported();
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
     ID3D11BlendState* Device::getBlendState(const BlendState& blendState)
     {
         size_t hash = 0;
@@ -148,10 +148,11 @@ BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLa
 
         case ResourceType::PushConstants:
         {
-            ret->constantBuffers[slot] = m_Context.pushConstantBuffer;
+            const bool isLarge = binding.range.byteSize > c_MaxPushConstantSize;
+            ret->constantBuffers[slot] = isLarge ? m_Context.largePushConstantBuffer : m_Context.pushConstantBuffer;
             // Set the offset and size of the CB range, in 16-byte constants, same as for constant buffers.
             ret->constantBufferOffsets[slot] = 0;
-            ret->constantBufferCounts[slot] = align(c_MaxPushConstantSize, c_ConstantBufferOffsetSizeAlignment) / sizeOfConstantInBytes;
+            ret->constantBufferCounts[slot] = align(isLarge ? c_MaxPushConstantBufferSize : c_MaxPushConstantSize, c_ConstantBufferOffsetSizeAlignment) / sizeOfConstantInBytes;
 
             ret->minConstantBufferSlot = std::min(ret->minConstantBufferSlot, slot);
             ret->maxConstantBufferSlot = std::max(ret->maxConstantBufferSlot, slot);
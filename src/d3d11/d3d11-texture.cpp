@@ -241,6 +241,16 @@ namespace nvrhi::d3d11
         utils::NotSupported();
         return false;
     }
+
+    void Device::getTextureTiling(ITexture*, uint32_t*, PackedMipDesc*, TileShape*, uint32_t*, SubresourceTiling*)
+    {
+        utils::NotSupported();
+    }
+
+    void Device::updateTextureTileMappings(ITexture*, const TextureTilesMapping*, uint32_t, CommandQueue)
+    {
+        utils::NotSupported();
+    }
     
     nvrhi::TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object _texture, const TextureDesc& desc)
     {
@@ -63,9 +63,14 @@
 
 #include <nvrhi/common/resourcebindingmap.h>
 #include <nvrhi/utils.h>
+#include "../common/allocator.h"
 #include "../common/state-tracking.h"
 #include "../common/dxgi-format.h"
 #include "../common/versioning.h"
+#include "../common/resource-references.h"
+#include "../common/tile-heap-references.h"
+#include "../common/object-pool.h"
+#include "../common/task-scheduler.h"
 
 #ifdef NVRHI_WITH_RTXMU
 #include <rtxmu/D3D12AccelStructManager.h>
@@ -113,10 +118,12 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12CommandSignature> drawIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> drawIndexedIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> dispatchIndirectSignature;
+        RefCountPtr<ID3D12CommandSignature> dispatchMeshIndirectSignature; // only created if meshlets are supported
         RefCountPtr<ID3D12QueryHeap> timerQueryHeap;
         RefCountPtr<Buffer> timerQueryResolveBuffer;
 
         IMessageCallback* messageCallback = nullptr;
+        TaskDispatcher* taskDispatcher = nullptr;
         void error(const std::string& message) const;
     };
 
@@ -169,9 +176,9 @@ namespace nvrhi::d3d12
 #endif
 
         // The cache does not own the RS objects, so store weak references
-        std::unordered_map<size_t, RootSignature*> rootsigCache;
+        tracked_unordered_map<size_t, RootSignature*> rootsigCache;
 
-        explicit DeviceResources(const Context& context, const DeviceDesc& desc);
+        DeviceResources(const Context& context, const DeviceDesc& desc, AllocationTracker* allocationTracker);
 
         uint8_t getFormatPlaneCount(DXGI_FORMAT format);
 
@@ -233,7 +240,7 @@ namespace nvrhi::d3d12
         const HeapDesc& getDesc() override { return desc; }
     };
 
-    class Texture : public RefCounter<ITexture>, public TextureStateExtension
+    class Texture : public RefCounter<ITexture>, public TextureStateExtension, public PooledObject<Texture>
     {
     public:
         const TextureDesc desc;
@@ -243,6 +250,9 @@ namespace nvrhi::d3d12
         HANDLE sharedHandle = nullptr;
         HeapHandle heap;
 
+        // Heaps that back the mapped tiles of a tiled texture
+        TileHeapReferences tileHeaps;
+
         Texture(const Context& context, DeviceResources& resources, TextureDesc desc, const D3D12_RESOURCE_DESC& resourceDesc)
             : TextureStateExtension(this->desc)
             , desc(std::move(desc))
@@ -278,7 +288,7 @@ namespace nvrhi::d3d12
         std::vector<DescriptorIndex> m_ClearMipLevelUAVs;
     };
 
-    class Buffer : public RefCounter<IBuffer>, public BufferStateExtension
+    class Buffer : public RefCounter<IBuffer>, public BufferStateExtension, public PooledObject<Buffer>
     {
     public:
         const BufferDesc desc;
@@ -384,7 +394,7 @@ namespace nvrhi::d3d12
         const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
     };
 
-    class EventQuery : public RefCounter<IEventQuery>
+    class EventQuery : public RefCounter<IEventQuery>, public PooledObject<EventQuery>
     {
     public:
         RefCountPtr<ID3D12Fence> fence;
@@ -393,7 +403,7 @@ namespace nvrhi::d3d12
         bool resolved = false;
     };
 
-    class TimerQuery : public RefCounter<ITimerQuery>
+    class TimerQuery : public RefCounter<ITimerQuery>, public PooledObject<TimerQuery>
     {
     public:
         uint32_t beginQueryIndex = 0;
@@ -550,7 +560,7 @@ namespace nvrhi::d3d12
         Object getNativeObject(ObjectType objectType) override;
     };
     
-    class BindingSet : public RefCounter<IBindingSet>
+    class BindingSet : public RefCounter<IBindingSet>, public PooledObject<BindingSet>
     {
     public:
         RefCountPtr<BindingLayout> layout;
@@ -655,7 +665,8 @@ namespace nvrhi::d3d12
     class UploadManager
     {
     public:
-        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer);
+        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer,
+            AllocationTracker* allocationTracker);
 
         bool suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset, void** pCpuVA,
             D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment = 256);
@@ -669,8 +680,9 @@ namespace nvrhi::d3d12
         uint64_t m_MemoryLimit = 0;
         uint64_t m_AllocatedMemory = 0;
         bool m_IsScratchBuffer = false;
+        AllocationTracker* m_AllocationTracker;
 
-        std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
+        tracked_list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
 
         [[nodiscard]] std::shared_ptr<BufferChunk> createChunk(size_t size) const;
@@ -847,7 +859,7 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12Fence> fence;
         RefCountPtr<ID3D12CommandAllocator> commandAllocator;
         RefCountPtr<ID3D12CommandList> commandList;
-        std::vector<RefCountPtr<IResource>> referencedResources;
+        ResourceReferenceSet referencedResources;
         std::vector<RefCountPtr<IUnknown>> referencedNativeResources;
         std::vector<RefCountPtr<StagingTexture>> referencedStagingTextures;
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers;
@@ -894,6 +906,7 @@ namespace nvrhi::d3d12
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        IBuffer* allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
 
@@ -902,6 +915,8 @@ namespace nvrhi::d3d12
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -909,6 +924,7 @@ namespace nvrhi::d3d12
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
@@ -1008,7 +1024,7 @@ namespace nvrhi::d3d12
         ID3D12Resource* m_CurrentUploadBuffer = nullptr;
         SinglePassStereoState m_CurrentSinglePassStereoState;
         
-        std::unordered_map<IBuffer*, D3D12_GPU_VIRTUAL_ADDRESS> m_VolatileConstantBufferAddresses;
+        tracked_unordered_map<IBuffer*, D3D12_GPU_VIRTUAL_ADDRESS> m_VolatileConstantBufferAddresses;
         bool m_AnyVolatileBufferWrites = false;
 
         std::vector<D3D12_RESOURCE_BARRIER> m_D3DBarriers; // Used locally in commitBarriers, member to avoid re-allocations
@@ -1019,7 +1035,7 @@ namespace nvrhi::d3d12
         static_vector<VolatileConstantBufferBinding, c_MaxVolatileConstantBuffers> m_CurrentGraphicsVolatileCBs;
         static_vector<VolatileConstantBufferBinding, c_MaxVolatileConstantBuffers> m_CurrentComputeVolatileCBs;
 
-        std::unordered_map<rt::IShaderTable*, std::unique_ptr<ShaderTableState>> m_ShaderTableStates;
+        tracked_unordered_map<rt::IShaderTable*, ShaderTableState> m_ShaderTableStates;
         ShaderTableState* getShaderTableStateTracking(rt::IShaderTable* shaderTable);
         
         void clearStateCache();
@@ -1051,6 +1067,8 @@ namespace nvrhi::d3d12
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
@@ -1122,6 +1140,8 @@ namespace nvrhi::d3d12
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+        AllocationStatistics getAllocationStatistics() override { return m_AllocationTracker.getStatistics(); }
+        ITaskScheduler* getTaskScheduler() override { return m_TaskDispatcher.getScheduler(); }
 
         // d3d12::IDevice implementation
 
@@ -1134,6 +1154,7 @@ namespace nvrhi::d3d12
         Queue* getQueue(CommandQueue type) { return m_Queues[int(type)].get(); }
 
         Context& getContext() { return m_Context; }
+        AllocationTracker* getAllocationTracker() { return &m_AllocationTracker; }
 
         bool setHlslExtensionsUAV(uint32_t slot);
 
@@ -1142,7 +1163,9 @@ namespace nvrhi::d3d12
         bool GetNvapiIsInitialized() const { return m_NvapiIsInitialized; }
     private:
         Context m_Context;
+        AllocationTracker m_AllocationTracker;
         DeviceResources m_Resources;
+        TaskDispatcher m_TaskDispatcher;
 
         std::array<std::unique_ptr<Queue>, (int)CommandQueue::Count> m_Queues;
         HANDLE m_FenceEvent;
@@ -480,12 +480,22 @@ namespace nvrhi::d3d12
             }
             commitBarriers();
 
-            m_Instance->referencedResources.push_back(buffer);
+            m_Instance->referencedResources.add(buffer);
 
             m_ActiveCommandList->commandList->CopyBufferRegion(buffer->resource, destOffsetBytes, uploadBuffer, offsetInUploadBuffer, dataSize);
         }
     }
 
+    IBuffer* CommandList::allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress)
+    {
+        (void)byteSize;
+        (void)outOffset;
+        (void)outCpuAddress;
+
+        // Upload chunks are raw resources without an IBuffer, and writeBuffer doesn't interrupt anything here
+        return nullptr;
+    }
+
     void CommandList::clearBufferUInt(IBuffer* _b, uint32_t clearValue)
     {
         Buffer* b = checked_cast<Buffer*>(_b);
@@ -510,7 +520,7 @@ namespace nvrhi::d3d12
         DescriptorIndex clearUAV = b->getClearUAV();
         assert(clearUAV != c_InvalidDescriptorIndex);
 
-        m_Instance->referencedResources.push_back(b);
+        m_Instance->referencedResources.add(b);
 
         const uint32_t values[4] = { clearValue, clearValue, clearValue, clearValue };
         m_ActiveCommandList->commandList->ClearUnorderedAccessViewUint(
@@ -534,12 +544,12 @@ namespace nvrhi::d3d12
         if(src->desc.cpuAccess != CpuAccessMode::None)
             m_Instance->referencedStagingBuffers.push_back(src);
         else
-            m_Instance->referencedResources.push_back(src);
+            m_Instance->referencedResources.add(src);
 
         if (dest->desc.cpuAccess != CpuAccessMode::None)
             m_Instance->referencedStagingBuffers.push_back(dest);
         else
-            m_Instance->referencedResources.push_back(dest);
+            m_Instance->referencedResources.add(dest);
 
         m_ActiveCommandList->commandList->CopyBufferRegion(dest->resource, destOffsetBytes, src->resource, srcOffsetBytes, dataSizeBytes);
     }
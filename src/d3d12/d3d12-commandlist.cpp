@@ -33,10 +33,12 @@ namespace nvrhi::d3d12
         , m_Resources(resources)
         , m_Device(device)
         , m_Queue(device->getQueue(params.queueType))
-        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false)
-        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true)
-        , m_StateTracker(context.messageCallback)
+        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false, device->getAllocationTracker())
+        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true, device->getAllocationTracker())
+        , m_StateTracker(context.messageCallback, device->getAllocationTracker())
         , m_Desc(params)
+        , m_VolatileConstantBufferAddresses(decltype(m_VolatileConstantBufferAddresses)::allocator_type(device->getAllocationTracker(), AllocationCategory::StateTracking))
+        , m_ShaderTableStates(decltype(m_ShaderTableStates)::allocator_type(device->getAllocationTracker(), AllocationCategory::StateTracking))
     {
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
@@ -222,6 +224,26 @@ namespace nvrhi::d3d12
             return;
 
         assert(byteSize == rootsig->pushConstantByteSize); // the validation error handles the error message
+
+        if (byteSize > c_MaxPushConstantSize)
+        {
+            // The layout declared a root CBV for these push constants, see BindingLayout
+            void* cpuVA;
+            D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
+            if (!allocateUploadBuffer(byteSize, &cpuVA, &gpuVA))
+            {
+                m_Context.error("Couldn't suballocate an upload buffer");
+                return;
+            }
+
+            memcpy(cpuVA, data, byteSize);
+
+            if (isGraphics)
+                m_ActiveCommandList->commandList->SetGraphicsRootConstantBufferView(rootsig->rootParameterPushConstants, gpuVA);
+            else
+                m_ActiveCommandList->commandList->SetComputeRootConstantBufferView(rootsig->rootParameterPushConstants, gpuVA);
+            return;
+        }
         
         if (isGraphics)
             m_ActiveCommandList->commandList->SetGraphicsRoot32BitConstants(rootsig->rootParameterPushConstants, UINT(byteSize / 4), data, 0);
@@ -125,7 +125,7 @@ namespace nvrhi::d3d12
         {
             m_ActiveCommandList->commandList->SetPipelineState(pso->pipelineState);
             
-            m_Instance->referencedResources.push_back(pso);
+            m_Instance->referencedResources.add(pso);
         }
 
         setComputeBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
@@ -57,12 +57,13 @@ namespace nvrhi::d3d12
         return DeviceHandle::Create(device);
     }
 
-    DeviceResources::DeviceResources(const Context& context, const DeviceDesc& desc)
+    DeviceResources::DeviceResources(const Context& context, const DeviceDesc& desc, AllocationTracker* allocationTracker)
         : renderTargetViewHeap(context)
         , depthStencilViewHeap(context)
         , shaderResourceViewHeap(context)
         , samplerHeap(context)
         , timerQueries(desc.maxTimerQueries, true)
+        , rootsigCache(decltype(rootsigCache)::allocator_type(allocationTracker, AllocationCategory::Caches))
         , m_Context(context)
     {
     }
@@ -85,10 +86,13 @@ namespace nvrhi::d3d12
     }
 
     Device::Device(const DeviceDesc& desc)
-        : m_Resources(m_Context, desc)
+        : m_AllocationTracker(desc.allocator)
+        , m_Resources(m_Context, desc, &m_AllocationTracker)
+        , m_TaskDispatcher(desc.taskScheduler)
     {
         m_Context.device = desc.pDevice;
         m_Context.messageCallback = desc.errorCB;
+        m_Context.taskDispatcher = &m_TaskDispatcher;
 
         if (desc.pGraphicsCommandQueue)
             m_Queues[int(CommandQueue::Graphics)] = std::make_unique<Queue>(m_Context, desc.pGraphicsCommandQueue);
@@ -150,6 +154,13 @@ namespace nvrhi::d3d12
             csDesc.ByteStride = 12;
             argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
             m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchIndirectSignature));
+
+            if (m_MeshletsSupported)
+            {
+                csDesc.ByteStride = sizeof(D3D12_DISPATCH_MESH_ARGUMENTS);
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+                m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchMeshIndirectSignature));
+            }
         }
         
         m_FenceEvent = CreateEvent(nullptr, false, false, nullptr);
@@ -444,6 +455,8 @@ namespace nvrhi::d3d12
             return m_ShaderExecutionReorderingSupported;
         case Feature::Meshlets:
             return m_MeshletsSupported;
+        case Feature::DrawIndirectCount:
+            return true;
         case Feature::VariableRateShading:
             if (pInfo)
             {
@@ -466,6 +479,10 @@ namespace nvrhi::d3d12
             return true;
         case Feature::ConstantBufferRanges:
             return true;
+        case Feature::TiledResources:
+            return m_Options.TiledResourcesTier >= D3D12_TILED_RESOURCES_TIER_1;
+        case Feature::MultiDrawIndirect:
+            return true;
         default:
             return false;
         }
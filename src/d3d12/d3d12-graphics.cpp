@@ -298,6 +298,7 @@ namespace nvrhi::d3d12
 
         const bool updatePipeline = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.pipeline != state.pipeline;
         const bool updateIndirectParams = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountBuffer = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indirectCountBuffer != state.indirectCountBuffer;
 
         const bool updateViewports = !m_CurrentGraphicsStateValid ||
             arraysAreDifferent(m_CurrentGraphicsState.viewport.viewports, state.viewport.viewports) ||
@@ -328,7 +329,7 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindGraphicsPipeline(pso, updateRootSignature);
-            m_Instance->referencedResources.push_back(pso);
+            m_Instance->referencedResources.add(pso);
         }
 
         if (pso->desc.renderState.depthStencilState.stencilEnable && (updatePipeline || updateStencilRef))
@@ -344,11 +345,20 @@ namespace nvrhi::d3d12
         if (updateFramebuffer)
         {
             bindFramebuffer(framebuffer);
-            m_Instance->referencedResources.push_back(framebuffer);
+            m_Instance->referencedResources.add(framebuffer);
         }
 
         setGraphicsBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
 
+        if (state.indirectCountBuffer && updateIndirectCountBuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+            m_Instance->referencedResources.add(state.indirectCountBuffer);
+        }
+
         if (updateIndexBuffer)
         {
             D3D12_INDEX_BUFFER_VIEW IBV = {};
@@ -366,7 +376,7 @@ namespace nvrhi::d3d12
                 IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - state.indexBuffer.offset);
                 IBV.BufferLocation = buffer->gpuVA + state.indexBuffer.offset;
 
-                m_Instance->referencedResources.push_back(state.indexBuffer.buffer);
+                m_Instance->referencedResources.add(state.indexBuffer.buffer);
             }
 
             m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
@@ -396,7 +406,7 @@ namespace nvrhi::d3d12
                 VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
                 maxVbIndex = std::max(maxVbIndex, binding.slot);
 
-                m_Instance->referencedResources.push_back(buffer);
+                m_Instance->referencedResources.add(buffer);
             }
 
             if (m_CurrentGraphicsStateValid)
@@ -571,6 +581,30 @@ namespace nvrhi::d3d12
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
     }
+
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && countBuffer); // validation layer handles this
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndirectSignature, maxDrawCount,
+            indirectParams->resource, paramOffsetBytes, countBuffer->resource, countOffsetBytes);
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && countBuffer);
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, maxDrawCount,
+            indirectParams->resource, paramOffsetBytes, countBuffer->resource, countOffsetBytes);
+    }
     
     DX12_ViewportState convertViewportState(const RasterState& rasterState, const FramebufferInfoEx& framebufferInfo, const ViewportState& vpState)
     {
@@ -221,6 +221,7 @@ namespace nvrhi::d3d12
 
         const bool updatePipeline = !m_CurrentMeshletStateValid || m_CurrentMeshletState.pipeline != state.pipeline;
         const bool updateIndirectParams = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountBuffer = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectCountBuffer != state.indirectCountBuffer;
 
         const bool updateViewports = !m_CurrentMeshletStateValid ||
             arraysAreDifferent(m_CurrentMeshletState.viewport.viewports, state.viewport.viewports) ||
@@ -246,7 +247,7 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindMeshletPipeline(pso, updateRootSignature);
-            m_Instance->referencedResources.push_back(pso);
+            m_Instance->referencedResources.add(pso);
         }
 
         if (pso->desc.renderState.depthStencilState.stencilEnable && (updatePipeline || updateStencilRef))
@@ -262,10 +263,19 @@ namespace nvrhi::d3d12
         if (updateFramebuffer)
         {
             bindFramebuffer(framebuffer);
-            m_Instance->referencedResources.push_back(framebuffer);
+            m_Instance->referencedResources.add(framebuffer);
         }
 
         setGraphicsBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
+
+        if (state.indirectCountBuffer && updateIndirectCountBuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+            m_Instance->referencedResources.add(state.indirectCountBuffer);
+        }
         
         commitBarriers();
 
@@ -300,4 +310,22 @@ namespace nvrhi::d3d12
 
         m_ActiveCommandList->commandList6->DispatchMesh(groupsX, groupsY, groupsZ);
     }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(indirectParams && countBuffer); // validation layer handles this
+
+        if (!m_Context.dispatchMeshIndirectSignature)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchMeshIndirectSignature, maxDispatchCount,
+            indirectParams->resource, paramOffsetBytes, countBuffer->resource, countOffsetBytes);
+    }
 } // namespace nvrhi::d3d12
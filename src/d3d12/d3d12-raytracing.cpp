@@ -1180,7 +1180,7 @@ namespace nvrhi::d3d12
             shaderTableState->descriptorHeapSamplers = m_Resources.samplerHeap.getShaderVisibleHeap();
 
             // AddRef the shaderTable only on the first use / build because build happens at least once per CL anyway
-            m_Instance->referencedResources.push_back(shaderTable);
+            m_Instance->referencedResources.add(shaderTable);
         }
 
         const bool updateRootSignature = !m_CurrentRayTracingStateValid || m_CurrentRayTracingState.shaderTable == nullptr ||
@@ -1207,7 +1207,7 @@ namespace nvrhi::d3d12
         {
             m_ActiveCommandList->commandList4->SetPipelineState1(pso->pipelineState);
 
-            m_Instance->referencedResources.push_back(pso);
+            m_Instance->referencedResources.add(pso);
         }
 
         setComputeBindings(state.bindings, bindingUpdateMask, nullptr, false, pso->globalRootSignature);
@@ -1256,9 +1256,9 @@ namespace nvrhi::d3d12
 
         if (desc.trackLiveness)
         {
-            m_Instance->referencedResources.push_back(desc.inputBuffer);
-            m_Instance->referencedResources.push_back(desc.perOmmDescs);
-            m_Instance->referencedResources.push_back(omm->dataBuffer);
+            m_Instance->referencedResources.add(desc.inputBuffer);
+            m_Instance->referencedResources.add(desc.perOmmDescs);
+            m_Instance->referencedResources.add(omm->dataBuffer);
         }
 
         commitBarriers();
@@ -1339,12 +1339,12 @@ namespace nvrhi::d3d12
                         requireBufferState(triangles.ommIndexBuffer, ResourceStates::AccelStructBuildInput);
                 }
 
-                m_Instance->referencedResources.push_back(triangles.indexBuffer);
-                m_Instance->referencedResources.push_back(triangles.vertexBuffer);
+                m_Instance->referencedResources.add(triangles.indexBuffer);
+                m_Instance->referencedResources.add(triangles.vertexBuffer);
                 if (om && om->desc.trackLiveness)
-                    m_Instance->referencedResources.push_back(om);
+                    m_Instance->referencedResources.add(om);
                 if (triangles.ommIndexBuffer)
-                    m_Instance->referencedResources.push_back(triangles.ommIndexBuffer);
+                    m_Instance->referencedResources.add(triangles.ommIndexBuffer);
             }
             else
             {
@@ -1355,7 +1355,7 @@ namespace nvrhi::d3d12
                     requireBufferState(aabbs.buffer, ResourceStates::AccelStructBuildInput);
                 }
 
-                m_Instance->referencedResources.push_back(aabbs.buffer);
+                m_Instance->referencedResources.add(aabbs.buffer);
             }
         }
 
@@ -1488,7 +1488,7 @@ namespace nvrhi::d3d12
 #endif // NVRHI_WITH_RTXMU
 
         if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+            m_Instance->referencedResources.add(as);
     }
 
     void CommandList::compactBottomLevelAccelStructs()
@@ -1583,10 +1583,31 @@ namespace nvrhi::d3d12
 
         // Construct the instance array in a local vector first and then copy it over
         // because doing it in GPU memory over PCIe is much slower.
-        for (uint32_t i = 0; i < numInstances; i++)
+        // Large instance arrays are converted in parallel through the task scheduler.
+        m_Context.taskDispatcher->parallelFor(numInstances, c_ParallelInstanceGrainSize, c_ParallelInstanceThreshold,
+            [as, pInstances](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const rt::InstanceDesc& instance = pInstances[i];
+                D3D12_RAYTRACING_INSTANCE_DESC& dxrInstance = as->dxrInstances[i];
+
+                static_assert(sizeof(dxrInstance) == sizeof(instance));
+                memcpy(&dxrInstance, &instance, sizeof(instance));
+
+                // With RTXMU, the BLAS addresses are resolved below
+                dxrInstance.AccelerationStructure = 0;
+#ifndef NVRHI_WITH_RTXMU
+                if (instance.bottomLevelAS)
+                    dxrInstance.AccelerationStructure = checked_cast<AccelStruct*>(instance.bottomLevelAS)->dataBuffer->gpuVA;
+#endif
+            }
+        });
+
+        // Track the BLAS references and states on this thread, because the state tracker is not thread-safe
+        for (size_t i = 0; i < numInstances; i++)
         {
             const rt::InstanceDesc& instance = pInstances[i];
-            D3D12_RAYTRACING_INSTANCE_DESC& dxrInstance = as->dxrInstances[i];
 
             if (instance.bottomLevelAS)
             {
@@ -1595,24 +1616,15 @@ namespace nvrhi::d3d12
                 if (blas->desc.trackLiveness)
                     as->bottomLevelASes.push_back(blas);
 
-                static_assert(sizeof(dxrInstance) == sizeof(instance));
-                memcpy(&dxrInstance, &instance, sizeof(instance));
-
 #ifdef NVRHI_WITH_RTXMU
-                dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
+                as->dxrInstances[i].AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
 #else
-                dxrInstance.AccelerationStructure = blas->dataBuffer->gpuVA;
-
                 if (m_EnableAutomaticBarriers)
                 {
                     requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
                 }
 #endif
             }
-            else // !instance.bottomLevelAS
-            {
-                dxrInstance.AccelerationStructure = 0;
-            }
         }
 
 #ifdef NVRHI_WITH_RTXMU
@@ -1641,7 +1653,7 @@ namespace nvrhi::d3d12
         buildTopLevelAccelStructInternal(as, gpuVA, numInstances, buildFlags);
 
         if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+            m_Instance->referencedResources.add(as);
     }
 
     void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -1661,6 +1673,6 @@ namespace nvrhi::d3d12
         buildTopLevelAccelStructInternal(as, getBufferGpuVA(instanceBuffer) + instanceBufferOffset, numInstances, buildFlags);
 
         if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+            m_Instance->referencedResources.add(as);
     }
 } // namespace nvrhi::d3d12
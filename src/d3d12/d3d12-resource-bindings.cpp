@@ -379,6 +379,7 @@ namespace nvrhi::d3d12
         uint32_t currentSlot = ~0u;
 
         D3D12_ROOT_CONSTANTS rootConstants = {};
+        D3D12_ROOT_DESCRIPTOR1 pushConstantBuffer = {};
 
         for (const BindingLayoutItem& binding : desc.bindings)
         {
@@ -399,9 +400,21 @@ namespace nvrhi::d3d12
             else if (binding.type == ResourceType::PushConstants)
             {
                 pushConstantByteSize = binding.size;
-                rootConstants.ShaderRegister = binding.slot;
-                rootConstants.RegisterSpace = desc.registerSpace;
-                rootConstants.Num32BitValues = binding.size / 4;
+
+                if (binding.size > c_MaxPushConstantSize)
+                {
+                    // Too large for root constants: setPushConstants writes the data into the upload buffer
+                    // and binds it as a root CBV, which is static for the same reason as with volatile CBs
+                    pushConstantBuffer.ShaderRegister = binding.slot;
+                    pushConstantBuffer.RegisterSpace = desc.registerSpace;
+                    pushConstantBuffer.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+                }
+                else
+                {
+                    rootConstants.ShaderRegister = binding.slot;
+                    rootConstants.RegisterSpace = desc.registerSpace;
+                    rootConstants.Num32BitValues = binding.size / 4;
+                }
             }
             else if (!AreResourceTypesCompatible(binding.type, currentType) || binding.slot != currentSlot + 1)
             {
@@ -515,6 +528,16 @@ namespace nvrhi::d3d12
 
             rootParameterPushConstants = RootParameterIndex(rootParameters.size() - 1);
         }
+        else if (pushConstantByteSize)
+        {
+            D3D12_ROOT_PARAMETER1& param = rootParameters.emplace_back();
+
+            param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+            param.ShaderVisibility = convertShaderStage(desc.visibility);
+            param.Descriptor = pushConstantBuffer;
+
+            rootParameterPushConstants = RootParameterIndex(rootParameters.size() - 1);
+        }
 
         for (std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>& rootParameterVolatileCB : rootParametersVolatileCB)
         {
@@ -941,7 +964,7 @@ namespace nvrhi::d3d12
                         }
 
                         if (bindingSet->desc.trackLiveness)
-                            m_Instance->referencedResources.push_back(bindingSet);
+                            m_Instance->referencedResources.add(bindingSet);
                     }
 
                     if (m_EnableAutomaticBarriers && (updateThisSet || bindingSet->hasUavBindings)) // UAV bindings may place UAV barriers on the same binding set
@@ -966,7 +989,7 @@ namespace nvrhi::d3d12
             {
                 requireBufferState(indirectParams, ResourceStates::IndirectArgument);
             }
-            m_Instance->referencedResources.push_back(indirectParams);
+            m_Instance->referencedResources.add(indirectParams);
         }
 
         uint32_t bindingMask = (1 << uint32_t(bindings.size())) - 1;
@@ -1067,7 +1090,7 @@ namespace nvrhi::d3d12
                         }
 
                         if (bindingSet->desc.trackLiveness)
-                            m_Instance->referencedResources.push_back(bindingSet);
+                            m_Instance->referencedResources.add(bindingSet);
                     }
 
                     if (m_EnableAutomaticBarriers && (updateThisSet || bindingSet->hasUavBindings)) // UAV bindings may place UAV barriers on the same binding set
@@ -1092,7 +1115,7 @@ namespace nvrhi::d3d12
             {
                 requireBufferState(indirectParams, ResourceStates::IndirectArgument);
             }
-            m_Instance->referencedResources.push_back(indirectParams);
+            m_Instance->referencedResources.add(indirectParams);
         }
 
         uint32_t bindingMask = (1 << uint32_t(bindings.size())) - 1;
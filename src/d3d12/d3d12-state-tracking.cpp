@@ -196,19 +196,8 @@ namespace nvrhi::d3d12
     
     ShaderTableState* CommandList::getShaderTableStateTracking(rt::IShaderTable* shaderTable)
     {
-        auto it = m_ShaderTableStates.find(shaderTable);
-
-        if (it != m_ShaderTableStates.end())
-        {
-            return it->second.get();
-        }
-
-        std::unique_ptr<ShaderTableState> trackingRef = std::make_unique<ShaderTableState>();
-
-        ShaderTableState* tracking = trackingRef.get();
-        m_ShaderTableStates.insert(std::make_pair(shaderTable, std::move(trackingRef)));
-
-        return tracking;
+        // The states are stored in the map nodes, which don't move when the map grows
+        return &m_ShaderTableStates[shaderTable];
     }
 
     void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
@@ -232,7 +221,7 @@ namespace nvrhi::d3d12
         m_StateTracker.requireTextureState(texture, subresources, stateBits);
 
         if (m_Instance)
-            m_Instance->referencedResources.push_back(texture);
+            m_Instance->referencedResources.add(texture);
     }
 
     void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -242,7 +231,7 @@ namespace nvrhi::d3d12
         m_StateTracker.requireBufferState(buffer, stateBits);
 
         if (m_Instance)
-            m_Instance->referencedResources.push_back(buffer);
+            m_Instance->referencedResources.add(buffer);
     }
 
     void CommandList::setAccelStructState(rt::IAccelStruct* _as, ResourceStates stateBits)
@@ -254,7 +243,7 @@ namespace nvrhi::d3d12
             m_StateTracker.requireBufferState(as->dataBuffer, stateBits);
             
             if (m_Instance)
-                m_Instance->referencedResources.push_back(as);
+                m_Instance->referencedResources.add(as);
         }
     }
 
@@ -265,7 +254,7 @@ namespace nvrhi::d3d12
         m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
 
         if (m_Instance)
-            m_Instance->referencedResources.push_back(texture);
+            m_Instance->referencedResources.add(texture);
     }
 
     void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -275,7 +264,7 @@ namespace nvrhi::d3d12
         m_StateTracker.setPermanentBufferState(buffer, stateBits);
         
         if (m_Instance)
-            m_Instance->referencedResources.push_back(buffer);
+            m_Instance->referencedResources.add(buffer);
     }
 
     ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
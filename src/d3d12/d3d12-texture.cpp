@@ -26,6 +26,7 @@
 
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 namespace nvrhi::d3d12
 {
@@ -324,13 +325,28 @@ namespace nvrhi::d3d12
 
         D3D12_CLEAR_VALUE clearValue = convertTextureClearValue(d);
 
-        HRESULT hr = m_Context.device->CreateCommittedResource(
-            &heapProps,
-            heapFlags,
-            &texture->resourceDesc,
-            convertResourceStates(d.initialState),
-            d.useClearValue ? &clearValue : nullptr,
-            IID_PPV_ARGS(&texture->resource));
+        HRESULT hr;
+        if (d.isTiled)
+        {
+            // Reserved resources have no memory, it is mapped tile by tile with updateTextureTileMappings
+            texture->resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+
+            hr = m_Context.device->CreateReservedResource(
+                &texture->resourceDesc,
+                convertResourceStates(d.initialState),
+                d.useClearValue ? &clearValue : nullptr,
+                IID_PPV_ARGS(&texture->resource));
+        }
+        else
+        {
+            hr = m_Context.device->CreateCommittedResource(
+                &heapProps,
+                heapFlags,
+                &texture->resourceDesc,
+                convertResourceStates(d.initialState),
+                d.useClearValue ? &clearValue : nullptr,
+                IID_PPV_ARGS(&texture->resource));
+        }
 
         if (FAILED(hr))
         {
@@ -420,6 +436,141 @@ namespace nvrhi::d3d12
 
         return true;
     }
+
+    void Device::getTextureTiling(ITexture* _texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        UINT numTilesForEntireResource = 0;
+        D3D12_PACKED_MIP_INFO packedMipDesc = {};
+        D3D12_TILE_SHAPE standardTileShapeForNonPackedMips = {};
+        UINT numSubresourceTilings = subresourceTilingsNum ? *subresourceTilingsNum : 0;
+        std::vector<D3D12_SUBRESOURCE_TILING> d3dSubresourceTilings(numSubresourceTilings);
+
+        m_Context.device->GetResourceTiling(texture->resource,
+            &numTilesForEntireResource,
+            &packedMipDesc,
+            &standardTileShapeForNonPackedMips,
+            &numSubresourceTilings,
+            0,
+            d3dSubresourceTilings.data());
+
+        if (numTiles)
+            *numTiles = numTilesForEntireResource;
+
+        if (desc)
+        {
+            desc->numStandardMips = packedMipDesc.NumStandardMips;
+            desc->numPackedMips = packedMipDesc.NumPackedMips;
+            desc->numTilesForPackedMips = packedMipDesc.NumTilesForPackedMips;
+            desc->startTileIndexInOverallResource = packedMipDesc.StartTileIndexInOverallResource;
+        }
+
+        if (tileShape)
+        {
+            tileShape->widthInTexels = standardTileShapeForNonPackedMips.WidthInTexels;
+            tileShape->heightInTexels = standardTileShapeForNonPackedMips.HeightInTexels;
+            tileShape->depthInTexels = standardTileShapeForNonPackedMips.DepthInTexels;
+        }
+
+        if (subresourceTilingsNum)
+        {
+            // Only the standard mips of the first array slice are reported, like on Vulkan
+            const uint32_t count = std::min(uint32_t(numSubresourceTilings), uint32_t(packedMipDesc.NumStandardMips));
+
+            if (subresourceTilings)
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    subresourceTilings[i].widthInTiles = d3dSubresourceTilings[i].WidthInTiles;
+                    subresourceTilings[i].heightInTiles = d3dSubresourceTilings[i].HeightInTiles;
+                    subresourceTilings[i].depthInTiles = d3dSubresourceTilings[i].DepthInTiles;
+                    subresourceTilings[i].startTileIndexInOverallResource = d3dSubresourceTilings[i].StartTileIndexInOverallResource;
+                }
+            }
+
+            *subresourceTilingsNum = packedMipDesc.NumStandardMips;
+        }
+    }
+
+    void Device::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+        ID3D12CommandQueue* queue = getQueue(executionQueue)->queue;
+
+        D3D12_PACKED_MIP_INFO packedMipDesc = {};
+        m_Context.device->GetResourceTiling(texture->resource, nullptr, &packedMipDesc, nullptr, nullptr, 0, nullptr);
+
+        std::vector<D3D12_TILED_RESOURCE_COORDINATE> resourceCoordinates;
+        std::vector<D3D12_TILE_REGION_SIZE> regionSizes;
+        std::vector<D3D12_TILE_RANGE_FLAGS> rangeFlags;
+        std::vector<UINT> heapStartOffsets;
+        std::vector<UINT> rangeTileCounts;
+
+        // Each mapping has its own heap, so it needs a separate UpdateTileMappings call.
+        // The calls are ordered on the queue with the work submitted so far, no batching is needed here.
+        for (uint32_t mappingIndex = 0; mappingIndex < numTileMappings; ++mappingIndex)
+        {
+            const TextureTilesMapping& mapping = tileMappings[mappingIndex];
+            ID3D12Heap* heap = mapping.heap ? checked_cast<Heap*>(mapping.heap)->heap.Get() : nullptr;
+
+            resourceCoordinates.resize(mapping.numTextureRegions);
+            regionSizes.resize(mapping.numTextureRegions);
+            rangeFlags.resize(mapping.numTextureRegions);
+            heapStartOffsets.resize(mapping.numTextureRegions);
+            rangeTileCounts.resize(mapping.numTextureRegions);
+
+            for (uint32_t regionIndex = 0; regionIndex < mapping.numTextureRegions; ++regionIndex)
+            {
+                const TiledTextureCoordinate& coordinate = mapping.tiledTextureCoordinates[regionIndex];
+                const TiledTextureRegion& region = mapping.tiledTextureRegions[regionIndex];
+
+                D3D12_TILED_RESOURCE_COORDINATE& d3dCoordinate = resourceCoordinates[regionIndex];
+                D3D12_TILE_REGION_SIZE& d3dRegion = regionSizes[regionIndex];
+
+                d3dCoordinate.Subresource = calcSubresource(coordinate.mipLevel, coordinate.arrayLevel, 0,
+                    texture->desc.mipLevels, texture->desc.arraySize);
+
+                if (coordinate.mipLevel >= packedMipDesc.NumStandardMips)
+                {
+                    // The packed mips of a slice are mapped all at once
+                    d3dCoordinate.X = 0;
+                    d3dCoordinate.Y = 0;
+                    d3dCoordinate.Z = 0;
+                    d3dRegion.NumTiles = packedMipDesc.NumTilesForPackedMips;
+                    d3dRegion.UseBox = false;
+                }
+                else
+                {
+                    d3dCoordinate.X = coordinate.x;
+                    d3dCoordinate.Y = coordinate.y;
+                    d3dCoordinate.Z = coordinate.z;
+                    d3dRegion.NumTiles = region.tilesNum;
+                    d3dRegion.UseBox = true;
+                    d3dRegion.Width = region.width;
+                    d3dRegion.Height = UINT16(region.height);
+                    d3dRegion.Depth = UINT16(region.depth);
+                }
+
+                texture->tileHeaps.map(coordinate, region, coordinate.mipLevel >= packedMipDesc.NumStandardMips, mapping.heap);
+
+                rangeFlags[regionIndex] = heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+                heapStartOffsets[regionIndex] = heap ? UINT(mapping.byteOffsets[regionIndex] / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES) : 0;
+                rangeTileCounts[regionIndex] = d3dRegion.NumTiles;
+            }
+
+            queue->UpdateTileMappings(texture->resource,
+                mapping.numTextureRegions,
+                resourceCoordinates.data(),
+                regionSizes.data(),
+                heap,
+                mapping.numTextureRegions,
+                rangeFlags.data(),
+                heapStartOffsets.data(),
+                rangeTileCounts.data(),
+                D3D12_TILE_MAPPING_FLAG_NONE);
+        }
+    }
     
     TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object _texture, const TextureDesc& desc)
     {
@@ -864,7 +1015,7 @@ namespace nvrhi::d3d12
 
         subresources = subresources.resolve(t->desc, false);
 
-        m_Instance->referencedResources.push_back(t);
+        m_Instance->referencedResources.add(t);
 
         if (t->desc.isRenderTarget)
         {
@@ -925,7 +1076,7 @@ namespace nvrhi::d3d12
 
         subresources = subresources.resolve(t->desc, false);
 
-        m_Instance->referencedResources.push_back(t);
+        m_Instance->referencedResources.add(t);
 
         if (m_EnableAutomaticBarriers)
         {
@@ -968,7 +1119,7 @@ namespace nvrhi::d3d12
 
         uint32_t clearValues[4] = { clearColor, clearColor, clearColor, clearColor };
 
-        m_Instance->referencedResources.push_back(t);
+        m_Instance->referencedResources.add(t);
 
         if (t->desc.isUAV)
         {
@@ -1047,8 +1198,8 @@ namespace nvrhi::d3d12
         }
         commitBarriers();
 
-        m_Instance->referencedResources.push_back(dst);
-        m_Instance->referencedResources.push_back(src);
+        m_Instance->referencedResources.add(dst);
+        m_Instance->referencedResources.add(src);
 
         m_ActiveCommandList->commandList->CopyTextureRegion(&dstLocation,
             resolvedDstSlice.x,
@@ -1075,7 +1226,7 @@ namespace nvrhi::d3d12
         }
         commitBarriers();
 
-        m_Instance->referencedResources.push_back(dst);
+        m_Instance->referencedResources.add(dst);
         m_Instance->referencedStagingTextures.push_back(src);
 
         auto srcRegion = src->getSliceRegion(m_Context.device, resolvedSrcSlice);
@@ -1119,7 +1270,7 @@ namespace nvrhi::d3d12
         }
         commitBarriers();
 
-        m_Instance->referencedResources.push_back(src);
+        m_Instance->referencedResources.add(src);
         m_Instance->referencedStagingTextures.push_back(dst);
 
         auto dstRegion = dst->getSliceRegion(m_Context.device, resolvedDstSlice);
@@ -1179,15 +1330,8 @@ namespace nvrhi::d3d12
 
         assert(numRows <= footprint.Footprint.Height);
 
-        for (uint32_t depthSlice = 0; depthSlice < footprint.Footprint.Depth; depthSlice++)
-        {
-            for (uint32_t row = 0; row < numRows; row++)
-            {
-                void* destAddress = (char*)cpuVA + uint64_t(footprint.Footprint.RowPitch) * uint64_t(row + depthSlice * numRows);
-                const void* srcAddress = (const char*)data + rowPitch * row + depthPitch * depthSlice;
-                memcpy(destAddress, srcAddress, std::min(rowPitch, rowSizeInBytes));
-            }
-        }
+        m_Context.taskDispatcher->copyRows(cpuVA, footprint.Footprint.RowPitch, size_t(footprint.Footprint.RowPitch) * numRows,
+            data, rowPitch, depthPitch, size_t(std::min(uint64_t(rowPitch), rowSizeInBytes)), numRows, footprint.Footprint.Depth);
 
         D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
         destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
@@ -1199,7 +1343,7 @@ namespace nvrhi::d3d12
         srcCopyLocation.PlacedFootprint = footprint;
         srcCopyLocation.pResource = uploadBuffer;
 
-        m_Instance->referencedResources.push_back(dest);
+        m_Instance->referencedResources.add(dest);
 
         if (uploadBuffer != m_CurrentUploadBuffer)
         {
@@ -37,19 +37,22 @@ namespace nvrhi::d3d12
         }
     }
     
-    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer,
+        AllocationTracker* allocationTracker)
         : m_Context(context)
         , m_Queue(pQueue)
         , m_DefaultChunkSize(defaultChunkSize)
         , m_MemoryLimit(memoryLimit)
         , m_IsScratchBuffer(isScratchBuffer)
+        , m_AllocationTracker(allocationTracker)
+        , m_ChunkPool(decltype(m_ChunkPool)::allocator_type(allocationTracker, AllocationCategory::Upload))
     {
         assert(pQueue);
     }
 
     std::shared_ptr<BufferChunk> UploadManager::createChunk(size_t size) const
     {
-        auto chunk = std::make_shared<BufferChunk>();
+        auto chunk = make_tracked_shared<BufferChunk>(m_AllocationTracker, AllocationCategory::Upload);
 
         size = align(size, BufferChunk::c_sizeAlignment);
 
@@ -24,6 +24,7 @@
 
 #include <nvrhi/validation.h>
 #include "../common/sparse-bitset.h"
+#include "../common/allocator.h"
 
 namespace nvrhi::validation
 {
@@ -74,13 +75,16 @@ namespace nvrhi::validation
         bool wasBuilt = false;
 
         // BLAS only
-        std::vector<rt::GeometryDesc> buildGeometries;
+        tracked_vector<rt::GeometryDesc> buildGeometries;
 
         // TLAS only
         size_t maxInstances = 0;
         size_t buildInstances = 0;
 
-        AccelStructWrapper(IAccelStruct* as) : m_AccelStruct(as) { }
+        AccelStructWrapper(IAccelStruct* as, AllocationTracker* allocationTracker)
+            : buildGeometries(TrackedAllocator<rt::GeometryDesc>(allocationTracker, AllocationCategory::Validation))
+            , m_AccelStruct(as)
+        { }
         IAccelStruct* getUnderlyingObject() const { return m_AccelStruct; }
 
         // IResource
@@ -137,6 +141,7 @@ namespace nvrhi::validation
         bool validateBindingSetsAgainstLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& layouts, const static_vector<IBindingSet*, c_MaxBindingLayouts>& sets) const;
 
         bool validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const;
+        bool validateIndirectCount(IBuffer* indirectParams, IBuffer* countBuffer, uint32_t countOffsetBytes, const char* operation) const;
 
     public:
 
@@ -163,6 +168,7 @@ namespace nvrhi::validation
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        IBuffer* allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
 
@@ -171,6 +177,8 @@ namespace nvrhi::validation
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -178,6 +186,7 @@ namespace nvrhi::validation
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
@@ -225,11 +234,12 @@ namespace nvrhi::validation
     public:
         friend class CommandListWrapper;
 
-        DeviceWrapper(IDevice* device);
+        DeviceWrapper(IDevice* device, IAllocator* allocator);
         
     protected:
         DeviceHandle m_Device;
         IMessageCallback* m_MessageCallback;
+        AllocationTracker m_AllocationTracker;
         std::atomic<unsigned int> m_NumOpenImmediateCommandLists = 0;
 
         void error(const std::string& messageText) const;
@@ -253,6 +263,8 @@ namespace nvrhi::validation
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
@@ -326,6 +338,8 @@ namespace nvrhi::validation
         IMessageCallback* getMessageCallback() override;
         bool isAftermathEnabled() override;
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override;
+        AllocationStatistics getAllocationStatistics() override;
+        ITaskScheduler* getTaskScheduler() override;
     };
 
 } // namespace nvrhi::validation
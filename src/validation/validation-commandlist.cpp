@@ -448,6 +448,20 @@ namespace nvrhi::validation
         m_CommandList->writeBuffer(b, data, dataSize, destOffsetBytes);
     }
 
+    IBuffer* CommandListWrapper::allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress)
+    {
+        if (!requireOpenState())
+            return nullptr;
+
+        if (!outOffset || !outCpuAddress)
+        {
+            error("allocateIndirectArguments: outOffset and outCpuAddress must not be NULL");
+            return nullptr;
+        }
+
+        return m_CommandList->allocateIndirectArguments(byteSize, outOffset, outCpuAddress);
+    }
+
     void CommandListWrapper::clearBufferUInt(IBuffer* b, uint32_t clearValue)
     {
         if (!requireOpenState())
@@ -527,10 +541,10 @@ namespace nvrhi::validation
             return;
         }
 
-        if (byteSize > c_MaxPushConstantSize)
+        if (byteSize > c_MaxPushConstantBufferSize)
         {
             std::stringstream ss;
-            ss << "Push constant size (" << byteSize << ") cannot exceed " << c_MaxPushConstantSize << " bytes";
+            ss << "Push constant size (" << byteSize << ") cannot exceed " << c_MaxPushConstantBufferSize << " bytes";
             error(ss.str());
             return;
         }
@@ -611,6 +625,12 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) << "' as an indirect count buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+            anyErrors = true;
+        }
+
         if (anyErrors)
         {
             error(ss.str());
@@ -714,6 +734,12 @@ namespace nvrhi::validation
             return;
         }
 
+        if (drawCount > 1 && !m_Device->queryFeatureSupport(Feature::MultiDrawIndirect))
+        {
+            error("drawIndirect: drawCount is " + std::to_string(drawCount) + ", but the device does not support Feature::MultiDrawIndirect");
+            return;
+        }
+
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
@@ -741,12 +767,99 @@ namespace nvrhi::validation
             return;
         }
 
+        if (drawCount > 1 && !m_Device->queryFeatureSupport(Feature::MultiDrawIndirect))
+        {
+            error("drawIndexedIndirect: drawCount is " + std::to_string(drawCount) + ", but the device does not support Feature::MultiDrawIndirect");
+            return;
+        }
+
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
         m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
     }
 
+    bool CommandListWrapper::validateIndirectCount(IBuffer* indirectParams, IBuffer* countBuffer, uint32_t countOffsetBytes, const char* operation) const
+    {
+        if (!m_Device->queryFeatureSupport(Feature::DrawIndirectCount))
+        {
+            error(std::string(operation) + " is not supported by the device, check Feature::DrawIndirectCount.");
+            return false;
+        }
+
+        if (!indirectParams)
+        {
+            error(std::string("Indirect params buffer is not set before a ") + operation + " call.");
+            return false;
+        }
+
+        if (!countBuffer)
+        {
+            error(std::string("Indirect count buffer is not set before a ") + operation + " call.");
+            return false;
+        }
+
+        const BufferDesc& countBufferDesc = countBuffer->getDesc();
+        if ((countOffsetBytes & 3) != 0 || uint64_t(countOffsetBytes) + sizeof(uint32_t) > countBufferDesc.byteSize)
+        {
+            std::stringstream ss;
+            ss << operation << ": count offset " << countOffsetBytes << " is not 4-byte aligned or is out of bounds of buffer '"
+                << utils::DebugNameToString(countBufferDesc.debugName) << "' (" << countBufferDesc.byteSize << " bytes).";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "drawIndirectCount"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndirectCount call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!validateIndirectCount(m_CurrentGraphicsState.indirectParams, m_CurrentGraphicsState.indirectCountBuffer, countOffsetBytes, "drawIndirectCount"))
+            return;
+
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "drawIndexedIndirectCount"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndexedIndirectCount call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!validateIndirectCount(m_CurrentGraphicsState.indirectParams, m_CurrentGraphicsState.indirectCountBuffer, countOffsetBytes, "drawIndexedIndirectCount"))
+            return;
+
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndexedIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
     void CommandListWrapper::setComputeState(const ComputeState& state)
     {
         if (!requireOpenState())
@@ -861,6 +974,18 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
+        {
+            error("Cannot use buffer '" + std::string(utils::DebugNameToString(state.indirectParams->getDesc().debugName)) + "' as a DispatchMesh argument buffer because it does not have the isDrawIndirectArgs flag set.");
+            anyErrors = true;
+        }
+
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            error("Cannot use buffer '" + std::string(utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName)) + "' as an indirect count buffer because it does not have the isDrawIndirectArgs flag set.");
+            anyErrors = true;
+        }
+
         if (anyErrors)
             return;
 
@@ -903,6 +1028,30 @@ namespace nvrhi::validation
         m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
     }
 
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "dispatchMeshIndirectCount"))
+            return;
+
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMeshIndirectCount call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return;
+        }
+
+        if (!validateIndirectCount(m_CurrentMeshletState.indirectParams, m_CurrentMeshletState.indirectCountBuffer, countOffsetBytes, "dispatchMeshIndirectCount"))
+            return;
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return;
+
+        m_CommandList->dispatchMeshIndirectCount(paramOffsetBytes, countOffsetBytes, maxDispatchCount);
+    }
+
     void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
     {
         if (!requireOpenState())
@@ -29,15 +29,16 @@
 
 namespace nvrhi::validation
 {
-    DeviceHandle createValidationLayer(IDevice* underlyingDevice)
+    DeviceHandle createValidationLayer(IDevice* underlyingDevice, IAllocator* allocator)
     {
-        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice);
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice, allocator);
         return DeviceHandle::Create(wrapper);
     }
 
-    DeviceWrapper::DeviceWrapper(IDevice* device)
+    DeviceWrapper::DeviceWrapper(IDevice* device, IAllocator* allocator)
         : m_Device(device)
         , m_MessageCallback(device->getMessageCallback())
+        , m_AllocationTracker(allocator)
     {
 
     }
@@ -223,6 +224,22 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (d.isTiled && !m_Device->queryFeatureSupport(Feature::TiledResources))
+        {
+            std::stringstream ss;
+            ss << dimensionStr << " " << debugName << ": The device does not support tiled resources";
+            error(ss.str());
+            anyErrors = true;
+        }
+
+        if (d.isTiled && d.isVirtual)
+        {
+            std::stringstream ss;
+            ss << dimensionStr << " " << debugName << ": isTiled and isVirtual cannot be used together";
+            error(ss.str());
+            anyErrors = true;
+        }
+
         if (d.keepInitialState && d.initialState == ResourceStates::Unknown)
         {
             std::stringstream ss;
@@ -318,6 +335,137 @@ namespace nvrhi::validation
 
         return m_Device->bindTextureMemory(texture, heap, offset);
     }
+
+    void DeviceWrapper::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        if (texture == nullptr)
+        {
+            error("getTextureTiling: texture is NULL");
+            return;
+        }
+
+        if (!texture->getDesc().isTiled)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform getTextureTiling on texture " << utils::DebugNameToString(texture->getDesc().debugName)
+                << " because it was created with isTiled = false";
+
+            error(ss.str());
+            return;
+        }
+
+        if (subresourceTilings != nullptr && subresourceTilingsNum == nullptr)
+        {
+            error("getTextureTiling: subresourceTilings is not NULL but subresourceTilingsNum is NULL");
+            return;
+        }
+
+        m_Device->getTextureTiling(texture, numTiles, desc, tileShape, subresourceTilingsNum, subresourceTilings);
+    }
+
+    void DeviceWrapper::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        if (texture == nullptr)
+        {
+            error("updateTextureTileMappings: texture is NULL");
+            return;
+        }
+
+        const TextureDesc& textureDesc = texture->getDesc();
+
+        if (!textureDesc.isTiled)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform updateTextureTileMappings on texture " << utils::DebugNameToString(textureDesc.debugName)
+                << " because it was created with isTiled = false";
+
+            error(ss.str());
+            return;
+        }
+
+        if (numTileMappings > 0 && tileMappings == nullptr)
+        {
+            error("updateTextureTileMappings: tileMappings is NULL");
+            return;
+        }
+
+        PackedMipDesc packedMips;
+        uint32_t numStandardMips = textureDesc.mipLevels;
+        std::vector<SubresourceTiling> tilings(numStandardMips);
+        m_Device->getTextureTiling(texture, nullptr, &packedMips, nullptr, &numStandardMips, tilings.data());
+
+        const uint64_t tileSize = m_Device->getTextureMemoryRequirements(texture).alignment;
+
+        for (uint32_t mappingIndex = 0; mappingIndex < numTileMappings; ++mappingIndex)
+        {
+            const TextureTilesMapping& mapping = tileMappings[mappingIndex];
+
+            if (mapping.numTextureRegions > 0 && (!mapping.tiledTextureCoordinates || !mapping.tiledTextureRegions || !mapping.byteOffsets))
+            {
+                std::stringstream ss;
+                ss << "updateTextureTileMappings: mapping " << mappingIndex << " has " << mapping.numTextureRegions
+                    << " regions, but some of its region arrays are NULL";
+                error(ss.str());
+                return;
+            }
+
+            for (uint32_t regionIndex = 0; regionIndex < mapping.numTextureRegions; ++regionIndex)
+            {
+                const TiledTextureCoordinate& coordinate = mapping.tiledTextureCoordinates[regionIndex];
+                const TiledTextureRegion& region = mapping.tiledTextureRegions[regionIndex];
+                const uint64_t byteOffset = mapping.byteOffsets[regionIndex];
+
+                std::stringstream ss;
+                ss << "updateTextureTileMappings: region " << regionIndex << " of mapping " << mappingIndex
+                    << " for texture " << utils::DebugNameToString(textureDesc.debugName);
+
+                if (coordinate.mipLevel >= textureDesc.mipLevels || coordinate.arrayLevel >= textureDesc.arraySize)
+                {
+                    ss << " refers to mip level " << coordinate.mipLevel << ", array slice " << coordinate.arrayLevel
+                        << ", which does not exist";
+                    error(ss.str());
+                    return;
+                }
+
+                uint64_t numTiles = packedMips.numTilesForPackedMips;
+                if (coordinate.mipLevel < numStandardMips)
+                {
+                    const SubresourceTiling& tiling = tilings[coordinate.mipLevel];
+                    if (coordinate.x + region.width > tiling.widthInTiles ||
+                        coordinate.y + region.height > tiling.heightInTiles ||
+                        coordinate.z + region.depth > tiling.depthInTiles)
+                    {
+                        ss << " extends beyond the " << tiling.widthInTiles << "x" << tiling.heightInTiles << "x" << tiling.depthInTiles
+                            << " tiles of the mip level";
+                        error(ss.str());
+                        return;
+                    }
+
+                    numTiles = uint64_t(region.width) * region.height * region.depth;
+                }
+
+                if (mapping.heap == nullptr)
+                    continue;
+
+                if (tileSize != 0 && (byteOffset % tileSize) != 0)
+                {
+                    ss << " is mapped at offset " << byteOffset << ", which is not a multiple of the tile size " << tileSize;
+                    error(ss.str());
+                    return;
+                }
+
+                if (byteOffset + numTiles * tileSize > mapping.heap->getDesc().capacity)
+                {
+                    ss << " does not fit into heap " << utils::DebugNameToString(mapping.heap->getDesc().debugName)
+                        << " at offset " << byteOffset;
+                    error(ss.str());
+                    return;
+                }
+            }
+        }
+
+        m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
+    }
     
     TextureHandle DeviceWrapper::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
     {
@@ -1001,11 +1149,11 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
-        if (pushConstantSize > c_MaxPushConstantSize)
+        if (pushConstantSize > c_MaxPushConstantBufferSize)
         {
             std::stringstream errorStream;
             errorStream << "Binding layout declares " << pushConstantSize << " bytes of push constant data, "
-                "which exceeds the limit of " << c_MaxPushConstantSize << " bytes";
+                "which exceeds the limit of " << c_MaxPushConstantBufferSize << " bytes";
             error(errorStream.str());
             anyErrors = true;
         }
@@ -1089,6 +1237,12 @@ namespace nvrhi::validation
         if (!validateRenderState(pipelineDesc.renderState, fb))
             return nullptr;
 
+        if (pipelineDesc.dynamicRenderState != DynamicRenderStateFlags::None && !m_Device->queryFeatureSupport(Feature::ExtendedDynamicState))
+        {
+            error("createGraphicsPipeline: dynamicRenderState is not None, but the device does not support Feature::ExtendedDynamicState");
+            return nullptr;
+        }
+
         return m_Device->createGraphicsPipeline(pipelineDesc, fb);
     }
 
@@ -1184,9 +1338,17 @@ namespace nvrhi::validation
                     anyErrors = true;
                 }
 
-                if (item.size > c_MaxPushConstantSize)
+                if (item.size > c_MaxPushConstantBufferSize)
                 {
-                    errorStream << "Push constant block size (" << item.size << ") cannot exceed " << c_MaxPushConstantSize << " bytes" << std::endl;
+                    errorStream << "Push constant block size (" << item.size << ") cannot exceed " << c_MaxPushConstantBufferSize << " bytes" << std::endl;
+                    anyErrors = true;
+                }
+
+                // Blocks larger than c_MaxPushConstantSize are bound like a volatile CB
+                if (item.size > c_MaxPushConstantSize && bindings.numVolatileCBs >= c_MaxVolatileConstantBuffersPerLayout)
+                {
+                    errorStream << "Push constant block size (" << item.size << ") exceeds " << c_MaxPushConstantSize
+                        << " bytes, so it needs a volatile CB slot, but the layout already has " << bindings.numVolatileCBs << std::endl;
                     anyErrors = true;
                 }
 
@@ -1727,7 +1889,7 @@ namespace nvrhi::validation
             return nullptr;
         }
 
-        AccelStructWrapper* wrapper = new AccelStructWrapper(as);
+        AccelStructWrapper* wrapper = new AccelStructWrapper(as, &m_AllocationTracker);
         wrapper->isTopLevel = desc.isTopLevel;
         wrapper->allowUpdate = !!(desc.buildFlags & rt::AccelStructBuildFlags::AllowUpdate);
         wrapper->allowCompaction = !!(desc.buildFlags & rt::AccelStructBuildFlags::AllowCompaction);
@@ -1946,6 +2108,22 @@ namespace nvrhi::validation
         return m_Device->getAftermathCrashDumpHelper();
     }
 
+    AllocationStatistics DeviceWrapper::getAllocationStatistics()
+    {
+        AllocationStatistics statistics = m_Device->getAllocationStatistics();
+        const AllocationStatistics ownStatistics = m_AllocationTracker.getStatistics();
+
+        for (size_t category = 0; category < size_t(AllocationCategory::Count); category++)
+            statistics.bytesInUse[category] += ownStatistics.bytesInUse[category];
+
+        return statistics;
+    }
+
+    ITaskScheduler* DeviceWrapper::getTaskScheduler()
+    {
+        return m_Device->getTaskScheduler();
+    }
+
     void Range::add(uint32_t item)
     {
         min = std::min(min, item);
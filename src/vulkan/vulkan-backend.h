@@ -25,10 +25,22 @@
 #include <nvrhi/vulkan.h>
 #include <nvrhi/utils.h>
 #include <nvrhi/common/aftermath.h>
+#include <nvrhi/common/breadcrumbs.h>
+#include "../common/allocator.h"
+#include "../common/content-hash.h"
 #include "../common/state-tracking.h"
 #include "../common/versioning.h"
+#include "../common/interning.h"
+#include "../common/resource-references.h"
+#include "../common/tile-heap-references.h"
+#include "../common/object-pool.h"
+#include "../common/task-scheduler.h"
+#include <atomic>
 #include <mutex>
 #include <list>
+#include <map>
+#include <thread>
+#include <unordered_map>
 
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include <vulkan/vulkan.hpp>
@@ -124,6 +136,8 @@ namespace nvrhi::vulkan
         size_t& numShadersWithSpecializations,
         size_t& numSpecializationConstants);
 
+    vk::PipelineRenderingCreateInfo makePipelineRenderingCreateInfo(const Framebuffer* fb);
+
     vk::PipelineShaderStageCreateInfo makeShaderStageCreateInfo(
         Shader* shader,
         std::vector<vk::SpecializationInfo>& specInfos,
@@ -165,6 +179,8 @@ namespace nvrhi::vulkan
             bool EXT_debug_marker = false;
             bool KHR_acceleration_structure = false;
             bool buffer_device_address = false; // either KHR_ or Vulkan 1.2 versions
+            bool KHR_draw_indirect_count = false;
+            bool draw_indirect_count = false; // either KHR_ or Vulkan 1.2 versions
             bool KHR_ray_query = false;
             bool KHR_ray_tracing_pipeline = false;
             bool NV_mesh_shader = false;
@@ -172,6 +188,10 @@ namespace nvrhi::vulkan
             bool EXT_conservative_rasterization = false;
             bool EXT_opacity_micromap = false;
             bool NV_ray_tracing_invocation_reorder = false;
+            bool KHR_dynamic_rendering = false;
+            bool AMD_buffer_marker = false;
+            bool EXT_extended_dynamic_state = false;
+            bool EXT_graphics_pipeline_library = false;
 #if NVRHI_WITH_AFTERMATH
             bool EXT_debug_utils = false;
             bool NV_device_diagnostic_checkpoints = false;
@@ -188,6 +208,7 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceRayTracingInvocationReorderPropertiesNV nvRayTracingInvocationReorderProperties;
         vk::PhysicalDeviceFragmentShadingRateFeaturesKHR shadingRateFeatures;
         IMessageCallback* messageCallback = nullptr;
+        TaskDispatcher* taskDispatcher = nullptr;
 #ifdef NVRHI_WITH_RTXMU
         std::unique_ptr<rtxmu::VkAccelStructManager> rtxMemUtil;
         std::unique_ptr<RtxMuResources> rtxMuResources;
@@ -208,7 +229,7 @@ namespace nvrhi::vulkan
         vk::CommandBuffer cmdBuf = vk::CommandBuffer();
         vk::CommandPool cmdPool = vk::CommandPool();
 
-        std::vector<RefCountPtr<IResource>> referencedResources; // to keep them alive
+        ResourceReferenceSet referencedResources; // to keep them alive
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers; // to allow synchronous mapBuffer
 
         uint64_t recordingID = 0;
@@ -249,7 +270,14 @@ namespace nvrhi::vulkan
         void addSignalSemaphore(vk::Semaphore semaphore, uint64_t value);
 
         // submits a command buffer to this queue, returns submissionID
-        uint64_t submit(ICommandList* const* ppCmd, size_t numCmd);
+        // the prologue command buffer, if any, executes before the command lists in the same batch
+        uint64_t submit(ICommandList* const* ppCmd, size_t numCmd, const TrackedCommandBufferPtr& prologue = nullptr);
+
+        // submits an internal command buffer without consuming the wait and signal semaphores added for the next submit
+        uint64_t submitInternal(const TrackedCommandBufferPtr& commandBuffer);
+
+        // performs sparse binding after all previous work on the queue, and makes the next submit wait for it
+        uint64_t bindSparse(vk::BindSparseInfo bindInfo);
 
         // retire any command buffers that have finished execution from the pending execution list
         void retireCommandBuffers();
@@ -260,6 +288,7 @@ namespace nvrhi::vulkan
         uint64_t getLastSubmittedID() const { return m_LastSubmittedID; }
         uint64_t getLastFinishedID() const { return m_LastFinishedID; }
         CommandQueue getQueueID() const { return m_QueueID; }
+        uint32_t getQueueFamilyIndex() const { return m_QueueFamilyIndex; }
         vk::Queue getVkQueue() const { return m_Queue; }
 
         bool pollCommandList(uint64_t commandListID);
@@ -287,6 +316,46 @@ namespace nvrhi::vulkan
         std::list<TrackedCommandBufferPtr> m_CommandBuffersPool;
     };
 
+    // Runs the callbacks registered with IDevice::registerCompletionCallback.
+    // A single thread waits until any queue's tracking semaphore reaches the earliest pending value on that queue.
+    // The wait also includes a host-signaled wake semaphore, which interrupts it when an earlier value
+    // is registered or when the thread is shut down. If the wait fails, the pending callbacks and all that are
+    // registered later are called with completed = false.
+    class CompletionThread
+    {
+    public:
+        explicit CompletionThread(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~CompletionThread() { shutdown(); }
+
+        void registerCallback(Queue& queue, uint64_t submissionID, std::function<void(bool completed)> callback);
+
+        // Waits for all pending callbacks to be called and stops the thread
+        void shutdown();
+
+    private:
+        struct PendingCallbacks
+        {
+            vk::Semaphore semaphore;
+            std::multimap<uint64_t, std::function<void(bool completed)>> callbacks;
+        };
+
+        const VulkanContext& m_Context;
+
+        std::mutex m_Mutex;
+        std::thread m_Thread;
+        std::array<PendingCallbacks, uint32_t(CommandQueue::Count)> m_PendingCallbacks;
+        vk::Semaphore m_WakeSemaphore;
+        uint64_t m_WakeValue = 0;
+        bool m_Terminate = false;
+        bool m_Failed = false;
+
+        void wake();
+        void threadProc();
+    };
+
     class MemoryResource
     {
     public:
@@ -360,7 +429,7 @@ namespace nvrhi::vulkan
         }
     };
 
-    class Texture : public MemoryResource, public RefCounter<ITexture>, public TextureStateExtension
+    class Texture : public MemoryResource, public RefCounter<ITexture>, public TextureStateExtension, public PooledObject<Texture>
     {
     public:
 
@@ -403,6 +472,11 @@ namespace nvrhi::vulkan
 
         HeapHandle heap;
 
+        // filled for textures created with isTiled = true
+        vk::SparseImageMemoryRequirements sparseRequirements;
+        vk::DeviceSize tileSize = 0;
+        TileHeapReferences tileHeaps;
+
         void* sharedHandle = nullptr;
 
         // contains subresource views for this texture
@@ -536,7 +610,7 @@ namespace nvrhi::vulkan
         }
     };
 
-    class Buffer : public MemoryResource, public RefCounter<IBuffer>, public BufferStateExtension
+    class Buffer : public MemoryResource, public RefCounter<IBuffer>, public BufferStateExtension, public PooledObject<Buffer>
     {
     public:
         BufferDesc desc;
@@ -624,6 +698,81 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
+    // Identifies a SPIR-V binary by a 128-bit hash of its contents and its size
+    struct ShaderModuleKey
+    {
+        ContentHash contentHash;
+        size_t size = 0;
+
+        bool operator==(const ShaderModuleKey& other) const { return contentHash == other.contentHash && size == other.size; }
+        bool operator!=(const ShaderModuleKey& other) const { return !(*this == other); }
+    };
+
+    struct ShaderSpecializationKey
+    {
+        ShaderModuleKey module;
+        std::string entryName;
+        ShaderType shaderType = ShaderType::None;
+        std::vector<ShaderSpecialization> constants;
+
+        bool operator==(const ShaderSpecializationKey& other) const;
+        bool operator!=(const ShaderSpecializationKey& other) const { return !(*this == other); }
+    };
+}
+
+namespace std
+{
+    template<> struct hash<nvrhi::vulkan::ShaderModuleKey>
+    {
+        std::size_t operator()(nvrhi::vulkan::ShaderModuleKey const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.contentHash);
+            nvrhi::hash_combine(hash, s.size);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::vulkan::ShaderSpecializationKey>
+    {
+        std::size_t operator()(nvrhi::vulkan::ShaderSpecializationKey const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.module);
+            nvrhi::hash_combine(hash, s.entryName);
+            nvrhi::hash_combine(hash, s.shaderType);
+            for (const auto& constant : s.constants)
+            {
+                nvrhi::hash_combine(hash, constant.constantID);
+                nvrhi::hash_combine(hash, constant.value.u);
+            }
+            return hash;
+        }
+    };
+}
+
+namespace nvrhi::vulkan
+{
+    // A shader module shared by all Shader objects created from the same SPIR-V binary
+    class SharedShaderModule : public RefCounter<IResource>
+    {
+    public:
+        ShaderModuleKey key;
+        vk::ShaderModule shaderModule;
+
+        // Copy of the SPIR-V binary, only kept when DeviceDesc::retainShaderBytecode is set
+        std::vector<char> bytecode;
+
+        explicit SharedShaderModule(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~SharedShaderModule() override;
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
     class Shader : public RefCounter<IShader>
     {
     public:
@@ -632,6 +781,9 @@ namespace nvrhi::vulkan
         vk::ShaderModule shaderModule;
         vk::ShaderStageFlagBits stageFlagBits{};
 
+        // Owner of 'shaderModule' for shaders created with createShader and their specializations
+        RefCountPtr<SharedShaderModule> sharedModule;
+
         // Shader specializations are just references to the original shader module
         // plus the specialization constant array.
         ResourceHandle baseShader; // Could be a Shader or ShaderLibrary
@@ -679,14 +831,14 @@ namespace nvrhi::vulkan
         const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
     };
 
-    class EventQuery : public RefCounter<IEventQuery>
+    class EventQuery : public RefCounter<IEventQuery>, public PooledObject<EventQuery>
     {
     public:
         CommandQueue queue = CommandQueue::Graphics;
         uint64_t commandListID = 0;
     };
     
-    class TimerQuery : public RefCounter<ITimerQuery>
+    class TimerQuery : public RefCounter<ITimerQuery>, public PooledObject<TimerQuery>
     {
     public:
         int beginQueryIndex = -1;
@@ -706,6 +858,175 @@ namespace nvrhi::vulkan
         utils::BitSetAllocator& m_QueryAllocator;
     };
 
+    // Describes the attachments of a render pass.
+    // Render passes are interned by the device using this key, so framebuffers with compatible attachments share one.
+    struct RenderPassKey
+    {
+        static_vector<vk::AttachmentDescription2, c_MaxRenderTargets + 2> attachments; // render targets + depth + shading rate
+        uint32_t numColorAttachments = 0;
+        bool hasDepthAttachment = false;
+        bool hasShadingRateAttachment = false;
+        vk::Extent2D shadingRateTexelSize;
+
+        bool operator==(const RenderPassKey& other) const;
+        bool operator!=(const RenderPassKey& other) const { return !(*this == other); }
+    };
+
+    // Identifies one part of a graphics pipeline built with VK_EXT_graphics_pipeline_library.
+    // Contains the part's create info flattened into words, see vulkan-pipeline-library.cpp.
+    struct PipelineLibraryKey
+    {
+        std::vector<uint64_t> data;
+
+        bool operator==(const PipelineLibraryKey& other) const { return data == other.data; }
+        bool operator!=(const PipelineLibraryKey& other) const { return !(*this == other); }
+    };
+
+    struct PipelineLibrary
+    {
+        vk::Pipeline pipeline;
+
+        // Number of pipeline links using the part. The part is destroyed when the last one is released.
+        uint32_t useCount = 0;
+    };
+
+    // Graphics pipeline parts shared between the pipelines that have the same shaders and state for a part.
+    // Keys contain the shader module handles, which are interned and kept alive by the pipelines using the part,
+    // so a handle cannot be reused for different code while its part is in the cache.
+    class PipelineLibraryCache
+    {
+    public:
+        PipelineLibraryCache(const VulkanContext& context, AllocationTracker* allocationTracker)
+            : m_Context(context)
+            , m_Libraries(decltype(m_Libraries)::allocator_type(allocationTracker, AllocationCategory::Caches))
+        { }
+
+        ~PipelineLibraryCache();
+
+        // Finds or creates the part and adds a use to it. 'outKey' identifies the part when releasing it.
+        vk::Result acquire(PipelineLibraryKey key, const vk::GraphicsPipelineCreateInfo& partInfo,
+            vk::Pipeline& outPipeline, const PipelineLibraryKey*& outKey);
+
+        // Removes a use added by acquire and destroys the part if it was the last one
+        void release(const PipelineLibraryKey* key);
+
+    private:
+        const VulkanContext& m_Context;
+        std::mutex m_Mutex;
+        tracked_unordered_map<PipelineLibraryKey, PipelineLibrary> m_Libraries;
+    };
+
+    // State shared between a graphics pipeline linked from parts and the background task that links its
+    // optimized version, so that neither waits for the other. Whichever of the two is done last destroys
+    // the optimized pipeline and releases the parts.
+    class PipelineLinkState
+    {
+    public:
+        PipelineLibraryCache* libraryCache = nullptr;
+        static_vector<const PipelineLibraryKey*, 4> libraries;
+
+        // Owned by the link state because the task links with it
+        vk::PipelineLayout pipelineLayout;
+
+        std::atomic<VkPipeline> optimizedPipeline = VK_NULL_HANDLE;
+
+        // Called by the task with its result, which is null if linking failed
+        void linkFinished(const VulkanContext& context, vk::Pipeline optimized);
+
+        // Called when the pipeline object is destroyed
+        void pipelineReleased(const VulkanContext& context);
+
+        void setLinkPending() { std::lock_guard lockGuard(m_Mutex); m_LinkPending = true; }
+        [[nodiscard]] bool isLinkPending() { std::lock_guard lockGuard(m_Mutex); return m_LinkPending; }
+
+    private:
+        std::mutex m_Mutex;
+        bool m_LinkPending = false;
+        bool m_PipelineReleased = false;
+
+        void destroy(const VulkanContext& context);
+    };
+
+    struct FramebufferKey
+    {
+        vk::RenderPass renderPass;
+        static_vector<vk::ImageView, c_MaxRenderTargets + 2> attachments;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t layers = 0;
+
+        bool operator==(const FramebufferKey& other) const;
+        bool operator!=(const FramebufferKey& other) const { return !(*this == other); }
+    };
+}
+
+namespace std
+{
+    template<> struct hash<nvrhi::vulkan::RenderPassKey>
+    {
+        std::size_t operator()(nvrhi::vulkan::RenderPassKey const& s) const noexcept;
+    };
+
+    template<> struct hash<nvrhi::vulkan::FramebufferKey>
+    {
+        std::size_t operator()(nvrhi::vulkan::FramebufferKey const& s) const noexcept;
+    };
+
+    template<> struct hash<nvrhi::vulkan::PipelineLibraryKey>
+    {
+        std::size_t operator()(nvrhi::vulkan::PipelineLibraryKey const& s) const noexcept;
+    };
+}
+
+namespace nvrhi::vulkan
+{
+    // A framebuffer object that may be shared by multiple Framebuffer instances through the FramebufferCache.
+    // Keeps the attachment textures alive because the framebuffer object references their image views.
+    class FramebufferObject
+    {
+    public:
+        vk::Framebuffer framebuffer = vk::Framebuffer();
+        std::vector<ResourceHandle> resources;
+
+        explicit FramebufferObject(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~FramebufferObject();
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
+    // LRU cache of framebuffer objects, keyed by render pass and attachment views.
+    // Evicting an entry is always safe: Framebuffer instances and, through them, in-flight command buffers
+    // hold their own references to the object.
+    class FramebufferCache
+    {
+    public:
+        FramebufferCache(uint32_t capacity, AllocationTracker* allocationTracker)
+            : m_Capacity(capacity)
+            , m_Entries(EntryList::allocator_type(allocationTracker, AllocationCategory::Caches))
+            , m_EntryMap(EntryMap::allocator_type(allocationTracker, AllocationCategory::Caches))
+        { }
+
+        std::shared_ptr<FramebufferObject> find(const FramebufferKey& key);
+
+        // Returns the object that ends up in the cache, which is the existing one if another thread inserted the same key first
+        std::shared_ptr<FramebufferObject> insert(const FramebufferKey& key, const std::shared_ptr<FramebufferObject>& object);
+
+        void clear();
+
+    private:
+        typedef tracked_list<std::pair<FramebufferKey, std::shared_ptr<FramebufferObject>>> EntryList;
+        typedef tracked_unordered_map<FramebufferKey, EntryList::iterator> EntryMap;
+
+        uint32_t m_Capacity;
+        std::mutex m_Mutex;
+        EntryList m_Entries; // most recently used first
+        EntryMap m_EntryMap;
+    };
+
     class Framebuffer : public RefCounter<IFramebuffer>
     {
     public:
@@ -715,6 +1036,20 @@ namespace nvrhi::vulkan
         vk::RenderPass renderPass = vk::RenderPass();
         vk::Framebuffer framebuffer = vk::Framebuffer();
 
+        // Owner of 'framebuffer' for framebuffers created through Device::createFramebuffer.
+        // The render pass of such framebuffers is owned by the device render pass cache.
+        std::shared_ptr<FramebufferObject> framebufferObject;
+
+        // Attachment info for VK_KHR_dynamic_rendering, used instead of renderPass and framebuffer when 'dynamicRendering' is set
+        bool dynamicRendering = false;
+        uint32_t numArraySlices = 0;
+        static_vector<vk::ImageView, c_MaxRenderTargets> colorAttachmentViews;
+        static_vector<vk::Format, c_MaxRenderTargets> colorAttachmentFormats;
+        vk::ImageView depthAttachmentView = vk::ImageView();
+        vk::ImageLayout depthAttachmentLayout = vk::ImageLayout::eUndefined;
+        vk::Format depthAttachmentFormat = vk::Format::eUndefined;
+        bool depthAttachmentHasStencil = false;
+
         std::vector<ResourceHandle> resources;
 
         bool managed = true;
@@ -761,7 +1096,51 @@ namespace nvrhi::vulkan
     };
 
     // contains a vk::DescriptorSet
-    class BindingSet : public RefCounter<IBindingSet>
+    // Push constant blocks larger than c_MaxPushConstantSize are bound as a dynamic uniform buffer.
+    // Binding sets point at the first page of this device-wide pool, and command lists write their data into blocks of it,
+    // so setPushConstants only needs a memcpy and a new dynamic offset. Blocks are recycled by version like upload chunks.
+    // When every block is in flight, the pool grows by another page; binding sets get a descriptor set for that page on first use.
+    class PushConstantBufferPool
+    {
+    public:
+        static constexpr uint64_t c_BlockSize = 64 * 1024;
+        static constexpr uint32_t c_BlocksPerPage = 256;
+        static constexpr uint32_t c_MaxPages = 16;
+
+        explicit PushConstantBufferPool(Device* device)
+            : m_Device(device)
+        { }
+
+        // Creates the first page on first use
+        Buffer* getBuffer(uint32_t page = 0);
+
+        // Block indices are global, see getBlockPage and getBlockOffset
+        bool allocateBlock(uint64_t currentVersion, uint32_t& outBlock);
+        void submitBlocks(const std::vector<uint32_t>& blocks, uint64_t submittedVersion);
+
+        [[nodiscard]] static uint32_t getBlockPage(uint32_t block) { return block / c_BlocksPerPage; }
+        [[nodiscard]] static uint64_t getBlockOffset(uint32_t block) { return (block % c_BlocksPerPage) * c_BlockSize; }
+        [[nodiscard]] char* getBlockData(uint32_t block) const;
+
+    private:
+        struct Page
+        {
+            BufferHandle buffer;
+            void* mappedMemory = nullptr;
+            std::array<uint64_t, c_BlocksPerPage> blockVersions{};
+        };
+
+        bool createPage();
+
+        Device* m_Device;
+        std::mutex m_Mutex;
+        // Pages never move once created, so block data can be accessed without the lock
+        std::array<std::unique_ptr<Page>, c_MaxPages> m_Pages;
+        uint32_t m_NumPages = 0;
+        uint32_t m_SearchStart = 0;
+    };
+
+    class BindingSet : public RefCounter<IBindingSet>, public PooledObject<BindingSet>
     {
     public:
         BindingSetDesc desc;
@@ -785,8 +1164,20 @@ namespace nvrhi::vulkan
         IBindingLayout* getLayout() const override { return layout; }
         Object getNativeObject(ObjectType objectType) override;
 
+        // Returns the descriptor set that points the push constant binding at the given page of the pool
+        vk::DescriptorSet getDescriptorSetForPushConstantPage(PushConstantBufferPool& pool, uint32_t page);
+
     private:
         const VulkanContext& m_Context;
+
+        // Copies of descriptorSet for the push constant pool pages after the first one, created on first use
+        struct PushConstantPageSet
+        {
+            vk::DescriptorPool descriptorPool;
+            vk::DescriptorSet descriptorSet;
+        };
+        std::mutex m_PushConstantPageMutex;
+        std::array<PushConstantPageSet, PushConstantBufferPool::c_MaxPages - 1> m_PushConstantPageSets;
     };
 
     class DescriptorTable : public RefCounter<IDescriptorTable>
@@ -837,11 +1228,19 @@ namespace nvrhi::vulkan
         vk::ShaderStageFlags pushConstantVisibility;
         bool usesBlendConstants = false;
 
+        // Pipelines linked from libraries: 'pipeline' is the fast-linked one, and the background task
+        // stores the link-time optimized pipeline in the link state when it's done.
+        std::shared_ptr<PipelineLinkState> linkState;
+
         explicit GraphicsPipeline(const VulkanContext& context)
             : m_Context(context)
         { }
 
         ~GraphicsPipeline() override;
+
+        // Returns the optimized pipeline if it's available, otherwise the one created by createGraphicsPipeline
+        [[nodiscard]] vk::Pipeline getPipelineForBinding() const;
+
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
         Object getNativeObject(ObjectType objectType) override;
@@ -974,12 +1373,7 @@ namespace nvrhi::vulkan
     class UploadManager
     {
     public:
-        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
-            : m_Device(pParent)
-            , m_DefaultChunkSize(defaultChunkSize)
-            , m_MemoryLimit(memoryLimit)
-            , m_IsScratchBuffer(isScratchBuffer)
-        { }
+        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer);
 
         std::shared_ptr<BufferChunk> CreateChunk(uint64_t size);
 
@@ -993,7 +1387,7 @@ namespace nvrhi::vulkan
         uint64_t m_AllocatedMemory = 0;
         bool m_IsScratchBuffer = false;
 
-        std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
+        tracked_list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
     };
 
@@ -1069,6 +1463,8 @@ namespace nvrhi::vulkan
         TextureHandle createTexture(const TextureDesc& d) override;
         MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
         bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
 
@@ -1150,10 +1546,31 @@ namespace nvrhi::vulkan
         uint64_t queueGetCompletedInstance(CommandQueue queue) override;
         FramebufferHandle createHandleForNativeFramebuffer(VkRenderPass renderPass, VkFramebuffer framebuffer,
             const FramebufferDesc& desc, bool transferOwnership) override;
+        InterningStatistics getSamplerInterningStatistics() override;
+        InterningStatistics getInputLayoutInterningStatistics() override;
+        std::string getBreadcrumbReport() override;
+        void registerCompletionCallback(CommandQueue queue, uint64_t submissionID, std::function<void(bool completed)> callback) override;
+        EventTimelinePoint getEventTimelinePoint(CommandQueue queue) override;
+        void pollEventTimelinePoints(const EventTimelinePoint* points, size_t numPoints, bool* results) override;
+        void pollEventQueries(IEventQuery* const* queries, size_t numQueries, bool* results) override;
+        void waitEventTimelinePoint(const EventTimelinePoint& point) override;
+        AllocationStatistics getAllocationStatistics() override { return m_AllocationTracker.getStatistics(); }
+        ITaskScheduler* getTaskScheduler() override { return m_TaskDispatcher.getScheduler(); }
+
+        // internal methods
+        [[nodiscard]] bool isBreadcrumbsEnabled() const { return m_BreadcrumbsEnabled; }
+        [[nodiscard]] vk::Buffer getBreadcrumbBuffer(CommandQueue queue) const;
+        uint32_t allocateBreadcrumbSlot(CommandQueue queue);
+        uint32_t allocateCommandListID() { return ++m_LastCommandListID; }
+        [[nodiscard]] AllocationTracker* getAllocationTracker() { return &m_AllocationTracker; }
+        [[nodiscard]] bool isQueueOwnershipTrackingEnabled() const { return m_QueueOwnershipTransfers; }
+        [[nodiscard]] PushConstantBufferPool& getPushConstantBufferPool() { return m_PushConstantBufferPool; }
 
     private:
         VulkanContext m_Context;
         VulkanAllocator m_Allocator;
+        AllocationTracker m_AllocationTracker;
+        TaskDispatcher m_TaskDispatcher;
         
         vk::QueryPool m_TimerQueryPool = nullptr;
         utils::BitSetAllocator m_TimerQueryAllocator;
@@ -1162,7 +1579,89 @@ namespace nvrhi::vulkan
 
         // array of submission queues
         std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> m_Queues;
+
+        // declared after m_Queues so that it stops before the queue semaphores are destroyed
+        CompletionThread m_CompletionThread;
+        
+        std::mutex m_RenderPassCacheMutex;
+        tracked_unordered_map<RenderPassKey, vk::RenderPass> m_RenderPassCache;
+        FramebufferCache m_FramebufferCache;
+        bool m_UseDynamicRendering = false;
+
+        // Graphics pipeline parts, kept while a pipeline or an optimizing link uses them
+        bool m_UsePipelineLibraries = false;
+        PipelineLibraryCache m_PipelineLibraries;
+
+        // Optimizing link tasks, waited on once they are done or when the device is destroyed
+        std::mutex m_PipelineLinkMutex;
+        std::vector<std::pair<ITaskScheduler::TaskID, std::shared_ptr<PipelineLinkState>>> m_PipelineLinkTasks;
+
+        void retirePipelineLinkTasks(bool waitForAll);
+
+        InterningTable<SamplerDesc, SamplerHandle> m_SamplerTable;
+        InterningTable<ShaderModuleKey, RefCountPtr<SharedShaderModule>> m_ShaderModuleTable;
+        InterningTable<ShaderSpecializationKey, ShaderHandle> m_ShaderSpecializationTable;
+        bool m_RetainShaderBytecode = false;
+        InterningTable<std::vector<VertexAttributeDesc>, InputLayoutHandle, ArrayHash<std::vector<VertexAttributeDesc>>> m_InputLayoutTable;
+
+        // Completed submission IDs of each queue, read at most once during a batched event poll
+        struct CompletedSubmissionCache
+        {
+            std::array<uint64_t, uint32_t(CommandQueue::Count)> values{};
+            std::array<bool, uint32_t(CommandQueue::Count)> valid{};
+        };
+
+        bool isSubmissionCompleted(CommandQueue queue, uint64_t submissionID, CompletedSubmissionCache& cache);
+
+        // Tile mapping updates collected per queue, issued in one vkQueueBindSparse before the next submission
+        struct PendingSparseBinds
+        {
+            TextureHandle texture;
+            std::vector<vk::SparseImageMemoryBind> imageBinds;
+            std::vector<vk::SparseMemoryBind> mipTailBinds;
+            // The heaps the binds refer to and the heaps they replace, see flushSparseBinds
+            std::vector<HeapHandle> heaps;
+        };
+
+        // Heaps that must stay alive until every queue has finished the given submission; 0 means nothing to wait for
+        struct RetiredSparseHeaps
+        {
+            std::array<uint64_t, uint32_t(CommandQueue::Count)> submissionIDs{};
+            std::vector<HeapHandle> heaps;
+        };
+
+        bool m_SparseResidencySupported = false;
+        bool m_MultiDrawIndirectSupported = false;
+        std::array<bool, uint32_t(CommandQueue::Count)> m_QueueSupportsSparseBinding = {};
+        std::mutex m_SparseBindMutex;
+        std::array<std::vector<PendingSparseBinds>, uint32_t(CommandQueue::Count)> m_PendingSparseBinds;
+        std::vector<RetiredSparseHeaps> m_RetiredSparseHeaps;
+
+        void flushSparseBinds(CommandQueue queue);
+        void releaseRetiredSparseHeaps();
+
+        PushConstantBufferPool m_PushConstantBufferPool;
+
+        bool m_QueueOwnershipTransfers = false;
+        std::mutex m_QueueOwnershipMutex;
+        QueueOwnershipTracker m_QueueOwnershipTracker;
+
+        // Submits the releases to the source queues and returns the command buffer with the acquires for the destination queue
+        TrackedCommandBufferPtr submitQueueOwnershipReleases(const std::vector<QueueOwnershipTransfer>& transfers, CommandQueue dstQueue);
+
+        vk::RenderPass getOrCreateRenderPass(const RenderPassKey& key);
+        vk::Result createGraphicsPipelineFromLibraries(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo, IFramebuffer* fb);
+        SamplerHandle createSamplerInternal(const SamplerDesc& desc);
+        InputLayoutHandle createInputLayoutInternal(const VertexAttributeDesc* attributeDesc, uint32_t attributeCount);
         
+        bool m_BreadcrumbsEnabled = false;
+        std::array<BufferHandle, uint32_t(CommandQueue::Count)> m_BreadcrumbBuffers;
+        std::array<const uint32_t*, uint32_t(CommandQueue::Count)> m_BreadcrumbData{};
+        std::array<std::atomic<uint32_t>, uint32_t(CommandQueue::Count)> m_BreadcrumbSlotCounters{};
+        std::atomic<uint32_t> m_LastCommandListID = 0;
+
+        void createBreadcrumbBuffers();
+
         void *mapBuffer(IBuffer* b, CpuAccessMode flags, uint64_t offset, size_t size) const;
         bool m_AftermathEnabled = false;
         AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
@@ -1201,6 +1700,7 @@ namespace nvrhi::vulkan
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+        IBuffer* allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
 
@@ -1209,6 +1709,8 @@ namespace nvrhi::vulkan
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -1216,6 +1718,7 @@ namespace nvrhi::vulkan
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
@@ -1258,6 +1761,7 @@ namespace nvrhi::vulkan
         const CommandListParameters& getDesc() override { return m_CommandListParameters; }
 
         TrackedCommandBufferPtr getCurrentCmdBuf() const { return m_CurrentCmdBuf; }
+        CommandListResourceStateTracker& getStateTracker() { return m_StateTracker; }
 
     private:
         Device* m_Device;
@@ -1268,15 +1772,28 @@ namespace nvrhi::vulkan
         CommandListResourceStateTracker m_StateTracker;
         bool m_EnableAutomaticBarriers = true;
 
+        // With queue ownership transfers, the resources used by the command list are recorded even when
+        // automatic barriers are disabled, so that their transfers are not skipped
+        bool m_RecordResourceUses = false;
+
+        [[nodiscard]] bool isTrackingResources() const { return m_EnableAutomaticBarriers || m_RecordResourceUses; }
+
         // current internal command buffer
         TrackedCommandBufferPtr m_CurrentCmdBuf = nullptr;
 
-#if NVRHI_WITH_AFTERMATH
+        // also used to resolve the breadcrumb marker names when breadcrumbs are enabled without Aftermath
         AftermathMarkerTracker m_AftermathTracker;
-#endif
+
+        uint32_t m_CommandListID = 0;
+        BreadcrumbEncoder m_Breadcrumbs;
+        bool m_BreadcrumbsSkippedInRenderPass = false; // warned once about writes dropped inside a render pass
+
+        // endOfCommandList orders the writes after all the work recorded before them
+        void writeBreadcrumbs(const BreadcrumbWrites& writes, bool endOfCommandList = false);
 
         vk::PipelineLayout m_CurrentPipelineLayout;
         vk::ShaderStageFlags m_CurrentPushConstantsVisibility;
+        vk::Pipeline m_CurrentGraphicsPipelineObject; // differs from the state's pipeline when an optimized library link becomes available
         GraphicsState m_CurrentGraphicsState{};
         ComputeState m_CurrentComputeState{};
         MeshletState m_CurrentMeshletState{};
@@ -1292,7 +1809,13 @@ namespace nvrhi::vulkan
             uint32_t version = 0;
         } m_CurrentShaderTablePointers;
 
-        std::unordered_map<Buffer*, VolatileBufferState> m_VolatileBufferStates;
+        tracked_unordered_map<Buffer*, VolatileBufferState> m_VolatileBufferStates;
+
+        // Blocks of the push constant buffer pool used by the current recording, the last one is being written
+        std::vector<uint32_t> m_PushConstantBlocks;
+        uint64_t m_PushConstantWritePointer = 0;
+        uint32_t m_CurrentPushConstantBufferOffset = 0;
+        uint32_t m_CurrentPushConstantBufferPage = 0;
 
         std::unique_ptr<UploadManager> m_UploadManager;
         std::unique_ptr<UploadManager> m_ScratchManager;
@@ -1301,12 +1824,18 @@ namespace nvrhi::vulkan
 
         void bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx);
 
+        void beginRenderPass(Framebuffer* fb);
         void endRenderPass();
 
+        void setDynamicRenderState(DynamicRenderStateFlags groups, const DynamicRenderState& state, const DynamicRenderState* prev);
+
         void trackResourcesAndBarriers(const GraphicsState& state);
         void trackResourcesAndBarriers(const MeshletState& state);
+        void requireFramebufferStates(IFramebuffer* framebuffer);
+        void requireBindingSetStates(IBindingSet* bindingSet);
         
         void writeVolatileBuffer(Buffer* buffer, const void* data, size_t dataSize);
+        void writePushConstantBuffer(const void* data, size_t dataSize);
         void flushVolatileBufferWrites();
         void submitVolatileBuffers(uint64_t recordingID, uint64_t submittedID);
 
@@ -195,14 +195,14 @@ namespace nvrhi::vulkan
         if (dest->desc.cpuAccess != CpuAccessMode::None)
             m_CurrentCmdBuf->referencedStagingBuffers.push_back(dest);
         else
-            m_CurrentCmdBuf->referencedResources.push_back(dest);
+            m_CurrentCmdBuf->referencedResources.add(dest);
 
         if (src->desc.cpuAccess != CpuAccessMode::None)
             m_CurrentCmdBuf->referencedStagingBuffers.push_back(src);
         else
-            m_CurrentCmdBuf->referencedResources.push_back(src);
+            m_CurrentCmdBuf->referencedResources.add(src);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(src, ResourceStates::CopySource);
             requireBufferState(dest, ResourceStates::CopyDest);
@@ -337,6 +337,37 @@ namespace nvrhi::vulkan
         m_AnyVolatileBufferWrites = true;
     }
 
+    void CommandList::writePushConstantBuffer(const void* data, size_t dataSize)
+    {
+        PushConstantBufferPool& pool = m_Device->getPushConstantBufferPool();
+
+        const uint64_t alignment = m_Context.physicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
+        uint64_t offset = align(m_PushConstantWritePointer, alignment);
+
+        if (m_PushConstantBlocks.empty() || offset + dataSize > PushConstantBufferPool::c_BlockSize)
+        {
+            uint32_t block;
+            if (!pool.allocateBlock(MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false), block))
+            {
+                m_Context.error("The push constant buffer pool is exhausted, too many large push constant writes are in flight");
+                return;
+            }
+
+            m_PushConstantBlocks.push_back(block);
+            offset = 0;
+        }
+
+        const uint32_t block = m_PushConstantBlocks.back();
+        memcpy(pool.getBlockData(block) + offset, data, dataSize);
+
+        m_PushConstantWritePointer = offset + dataSize;
+        m_CurrentPushConstantBufferOffset = uint32_t(PushConstantBufferPool::getBlockOffset(block) + offset);
+        m_CurrentPushConstantBufferPage = PushConstantBufferPool::getBlockPage(block);
+
+        // The new offset and page are applied when the binding sets are rebound before the next draw or dispatch
+        m_AnyVolatileBufferWrites = true;
+    }
+
     void CommandList::flushVolatileBufferWrites()
     {
         // The volatile CBs are permanently mapped with the eHostVisible flag, but not eHostCoherent,
@@ -365,6 +396,21 @@ namespace nvrhi::vulkan
             ranges.push_back(range);
         }
 
+        if (!m_PushConstantBlocks.empty())
+        {
+            PushConstantBufferPool& pool = m_Device->getPushConstantBufferPool();
+
+            for (uint32_t block : m_PushConstantBlocks)
+            {
+                Buffer* pushConstantBuffer = pool.getBuffer(PushConstantBufferPool::getBlockPage(block));
+
+                ranges.push_back(vk::MappedMemoryRange()
+                    .setMemory(pushConstantBuffer->memory)
+                    .setOffset(PushConstantBufferPool::getBlockOffset(block))
+                    .setSize(PushConstantBufferPool::c_BlockSize));
+            }
+        }
+
         if (!ranges.empty())
         {
             m_Context.device.flushMappedMemoryRanges(ranges);
@@ -408,7 +454,7 @@ namespace nvrhi::vulkan
 
         endRenderPass();
 
-        m_CurrentCmdBuf->referencedResources.push_back(buffer);
+        m_CurrentCmdBuf->referencedResources.add(buffer);
 
         if (buffer->desc.isVolatile)
         {
@@ -426,7 +472,7 @@ namespace nvrhi::vulkan
         // is rounded up later.
         if (dataSize <= vkCmdUpdateBufferLimit && (destOffsetBytes & 3) == 0)
         {
-            if (m_EnableAutomaticBarriers)
+            if (isTrackingResources())
             {
                 requireBufferState(buffer, ResourceStates::CopyDest);
             }
@@ -458,6 +504,20 @@ namespace nvrhi::vulkan
         }
     }
 
+    IBuffer* CommandList::allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress)
+    {
+        assert(m_CurrentCmdBuf);
+
+        // Upload chunks are host-visible and never change state, so using one as indirectParams needs no barrier
+        Buffer* uploadBuffer = nullptr;
+        if (!m_UploadManager->suballocateBuffer(byteSize, &uploadBuffer, outOffset, outCpuAddress,
+            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false)))
+            return nullptr;
+
+        m_CurrentCmdBuf->referencedResources.add(uploadBuffer);
+        return uploadBuffer;
+    }
+
     void CommandList::clearBufferUInt(IBuffer* b, uint32_t clearValue)
     {
         Buffer* vkbuf = checked_cast<Buffer*>(b);
@@ -466,14 +526,14 @@ namespace nvrhi::vulkan
 
         endRenderPass();
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(vkbuf, ResourceStates::CopyDest);
         }
         commitBarriers();
 
         m_CurrentCmdBuf->cmdBuf.fillBuffer(vkbuf->buffer, 0, vkbuf->desc.byteSize, clearValue);
-        m_CurrentCmdBuf->referencedResources.push_back(b);
+        m_CurrentCmdBuf->referencedResources.add(b);
     }
 
     Buffer::~Buffer()
@@ -29,22 +29,23 @@ namespace nvrhi::vulkan
         : m_Device(device)
         , m_Context(context)
         , m_CommandListParameters(parameters)
-        , m_StateTracker(context.messageCallback)
+        , m_StateTracker(context.messageCallback, device->getAllocationTracker())
+        , m_VolatileBufferStates(decltype(m_VolatileBufferStates)::allocator_type(device->getAllocationTracker(), AllocationCategory::StateTracking))
         , m_UploadManager(std::make_unique<UploadManager>(device, parameters.uploadChunkSize, 0, false))
         , m_ScratchManager(std::make_unique<UploadManager>(device, parameters.scratchChunkSize, parameters.scratchMaxMemory, true))
+        , m_CommandListID(device->allocateCommandListID())
     {
-#if NVRHI_WITH_AFTERMATH
-        if (m_Device->isAftermathEnabled())
+        m_RecordResourceUses = m_Device->isQueueOwnershipTrackingEnabled();
+        m_StateTracker.setTrackPermanentResourceUses(m_RecordResourceUses);
+
+        if (m_Device->isAftermathEnabled() || m_Device->isBreadcrumbsEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
-#endif
     }
 
     CommandList::~CommandList()
     {
-#if NVRHI_WITH_AFTERMATH
-        if (m_Device->isAftermathEnabled())
+        if (m_Device->isAftermathEnabled() || m_Device->isBreadcrumbsEnabled())
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
-#endif
     }
 
     nvrhi::Object CommandList::getNativeObject(ObjectType objectType)
@@ -66,9 +67,15 @@ namespace nvrhi::vulkan
             .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 
         (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
-        m_CurrentCmdBuf->referencedResources.push_back(this); // prevent deletion of e.g. UploadManager
+        m_CurrentCmdBuf->referencedResources.add(this); // prevent deletion of e.g. UploadManager
 
         clearState();
+
+        if (m_Device->isBreadcrumbsEnabled())
+        {
+            const uint32_t slot = m_Device->allocateBreadcrumbSlot(m_CommandListParameters.queueType);
+            writeBreadcrumbs(m_Breadcrumbs.begin(slot, m_CommandListID));
+        }
     }
 
     void CommandList::close()
@@ -86,6 +93,9 @@ namespace nvrhi::vulkan
         }
 #endif
 
+        if (m_Device->isBreadcrumbsEnabled())
+            writeBreadcrumbs(m_Breadcrumbs.end(), true);
+
         m_CurrentCmdBuf->cmdBuf.end();
 
         clearState();
@@ -115,6 +125,12 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (byteSize > c_MaxPushConstantSize)
+        {
+            writePushConstantBuffer(data, byteSize);
+            return;
+        }
+
         m_CurrentCmdBuf->cmdBuf.pushConstants(m_CurrentPipelineLayout, m_CurrentPushConstantsVisibility, 0, uint32_t(byteSize), data);
     }
 
@@ -142,6 +158,10 @@ namespace nvrhi::vulkan
             MakeVersion(submissionID, queueID, true));
 
         m_VolatileBufferStates.clear();
+
+        m_Device->getPushConstantBufferPool().submitBlocks(m_PushConstantBlocks, MakeVersion(submissionID, queueID, true));
+        m_PushConstantBlocks.clear();
+        m_PushConstantWritePointer = 0;
     }
     
 }
\ No newline at end of file
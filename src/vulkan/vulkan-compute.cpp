@@ -117,7 +117,7 @@ namespace nvrhi::vulkan
 
         ComputePipeline* pso = checked_cast<ComputePipeline*>(state.pipeline);
 
-        if (m_EnableAutomaticBarriers && arraysAreDifferent(state.bindings, m_CurrentComputeState.bindings))
+        if (isTrackingResources() && arraysAreDifferent(state.bindings, m_CurrentComputeState.bindings))
         {
             for (size_t i = 0; i < state.bindings.size() && i < pso->desc.bindingLayouts.size(); i++)
             {
@@ -126,9 +126,9 @@ namespace nvrhi::vulkan
                 if ((layout->desc.visibility & ShaderType::Compute) == 0)
                     continue;
 
-                if (m_EnableAutomaticBarriers)
+                if (isTrackingResources())
                 {
-                    setResourceStatesForBindingSet(state.bindings[i]);
+                    requireBindingSetStates(state.bindings[i]);
                 }
             }
         }
@@ -137,7 +137,7 @@ namespace nvrhi::vulkan
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, pso->pipeline);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            m_CurrentCmdBuf->referencedResources.add(state.pipeline);
         }
 
         if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
@@ -152,9 +152,9 @@ namespace nvrhi::vulkan
         {
             Buffer* indirectParams = checked_cast<Buffer*>(state.indirectParams);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            m_CurrentCmdBuf->referencedResources.add(state.indirectParams);
 
-            if (m_EnableAutomaticBarriers)
+            if (isTrackingResources())
             {
                 requireBufferState(indirectParams, ResourceStates::IndirectArgument);
             }
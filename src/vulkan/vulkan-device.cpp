@@ -23,6 +23,8 @@
 #include "vulkan-backend.h"
 #include <unordered_map>
 #include <sstream>
+#include <algorithm>
+#include <iterator>
 
 #include <nvrhi/common/misc.h>
 
@@ -49,7 +51,20 @@ namespace nvrhi::vulkan
     Device::Device(const DeviceDesc& desc)
         : m_Context(desc.instance, desc.physicalDevice, desc.device, reinterpret_cast<vk::AllocationCallbacks*>(desc.allocationCallbacks))
         , m_Allocator(m_Context)
+        , m_AllocationTracker(desc.allocator)
+        , m_TaskDispatcher(desc.taskScheduler)
         , m_TimerQueryAllocator(desc.maxTimerQueries, true)
+        , m_CompletionThread(m_Context)
+        , m_RenderPassCache(decltype(m_RenderPassCache)::allocator_type(&m_AllocationTracker, AllocationCategory::Caches))
+        , m_FramebufferCache(desc.maxCachedFramebuffers, &m_AllocationTracker)
+        , m_PipelineLibraries(m_Context, &m_AllocationTracker)
+        , m_SamplerTable(&m_AllocationTracker)
+        , m_ShaderModuleTable(&m_AllocationTracker)
+        , m_ShaderSpecializationTable(&m_AllocationTracker)
+        , m_RetainShaderBytecode(desc.retainShaderBytecode)
+        , m_InputLayoutTable(&m_AllocationTracker)
+        , m_MultiDrawIndirectSupported(desc.multiDrawIndirectSupported)
+        , m_PushConstantBufferPool(this)
     {
         if (desc.graphicsQueue)
         {
@@ -69,6 +84,41 @@ namespace nvrhi::vulkan
                 CommandQueue::Copy, desc.transferQueue, desc.transferQueueIndex);
         }
 
+        if (desc.sparseResidencySupported)
+        {
+            // Tile mappings are bound with vkQueueBindSparse, which needs a queue family with sparse binding
+            const std::vector<vk::QueueFamilyProperties> families = m_Context.physicalDevice.getQueueFamilyProperties();
+
+            for (const auto& queue : m_Queues)
+            {
+                if (!queue || queue->getQueueFamilyIndex() >= families.size())
+                    continue;
+
+                const bool sparseBinding = bool(families[queue->getQueueFamilyIndex()].queueFlags & vk::QueueFlagBits::eSparseBinding);
+                m_QueueSupportsSparseBinding[uint32_t(queue->getQueueID())] = sparseBinding;
+                m_SparseResidencySupported = m_SparseResidencySupported || sparseBinding;
+            }
+        }
+
+        if (desc.enableQueueOwnershipTransfers)
+        {
+            // Transfers are only needed if some of the queues come from different families
+            int firstFamily = -1;
+            for (const auto& queue : m_Queues)
+            {
+                if (!queue)
+                    continue;
+
+                const uint32_t family = queue->getQueueFamilyIndex();
+                m_QueueOwnershipTracker.setQueueFamily(queue->getQueueID(), family);
+
+                if (firstFamily < 0)
+                    firstFamily = int(family);
+                else if (uint32_t(firstFamily) != family)
+                    m_QueueOwnershipTransfers = true;
+            }
+        }
+
         // maps Vulkan extension strings into the corresponding boolean flags in Device
         const std::unordered_map<std::string, bool*> extensionStringMap = {
             { VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, &m_Context.extensions.KHR_synchronization2 },
@@ -77,6 +127,7 @@ namespace nvrhi::vulkan
             { VK_EXT_DEBUG_MARKER_EXTENSION_NAME, &m_Context.extensions.EXT_debug_marker },
             { VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME, &m_Context.extensions.KHR_acceleration_structure },
             { VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME, &m_Context.extensions.buffer_device_address },
+            { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, &m_Context.extensions.KHR_draw_indirect_count },
             { VK_KHR_RAY_QUERY_EXTENSION_NAME,&m_Context.extensions.KHR_ray_query },
             { VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, &m_Context.extensions.KHR_ray_tracing_pipeline },
             { VK_NV_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.NV_mesh_shader },
@@ -84,6 +135,10 @@ namespace nvrhi::vulkan
             { VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME, &m_Context.extensions.KHR_fragment_shading_rate },
             { VK_EXT_OPACITY_MICROMAP_EXTENSION_NAME, &m_Context.extensions.EXT_opacity_micromap },
             { VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME, &m_Context.extensions.NV_ray_tracing_invocation_reorder },
+            { VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, &m_Context.extensions.KHR_dynamic_rendering },
+            { VK_AMD_BUFFER_MARKER_EXTENSION_NAME, &m_Context.extensions.AMD_buffer_marker },
+            { VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME, &m_Context.extensions.EXT_extended_dynamic_state },
+            { VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, &m_Context.extensions.EXT_graphics_pipeline_library },
 #if NVRHI_WITH_AFTERMATH
             { VK_EXT_DEBUG_UTILS_EXTENSION_NAME, &m_Context.extensions.EXT_debug_utils },
             { VK_NV_DEVICE_DIAGNOSTIC_CHECKPOINTS_EXTENSION_NAME, &m_Context.extensions.NV_device_diagnostic_checkpoints },
@@ -114,6 +169,14 @@ namespace nvrhi::vulkan
         if (desc.bufferDeviceAddressSupported)
             m_Context.extensions.buffer_device_address = true;
 
+        // The Vulkan 1.2 way of enabling drawIndirectCount
+        if (desc.drawIndirectCountSupported || m_Context.extensions.KHR_draw_indirect_count)
+            m_Context.extensions.draw_indirect_count = true;
+
+        // The Vulkan 1.3 way of enabling dynamic rendering
+        if (desc.dynamicRenderingSupported)
+            m_Context.extensions.KHR_dynamic_rendering = true;
+
         void* pNext = nullptr;
         vk::PhysicalDeviceAccelerationStructurePropertiesKHR accelStructProperties;
         vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingPipelineProperties;
@@ -172,6 +235,7 @@ namespace nvrhi::vulkan
         m_Context.opacityMicromapProperties = opacityMicromapProperties;
         m_Context.nvRayTracingInvocationReorderProperties = nvRayTracingInvocationReorderProperties;
         m_Context.messageCallback = desc.errorCB;
+        m_Context.taskDispatcher = &m_TaskDispatcher;
 
         if (m_Context.extensions.EXT_opacity_micromap && !m_Context.extensions.KHR_synchronization2)
         {
@@ -179,6 +243,41 @@ namespace nvrhi::vulkan
                 "EXT_opacity_micromap is used without KHR_synchronization2 which is nessesary for OMM Array state transitions. Feature::RayTracingOpacityMicromap will be disabled.");
         }
 
+        if (desc.enableDynamicRendering)
+        {
+            // A Vulkan 1.3 device can support the feature without it having been enabled, so the API version is not enough
+            if (m_Context.extensions.KHR_dynamic_rendering)
+            {
+                m_UseDynamicRendering = true;
+            }
+            else
+            {
+                m_Context.warning("DeviceDesc::enableDynamicRendering is set but neither VK_KHR_dynamic_rendering nor "
+                    "DeviceDesc::dynamicRenderingSupported is, render passes will be used instead.");
+            }
+        }
+
+        if (desc.enableGraphicsPipelineLibraries)
+        {
+            if (m_Context.extensions.EXT_graphics_pipeline_library)
+            {
+                vk::PhysicalDeviceProperties2 libraryProperties2;
+                vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT libraryProperties;
+                libraryProperties2.setPNext(&libraryProperties);
+                m_Context.physicalDevice.getProperties2(&libraryProperties2);
+
+                // Without fast linking, a link can take as long as a monolithic pipeline compile
+                if (libraryProperties.graphicsPipelineLibraryFastLinking)
+                    m_UsePipelineLibraries = true;
+                else
+                    m_Context.warning("DeviceDesc::enableGraphicsPipelineLibraries is set but the device doesn't support fast linking, monolithic pipelines will be used instead.");
+            }
+            else
+            {
+                m_Context.warning("DeviceDesc::enableGraphicsPipelineLibraries is set but VK_EXT_graphics_pipeline_library is not available, monolithic pipelines will be used instead.");
+            }
+        }
+
         if (m_Context.extensions.KHR_fragment_shading_rate)
         {
             vk::PhysicalDeviceFeatures2 deviceFeatures2;
@@ -229,10 +328,38 @@ namespace nvrhi::vulkan
 #if NVRHI_WITH_AFTERMATH
         m_AftermathEnabled = desc.aftermathEnabled;
 #endif
+
+        m_BreadcrumbsEnabled = desc.enableBreadcrumbs;
+        if (m_BreadcrumbsEnabled)
+            createBreadcrumbBuffers();
     }
 
     Device::~Device()
     {
+        m_CompletionThread.shutdown();
+
+        m_SamplerTable.clear();
+        m_InputLayoutTable.clear();
+        m_ShaderSpecializationTable.clear();
+        m_ShaderModuleTable.clear();
+        m_FramebufferCache.clear();
+
+        for (auto& buffer : m_BreadcrumbBuffers)
+        {
+            if (buffer)
+                unmapBuffer(buffer);
+            buffer = nullptr;
+        }
+
+        for (const auto& entry : m_RenderPassCache)
+        {
+            m_Context.device.destroyRenderPass(entry.second, m_Context.allocationCallbacks);
+        }
+        m_RenderPassCache.clear();
+
+        // The tasks use the context and the parts, the parts themselves are destroyed with the cache
+        retirePipelineLinkTasks(true);
+
         if (m_TimerQueryPool)
         {
             m_Context.device.destroyQueryPool(m_TimerQueryPool);
@@ -295,6 +422,108 @@ namespace nvrhi::vulkan
                 m_Queue->retireCommandBuffers();
             }
         }
+
+        retirePipelineLinkTasks(false);
+        releaseRetiredSparseHeaps();
+
+        m_SamplerTable.collectUnused();
+        m_InputLayoutTable.collectUnused();
+        // specializations reference the modules, so release them first
+        m_ShaderSpecializationTable.collectUnused();
+        m_ShaderModuleTable.collectUnused();
+    }
+
+    InterningStatistics Device::getSamplerInterningStatistics()
+    {
+        return m_SamplerTable.getStatistics();
+    }
+
+    InterningStatistics Device::getInputLayoutInterningStatistics()
+    {
+        return m_InputLayoutTable.getStatistics();
+    }
+
+    void Device::createBreadcrumbBuffers()
+    {
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            if (!m_Queues[queueIndex])
+                continue;
+
+            auto bufferDesc = BufferDesc()
+                .setByteSize(c_BreadcrumbSlotsPerQueue * c_BreadcrumbSlotSize)
+                .setCpuAccess(CpuAccessMode::Write) // host-visible memory that can be read back after a device loss
+                .setDebugName("Breadcrumbs");
+
+            BufferHandle buffer = createBuffer(bufferDesc);
+            if (!buffer)
+            {
+                m_Context.warning("Failed to create the breadcrumb buffer, breadcrumbs are disabled");
+                m_BreadcrumbsEnabled = false;
+                return;
+            }
+
+            // The buffer stays mapped so that reading it doesn't need any device calls
+            void* data = mapBuffer(buffer, CpuAccessMode::Read);
+            memset(data, 0, bufferDesc.byteSize);
+
+            m_BreadcrumbBuffers[queueIndex] = buffer;
+            m_BreadcrumbData[queueIndex] = static_cast<const uint32_t*>(data);
+        }
+    }
+
+    vk::Buffer Device::getBreadcrumbBuffer(CommandQueue queue) const
+    {
+        const BufferHandle& buffer = m_BreadcrumbBuffers[uint32_t(queue)];
+        return buffer ? checked_cast<Buffer*>(buffer.Get())->buffer : vk::Buffer();
+    }
+
+    uint32_t Device::allocateBreadcrumbSlot(CommandQueue queue)
+    {
+        return m_BreadcrumbSlotCounters[uint32_t(queue)]++ % c_BreadcrumbSlotsPerQueue;
+    }
+
+    std::string Device::getBreadcrumbReport()
+    {
+        if (!m_BreadcrumbsEnabled)
+            return std::string();
+
+        static const char* queueNames[] = { "Graphics", "Compute", "Copy" };
+        static_assert(std::size(queueNames) == size_t(CommandQueue::Count));
+
+        std::string report;
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            const BufferHandle& buffer = m_BreadcrumbBuffers[queueIndex];
+            if (!buffer)
+                continue;
+
+            // The memory is not necessarily coherent
+            auto range = vk::MappedMemoryRange()
+                .setMemory(checked_cast<Buffer*>(buffer.Get())->memory)
+                .setOffset(0)
+                .setSize(VK_WHOLE_SIZE);
+            (void)m_Context.device.invalidateMappedMemoryRanges(1, &range);
+
+            std::vector<BreadcrumbCommandList> commandLists;
+            decodeBreadcrumbs(m_BreadcrumbData[queueIndex], c_BreadcrumbSlotsPerQueue * c_BreadcrumbSlotWords, commandLists);
+
+            // Only the command lists that didn't finish are interesting after a device loss
+            commandLists.erase(std::remove_if(commandLists.begin(), commandLists.end(),
+                [](const BreadcrumbCommandList& commandList) { return commandList.finished; }), commandLists.end());
+
+            if (commandLists.empty())
+                continue;
+
+            report += std::string(queueNames[queueIndex]) + " queue:\n";
+            report += formatBreadcrumbs(commandLists, [this](uint32_t markerID)
+            {
+                auto [found, name] = m_AftermathCrashDumpHelper.ResolveBreadcrumbMarker(markerID);
+                return found ? name.get() : std::string();
+            });
+        }
+
+        return report;
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -327,6 +556,8 @@ namespace nvrhi::vulkan
             return true;
         case Feature::Meshlets:
             return m_Context.extensions.NV_mesh_shader;
+        case Feature::DrawIndirectCount:
+            return m_Context.extensions.draw_indirect_count;
         case Feature::VariableRateShading:
             if (pInfo)
             {
@@ -350,6 +581,12 @@ namespace nvrhi::vulkan
             return (m_Queues[uint32_t(CommandQueue::Copy)] != nullptr);
         case Feature::ConstantBufferRanges:
             return true;
+        case Feature::TiledResources:
+            return m_SparseResidencySupported;
+        case Feature::ExtendedDynamicState:
+            return m_Context.extensions.EXT_extended_dynamic_state;
+        case Feature::MultiDrawIndirect:
+            return m_MultiDrawIndirectSupported;
         default:
             return false;
         }
@@ -437,7 +674,32 @@ namespace nvrhi::vulkan
     {
         Queue& queue = *m_Queues[uint32_t(executionQueue)];
 
-        uint64_t submissionID = queue.submit(pCommandLists, numCommandLists);
+        // Tile mappings updated since the last submission must be visible to these command lists
+        flushSparseBinds(executionQueue);
+
+        uint64_t submissionID;
+        if (m_QueueOwnershipTransfers)
+        {
+            // The owners must be updated in the same order as the submissions are made
+            std::lock_guard lockGuard(m_QueueOwnershipMutex);
+
+            std::vector<QueueOwnershipTransfer> transfers;
+            for (size_t i = 0; i < numCommandLists; i++)
+            {
+                m_QueueOwnershipTracker.commandListSubmitted(executionQueue,
+                    checked_cast<CommandList*>(pCommandLists[i])->getStateTracker(), transfers);
+            }
+
+            TrackedCommandBufferPtr acquires;
+            if (!transfers.empty())
+                acquires = submitQueueOwnershipReleases(transfers, executionQueue);
+
+            submissionID = queue.submit(pCommandLists, numCommandLists, acquires);
+        }
+        else
+        {
+            submissionID = queue.submit(pCommandLists, numCommandLists);
+        }
 
         for (size_t i = 0; i < numCommandLists; i++)
         {
@@ -57,18 +57,156 @@ namespace nvrhi::vulkan
         return dimension;
     }
 
+    bool RenderPassKey::operator==(const RenderPassKey& other) const
+    {
+        return !arraysAreDifferent(attachments, other.attachments)
+            && numColorAttachments == other.numColorAttachments
+            && hasDepthAttachment == other.hasDepthAttachment
+            && hasShadingRateAttachment == other.hasShadingRateAttachment
+            && shadingRateTexelSize == other.shadingRateTexelSize;
+    }
+
+    bool FramebufferKey::operator==(const FramebufferKey& other) const
+    {
+        return renderPass == other.renderPass
+            && !arraysAreDifferent(attachments, other.attachments)
+            && width == other.width
+            && height == other.height
+            && layers == other.layers;
+    }
+
+    vk::RenderPass Device::getOrCreateRenderPass(const RenderPassKey& key)
+    {
+        std::lock_guard lockGuard(m_RenderPassCacheMutex);
+
+        auto it = m_RenderPassCache.find(key);
+        if (it != m_RenderPassCache.end())
+            return it->second;
+
+        attachment_vector<vk::AttachmentReference2> colorAttachmentRefs(key.numColorAttachments);
+        for (uint32_t i = 0; i < key.numColorAttachments; i++)
+        {
+            colorAttachmentRefs[i] = vk::AttachmentReference2()
+                                        .setAttachment(i)
+                                        .setLayout(vk::ImageLayout::eColorAttachmentOptimal);
+        }
+
+        vk::AttachmentReference2 depthAttachmentRef;
+        if (key.hasDepthAttachment)
+        {
+            const uint32_t depthIndex = key.numColorAttachments;
+            depthAttachmentRef = vk::AttachmentReference2()
+                                    .setAttachment(depthIndex)
+                                    .setLayout(key.attachments[depthIndex].initialLayout);
+        }
+
+        auto subpass = vk::SubpassDescription2()
+            .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+            .setColorAttachmentCount(key.numColorAttachments)
+            .setPColorAttachments(colorAttachmentRefs.data())
+            .setPDepthStencilAttachment(key.hasDepthAttachment ? &depthAttachmentRef : nullptr);
+
+        // add VRS attachment
+        // declare the structures here to avoid using pointers to out-of-scope objects in renderPassInfo further
+        vk::AttachmentReference2 vrsAttachmentRef;
+        vk::FragmentShadingRateAttachmentInfoKHR shadingRateAttachmentInfo;
+
+        if (key.hasShadingRateAttachment)
+        {
+            vrsAttachmentRef = vk::AttachmentReference2()
+                .setAttachment(uint32_t(key.attachments.size()) - 1)
+                .setLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR);
+
+            shadingRateAttachmentInfo = vk::FragmentShadingRateAttachmentInfoKHR()
+                .setPFragmentShadingRateAttachment(&vrsAttachmentRef)
+                .setShadingRateAttachmentTexelSize(key.shadingRateTexelSize);
+
+            subpass.setPNext(&shadingRateAttachmentInfo);
+        }
+
+        auto renderPassInfo = vk::RenderPassCreateInfo2()
+                    .setAttachmentCount(uint32_t(key.attachments.size()))
+                    .setPAttachments(key.attachments.data())
+                    .setSubpassCount(1)
+                    .setPSubpasses(&subpass);
+
+        vk::RenderPass renderPass;
+        const vk::Result res = m_Context.device.createRenderPass2(&renderPassInfo,
+                                                                 m_Context.allocationCallbacks,
+                                                                 &renderPass);
+        CHECK_VK_FAIL(res)
+
+        m_RenderPassCache[key] = renderPass;
+        return renderPass;
+    }
+
+    FramebufferObject::~FramebufferObject()
+    {
+        if (framebuffer)
+        {
+            m_Context.device.destroyFramebuffer(framebuffer, m_Context.allocationCallbacks);
+            framebuffer = nullptr;
+        }
+    }
+
+    std::shared_ptr<FramebufferObject> FramebufferCache::find(const FramebufferKey& key)
+    {
+        if (m_Capacity == 0)
+            return nullptr;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto it = m_EntryMap.find(key);
+        if (it == m_EntryMap.end())
+            return nullptr;
+
+        // mark the entry as most recently used
+        m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+        return it->second->second;
+    }
+
+    std::shared_ptr<FramebufferObject> FramebufferCache::insert(const FramebufferKey& key, const std::shared_ptr<FramebufferObject>& object)
+    {
+        if (m_Capacity == 0)
+            return object;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto it = m_EntryMap.find(key);
+        if (it != m_EntryMap.end())
+        {
+            m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+            return it->second->second;
+        }
+
+        m_Entries.emplace_front(key, object);
+        m_EntryMap[key] = m_Entries.begin();
+
+        while (m_Entries.size() > m_Capacity)
+        {
+            m_EntryMap.erase(m_Entries.back().first);
+            m_Entries.pop_back();
+        }
+
+        return object;
+    }
+
+    void FramebufferCache::clear()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_EntryMap.clear();
+        m_Entries.clear();
+    }
+
     FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
     {
         Framebuffer *fb = new Framebuffer(m_Context);
         fb->desc = desc;
         fb->framebufferInfo = FramebufferInfoEx(desc);
 
-        attachment_vector<vk::AttachmentDescription2> attachmentDescs(desc.colorAttachments.size());
-        attachment_vector<vk::AttachmentReference2> colorAttachmentRefs(desc.colorAttachments.size());
-        vk::AttachmentReference2 depthAttachmentRef;
-
-        static_vector<vk::ImageView, c_MaxRenderTargets + 1> attachmentViews;
-        attachmentViews.resize(desc.colorAttachments.size());
+        RenderPassKey renderPassKey;
+        FramebufferKey framebufferKey;
 
         uint32_t numArraySlices = 0;
 
@@ -82,25 +220,23 @@ namespace nvrhi::vulkan
 
             const vk::Format attachmentFormat = (rt.format == Format::UNKNOWN ? t->imageInfo.format : vk::Format(convertFormat(rt.format)));
 
-            attachmentDescs[i] = vk::AttachmentDescription2()
+            renderPassKey.attachments.push_back(vk::AttachmentDescription2()
                                         .setFormat(attachmentFormat)
                                         .setSamples(t->imageInfo.samples)
                                         .setLoadOp(vk::AttachmentLoadOp::eLoad)
                                         .setStoreOp(vk::AttachmentStoreOp::eStore)
                                         .setInitialLayout(vk::ImageLayout::eColorAttachmentOptimal)
-                                        .setFinalLayout(vk::ImageLayout::eColorAttachmentOptimal);
-
-            colorAttachmentRefs[i] = vk::AttachmentReference2()
-                                        .setAttachment(i)
-                                        .setLayout(vk::ImageLayout::eColorAttachmentOptimal);
+                                        .setFinalLayout(vk::ImageLayout::eColorAttachmentOptimal));
 
             TextureSubresourceSet subresources = rt.subresources.resolve(t->desc, true);
 
             TextureDimension dimension = getDimensionForFramebuffer(t->desc.dimension, subresources.numArraySlices > 1);
 
             const auto& view = t->getSubresourceView(subresources, dimension, rt.format, vk::ImageUsageFlagBits::eColorAttachment);
-            attachmentViews[i] = view.view;
+            framebufferKey.attachments.push_back(view.view);
 
+            fb->colorAttachmentViews.push_back(view.view);
+            fb->colorAttachmentFormats.push_back(attachmentFormat);
             fb->resources.push_back(rt.texture);
 
             if (numArraySlices)
@@ -109,6 +245,8 @@ namespace nvrhi::vulkan
                 numArraySlices = subresources.numArraySlices;
         }
 
+        renderPassKey.numColorAttachments = uint32_t(desc.colorAttachments.size());
+
         // add depth/stencil attachment if present
         if (desc.depthAttachment.valid())
         {
@@ -125,25 +263,26 @@ namespace nvrhi::vulkan
                 depthLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
             }
 
-            attachmentDescs.push_back(vk::AttachmentDescription2()
+            renderPassKey.attachments.push_back(vk::AttachmentDescription2()
                                         .setFormat(texture->imageInfo.format)
                                         .setSamples(texture->imageInfo.samples)
                                         .setLoadOp(vk::AttachmentLoadOp::eLoad)
                                         .setStoreOp(vk::AttachmentStoreOp::eStore)
                                         .setInitialLayout(depthLayout)
                                         .setFinalLayout(depthLayout));
-
-            depthAttachmentRef = vk::AttachmentReference2()
-                                    .setAttachment(uint32_t(attachmentDescs.size()) - 1)
-                                    .setLayout(depthLayout);
+            renderPassKey.hasDepthAttachment = true;
 
             TextureSubresourceSet subresources = att.subresources.resolve(texture->desc, true);
 
             TextureDimension dimension = getDimensionForFramebuffer(texture->desc.dimension, subresources.numArraySlices > 1);
 
             const auto& view = texture->getSubresourceView(subresources, dimension, att.format, vk::ImageUsageFlagBits::eDepthStencilAttachment);
-            attachmentViews.push_back(view.view);
+            framebufferKey.attachments.push_back(view.view);
 
+            fb->depthAttachmentView = view.view;
+            fb->depthAttachmentLayout = depthLayout;
+            fb->depthAttachmentFormat = texture->imageInfo.format;
+            fb->depthAttachmentHasStencil = getFormatInfo(texture->desc.format).hasStencil;
             fb->resources.push_back(att.texture);
 
             if (numArraySlices)
@@ -152,38 +291,29 @@ namespace nvrhi::vulkan
                 numArraySlices = subresources.numArraySlices;
         }
 
-        auto subpass = vk::SubpassDescription2()
-            .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
-            .setColorAttachmentCount(uint32_t(desc.colorAttachments.size()))
-            .setPColorAttachments(colorAttachmentRefs.data())
-            .setPDepthStencilAttachment(desc.depthAttachment.valid() ? &depthAttachmentRef : nullptr);
-
         // add VRS attachment
-        // declare the structures here to avoid using pointers to out-of-scope objects in renderPassInfo further
-        vk::AttachmentReference2 vrsAttachmentRef;
-        vk::FragmentShadingRateAttachmentInfoKHR shadingRateAttachmentInfo;
-
         if (desc.shadingRateAttachment.valid())
         {
             const auto& vrsAttachment = desc.shadingRateAttachment;
             Texture* vrsTexture = checked_cast<Texture*>(vrsAttachment.texture);
             assert(vrsTexture->imageInfo.format == vk::Format::eR8Uint);
             assert(vrsTexture->imageInfo.samples == vk::SampleCountFlagBits::e1);
-            auto vrsAttachmentDesc = vk::AttachmentDescription2()
+
+            renderPassKey.attachments.push_back(vk::AttachmentDescription2()
                 .setFormat(vk::Format::eR8Uint)
                 .setSamples(vk::SampleCountFlagBits::e1)
                 .setLoadOp(vk::AttachmentLoadOp::eLoad)
                 .setStoreOp(vk::AttachmentStoreOp::eStore)
                 .setInitialLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR)
-                .setFinalLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR);
-
-            attachmentDescs.push_back(vrsAttachmentDesc);
+                .setFinalLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR));
+            renderPassKey.hasShadingRateAttachment = true;
+            renderPassKey.shadingRateTexelSize = m_Context.shadingRateProperties.minFragmentShadingRateAttachmentTexelSize;
 
             TextureSubresourceSet subresources = vrsAttachment.subresources.resolve(vrsTexture->desc, true);
             TextureDimension dimension = getDimensionForFramebuffer(vrsTexture->desc.dimension, subresources.numArraySlices > 1);
 
             const auto& view = vrsTexture->getSubresourceView(subresources, dimension, vrsAttachment.format, vk::ImageUsageFlagBits::eFragmentShadingRateAttachmentKHR);
-            attachmentViews.push_back(view.view);
+            framebufferKey.attachments.push_back(view.view);
 
             fb->resources.push_back(vrsAttachment.texture);
 
@@ -191,46 +321,52 @@ namespace nvrhi::vulkan
                 assert(numArraySlices == subresources.numArraySlices);
             else
                 numArraySlices = subresources.numArraySlices;
+        }
 
-            auto rateProps = vk::PhysicalDeviceFragmentShadingRatePropertiesKHR();
-            auto props = vk::PhysicalDeviceProperties2();
-            props.pNext = &rateProps;
-            m_Context.physicalDevice.getProperties2(&props);
+        fb->numArraySlices = numArraySlices;
+        fb->managed = false; // the render pass and framebuffer objects are owned by the caches
 
-            vrsAttachmentRef = vk::AttachmentReference2()
-                .setAttachment(uint32_t(attachmentDescs.size()) - 1)
-                .setLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR);
+        // With dynamic rendering, there are no objects to create: everything is passed to beginRendering directly.
+        // Shading rate attachments would require a different pipeline creation path, so those use render passes.
+        if (m_UseDynamicRendering && !desc.shadingRateAttachment.valid())
+        {
+            fb->dynamicRendering = true;
+            return FramebufferHandle::Create(fb);
+        }
 
-            shadingRateAttachmentInfo = vk::FragmentShadingRateAttachmentInfoKHR()
-                .setPFragmentShadingRateAttachment(&vrsAttachmentRef)
-                .setShadingRateAttachmentTexelSize(rateProps.minFragmentShadingRateAttachmentTexelSize);
+        fb->renderPass = getOrCreateRenderPass(renderPassKey);
+        if (!fb->renderPass)
+            return nullptr;
 
-            subpass.setPNext(&shadingRateAttachmentInfo);
-        }
+        framebufferKey.renderPass = fb->renderPass;
+        framebufferKey.width = fb->framebufferInfo.width;
+        framebufferKey.height = fb->framebufferInfo.height;
+        framebufferKey.layers = numArraySlices;
 
-        auto renderPassInfo = vk::RenderPassCreateInfo2()
-                    .setAttachmentCount(uint32_t(attachmentDescs.size()))
-                    .setPAttachments(attachmentDescs.data())
-                    .setSubpassCount(1)
-                    .setPSubpasses(&subpass);
+        fb->framebufferObject = m_FramebufferCache.find(framebufferKey);
 
-        vk::Result res = m_Context.device.createRenderPass2(&renderPassInfo,
-                                                           m_Context.allocationCallbacks,
-                                                           &fb->renderPass);
-        CHECK_VK_FAIL(res)
-        
-        // set up the framebuffer object
-        auto framebufferInfo = vk::FramebufferCreateInfo()
-                                .setRenderPass(fb->renderPass)
-                                .setAttachmentCount(uint32_t(attachmentViews.size()))
-                                .setPAttachments(attachmentViews.data())
-                                .setWidth(fb->framebufferInfo.width)
-                                .setHeight(fb->framebufferInfo.height)
-                                .setLayers(numArraySlices);
-
-        res = m_Context.device.createFramebuffer(&framebufferInfo, m_Context.allocationCallbacks,
-                                               &fb->framebuffer);
-        CHECK_VK_FAIL(res)
+        if (!fb->framebufferObject)
+        {
+            auto framebufferObject = make_tracked_shared<FramebufferObject>(&m_AllocationTracker, AllocationCategory::Caches, m_Context);
+            framebufferObject->resources = fb->resources;
+
+            // set up the framebuffer object
+            auto framebufferInfo = vk::FramebufferCreateInfo()
+                                    .setRenderPass(fb->renderPass)
+                                    .setAttachmentCount(uint32_t(framebufferKey.attachments.size()))
+                                    .setPAttachments(framebufferKey.attachments.data())
+                                    .setWidth(framebufferKey.width)
+                                    .setHeight(framebufferKey.height)
+                                    .setLayers(framebufferKey.layers);
+
+            const vk::Result res = m_Context.device.createFramebuffer(&framebufferInfo, m_Context.allocationCallbacks,
+                                                                     &framebufferObject->framebuffer);
+            CHECK_VK_FAIL(res)
+
+            fb->framebufferObject = m_FramebufferCache.insert(framebufferKey, framebufferObject);
+        }
+
+        fb->framebuffer = fb->framebufferObject->framebuffer;
         
         return FramebufferHandle::Create(fb);
     }
@@ -259,6 +395,15 @@ namespace nvrhi::vulkan
         return FramebufferHandle::Create(fb);
     }
 
+    vk::PipelineRenderingCreateInfo makePipelineRenderingCreateInfo(const Framebuffer* fb)
+    {
+        return vk::PipelineRenderingCreateInfo()
+            .setColorAttachmentCount(uint32_t(fb->colorAttachmentFormats.size()))
+            .setPColorAttachmentFormats(fb->colorAttachmentFormats.data())
+            .setDepthAttachmentFormat(fb->depthAttachmentFormat)
+            .setStencilAttachmentFormat(fb->depthAttachmentHasStencil ? fb->depthAttachmentFormat : vk::Format::eUndefined);
+    }
+
     Framebuffer::~Framebuffer()
     {
         if (framebuffer && managed)
@@ -521,7 +666,7 @@ namespace nvrhi::vulkan
 
         pso->usesBlendConstants = blendState.usesConstantColor(uint32_t(fb->desc.colorAttachments.size()));
 
-        static_vector<vk::DynamicState, 5> dynamicStates = {
+        static_vector<vk::DynamicState, 12> dynamicStates = {
             vk::DynamicState::eViewport,
             vk::DynamicState::eScissor
         };
@@ -532,6 +677,24 @@ namespace nvrhi::vulkan
         if (pso->desc.shadingRateState.enabled)
             dynamicStates.push_back(vk::DynamicState::eFragmentShadingRateKHR);
 
+        // Extended dynamic state: the values baked into 'rasterizer' and 'depthStencil' for these groups are ignored
+        const DynamicRenderStateFlags dynamicRenderState = pso->desc.dynamicRenderState;
+        if ((dynamicRenderState & DynamicRenderStateFlags::CullMode) != 0)
+            dynamicStates.push_back(vk::DynamicState::eCullModeEXT);
+        if ((dynamicRenderState & DynamicRenderStateFlags::FrontFace) != 0)
+            dynamicStates.push_back(vk::DynamicState::eFrontFaceEXT);
+        if ((dynamicRenderState & DynamicRenderStateFlags::DepthTest) != 0)
+            dynamicStates.push_back(vk::DynamicState::eDepthTestEnableEXT);
+        if ((dynamicRenderState & DynamicRenderStateFlags::DepthWrite) != 0)
+            dynamicStates.push_back(vk::DynamicState::eDepthWriteEnableEXT);
+        if ((dynamicRenderState & DynamicRenderStateFlags::DepthCompare) != 0)
+            dynamicStates.push_back(vk::DynamicState::eDepthCompareOpEXT);
+        if ((dynamicRenderState & DynamicRenderStateFlags::Stencil) != 0)
+        {
+            dynamicStates.push_back(vk::DynamicState::eStencilTestEnableEXT);
+            dynamicStates.push_back(vk::DynamicState::eStencilOpEXT);
+        }
+
         auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo()
             .setDynamicStateCount(uint32_t(dynamicStates.size()))
             .setPDynamicStates(dynamicStates.data());
@@ -557,6 +720,14 @@ namespace nvrhi::vulkan
         if (pso->desc.shadingRateState.enabled)
             pipelineInfo.setPNext(&shadingRateState);
 
+        auto renderingInfo = vk::PipelineRenderingCreateInfo();
+        if (fb->dynamicRendering)
+        {
+            renderingInfo = makePipelineRenderingCreateInfo(fb);
+            renderingInfo.setPNext(pipelineInfo.pNext);
+            pipelineInfo.setPNext(&renderingInfo);
+        }
+
         auto tessellationState = vk::PipelineTessellationStateCreateInfo();
 
         if (desc.primType == PrimitiveType::PatchList)
@@ -565,10 +736,17 @@ namespace nvrhi::vulkan
             pipelineInfo.setPTessellationState(&tessellationState);
         }
 
-        res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
-                                                     1, &pipelineInfo,
-                                                     m_Context.allocationCallbacks,
-                                                     &pso->pipeline);
+        if (m_UsePipelineLibraries)
+        {
+            res = createGraphicsPipelineFromLibraries(pso, pipelineInfo, fb);
+        }
+        else
+        {
+            res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                                                         1, &pipelineInfo,
+                                                         m_Context.allocationCallbacks,
+                                                         &pso->pipeline);
+        }
         ASSERT_VK_OK(res); // for debugging
         CHECK_VK_FAIL(res);
         
@@ -577,6 +755,16 @@ namespace nvrhi::vulkan
 
     GraphicsPipeline::~GraphicsPipeline()
     {
+        // Doesn't wait for the optimizing link: if it's still running, the task destroys its result instead
+        if (linkState)
+        {
+            linkState->pipelineReleased(m_Context);
+            linkState.reset();
+
+            // Owned by the link state
+            pipelineLayout = nullptr;
+        }
+
         if (pipeline)
         {
             m_Context.device.destroyPipeline(pipeline, m_Context.allocationCallbacks);
@@ -597,17 +785,83 @@ namespace nvrhi::vulkan
         case ObjectTypes::VK_PipelineLayout:
             return Object(pipelineLayout);
         case ObjectTypes::VK_Pipeline:
-            return Object(pipeline);
+            return Object(VkPipeline(getPipelineForBinding()));
         default:
             return nullptr;
         }
     }
 
+    vk::Pipeline GraphicsPipeline::getPipelineForBinding() const
+    {
+        if (linkState)
+        {
+            if (const VkPipeline optimized = linkState->optimizedPipeline.load(std::memory_order_acquire))
+                return optimized;
+        }
+
+        return pipeline;
+    }
+
+    void CommandList::beginRenderPass(Framebuffer* fb)
+    {
+        const auto renderArea = vk::Rect2D()
+            .setOffset(vk::Offset2D(0, 0))
+            .setExtent(vk::Extent2D(fb->framebufferInfo.width, fb->framebufferInfo.height));
+
+        if (fb->dynamicRendering)
+        {
+            static_vector<vk::RenderingAttachmentInfo, c_MaxRenderTargets> colorAttachments;
+            for (const vk::ImageView& view : fb->colorAttachmentViews)
+            {
+                colorAttachments.push_back(vk::RenderingAttachmentInfo()
+                    .setImageView(view)
+                    .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
+                    .setLoadOp(vk::AttachmentLoadOp::eLoad)
+                    .setStoreOp(vk::AttachmentStoreOp::eStore));
+            }
+
+            const auto depthAttachment = vk::RenderingAttachmentInfo()
+                .setImageView(fb->depthAttachmentView)
+                .setImageLayout(fb->depthAttachmentLayout)
+                .setLoadOp(vk::AttachmentLoadOp::eLoad)
+                .setStoreOp(vk::AttachmentStoreOp::eStore);
+
+            const bool hasDepth = bool(fb->depthAttachmentView);
+
+            m_CurrentCmdBuf->cmdBuf.beginRendering(vk::RenderingInfo()
+                .setRenderArea(renderArea)
+                .setLayerCount(fb->numArraySlices)
+                .setColorAttachmentCount(uint32_t(colorAttachments.size()))
+                .setPColorAttachments(colorAttachments.data())
+                .setPDepthAttachment(hasDepth ? &depthAttachment : nullptr)
+                .setPStencilAttachment(hasDepth && fb->depthAttachmentHasStencil ? &depthAttachment : nullptr));
+        }
+        else
+        {
+            m_CurrentCmdBuf->cmdBuf.beginRenderPass(vk::RenderPassBeginInfo()
+                .setRenderPass(fb->renderPass)
+                .setFramebuffer(fb->framebuffer)
+                .setRenderArea(renderArea)
+                .setClearValueCount(0),
+                vk::SubpassContents::eInline);
+        }
+
+        m_CurrentCmdBuf->referencedResources.add(fb);
+    }
+
     void CommandList::endRenderPass()
     {
-        if (m_CurrentGraphicsState.framebuffer || m_CurrentMeshletState.framebuffer)
+        IFramebuffer* currentFramebuffer = m_CurrentGraphicsState.framebuffer
+            ? m_CurrentGraphicsState.framebuffer
+            : m_CurrentMeshletState.framebuffer;
+
+        if (currentFramebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.endRenderPass();
+            if (checked_cast<Framebuffer*>(currentFramebuffer)->dynamicRendering)
+                m_CurrentCmdBuf->cmdBuf.endRendering();
+            else
+                m_CurrentCmdBuf->cmdBuf.endRenderPass();
+
             m_CurrentGraphicsState.framebuffer = nullptr;
             m_CurrentMeshletState.framebuffer = nullptr;
         }
@@ -626,7 +880,7 @@ namespace nvrhi::vulkan
         GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
         Framebuffer* fb = checked_cast<Framebuffer*>(state.framebuffer);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             trackResourcesAndBarriers(state);
         }
@@ -634,11 +888,14 @@ namespace nvrhi::vulkan
         bool anyBarriers = this->anyBarriers();
         bool updatePipeline = false;
 
-        if (m_CurrentGraphicsState.pipeline != state.pipeline)
+        const vk::Pipeline pipelineObject = pso->getPipelineForBinding();
+
+        if (m_CurrentGraphicsState.pipeline != state.pipeline || m_CurrentGraphicsPipelineObject != pipelineObject)
         {
-            m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineObject);
+            m_CurrentGraphicsPipelineObject = pipelineObject;
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            m_CurrentCmdBuf->referencedResources.add(state.pipeline);
             updatePipeline = true;
         }
 
@@ -657,16 +914,7 @@ namespace nvrhi::vulkan
 
         if(!m_CurrentGraphicsState.framebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.beginRenderPass(vk::RenderPassBeginInfo()
-                .setRenderPass(fb->renderPass)
-                .setFramebuffer(fb->framebuffer)
-                .setRenderArea(vk::Rect2D()
-                    .setOffset(vk::Offset2D(0, 0))
-                    .setExtent(vk::Extent2D(fb->framebufferInfo.width, fb->framebufferInfo.height)))
-                .setClearValueCount(0),
-                vk::SubpassContents::eInline);
-
-            m_CurrentCmdBuf->referencedResources.push_back(state.framebuffer);
+            beginRenderPass(fb);
         }
 
         m_CurrentPipelineLayout = pso->pipelineLayout;
@@ -710,6 +958,13 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->cmdBuf.setBlendConstants(&state.blendConstantColor.r);
         }
 
+        if (pso->desc.dynamicRenderState != DynamicRenderStateFlags::None)
+        {
+            // Binding a pipeline invalidates the dynamic state that it declares, so set every group after a pipeline change
+            setDynamicRenderState(pso->desc.dynamicRenderState, state.dynamicRenderState,
+                updatePipeline ? nullptr : &m_CurrentGraphicsState.dynamicRenderState);
+        }
+
         if (state.indexBuffer.buffer && m_CurrentGraphicsState.indexBuffer != state.indexBuffer)
         {
             m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->buffer,
@@ -717,7 +972,7 @@ namespace nvrhi::vulkan
                 state.indexBuffer.format == Format::R16_UINT ?
                 vk::IndexType::eUint16 : vk::IndexType::eUint32);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.indexBuffer.buffer);
+            m_CurrentCmdBuf->referencedResources.add(state.indexBuffer.buffer);
         }
 
         if (!state.vertexBuffers.empty() && arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
@@ -736,7 +991,7 @@ namespace nvrhi::vulkan
                 vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
                 maxVbIndex = std::max(maxVbIndex, binding.slot);
 
-                m_CurrentCmdBuf->referencedResources.push_back(binding.buffer);
+                m_CurrentCmdBuf->referencedResources.add(binding.buffer);
             }
 
             m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
@@ -744,7 +999,12 @@ namespace nvrhi::vulkan
 
         if (state.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            m_CurrentCmdBuf->referencedResources.add(state.indirectParams);
+        }
+
+        if (state.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.add(state.indirectCountBuffer);
         }
 
         if (state.shadingRateState.enabled)
@@ -761,6 +1021,59 @@ namespace nvrhi::vulkan
         m_AnyVolatileBufferWrites = false;
     }
 
+    void CommandList::setDynamicRenderState(DynamicRenderStateFlags groups, const DynamicRenderState& state, const DynamicRenderState* prev)
+    {
+        // 'prev' is null when all groups must be set; otherwise only the values that changed are set
+        vk::CommandBuffer cmdBuf = m_CurrentCmdBuf->cmdBuf;
+
+        if ((groups & DynamicRenderStateFlags::CullMode) != 0 && (!prev || prev->cullMode != state.cullMode))
+        {
+            cmdBuf.setCullModeEXT(convertCullMode(state.cullMode));
+        }
+
+        if ((groups & DynamicRenderStateFlags::FrontFace) != 0 && (!prev || prev->frontCounterClockwise != state.frontCounterClockwise))
+        {
+            cmdBuf.setFrontFaceEXT(state.frontCounterClockwise ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise);
+        }
+
+        if ((groups & DynamicRenderStateFlags::DepthTest) != 0 && (!prev || prev->depthTestEnable != state.depthTestEnable))
+        {
+            cmdBuf.setDepthTestEnableEXT(state.depthTestEnable);
+        }
+
+        if ((groups & DynamicRenderStateFlags::DepthWrite) != 0 && (!prev || prev->depthWriteEnable != state.depthWriteEnable))
+        {
+            cmdBuf.setDepthWriteEnableEXT(state.depthWriteEnable);
+        }
+
+        if ((groups & DynamicRenderStateFlags::DepthCompare) != 0 && (!prev || prev->depthFunc != state.depthFunc))
+        {
+            cmdBuf.setDepthCompareOpEXT(convertCompareOp(state.depthFunc));
+        }
+
+        if ((groups & DynamicRenderStateFlags::Stencil) != 0)
+        {
+            if (!prev || prev->stencilEnable != state.stencilEnable)
+            {
+                cmdBuf.setStencilTestEnableEXT(state.stencilEnable);
+            }
+
+            if (!prev || prev->frontFaceStencil != state.frontFaceStencil)
+            {
+                const DepthStencilState::StencilOpDesc& ops = state.frontFaceStencil;
+                cmdBuf.setStencilOpEXT(vk::StencilFaceFlagBits::eFront, convertStencilOp(ops.failOp),
+                    convertStencilOp(ops.passOp), convertStencilOp(ops.depthFailOp), convertCompareOp(ops.stencilFunc));
+            }
+
+            if (!prev || prev->backFaceStencil != state.backFaceStencil)
+            {
+                const DepthStencilState::StencilOpDesc& ops = state.backFaceStencil;
+                cmdBuf.setStencilOpEXT(vk::StencilFaceFlagBits::eBack, convertStencilOp(ops.failOp),
+                    convertStencilOp(ops.passOp), convertStencilOp(ops.depthFailOp), convertCompareOp(ops.stencilFunc));
+            }
+        }
+    }
+
     void CommandList::updateGraphicsVolatileBuffers()
     {
         if (m_AnyVolatileBufferWrites && m_CurrentGraphicsState.pipeline)
@@ -822,4 +1135,92 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.drawIndexedIndirect(indirectParams->buffer, offsetBytes, drawCount, sizeof(DrawIndexedIndirectArguments));
     }
 
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_Context.extensions.draw_indirect_count)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        updateGraphicsVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && countBuffer);
+
+        if (!m_Context.extensions.KHR_draw_indirect_count)
+        {
+            m_CurrentCmdBuf->cmdBuf.drawIndirectCount(indirectParams->buffer, paramOffsetBytes,
+                countBuffer->buffer, countOffsetBytes, maxDrawCount, sizeof(DrawIndirectArguments));
+        }
+        else
+        {
+            m_CurrentCmdBuf->cmdBuf.drawIndirectCountKHR(indirectParams->buffer, paramOffsetBytes,
+                countBuffer->buffer, countOffsetBytes, maxDrawCount, sizeof(DrawIndirectArguments));
+        }
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_Context.extensions.draw_indirect_count)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        updateGraphicsVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && countBuffer);
+
+        if (!m_Context.extensions.KHR_draw_indirect_count)
+        {
+            m_CurrentCmdBuf->cmdBuf.drawIndexedIndirectCount(indirectParams->buffer, paramOffsetBytes,
+                countBuffer->buffer, countOffsetBytes, maxDrawCount, sizeof(DrawIndexedIndirectArguments));
+        }
+        else
+        {
+            m_CurrentCmdBuf->cmdBuf.drawIndexedIndirectCountKHR(indirectParams->buffer, paramOffsetBytes,
+                countBuffer->buffer, countOffsetBytes, maxDrawCount, sizeof(DrawIndexedIndirectArguments));
+        }
+    }
+
 } // namespace nvrhi::vulkan
+
+namespace std
+{
+    size_t hash<nvrhi::vulkan::RenderPassKey>::operator()(nvrhi::vulkan::RenderPassKey const& s) const noexcept
+    {
+        size_t hash = 0;
+        for (const auto& attachment : s.attachments)
+        {
+            nvrhi::hash_combine(hash, attachment.format);
+            nvrhi::hash_combine(hash, attachment.samples);
+            nvrhi::hash_combine(hash, attachment.loadOp);
+            nvrhi::hash_combine(hash, attachment.storeOp);
+            nvrhi::hash_combine(hash, attachment.initialLayout);
+        }
+        nvrhi::hash_combine(hash, s.numColorAttachments);
+        nvrhi::hash_combine(hash, s.hasDepthAttachment);
+        nvrhi::hash_combine(hash, s.hasShadingRateAttachment);
+        return hash;
+    }
+
+    size_t hash<nvrhi::vulkan::FramebufferKey>::operator()(nvrhi::vulkan::FramebufferKey const& s) const noexcept
+    {
+        size_t hash = 0;
+        nvrhi::hash_combine(hash, VkRenderPass(s.renderPass));
+        for (const auto& view : s.attachments)
+            nvrhi::hash_combine(hash, VkImageView(view));
+        nvrhi::hash_combine(hash, s.width);
+        nvrhi::hash_combine(hash, s.height);
+        nvrhi::hash_combine(hash, s.layers);
+        return hash;
+    }
+}
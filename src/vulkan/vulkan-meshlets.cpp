@@ -179,6 +179,13 @@ namespace nvrhi::vulkan
             .setBasePipelineHandle(nullptr)
             .setBasePipelineIndex(-1);
 
+        auto renderingInfo = vk::PipelineRenderingCreateInfo();
+        if (fb->dynamicRendering)
+        {
+            renderingInfo = makePipelineRenderingCreateInfo(fb);
+            pipelineInfo.setPNext(&renderingInfo);
+        }
+
         res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
                                                      1, &pipelineInfo,
                                                      m_Context.allocationCallbacks,
@@ -230,7 +237,7 @@ namespace nvrhi::vulkan
         MeshletPipeline* pso = checked_cast<MeshletPipeline*>(state.pipeline);
         Framebuffer* fb = checked_cast<Framebuffer*>(state.framebuffer);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             trackResourcesAndBarriers(state);
         }
@@ -242,7 +249,7 @@ namespace nvrhi::vulkan
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            m_CurrentCmdBuf->referencedResources.add(state.pipeline);
             updatePipeline = true;
         }
 
@@ -255,16 +262,7 @@ namespace nvrhi::vulkan
 
         if(!m_CurrentMeshletState.framebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.beginRenderPass(vk::RenderPassBeginInfo()
-                .setRenderPass(fb->renderPass)
-                .setFramebuffer(fb->framebuffer)
-                .setRenderArea(vk::Rect2D()
-                    .setOffset(vk::Offset2D(0, 0))
-                    .setExtent(vk::Extent2D(fb->framebufferInfo.width, fb->framebufferInfo.height)))
-                .setClearValueCount(0),
-                vk::SubpassContents::eInline);
-
-            m_CurrentCmdBuf->referencedResources.push_back(state.framebuffer);
+            beginRenderPass(fb);
         }
 
         m_CurrentPipelineLayout = pso->pipelineLayout;
@@ -310,7 +308,12 @@ namespace nvrhi::vulkan
 
         if (state.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            m_CurrentCmdBuf->referencedResources.add(state.indirectParams);
+        }
+
+        if (state.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.add(state.indirectCountBuffer);
         }
 
         m_CurrentComputeState = ComputeState();
@@ -348,4 +351,24 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.drawMeshTasksNV(groupsX, 0);
     }
 
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_Context.extensions.NV_mesh_shader || !m_Context.extensions.draw_indirect_count)
+        {
+            utils::NotSupported();
+            return;
+        }
+
+        updateMeshletVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(indirectParams && countBuffer);
+
+        m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountNV(indirectParams->buffer, paramOffsetBytes,
+            countBuffer->buffer, countOffsetBytes, maxDispatchCount, sizeof(VkDrawMeshTasksIndirectCommandNV));
+    }
+
 } // namespace nvrhi::vulkan
@@ -0,0 +1,607 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cstring>
+
+namespace nvrhi::vulkan
+{
+    namespace
+    {
+        // Flattens the parts of a graphics pipeline create info that affect a library into a key.
+        // Only the state pointers that are set in the part's create info are written.
+        class PipelineLibraryKeyWriter
+        {
+        public:
+            PipelineLibraryKey key;
+
+            void add(uint64_t value) { key.data.push_back(value); }
+            void addFloat(float value) { uint32_t bits; memcpy(&bits, &value, sizeof(bits)); add(bits); }
+            template<typename T> void addHandle(T handle) { add(reinterpret_cast<uint64_t>(typename T::CType(handle))); }
+
+            void addString(const char* str)
+            {
+                size_t length = str ? strlen(str) : 0;
+                add(length);
+                for (size_t i = 0; i < length; i++)
+                    add(uint8_t(str[i]));
+            }
+
+            void addStencilOp(const vk::StencilOpState& op)
+            {
+                add(uint64_t(op.failOp));
+                add(uint64_t(op.passOp));
+                add(uint64_t(op.depthFailOp));
+                add(uint64_t(op.compareOp));
+                add(op.compareMask);
+                add(op.writeMask);
+                add(op.reference);
+            }
+
+            void addShaderStage(const vk::PipelineShaderStageCreateInfo& stage)
+            {
+                add(uint64_t(VkShaderStageFlags(stage.stage)));
+                addHandle(stage.module);
+                addString(stage.pName);
+
+                const vk::SpecializationInfo* spec = stage.pSpecializationInfo;
+                add(spec ? spec->mapEntryCount : 0);
+                if (!spec)
+                    return;
+
+                for (uint32_t i = 0; i < spec->mapEntryCount; i++)
+                {
+                    add(spec->pMapEntries[i].constantID);
+                    add(spec->pMapEntries[i].offset);
+                    add(spec->pMapEntries[i].size);
+                }
+
+                add(spec->dataSize);
+                for (size_t i = 0; i < spec->dataSize; i++)
+                    add(static_cast<const uint8_t*>(spec->pData)[i]);
+            }
+
+            void addCreateInfo(const vk::GraphicsPipelineCreateInfo& info)
+            {
+                add(uint64_t(VkPipelineCreateFlags(info.flags)));
+
+                add(info.stageCount);
+                for (uint32_t i = 0; i < info.stageCount; i++)
+                    addShaderStage(info.pStages[i]);
+
+                if (const vk::PipelineVertexInputStateCreateInfo* vertexInput = info.pVertexInputState)
+                {
+                    add(vertexInput->vertexBindingDescriptionCount);
+                    for (uint32_t i = 0; i < vertexInput->vertexBindingDescriptionCount; i++)
+                    {
+                        const vk::VertexInputBindingDescription& binding = vertexInput->pVertexBindingDescriptions[i];
+                        add(binding.binding);
+                        add(binding.stride);
+                        add(uint64_t(binding.inputRate));
+                    }
+
+                    add(vertexInput->vertexAttributeDescriptionCount);
+                    for (uint32_t i = 0; i < vertexInput->vertexAttributeDescriptionCount; i++)
+                    {
+                        const vk::VertexInputAttributeDescription& attribute = vertexInput->pVertexAttributeDescriptions[i];
+                        add(attribute.location);
+                        add(attribute.binding);
+                        add(uint64_t(attribute.format));
+                        add(attribute.offset);
+                    }
+                }
+
+                if (const vk::PipelineInputAssemblyStateCreateInfo* inputAssembly = info.pInputAssemblyState)
+                {
+                    add(uint64_t(inputAssembly->topology));
+                    add(inputAssembly->primitiveRestartEnable);
+                }
+
+                if (const vk::PipelineTessellationStateCreateInfo* tessellation = info.pTessellationState)
+                {
+                    add(tessellation->patchControlPoints);
+                }
+
+                if (const vk::PipelineViewportStateCreateInfo* viewport = info.pViewportState)
+                {
+                    add(viewport->viewportCount);
+                    add(viewport->scissorCount);
+                }
+
+                if (const vk::PipelineRasterizationStateCreateInfo* rasterizer = info.pRasterizationState)
+                {
+                    add(rasterizer->depthClampEnable);
+                    add(rasterizer->rasterizerDiscardEnable);
+                    add(uint64_t(rasterizer->polygonMode));
+                    add(uint64_t(VkCullModeFlags(rasterizer->cullMode)));
+                    add(uint64_t(rasterizer->frontFace));
+                    add(rasterizer->depthBiasEnable);
+                    addFloat(rasterizer->depthBiasConstantFactor);
+                    addFloat(rasterizer->depthBiasClamp);
+                    addFloat(rasterizer->depthBiasSlopeFactor);
+                    addFloat(rasterizer->lineWidth);
+
+                    for (auto next = static_cast<const vk::BaseInStructure*>(rasterizer->pNext); next; next = next->pNext)
+                    {
+                        add(uint64_t(next->sType));
+
+                        if (next->sType == vk::StructureType::ePipelineRasterizationConservativeStateCreateInfoEXT)
+                        {
+                            const auto* conservative = reinterpret_cast<const vk::PipelineRasterizationConservativeStateCreateInfoEXT*>(next);
+                            add(uint64_t(conservative->conservativeRasterizationMode));
+                            addFloat(conservative->extraPrimitiveOverestimationSize);
+                        }
+                    }
+                }
+
+                if (const vk::PipelineMultisampleStateCreateInfo* multisample = info.pMultisampleState)
+                {
+                    add(uint64_t(multisample->rasterizationSamples));
+                    add(multisample->sampleShadingEnable);
+                    addFloat(multisample->minSampleShading);
+                    add(multisample->alphaToCoverageEnable);
+                    add(multisample->alphaToOneEnable);
+                }
+
+                if (const vk::PipelineDepthStencilStateCreateInfo* depthStencil = info.pDepthStencilState)
+                {
+                    add(depthStencil->depthTestEnable);
+                    add(depthStencil->depthWriteEnable);
+                    add(uint64_t(depthStencil->depthCompareOp));
+                    add(depthStencil->depthBoundsTestEnable);
+                    add(depthStencil->stencilTestEnable);
+                    addStencilOp(depthStencil->front);
+                    addStencilOp(depthStencil->back);
+                    addFloat(depthStencil->minDepthBounds);
+                    addFloat(depthStencil->maxDepthBounds);
+                }
+
+                if (const vk::PipelineColorBlendStateCreateInfo* colorBlend = info.pColorBlendState)
+                {
+                    add(colorBlend->logicOpEnable);
+                    add(uint64_t(colorBlend->logicOp));
+                    add(colorBlend->attachmentCount);
+                    for (uint32_t i = 0; i < colorBlend->attachmentCount; i++)
+                    {
+                        const vk::PipelineColorBlendAttachmentState& attachment = colorBlend->pAttachments[i];
+                        add(attachment.blendEnable);
+                        add(uint64_t(attachment.srcColorBlendFactor));
+                        add(uint64_t(attachment.dstColorBlendFactor));
+                        add(uint64_t(attachment.colorBlendOp));
+                        add(uint64_t(attachment.srcAlphaBlendFactor));
+                        add(uint64_t(attachment.dstAlphaBlendFactor));
+                        add(uint64_t(attachment.alphaBlendOp));
+                        add(uint64_t(VkColorComponentFlags(attachment.colorWriteMask)));
+                    }
+                    for (float constant : colorBlend->blendConstants)
+                        addFloat(constant);
+                }
+
+                if (const vk::PipelineDynamicStateCreateInfo* dynamicState = info.pDynamicState)
+                {
+                    add(dynamicState->dynamicStateCount);
+                    for (uint32_t i = 0; i < dynamicState->dynamicStateCount; i++)
+                        add(uint64_t(dynamicState->pDynamicStates[i]));
+                }
+
+                addHandle(info.renderPass);
+                add(info.subpass);
+
+                for (auto next = static_cast<const vk::BaseInStructure*>(info.pNext); next; next = next->pNext)
+                {
+                    add(uint64_t(next->sType));
+
+                    if (next->sType == vk::StructureType::eGraphicsPipelineLibraryCreateInfoEXT)
+                    {
+                        const auto* library = reinterpret_cast<const vk::GraphicsPipelineLibraryCreateInfoEXT*>(next);
+                        add(uint64_t(VkGraphicsPipelineLibraryFlagsEXT(library->flags)));
+                    }
+                    else if (next->sType == vk::StructureType::ePipelineRenderingCreateInfo)
+                    {
+                        const auto* rendering = reinterpret_cast<const vk::PipelineRenderingCreateInfo*>(next);
+                        add(rendering->viewMask);
+                        add(rendering->colorAttachmentCount);
+                        for (uint32_t i = 0; i < rendering->colorAttachmentCount; i++)
+                            add(uint64_t(rendering->pColorAttachmentFormats[i]));
+                        add(uint64_t(rendering->depthAttachmentFormat));
+                        add(uint64_t(rendering->stencilAttachmentFormat));
+                    }
+                    else if (next->sType == vk::StructureType::ePipelineFragmentShadingRateStateCreateInfoKHR)
+                    {
+                        const auto* shadingRate = reinterpret_cast<const vk::PipelineFragmentShadingRateStateCreateInfoKHR*>(next);
+                        add(shadingRate->fragmentSize.width);
+                        add(shadingRate->fragmentSize.height);
+                        add(uint64_t(shadingRate->combinerOps[0]));
+                        add(uint64_t(shadingRate->combinerOps[1]));
+                    }
+                }
+            }
+
+            // The pipeline layout handle is specific to the pipeline being created, but parts can be linked
+            // with any identically defined layout, so the layout is described by its contents instead.
+            void addPipelineLayout(const BindingVector<RefCountPtr<BindingLayout>>& bindingLayouts, vk::ShaderStageFlags pushConstantVisibility)
+            {
+                add(bindingLayouts.size());
+                for (const BindingLayout* layout : bindingLayouts)
+                {
+                    if (!layout)
+                    {
+                        // Empty descriptor set
+                        add(0);
+                        continue;
+                    }
+
+                    add(layout->isBindless ? 2 : 1);
+                    add(layout->vulkanLayoutBindings.size());
+                    for (const vk::DescriptorSetLayoutBinding& binding : layout->vulkanLayoutBindings)
+                    {
+                        add(binding.binding);
+                        add(uint64_t(binding.descriptorType));
+                        add(binding.descriptorCount);
+                        add(uint64_t(VkShaderStageFlags(binding.stageFlags)));
+                    }
+
+                    if (!layout->isBindless)
+                    {
+                        for (const BindingLayoutItem& item : layout->desc.bindings)
+                        {
+                            if (item.type == ResourceType::PushConstants && item.size <= c_MaxPushConstantSize)
+                                add(item.size);
+                        }
+                    }
+                }
+
+                add(uint64_t(VkShaderStageFlags(pushConstantVisibility)));
+            }
+        };
+    }
+
+    PipelineLibraryCache::~PipelineLibraryCache()
+    {
+        for (const auto& entry : m_Libraries)
+        {
+            m_Context.device.destroyPipeline(entry.second.pipeline, m_Context.allocationCallbacks);
+        }
+        m_Libraries.clear();
+    }
+
+    vk::Result PipelineLibraryCache::acquire(PipelineLibraryKey key, const vk::GraphicsPipelineCreateInfo& partInfo,
+        vk::Pipeline& outPipeline, const PipelineLibraryKey*& outKey)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto it = m_Libraries.find(key);
+            if (it != m_Libraries.end())
+            {
+                ++it->second.useCount;
+                outPipeline = it->second.pipeline;
+                outKey = &it->first;
+                return vk::Result::eSuccess;
+            }
+        }
+
+        // Compile without holding the lock so that pipelines using different parts can be created in parallel
+        vk::Pipeline library;
+        const vk::Result res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                                                                      1, &partInfo,
+                                                                      m_Context.allocationCallbacks,
+                                                                      &library);
+        if (res != vk::Result::eSuccess)
+            return res;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto [it, inserted] = m_Libraries.try_emplace(std::move(key));
+        if (inserted)
+        {
+            it->second.pipeline = library;
+        }
+        else
+        {
+            // Another thread has created the same part in the meantime
+            m_Context.device.destroyPipeline(library, m_Context.allocationCallbacks);
+        }
+
+        ++it->second.useCount;
+        outPipeline = it->second.pipeline;
+        outKey = &it->first;
+        return vk::Result::eSuccess;
+    }
+
+    void PipelineLibraryCache::release(const PipelineLibraryKey* key)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Element addresses in an unordered_map are stable, so the key still belongs to its entry
+        auto it = m_Libraries.find(*key);
+        assert(it != m_Libraries.end() && it->second.useCount > 0);
+
+        if (--it->second.useCount == 0)
+        {
+            m_Context.device.destroyPipeline(it->second.pipeline, m_Context.allocationCallbacks);
+            m_Libraries.erase(it);
+        }
+    }
+
+    void PipelineLinkState::linkFinished(const VulkanContext& context, vk::Pipeline optimized)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_LinkPending = false;
+        optimizedPipeline.store(VkPipeline(optimized), std::memory_order_release);
+
+        if (m_PipelineReleased)
+            destroy(context);
+    }
+
+    void PipelineLinkState::pipelineReleased(const VulkanContext& context)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_PipelineReleased = true;
+
+        if (!m_LinkPending)
+            destroy(context);
+    }
+
+    void PipelineLinkState::destroy(const VulkanContext& context)
+    {
+        if (VkPipeline optimized = optimizedPipeline.exchange(VK_NULL_HANDLE))
+        {
+            context.device.destroyPipeline(optimized, context.allocationCallbacks);
+        }
+
+        if (pipelineLayout)
+        {
+            context.device.destroyPipelineLayout(pipelineLayout, context.allocationCallbacks);
+            pipelineLayout = nullptr;
+        }
+
+        for (const PipelineLibraryKey* key : libraries)
+            libraryCache->release(key);
+        libraries.clear();
+    }
+
+    void Device::retirePipelineLinkTasks(bool waitForAll)
+    {
+        std::lock_guard lockGuard(m_PipelineLinkMutex);
+
+        ITaskScheduler* scheduler = m_TaskDispatcher.getScheduler();
+        auto end = std::remove_if(m_PipelineLinkTasks.begin(), m_PipelineLinkTasks.end(),
+            [scheduler, waitForAll](const auto& task)
+            {
+                if (!waitForAll && task.second->isLinkPending())
+                    return false;
+
+                // Returns right away for finished tasks, but each task ID must still be waited on once
+                scheduler->wait(task.first);
+                return true;
+            });
+        m_PipelineLinkTasks.erase(end, m_PipelineLinkTasks.end());
+    }
+
+    vk::Result Device::createGraphicsPipelineFromLibraries(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo, IFramebuffer* fb)
+    {
+        // Extract the chained structures that some of the parts need. Each part gets its own copies
+        // because a structure can only be in one chain at a time.
+        const vk::PipelineRenderingCreateInfo* renderingInfo = nullptr;
+        const vk::PipelineFragmentShadingRateStateCreateInfoKHR* shadingRateInfo = nullptr;
+        for (auto next = static_cast<const vk::BaseInStructure*>(pipelineInfo.pNext); next; next = next->pNext)
+        {
+            if (next->sType == vk::StructureType::ePipelineRenderingCreateInfo)
+                renderingInfo = reinterpret_cast<const vk::PipelineRenderingCreateInfo*>(next);
+            else if (next->sType == vk::StructureType::ePipelineFragmentShadingRateStateCreateInfoKHR)
+                shadingRateInfo = reinterpret_cast<const vk::PipelineFragmentShadingRateStateCreateInfoKHR*>(next);
+        }
+
+        struct PartChain
+        {
+            vk::GraphicsPipelineLibraryCreateInfoEXT library;
+            vk::PipelineRenderingCreateInfo rendering;
+            vk::PipelineFragmentShadingRateStateCreateInfoKHR shadingRate;
+        };
+
+        auto makeChain = [renderingInfo, shadingRateInfo](PartChain& chain, vk::GraphicsPipelineLibraryFlagsEXT part, bool useRendering, bool useShadingRate)
+        {
+            void* next = nullptr;
+
+            if (shadingRateInfo && useShadingRate)
+            {
+                chain.shadingRate = *shadingRateInfo;
+                chain.shadingRate.setPNext(next);
+                next = &chain.shadingRate;
+            }
+
+            if (renderingInfo && useRendering)
+            {
+                chain.rendering = *renderingInfo;
+                chain.rendering.setPNext(next);
+                next = &chain.rendering;
+            }
+
+            chain.library = vk::GraphicsPipelineLibraryCreateInfoEXT()
+                .setFlags(part)
+                .setPNext(next);
+
+            return &chain.library;
+        };
+
+        const auto basePartInfo = vk::GraphicsPipelineCreateInfo()
+            .setFlags(vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT)
+            .setPDynamicState(pipelineInfo.pDynamicState)
+            .setBasePipelineIndex(-1);
+
+        static_vector<vk::PipelineShaderStageCreateInfo, 4> preRasterizationStages;
+        static_vector<vk::PipelineShaderStageCreateInfo, 1> fragmentStages;
+        for (uint32_t i = 0; i < pipelineInfo.stageCount; i++)
+        {
+            if (pipelineInfo.pStages[i].stage == vk::ShaderStageFlagBits::eFragment)
+                fragmentStages.push_back(pipelineInfo.pStages[i]);
+            else
+                preRasterizationStages.push_back(pipelineInfo.pStages[i]);
+        }
+
+        // The link state holds the uses of the parts and the pipeline layout from here on, also if creation fails
+        pso->linkState = std::make_shared<PipelineLinkState>();
+        pso->linkState->libraryCache = &m_PipelineLibraries;
+        pso->linkState->pipelineLayout = pipelineInfo.layout;
+
+        std::array<vk::Pipeline, 4> libraries;
+        PartChain chain;
+
+        auto acquirePart = [this, pso, &libraries](const vk::GraphicsPipelineCreateInfo& partInfo, bool usesLayout)
+        {
+            PipelineLibraryKeyWriter writer;
+            writer.addCreateInfo(partInfo);
+            if (usesLayout)
+                writer.addPipelineLayout(pso->pipelineBindingLayouts, pso->pushConstantVisibility);
+
+            const PipelineLibraryKey* key = nullptr;
+            const vk::Result res = m_PipelineLibraries.acquire(std::move(writer.key), partInfo,
+                libraries[pso->linkState->libraries.size()], key);
+
+            if (res == vk::Result::eSuccess)
+                pso->linkState->libraries.push_back(key);
+
+            return res;
+        };
+
+        auto vertexInputInfo = basePartInfo;
+        vertexInputInfo
+            .setPNext(makeChain(chain, vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface, false, false))
+            .setPVertexInputState(pipelineInfo.pVertexInputState)
+            .setPInputAssemblyState(pipelineInfo.pInputAssemblyState);
+
+        vk::Result res = acquirePart(vertexInputInfo, false);
+        CHECK_VK_RETURN(res)
+
+        auto preRasterizationInfo = basePartInfo;
+        preRasterizationInfo
+            .setPNext(makeChain(chain, vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders, true, true))
+            .setStageCount(uint32_t(preRasterizationStages.size()))
+            .setPStages(preRasterizationStages.data())
+            .setPViewportState(pipelineInfo.pViewportState)
+            .setPRasterizationState(pipelineInfo.pRasterizationState)
+            .setPTessellationState(pipelineInfo.pTessellationState)
+            .setLayout(pipelineInfo.layout)
+            .setRenderPass(pipelineInfo.renderPass)
+            .setSubpass(pipelineInfo.subpass);
+
+        res = acquirePart(preRasterizationInfo, true);
+        CHECK_VK_RETURN(res)
+
+        auto fragmentInfo = basePartInfo;
+        fragmentInfo
+            .setPNext(makeChain(chain, vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader, true, true))
+            .setStageCount(uint32_t(fragmentStages.size()))
+            .setPStages(fragmentStages.data())
+            .setPDepthStencilState(pipelineInfo.pDepthStencilState)
+            .setPMultisampleState(pipelineInfo.pMultisampleState)
+            .setLayout(pipelineInfo.layout)
+            .setRenderPass(pipelineInfo.renderPass)
+            .setSubpass(pipelineInfo.subpass);
+
+        res = acquirePart(fragmentInfo, true);
+        CHECK_VK_RETURN(res)
+
+        auto fragmentOutputInfo = basePartInfo;
+        fragmentOutputInfo
+            .setPNext(makeChain(chain, vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface, true, false))
+            .setPColorBlendState(pipelineInfo.pColorBlendState)
+            .setPMultisampleState(pipelineInfo.pMultisampleState)
+            .setRenderPass(pipelineInfo.renderPass)
+            .setSubpass(pipelineInfo.subpass);
+
+        res = acquirePart(fragmentOutputInfo, false);
+        CHECK_VK_RETURN(res)
+
+        // Fast link without optimization, so that the pipeline can be used right away
+        const auto linkLibraries = vk::PipelineLibraryCreateInfoKHR()
+            .setLibraries(libraries);
+
+        const auto linkInfo = vk::GraphicsPipelineCreateInfo()
+            .setPNext(&linkLibraries)
+            .setLayout(pipelineInfo.layout)
+            .setRenderPass(pipelineInfo.renderPass)
+            .setSubpass(pipelineInfo.subpass)
+            .setBasePipelineIndex(-1);
+
+        res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                                                     1, &linkInfo,
+                                                     m_Context.allocationCallbacks,
+                                                     &pso->pipeline);
+        CHECK_VK_RETURN(res)
+
+        // Link the optimized pipeline in the background. The task shares the link state with the pipeline
+        // instead of referencing the pipeline, so the pipeline can be destroyed without waiting for it.
+        // The framebuffer is captured because it may own the render pass in the link info.
+        const VulkanContext& context = m_Context;
+        std::shared_ptr<PipelineLinkState> linkState = pso->linkState;
+        linkState->setLinkPending();
+
+        const ITaskScheduler::TaskID task = m_TaskDispatcher.getScheduler()->runAsync([&context, linkState, libraries, linkInfo, framebuffer = FramebufferHandle(fb)]()
+        {
+
+            const auto optimizedLibraries = vk::PipelineLibraryCreateInfoKHR()
+                .setLibraries(libraries);
+
+            auto optimizedInfo = linkInfo;
+            optimizedInfo
+                .setPNext(&optimizedLibraries)
+                .setFlags(vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT);
+
+            vk::Pipeline optimized;
+            const vk::Result res = context.device.createGraphicsPipelines(context.pipelineCache,
+                                                                        1, &optimizedInfo,
+                                                                        context.allocationCallbacks,
+                                                                        &optimized);
+
+            if (res != vk::Result::eSuccess)
+            {
+                context.warning(std::string("Failed to link an optimized graphics pipeline, the fast-linked one will be used: ") + resultToString(VkResult(res)));
+                optimized = vk::Pipeline();
+            }
+
+            linkState->linkFinished(context, optimized);
+        });
+
+        std::lock_guard lockGuard(m_PipelineLinkMutex);
+        m_PipelineLinkTasks.emplace_back(task, std::move(linkState));
+
+        return vk::Result::eSuccess;
+    }
+}
+
+namespace std
+{
+    size_t hash<nvrhi::vulkan::PipelineLibraryKey>::operator()(nvrhi::vulkan::PipelineLibraryKey const& s) const noexcept
+    {
+        size_t hash = 0;
+        for (uint64_t word : s.data)
+            nvrhi::hash_combine(hash, word);
+        return hash;
+    }
+}
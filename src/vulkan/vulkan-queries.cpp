@@ -72,6 +72,68 @@ namespace nvrhi::vulkan
         query->commandListID = 0;
     }
 
+    EventTimelinePoint Device::getEventTimelinePoint(CommandQueue queue)
+    {
+        EventTimelinePoint point;
+        point.queue = queue;
+        point.submissionID = m_Queues[uint32_t(queue)]->getLastSubmittedID();
+        return point;
+    }
+
+    bool Device::isSubmissionCompleted(CommandQueue queueID, uint64_t submissionID, CompletedSubmissionCache& cache)
+    {
+        Queue* queue = getQueue(queueID);
+
+        if (!queue || submissionID == 0 || submissionID > queue->getLastSubmittedID())
+            return false;
+
+        if (queue->getLastFinishedID() >= submissionID)
+            return true;
+
+        const uint32_t queueIndex = uint32_t(queueID);
+        if (!cache.valid[queueIndex])
+        {
+            cache.values[queueIndex] = queue->updateLastFinishedID();
+            cache.valid[queueIndex] = true;
+        }
+
+        return cache.values[queueIndex] >= submissionID;
+    }
+
+    void Device::pollEventTimelinePoints(const EventTimelinePoint* points, size_t numPoints, bool* results)
+    {
+        CompletedSubmissionCache cache;
+
+        for (size_t i = 0; i < numPoints; i++)
+        {
+            results[i] = isSubmissionCompleted(points[i].queue, points[i].submissionID, cache);
+        }
+    }
+
+    void Device::pollEventQueries(IEventQuery* const* queries, size_t numQueries, bool* results)
+    {
+        CompletedSubmissionCache cache;
+
+        for (size_t i = 0; i < numQueries; i++)
+        {
+            EventQuery* query = checked_cast<EventQuery*>(queries[i]);
+
+            results[i] = isSubmissionCompleted(query->queue, query->commandListID, cache);
+        }
+    }
+
+    void Device::waitEventTimelinePoint(const EventTimelinePoint& point)
+    {
+        if (point.submissionID == 0)
+            return;
+
+        auto& queue = *m_Queues[uint32_t(point.queue)];
+
+        bool success = queue.waitCommandList(point.submissionID, ~0ull);
+        assert(success);
+        (void)success;
+    }
+
 
     TimerQueryHandle Device::createTimerQuery(void)
     {
@@ -217,13 +279,17 @@ namespace nvrhi::vulkan
                                 .setPMarkerName(name);
             m_CurrentCmdBuf->cmdBuf.debugMarkerBeginEXT(&markerInfo);
         }
-#if NVRHI_WITH_AFTERMATH
-        if (m_Device->isAftermathEnabled())
+
+        if (m_Device->isAftermathEnabled() || m_Device->isBreadcrumbsEnabled())
         {
-            const size_t aftermathMarker = m_AftermathTracker.pushEvent(name);
-            m_CurrentCmdBuf->cmdBuf.setCheckpointNV((const void*)aftermathMarker);
-        }
+            const size_t markerHash = m_AftermathTracker.pushEvent(name);
+#if NVRHI_WITH_AFTERMATH
+            if (m_Device->isAftermathEnabled())
+                m_CurrentCmdBuf->cmdBuf.setCheckpointNV((const void*)markerHash);
 #endif
+            if (m_Device->isBreadcrumbsEnabled())
+                writeBreadcrumbs(m_Breadcrumbs.pushMarker(markerHash));
+        }
     }
 
     void CommandList::endMarker()
@@ -234,9 +300,68 @@ namespace nvrhi::vulkan
 
             m_CurrentCmdBuf->cmdBuf.debugMarkerEndEXT();
         }
-#if NVRHI_WITH_AFTERMATH
+
+        if (m_Device->isBreadcrumbsEnabled())
+            writeBreadcrumbs(m_Breadcrumbs.popMarker());
+
         m_AftermathTracker.popEvent();
-#endif
+    }
+
+    void CommandList::writeBreadcrumbs(const BreadcrumbWrites& writes, bool endOfCommandList)
+    {
+        assert(m_CurrentCmdBuf);
+
+        const vk::Buffer buffer = m_Device->getBreadcrumbBuffer(m_CommandListParameters.queueType);
+        if (!buffer)
+            return;
+
+        const bool insideRenderPass = m_CurrentGraphicsState.framebuffer || m_CurrentMeshletState.framebuffer;
+        bool fillBarrierPlaced = false;
+
+        for (const BreadcrumbWrite& write : writes)
+        {
+            if (m_Context.extensions.AMD_buffer_marker && write.size == sizeof(uint32_t))
+            {
+                // Buffer markers are written when the preceding work reaches the given stage, and are allowed in render passes
+                const vk::PipelineStageFlagBits stage = write.completion
+                    ? vk::PipelineStageFlagBits::eBottomOfPipe
+                    : vk::PipelineStageFlagBits::eTopOfPipe;
+
+                m_CurrentCmdBuf->cmdBuf.writeBufferMarkerAMD(stage, buffer, write.offset, write.value);
+            }
+            else if (insideRenderPass)
+            {
+                // vkCmdFillBuffer is not allowed inside a render pass, and deferring the writes to the end of the pass
+                // would report the scopes as not started or as finished together. Leave them out instead, and say so
+                // once per command list.
+                if (!m_BreadcrumbsSkippedInRenderPass)
+                {
+                    m_Context.warning("Breadcrumbs for markers inside render passes are not recorded without VK_AMD_buffer_marker");
+                    m_BreadcrumbsSkippedInRenderPass = true;
+                }
+            }
+            else
+            {
+                // A barrier for every scope would serialize the command list at each marker, so the fills for
+                // markers are left unordered, and a scope can be reported as finished slightly early. Only the end
+                // of the command list waits for all the preceding work, which keeps its completion reliable.
+                if (endOfCommandList && !fillBarrierPlaced)
+                {
+                    const auto barrier = vk::MemoryBarrier()
+                        .setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+                        .setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+
+                    m_CurrentCmdBuf->cmdBuf.pipelineBarrier(
+                        vk::PipelineStageFlagBits::eAllCommands,
+                        vk::PipelineStageFlagBits::eTransfer,
+                        vk::DependencyFlags(), 1, &barrier, 0, nullptr, 0, nullptr);
+
+                    fillBarrierPlaced = true;
+                }
+
+                m_CurrentCmdBuf->cmdBuf.fillBuffer(buffer, write.offset, write.size, write.value);
+            }
+        }
     }
 
 } // namespace nvrhi::vulkan
\ No newline at end of file
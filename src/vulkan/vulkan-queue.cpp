@@ -56,7 +56,7 @@ namespace nvrhi::vulkan
     {
         vk::Result res;
 
-        TrackedCommandBufferPtr ret = std::make_shared<TrackedCommandBuffer>(m_Context);
+        TrackedCommandBufferPtr ret = std::allocate_shared<TrackedCommandBuffer>(PoolAllocator<TrackedCommandBuffer>(), m_Context);
 
         auto cmdPoolInfo = vk::CommandPoolCreateInfo()
                             .setQueueFamilyIndex(m_QueueFamilyIndex)
@@ -117,10 +117,11 @@ namespace nvrhi::vulkan
         m_SignalSemaphoreValues.push_back(value);
     }
 
-    uint64_t Queue::submit(ICommandList* const* ppCmd, size_t numCmd)
+    uint64_t Queue::submit(ICommandList* const* ppCmd, size_t numCmd, const TrackedCommandBufferPtr& prologue)
     {
         std::vector<vk::PipelineStageFlags> waitStageArray(m_WaitSemaphores.size());
-        std::vector<vk::CommandBuffer> commandBuffers(numCmd);
+        std::vector<vk::CommandBuffer> commandBuffers;
+        commandBuffers.reserve(numCmd + 1);
 
         for (size_t i = 0; i < m_WaitSemaphores.size(); i++)
         {
@@ -129,12 +130,19 @@ namespace nvrhi::vulkan
 
         m_LastSubmittedID++;
 
+        if (prologue)
+        {
+            prologue->submissionID = m_LastSubmittedID;
+            commandBuffers.push_back(prologue->cmdBuf);
+            m_CommandBuffersInFlight.push_back(prologue);
+        }
+
         for (size_t i = 0; i < numCmd; i++)
         {
             CommandList* commandList = checked_cast<CommandList*>(ppCmd[i]);
             TrackedCommandBufferPtr commandBuffer = commandList->getCurrentCmdBuf();
 
-            commandBuffers[i] = commandBuffer->cmdBuf;
+            commandBuffers.push_back(commandBuffer->cmdBuf);
             m_CommandBuffersInFlight.push_back(commandBuffer);
 
             for (const auto& buffer : commandBuffer->referencedStagingBuffers)
@@ -159,7 +167,7 @@ namespace nvrhi::vulkan
 
         auto submitInfo = vk::SubmitInfo()
             .setPNext(&timelineSemaphoreInfo)
-            .setCommandBufferCount(uint32_t(numCmd))
+            .setCommandBufferCount(uint32_t(commandBuffers.size()))
             .setPCommandBuffers(commandBuffers.data())
             .setWaitSemaphoreCount(uint32_t(m_WaitSemaphores.size()))
             .setPWaitSemaphores(m_WaitSemaphores.data())
@@ -183,6 +191,73 @@ namespace nvrhi::vulkan
         return m_LastSubmittedID;
     }
 
+    uint64_t Queue::submitInternal(const TrackedCommandBufferPtr& commandBuffer)
+    {
+        m_LastSubmittedID++;
+
+        commandBuffer->submissionID = m_LastSubmittedID;
+        m_CommandBuffersInFlight.push_back(commandBuffer);
+
+        auto timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
+            .setSignalSemaphoreValueCount(1)
+            .setPSignalSemaphoreValues(&m_LastSubmittedID);
+
+        auto submitInfo = vk::SubmitInfo()
+            .setPNext(&timelineSemaphoreInfo)
+            .setCommandBufferCount(1)
+            .setPCommandBuffers(&commandBuffer->cmdBuf)
+            .setSignalSemaphoreCount(1)
+            .setPSignalSemaphores(&trackingSemaphore);
+
+        try {
+            m_Queue.submit(submitInfo);
+        }
+        catch (vk::DeviceLostError e)
+        {
+            m_Context.messageCallback->message(MessageSeverity::Error, "Device Removed!");
+        }
+
+        return m_LastSubmittedID;
+    }
+
+    uint64_t Queue::bindSparse(vk::BindSparseInfo bindInfo)
+    {
+        // Remapping tiles that are still in use is undefined, so wait for the work submitted so far
+        const uint64_t waitValue = m_LastSubmittedID;
+
+        m_LastSubmittedID++;
+
+        auto timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
+            .setSignalSemaphoreValueCount(1)
+            .setPSignalSemaphoreValues(&m_LastSubmittedID);
+
+        bindInfo.setPNext(&timelineSemaphoreInfo)
+            .setSignalSemaphoreCount(1)
+            .setPSignalSemaphores(&trackingSemaphore);
+
+        if (waitValue != 0)
+        {
+            timelineSemaphoreInfo.setWaitSemaphoreValueCount(1)
+                .setPWaitSemaphoreValues(&waitValue);
+
+            bindInfo.setWaitSemaphoreCount(1)
+                .setPWaitSemaphores(&trackingSemaphore);
+        }
+
+        try {
+            m_Queue.bindSparse(bindInfo, vk::Fence());
+        }
+        catch (vk::DeviceLostError e)
+        {
+            m_Context.messageCallback->message(MessageSeverity::Error, "Device Removed!");
+        }
+
+        // Sparse binding is not ordered with command buffer submissions
+        addWaitSemaphore(trackingSemaphore, m_LastSubmittedID);
+
+        return m_LastSubmittedID;
+    }
+
     uint64_t Queue::updateLastFinishedID()
     {
         m_LastFinishedID = m_Context.device.getSemaphoreCounterValue(trackingSemaphore);
@@ -303,4 +378,189 @@ namespace nvrhi::vulkan
 
         return (result == vk::Result::eSuccess);
     }
+
+    void Device::registerCompletionCallback(CommandQueue queueID, uint64_t submissionID, std::function<void(bool completed)> callback)
+    {
+        Queue* queue = getQueue(queueID);
+        if (!queue)
+        {
+            m_Context.error("registerCompletionCallback: the device doesn't have the specified queue");
+            callback(false);
+            return;
+        }
+
+        if (submissionID == 0 || submissionID > queue->getLastSubmittedID())
+        {
+            m_Context.error("registerCompletionCallback: submission " + std::to_string(submissionID)
+                + " has not been submitted to the queue");
+            callback(false);
+            return;
+        }
+
+        m_CompletionThread.registerCallback(*queue, submissionID, std::move(callback));
+    }
+
+    void CompletionThread::registerCallback(Queue& queue, uint64_t submissionID, std::function<void(bool completed)> callback)
+    {
+        if (m_Context.device.getSemaphoreCounterValue(queue.trackingSemaphore) >= submissionID)
+        {
+            callback(true);
+            return;
+        }
+
+        std::unique_lock lock(m_Mutex);
+
+        if (m_Terminate || m_Failed)
+        {
+            if (m_Terminate)
+                m_Context.error("registerCompletionCallback called while the device is being destroyed");
+
+            // The thread will not wait for the submission, so it fails right away
+            lock.unlock();
+            callback(false);
+            return;
+        }
+
+        if (!m_Thread.joinable())
+        {
+            auto semaphoreTypeInfo = vk::SemaphoreTypeCreateInfo()
+                .setSemaphoreType(vk::SemaphoreType::eTimeline);
+
+            auto semaphoreInfo = vk::SemaphoreCreateInfo()
+                .setPNext(&semaphoreTypeInfo);
+
+            m_WakeSemaphore = m_Context.device.createSemaphore(semaphoreInfo, m_Context.allocationCallbacks);
+            m_Thread = std::thread(&CompletionThread::threadProc, this);
+        }
+
+        PendingCallbacks& pending = m_PendingCallbacks[uint32_t(queue.getQueueID())];
+        pending.semaphore = queue.trackingSemaphore;
+
+        // The thread is waiting for an older value on this queue, or not waiting for this queue at all
+        const bool earliest = pending.callbacks.empty() || submissionID < pending.callbacks.begin()->first;
+
+        pending.callbacks.emplace(submissionID, std::move(callback));
+
+        if (earliest)
+            wake();
+    }
+
+    void CompletionThread::shutdown()
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+
+            if (!m_Thread.joinable())
+                return;
+
+            m_Terminate = true;
+            wake();
+        }
+
+        m_Thread.join();
+
+        m_Context.device.destroySemaphore(m_WakeSemaphore, m_Context.allocationCallbacks);
+        m_WakeSemaphore = vk::Semaphore();
+    }
+
+    void CompletionThread::wake()
+    {
+        ++m_WakeValue;
+
+        auto signalInfo = vk::SemaphoreSignalInfo()
+            .setSemaphore(m_WakeSemaphore)
+            .setValue(m_WakeValue);
+
+        m_Context.device.signalSemaphore(signalInfo);
+    }
+
+    void CompletionThread::threadProc()
+    {
+        std::vector<std::function<void(bool completed)>> readyCallbacks;
+
+        std::unique_lock lock(m_Mutex);
+
+        while (true)
+        {
+            static_vector<vk::Semaphore, uint32_t(CommandQueue::Count) + 1> semaphores;
+            static_vector<uint64_t, uint32_t(CommandQueue::Count) + 1> waitValues;
+
+            for (const PendingCallbacks& pending : m_PendingCallbacks)
+            {
+                if (!pending.callbacks.empty())
+                {
+                    semaphores.push_back(pending.semaphore);
+                    waitValues.push_back(pending.callbacks.begin()->first);
+                }
+            }
+
+            // When terminating, keep running until all pending callbacks are called, but don't wait for wake-ups
+            if (m_Terminate && semaphores.empty())
+                break;
+
+            if (!m_Terminate)
+            {
+                semaphores.push_back(m_WakeSemaphore);
+                waitValues.push_back(m_WakeValue + 1);
+            }
+
+            lock.unlock();
+
+            auto waitInfo = vk::SemaphoreWaitInfo()
+                .setFlags(vk::SemaphoreWaitFlagBits::eAny)
+                .setSemaphoreCount(uint32_t(semaphores.size()))
+                .setPSemaphores(semaphores.data())
+                .setPValues(waitValues.data());
+
+            const vk::Result result = m_Context.device.waitSemaphores(waitInfo, ~0ull);
+
+            lock.lock();
+
+            if (result != vk::Result::eSuccess)
+            {
+                // Most likely a device loss, so the pending submissions will never complete
+                m_Context.error("vkWaitSemaphores failed in the completion thread, pending submissions are reported as failed");
+
+                for (PendingCallbacks& pending : m_PendingCallbacks)
+                {
+                    for (auto& entry : pending.callbacks)
+                        readyCallbacks.push_back(std::move(entry.second));
+                    pending.callbacks.clear();
+                }
+
+                m_Failed = true;
+                lock.unlock();
+
+                for (const auto& callback : readyCallbacks)
+                    callback(false);
+
+                return;
+            }
+
+            for (PendingCallbacks& pending : m_PendingCallbacks)
+            {
+                if (pending.callbacks.empty())
+                    continue;
+
+                const uint64_t completedValue = m_Context.device.getSemaphoreCounterValue(pending.semaphore);
+
+                auto end = pending.callbacks.upper_bound(completedValue);
+                for (auto it = pending.callbacks.begin(); it != end; ++it)
+                    readyCallbacks.push_back(std::move(it->second));
+                pending.callbacks.erase(pending.callbacks.begin(), end);
+            }
+
+            if (readyCallbacks.empty())
+                continue;
+
+            lock.unlock();
+
+            for (const auto& callback : readyCallbacks)
+                callback(true);
+            readyCallbacks.clear();
+
+            lock.lock();
+        }
+    }
+
 } // namespace nvrhi::vulkan
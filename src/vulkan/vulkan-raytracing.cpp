@@ -333,7 +333,7 @@ namespace nvrhi::vulkan
     {
         OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pOpacityMicromap);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
             requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
@@ -343,9 +343,9 @@ namespace nvrhi::vulkan
 
         if (desc.trackLiveness)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(desc.inputBuffer);
-            m_CurrentCmdBuf->referencedResources.push_back(desc.perOmmDescs);
-            m_CurrentCmdBuf->referencedResources.push_back(omm->dataBuffer);
+            m_CurrentCmdBuf->referencedResources.add(desc.inputBuffer);
+            m_CurrentCmdBuf->referencedResources.add(desc.perOmmDescs);
+            m_CurrentCmdBuf->referencedResources.add(omm->dataBuffer);
         }
 
         commitBarriers();
@@ -419,7 +419,7 @@ namespace nvrhi::vulkan
             {
             case rt::GeometryType::Triangles: {
                 const rt::GeometryTriangles& srct = src.geometryData.triangles;
-                if (m_EnableAutomaticBarriers)
+                if (isTrackingResources())
                 {
                     if (srct.indexBuffer)
                         requireBufferState(srct.indexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
@@ -432,7 +432,7 @@ namespace nvrhi::vulkan
             }
             case rt::GeometryType::AABBs: {
                 const rt::GeometryAABBs& srca = src.geometryData.aabbs;
-                if (m_EnableAutomaticBarriers)
+                if (isTrackingResources())
                 {
                     if (srca.buffer)
                         requireBufferState(srca.buffer, nvrhi::ResourceStates::AccelStructBuildInput);
@@ -494,7 +494,7 @@ namespace nvrhi::vulkan
         }
 #else
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
         }
@@ -544,7 +544,7 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
 #endif
         if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
+            m_CurrentCmdBuf->referencedResources.add(as);
     }
 
     void CommandList::compactBottomLevelAccelStructs()
@@ -653,39 +653,58 @@ namespace nvrhi::vulkan
 
         as->instances.resize(numInstances);
 
+        // Update the BLAS references and states on this thread first, because the state tracker is not thread-safe
+#ifdef NVRHI_WITH_RTXMU
         for (size_t i = 0; i < numInstances; i++)
         {
-            const rt::InstanceDesc& src = pInstances[i];
-            vk::AccelerationStructureInstanceKHR& dst = as->instances[i];
-
-            if (src.bottomLevelAS)
+            if (pInstances[i].bottomLevelAS)
             {
-                AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
-#ifdef NVRHI_WITH_RTXMU
+                AccelStruct* blas = checked_cast<AccelStruct*>(pInstances[i].bottomLevelAS);
                 blas->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(blas->rtxmuId);
                 blas->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(blas->rtxmuId);
                 blas->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(blas->rtxmuId);
-                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+            }
+        }
 #else
-                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
-
-                if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
+        {
+            for (size_t i = 0; i < numInstances; i++)
+            {
+                if (pInstances[i].bottomLevelAS)
                 {
+                    AccelStruct* blas = checked_cast<AccelStruct*>(pInstances[i].bottomLevelAS);
                     requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
                 }
-#endif
             }
-            else // !src.bottomLevelAS
+        }
+#endif
+
+        // Large instance arrays are converted in parallel through the task scheduler
+        m_Context.taskDispatcher->parallelFor(numInstances, c_ParallelInstanceGrainSize, c_ParallelInstanceThreshold,
+            [as, pInstances](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
             {
-                dst.setAccelerationStructureReference(0);
-            }
+                const rt::InstanceDesc& src = pInstances[i];
+                vk::AccelerationStructureInstanceKHR& dst = as->instances[i];
 
-            dst.setInstanceCustomIndex(src.instanceID);
-            dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
-            dst.setFlags(convertInstanceFlags(src.flags));
-            dst.setMask(src.instanceMask);
-            memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
-        }
+                if (src.bottomLevelAS)
+                {
+                    AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
+                    dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+                }
+                else // !src.bottomLevelAS
+                {
+                    dst.setAccelerationStructureReference(0);
+                }
+
+                dst.setInstanceCustomIndex(src.instanceID);
+                dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
+                dst.setFlags(convertInstanceFlags(src.flags));
+                dst.setMask(src.instanceMask);
+                memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
+            }
+        });
 
 #ifdef NVRHI_WITH_RTXMU
         m_Context.rtxMemUtil->PopulateUAVBarriersCommandList(m_CurrentCmdBuf->cmdBuf, m_CurrentCmdBuf->rtxmuBuildIds);
@@ -705,7 +724,7 @@ namespace nvrhi::vulkan
         memcpy(uploadCpuVA, as->instances.data(), // NOLINT(bugprone-undefined-memory-manipulation)
             as->instances.size() * sizeof(vk::AccelerationStructureInstanceKHR));
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
         }
@@ -714,7 +733,7 @@ namespace nvrhi::vulkan
         buildTopLevelAccelStructInternal(as, uploadBuffer->deviceAddress + uploadOffset, numInstances, buildFlags, currentVersion);
 
         if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
+            m_CurrentCmdBuf->referencedResources.add(as);
     }
 
     void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* _instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -724,7 +743,7 @@ namespace nvrhi::vulkan
 
         as->instances.clear();
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
             requireBufferState(instanceBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
@@ -736,7 +755,7 @@ namespace nvrhi::vulkan
         buildTopLevelAccelStructInternal(as, instanceBuffer->deviceAddress + instanceBufferOffset, numInstances, buildFlags, currentVersion);
 
         if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
+            m_CurrentCmdBuf->referencedResources.add(as);
     }
 
     AccelStruct::~AccelStruct()
@@ -824,7 +843,7 @@ namespace nvrhi::vulkan
             return;
         }
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             for (size_t i = 0; i < state.bindings.size() && i < pso->desc.globalBindingLayouts.size(); i++)
             {
@@ -833,13 +852,13 @@ namespace nvrhi::vulkan
                 if ((layout->desc.visibility & ShaderType::AllRayTracing) == 0)
                     continue;
                 
-                setResourceStatesForBindingSet(state.bindings[i]);
+                requireBindingSetStates(state.bindings[i]);
             }
         }
 
         if (m_CurrentRayTracingState.shaderTable != state.shaderTable)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.shaderTable);
+            m_CurrentCmdBuf->referencedResources.add(state.shaderTable);
         }
 
         if (!m_CurrentRayTracingState.shaderTable || m_CurrentRayTracingState.shaderTable->getPipeline() != pso)
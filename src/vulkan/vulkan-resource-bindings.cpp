@@ -22,6 +22,7 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi::vulkan
@@ -109,12 +110,20 @@ namespace nvrhi::vulkan
                 break;
 
             case ResourceType::PushConstants:
-                // don't need any descriptors for the push constants, but the vulkanLayoutBindings array 
-                // must match the binding layout items for further processing within nvrhi --
-                // so set descriptorCount to 0 instead of skipping it
                 registerOffset = _desc.bindingOffsets.constantBuffer;
-                descriptorType = vk::DescriptorType::eUniformBuffer;
-                descriptorCount = 0;
+                if (binding.size > c_MaxPushConstantSize)
+                {
+                    // larger blocks are emulated with a dynamic uniform buffer, see PushConstantBufferPool
+                    descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+                }
+                else
+                {
+                    // don't need any descriptors for the push constants, but the vulkanLayoutBindings array 
+                    // must match the binding layout items for further processing within nvrhi --
+                    // so set descriptorCount to 0 instead of skipping it
+                    descriptorType = vk::DescriptorType::eUniformBuffer;
+                    descriptorCount = 0;
+                }
                 break;
 
             case ResourceType::RayTracingAccelStruct:
@@ -370,6 +379,23 @@ namespace nvrhi::vulkan
             const BindingSetItem& binding = desc.bindings[bindingIndex];
             const vk::DescriptorSetLayoutBinding& layoutBinding = layout->vulkanLayoutBindings[bindingIndex];
 
+            if (binding.type == ResourceType::PushConstants && layoutBinding.descriptorCount != 0)
+            {
+                // The data is written by setPushConstants, the binding set only points at the pool
+                auto& bufferInfo = descriptorBufferInfo.emplace_back();
+                bufferInfo = vk::DescriptorBufferInfo()
+                    .setBuffer(m_PushConstantBufferPool.getBuffer()->buffer)
+                    .setOffset(0)
+                    .setRange(binding.range.byteSize);
+
+                generateWriteDescriptorData(layoutBinding.binding,
+                    layoutBinding.descriptorType,
+                    nullptr, &bufferInfo, nullptr);
+
+                ret->volatileConstantBuffers.push_back(nullptr);
+                continue;
+            }
+
             if (binding.resourceHandle == nullptr)
             {
                 continue;
@@ -599,6 +625,105 @@ namespace nvrhi::vulkan
             descriptorPool = vk::DescriptorPool();
             descriptorSet = vk::DescriptorSet();
         }
+
+        for (PushConstantPageSet& pageSet : m_PushConstantPageSets)
+        {
+            if (pageSet.descriptorPool)
+            {
+                m_Context.device.destroyDescriptorPool(pageSet.descriptorPool, m_Context.allocationCallbacks);
+                pageSet = PushConstantPageSet();
+            }
+        }
+    }
+
+    vk::DescriptorSet BindingSet::getDescriptorSetForPushConstantPage(PushConstantBufferPool& pool, uint32_t page)
+    {
+        if (page == 0)
+            return descriptorSet;
+
+        std::lock_guard lockGuard(m_PushConstantPageMutex);
+
+        PushConstantPageSet& pageSet = m_PushConstantPageSets[page - 1];
+        if (pageSet.descriptorSet)
+            return pageSet.descriptorSet;
+
+        const auto& poolSizes = layout->descriptorPoolSizeInfo;
+
+        auto poolInfo = vk::DescriptorPoolCreateInfo()
+            .setPoolSizeCount(uint32_t(poolSizes.size()))
+            .setPPoolSizes(poolSizes.data())
+            .setMaxSets(1);
+
+        vk::Result res = m_Context.device.createDescriptorPool(&poolInfo, m_Context.allocationCallbacks, &pageSet.descriptorPool);
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to create a descriptor pool for a push constant buffer page");
+            return descriptorSet;
+        }
+
+        const auto& descriptorSetLayout = layout->descriptorSetLayout;
+        auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
+            .setDescriptorPool(pageSet.descriptorPool)
+            .setDescriptorSetCount(1)
+            .setPSetLayouts(&descriptorSetLayout);
+
+        vk::DescriptorSet newSet;
+        res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &newSet);
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.device.destroyDescriptorPool(pageSet.descriptorPool, m_Context.allocationCallbacks);
+            pageSet.descriptorPool = vk::DescriptorPool();
+            m_Context.error("Failed to allocate a descriptor set for a push constant buffer page");
+            return descriptorSet;
+        }
+
+        // Copy every binding from the original set, then point the push constant binding at the page
+        static_vector<vk::CopyDescriptorSet, c_MaxBindingsPerLayout> descriptorCopyInfo;
+        static_vector<vk::DescriptorBufferInfo, c_MaxBindingsPerLayout> descriptorBufferInfo;
+        static_vector<vk::WriteDescriptorSet, c_MaxBindingsPerLayout> descriptorWriteInfo;
+
+        Buffer* pageBuffer = pool.getBuffer(page);
+
+        for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
+        {
+            const BindingSetItem& binding = desc.bindings[bindingIndex];
+            const vk::DescriptorSetLayoutBinding& layoutBinding = layout->vulkanLayoutBindings[bindingIndex];
+
+            if (layoutBinding.descriptorCount == 0)
+                continue;
+
+            if (binding.type == ResourceType::PushConstants)
+            {
+                auto& bufferInfo = descriptorBufferInfo.emplace_back();
+                bufferInfo = vk::DescriptorBufferInfo()
+                    .setBuffer(pageBuffer->buffer)
+                    .setOffset(0)
+                    .setRange(binding.range.byteSize);
+
+                descriptorWriteInfo.push_back(vk::WriteDescriptorSet()
+                    .setDstSet(newSet)
+                    .setDstBinding(layoutBinding.binding)
+                    .setDstArrayElement(0)
+                    .setDescriptorCount(1)
+                    .setDescriptorType(layoutBinding.descriptorType)
+                    .setPBufferInfo(&bufferInfo));
+                continue;
+            }
+
+            descriptorCopyInfo.push_back(vk::CopyDescriptorSet()
+                .setSrcSet(descriptorSet)
+                .setSrcBinding(layoutBinding.binding)
+                .setDstSet(newSet)
+                .setDstBinding(layoutBinding.binding)
+                .setDescriptorCount(layoutBinding.descriptorCount));
+        }
+
+        m_Context.device.updateDescriptorSets(
+            uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(),
+            uint32_t(descriptorCopyInfo.size()), descriptorCopyInfo.data());
+
+        pageSet.descriptorSet = newSet;
+        return newSet;
     }
 
     Object BindingSet::getNativeObject(ObjectType objectType)
@@ -657,6 +782,15 @@ namespace nvrhi::vulkan
             descriptorPool = vk::DescriptorPool();
             descriptorSet = vk::DescriptorSet();
         }
+
+        for (PushConstantPageSet& pageSet : m_PushConstantPageSets)
+        {
+            if (pageSet.descriptorPool)
+            {
+                m_Context.device.destroyDescriptorPool(pageSet.descriptorPool, m_Context.allocationCallbacks);
+                pageSet = PushConstantPageSet();
+            }
+        }
     }
 
     Object DescriptorTable::getNativeObject(ObjectType objectType)
@@ -900,10 +1034,24 @@ namespace nvrhi::vulkan
                 if (desc)
                 {
                     BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
-                    descriptorSets.push_back(bindingSet->descriptorSet);
+
+                    // Sets with a push constant buffer must point at the page that holds the current block
+                    const bool usesPushConstantPage = m_CurrentPushConstantBufferPage != 0 &&
+                        std::find(bindingSet->volatileConstantBuffers.begin(), bindingSet->volatileConstantBuffers.end(), nullptr) != bindingSet->volatileConstantBuffers.end();
+
+                    descriptorSets.push_back(usesPushConstantPage
+                        ? bindingSet->getDescriptorSetForPushConstantPage(m_Device->getPushConstantBufferPool(), m_CurrentPushConstantBufferPage)
+                        : bindingSet->descriptorSet);
 
                     for (Buffer* constantBuffer : bindingSet->volatileConstantBuffers)
                     {
+                        // A null entry is the push constant buffer, see PushConstantBufferPool
+                        if (!constantBuffer)
+                        {
+                            dynamicOffsets.push_back(m_CurrentPushConstantBufferOffset);
+                            continue;
+                        }
+
                         auto found = m_VolatileBufferStates.find(constantBuffer);
                         if (found == m_VolatileBufferStates.end())
                         {
@@ -924,7 +1072,7 @@ namespace nvrhi::vulkan
                     }
 
                     if (desc->trackLiveness)
-                        m_CurrentCmdBuf->referencedResources.push_back(bindingSetHandle);
+                        m_CurrentCmdBuf->referencedResources.add(bindingSetHandle);
                 }
                 else
                 {
@@ -1034,7 +1182,8 @@ namespace nvrhi::vulkan
                 {
                     for (const BindingLayoutItem& item : layout->desc.bindings)
                     {
-                        if (item.type == ResourceType::PushConstants)
+                        // push constant blocks larger than c_MaxPushConstantSize are bound as a buffer instead
+                        if (item.type == ResourceType::PushConstants && item.size <= c_MaxPushConstantSize)
                         {
                             pushConstantSize = item.size;
                             outPushConstantVisibility = convertShaderTypeToShaderStageFlagBits(layout->desc.visibility);
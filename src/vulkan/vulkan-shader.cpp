@@ -26,22 +26,61 @@
 namespace nvrhi::vulkan
 {
 
+    bool ShaderSpecializationKey::operator==(const ShaderSpecializationKey& other) const
+    {
+        if (module != other.module || entryName != other.entryName || shaderType != other.shaderType)
+            return false;
+
+        if (constants.size() != other.constants.size())
+            return false;
+
+        for (size_t i = 0; i < constants.size(); i++)
+        {
+            if (constants[i].constantID != other.constants[i].constantID || constants[i].value.u != other.constants[i].value.u)
+                return false;
+        }
+
+        return true;
+    }
+
     ShaderHandle Device::createShader(const ShaderDesc& desc, const void *binary, const size_t binarySize)
     {
-        Shader *shader = new Shader(m_Context);
+        // Identical binaries share one shader module, only the Shader objects with their descs are unique
+        ShaderModuleKey key;
+        key.contentHash = hashContents(binary, binarySize);
+        key.size = binarySize;
 
-        shader->desc = desc;
-        shader->stageFlagBits = convertShaderTypeToShaderStageFlagBits(desc.shaderType);
+        RefCountPtr<SharedShaderModule> sharedModule = m_ShaderModuleTable.findOrCreate(key, 
+            [this, &key, &desc, binary, binarySize]() -> RefCountPtr<SharedShaderModule>
+        {
+            SharedShaderModule* newModule = new SharedShaderModule(m_Context);
+            newModule->key = key;
 
-        auto shaderInfo = vk::ShaderModuleCreateInfo()
-            .setCodeSize(binarySize)
-            .setPCode((const uint32_t *)binary);
+            auto shaderInfo = vk::ShaderModuleCreateInfo()
+                .setCodeSize(binarySize)
+                .setPCode((const uint32_t *)binary);
 
-        const vk::Result res = m_Context.device.createShaderModule(&shaderInfo, m_Context.allocationCallbacks, &shader->shaderModule);
-        CHECK_VK_FAIL(res)
+            const vk::Result res = m_Context.device.createShaderModule(&shaderInfo, m_Context.allocationCallbacks, &newModule->shaderModule);
+            CHECK_VK_FAIL(res)
+
+            const std::string debugName = desc.debugName + ":" + desc.entryName;
+            m_Context.nameVKObject(VkShaderModule(newModule->shaderModule), vk::DebugReportObjectTypeEXT::eShaderModule, debugName.c_str());
+
+            if (m_RetainShaderBytecode)
+                newModule->bytecode.assign(static_cast<const char*>(binary), static_cast<const char*>(binary) + binarySize);
 
-        const std::string debugName = desc.debugName + ":" + desc.entryName;
-        m_Context.nameVKObject(VkShaderModule(shader->shaderModule), vk::DebugReportObjectTypeEXT::eShaderModule, debugName.c_str());
+            return RefCountPtr<SharedShaderModule>::Create(newModule);
+        });
+
+        if (!sharedModule)
+            return nullptr;
+
+        Shader *shader = new Shader(m_Context);
+
+        shader->desc = desc;
+        shader->stageFlagBits = convertShaderTypeToShaderStageFlagBits(desc.shaderType);
+        shader->shaderModule = sharedModule->shaderModule;
+        shader->sharedModule = sharedModule;
 
         return ShaderHandle::Create(shader);
     }
@@ -66,31 +105,60 @@ namespace nvrhi::vulkan
         assert(constants);
         assert(numConstants != 0);
 
-        Shader* newShader = new Shader(m_Context);
-
-        // Hold a strong reference to the parent object
-        newShader->baseShader = (baseShader->baseShader) ? baseShader->baseShader : baseShader;
-        newShader->desc = baseShader->desc;
-        newShader->shaderModule = baseShader->shaderModule;
-        newShader->stageFlagBits = baseShader->stageFlagBits;
-        newShader->specializationConstants.assign(constants, constants + numConstants);
-
-        return ShaderHandle::Create(newShader);
+        auto createSpecialization = [this, baseShader, constants, numConstants]() -> ShaderHandle
+        {
+            Shader* newShader = new Shader(m_Context);
+
+            // Hold a strong reference to the parent object
+            newShader->baseShader = (baseShader->baseShader) ? baseShader->baseShader : baseShader;
+            newShader->desc = baseShader->desc;
+            newShader->shaderModule = baseShader->shaderModule;
+            newShader->sharedModule = baseShader->sharedModule;
+            newShader->stageFlagBits = baseShader->stageFlagBits;
+            newShader->specializationConstants.assign(constants, constants + numConstants);
+
+            return ShaderHandle::Create(newShader);
+        };
+
+        // Shaders coming from libraries have no content hash, don't deduplicate their specializations
+        if (!baseShader->sharedModule)
+            return createSpecialization();
+
+        ShaderSpecializationKey key;
+        key.module = baseShader->sharedModule->key;
+        key.entryName = baseShader->desc.entryName;
+        key.shaderType = baseShader->desc.shaderType;
+        key.constants.assign(constants, constants + numConstants);
+
+        return m_ShaderSpecializationTable.findOrCreate(key, createSpecialization);
     }
 
 
-    Shader::~Shader()
+    SharedShaderModule::~SharedShaderModule()
     {
-        if (shaderModule && !baseShader) // do not destroy the module if this is a derived specialization shader or a library entry
+        if (shaderModule)
         {
             m_Context.device.destroyShaderModule(shaderModule, m_Context.allocationCallbacks);
             shaderModule = vk::ShaderModule();
         }
     }
 
+    Shader::~Shader()
+    {
+        // The module is owned by sharedModule, or by the library for library entries
+        shaderModule = vk::ShaderModule();
+    }
+
     void Shader::getBytecode(const void** ppBytecode, size_t* pSize) const
     {
-        // we don't save these for vulkan
+        // the bytecode is only available when the device retains it, see DeviceDesc::retainShaderBytecode
+        if (sharedModule && !sharedModule->bytecode.empty())
+        {
+            if (ppBytecode) *ppBytecode = sharedModule->bytecode.data();
+            if (pSize) *pSize = sharedModule->bytecode.size();
+            return;
+        }
+
         if (ppBytecode) *ppBytecode = nullptr;
         if (pSize) *pSize = 0;
     }
@@ -137,6 +205,16 @@ namespace nvrhi::vulkan
     {
         (void)vertexShader;
 
+        const std::vector<VertexAttributeDesc> key(attributeDesc, attributeDesc + attributeCount);
+
+        return m_InputLayoutTable.findOrCreate(key, [this, attributeDesc, attributeCount]() -> InputLayoutHandle
+        {
+            return createInputLayoutInternal(attributeDesc, attributeCount);
+        });
+    }
+
+    InputLayoutHandle Device::createInputLayoutInternal(const VertexAttributeDesc* attributeDesc, uint32_t attributeCount)
+    {
         InputLayout *layout = new InputLayout();
 
         int total_attribute_array_size = 0;
@@ -199,15 +199,15 @@ namespace nvrhi::vulkan
 
         assert(m_CurrentCmdBuf);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(dst->buffer, ResourceStates::CopyDest);
             requireTextureState(src, srcSubresource, ResourceStates::CopySource);
         }
         commitBarriers();
 
-        m_CurrentCmdBuf->referencedResources.push_back(src);
-        m_CurrentCmdBuf->referencedResources.push_back(dst);
+        m_CurrentCmdBuf->referencedResources.add(src);
+        m_CurrentCmdBuf->referencedResources.add(dst);
         m_CurrentCmdBuf->referencedStagingBuffers.push_back(dst->buffer);
 
         m_CurrentCmdBuf->cmdBuf.copyImageToBuffer(src->image, vk::ImageLayout::eTransferSrcOptimal,
@@ -248,15 +248,15 @@ namespace nvrhi::vulkan
 
         assert(m_CurrentCmdBuf);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireBufferState(src->buffer, ResourceStates::CopySource);
             requireTextureState(dst, dstSubresource, ResourceStates::CopyDest);
         }
         commitBarriers();
 
-        m_CurrentCmdBuf->referencedResources.push_back(src);
-        m_CurrentCmdBuf->referencedResources.push_back(dst);
+        m_CurrentCmdBuf->referencedResources.add(src);
+        m_CurrentCmdBuf->referencedResources.add(dst);
         m_CurrentCmdBuf->referencedStagingBuffers.push_back(src->buffer);
 
         m_CurrentCmdBuf->cmdBuf.copyBufferToImage(src->buffer->buffer,
@@ -22,11 +22,21 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 
 namespace nvrhi::vulkan
 {
     
-    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    void CommandList::setResourceStatesForBindingSet(IBindingSet* bindingSet)
+    {
+        // Called by the application, so the resources are transitioned even if automatic barriers are disabled
+        const bool enableAutomaticBarriers = m_EnableAutomaticBarriers;
+        m_EnableAutomaticBarriers = true;
+        requireBindingSetStates(bindingSet);
+        m_EnableAutomaticBarriers = enableAutomaticBarriers;
+    }
+
+    void CommandList::requireBindingSetStates(IBindingSet* _bindingSet)
     {
         if (_bindingSet == nullptr)
             return;
@@ -77,13 +87,13 @@ namespace nvrhi::vulkan
 
     void CommandList::trackResourcesAndBarriers(const GraphicsState& state)
     {
-        assert(m_EnableAutomaticBarriers);
+        assert(isTrackingResources());
 
         if (arraysAreDifferent(state.bindings, m_CurrentGraphicsState.bindings))
         {
             for (size_t i = 0; i < state.bindings.size(); i++)
             {
-                setResourceStatesForBindingSet(state.bindings[i]);
+                requireBindingSetStates(state.bindings[i]);
             }
         }
 
@@ -102,50 +112,84 @@ namespace nvrhi::vulkan
 
         if (m_CurrentGraphicsState.framebuffer != state.framebuffer)
         {
-            setResourceStatesForFramebuffer(state.framebuffer);
+            requireFramebufferStates(state.framebuffer);
         }
 
         if (state.indirectParams && state.indirectParams != m_CurrentGraphicsState.indirectParams)
         {
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentGraphicsState.indirectCountBuffer)
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
     }
 
     void CommandList::trackResourcesAndBarriers(const MeshletState& state)
     {
-        assert(m_EnableAutomaticBarriers);
+        assert(isTrackingResources());
         
         if (arraysAreDifferent(state.bindings, m_CurrentMeshletState.bindings))
         {
             for (size_t i = 0; i < state.bindings.size(); i++)
             {
-                setResourceStatesForBindingSet(state.bindings[i]);
+                requireBindingSetStates(state.bindings[i]);
             }
         }
 
         if (m_CurrentMeshletState.framebuffer != state.framebuffer)
         {
-            setResourceStatesForFramebuffer(state.framebuffer);
+            requireFramebufferStates(state.framebuffer);
         }
 
         if (state.indirectParams && state.indirectParams != m_CurrentMeshletState.indirectParams)
         {
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentMeshletState.indirectCountBuffer)
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+    }
+
+    void CommandList::requireFramebufferStates(IFramebuffer* framebuffer)
+    {
+        // Same as setResourceStatesForFramebuffer, but goes through requireTextureState so that
+        // only the uses are recorded when automatic barriers are disabled
+        const FramebufferDesc& desc = framebuffer->getDesc();
+
+        for (const auto& attachment : desc.colorAttachments)
+        {
+            requireTextureState(attachment.texture, attachment.subresources, ResourceStates::RenderTarget);
+        }
+
+        if (desc.depthAttachment.valid())
+        {
+            requireTextureState(desc.depthAttachment.texture, desc.depthAttachment.subresources,
+                desc.depthAttachment.isReadOnly ? ResourceStates::DepthRead : ResourceStates::DepthWrite);
+        }
     }
 
     void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
 
-        m_StateTracker.requireTextureState(texture, subresources, state);
+        if (m_EnableAutomaticBarriers)
+            m_StateTracker.requireTextureState(texture, subresources, state);
+        else
+            m_StateTracker.recordTextureUse(texture);
     }
 
     void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_StateTracker.requireBufferState(buffer, state);
+        if (m_EnableAutomaticBarriers)
+            m_StateTracker.requireBufferState(buffer, state);
+        else
+            m_StateTracker.recordBufferUse(buffer);
     }
 
     bool CommandList::anyBarriers() const
@@ -373,7 +417,7 @@ namespace nvrhi::vulkan
         m_StateTracker.requireTextureState(texture, subresources, stateBits);
 
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(texture);
+            m_CurrentCmdBuf->referencedResources.add(texture);
     }
 
     void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -383,7 +427,7 @@ namespace nvrhi::vulkan
         m_StateTracker.requireBufferState(buffer, stateBits);
         
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+            m_CurrentCmdBuf->referencedResources.add(buffer);
     }
     
     void CommandList::setAccelStructState(rt::IAccelStruct* _as, ResourceStates stateBits)
@@ -396,7 +440,7 @@ namespace nvrhi::vulkan
             m_StateTracker.requireBufferState(buffer, stateBits);
 
             if (m_CurrentCmdBuf)
-                m_CurrentCmdBuf->referencedResources.push_back(as);
+                m_CurrentCmdBuf->referencedResources.add(as);
         }
     }
 
@@ -407,7 +451,7 @@ namespace nvrhi::vulkan
         m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
 
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(texture);
+            m_CurrentCmdBuf->referencedResources.add(texture);
     }
 
     void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
@@ -417,7 +461,7 @@ namespace nvrhi::vulkan
         m_StateTracker.setPermanentBufferState(buffer, stateBits);
         
         if (m_CurrentCmdBuf)
-            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+            m_CurrentCmdBuf->referencedResources.add(buffer);
     }
 
     ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
@@ -453,4 +497,149 @@ namespace nvrhi::vulkan
         m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
     }
 
+    static vk::AccessFlags getOwnershipTransferAccessMask(const ResourceStateMapping& mapping, CommandQueue queue)
+    {
+        // Transfer queues only support transfer and generic memory accesses
+        if (queue == CommandQueue::Copy)
+        {
+            return mapping.accessMask & (vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite
+                | vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+        }
+
+        return mapping.accessMask;
+    }
+
+    static void recordOwnershipTransferBarriers(vk::CommandBuffer cmdBuf, TrackedCommandBuffer& trackedCmdBuf,
+        const std::vector<QueueOwnershipTransfer>& transfers, CommandQueue srcQueue, uint32_t srcFamily, uint32_t dstFamily, bool release)
+    {
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
+        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+
+        for (const QueueOwnershipTransfer& transfer : transfers)
+        {
+            if (transfer.srcQueue != srcQueue)
+                continue;
+
+            // The release uses the access of the state on the source queue, the acquire the same access on the destination queue
+            const CommandQueue queue = release ? transfer.srcQueue : transfer.dstQueue;
+
+            if (transfer.buffer)
+            {
+                Buffer* buffer = static_cast<Buffer*>(transfer.buffer);
+                const vk::AccessFlags accessMask = getOwnershipTransferAccessMask(convertResourceState(transfer.state), queue);
+
+                bufferBarriers.push_back(vk::BufferMemoryBarrier()
+                    .setSrcAccessMask(release ? accessMask : vk::AccessFlags())
+                    .setDstAccessMask(release ? vk::AccessFlags() : accessMask)
+                    .setSrcQueueFamilyIndex(srcFamily)
+                    .setDstQueueFamilyIndex(dstFamily)
+                    .setBuffer(buffer->buffer)
+                    .setOffset(0)
+                    .setSize(buffer->desc.byteSize));
+
+                trackedCmdBuf.referencedResources.add(buffer);
+                continue;
+            }
+
+            Texture* texture = static_cast<Texture*>(transfer.texture);
+
+            const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+
+            vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
+            if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
+            if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
+            if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
+
+            auto addImageBarrier = [&](ResourceStates state, MipLevel mipLevel, MipLevel numMipLevels, ArraySlice arraySlice, ArraySlice numArraySlices)
+            {
+                const ResourceStateMapping mapping = convertResourceState(state);
+                const vk::AccessFlags accessMask = getOwnershipTransferAccessMask(mapping, queue);
+
+                imageBarriers.push_back(vk::ImageMemoryBarrier()
+                    .setSrcAccessMask(release ? accessMask : vk::AccessFlags())
+                    .setDstAccessMask(release ? vk::AccessFlags() : accessMask)
+                    .setOldLayout(mapping.imageLayout)
+                    .setNewLayout(mapping.imageLayout)
+                    .setSrcQueueFamilyIndex(srcFamily)
+                    .setDstQueueFamilyIndex(dstFamily)
+                    .setImage(texture->image)
+                    .setSubresourceRange(vk::ImageSubresourceRange()
+                        .setBaseMipLevel(mipLevel)
+                        .setLevelCount(numMipLevels)
+                        .setBaseArrayLayer(arraySlice)
+                        .setLayerCount(numArraySlices)
+                        .setAspectMask(aspectMask)));
+            };
+
+            if (transfer.subresourceStates.empty())
+            {
+                addImageBarrier(transfer.state, 0, texture->desc.mipLevels, 0, texture->desc.arraySize);
+            }
+            else
+            {
+                for (ArraySlice arraySlice = 0; arraySlice < texture->desc.arraySize; arraySlice++)
+                {
+                    for (MipLevel mipLevel = 0; mipLevel < texture->desc.mipLevels; mipLevel++)
+                    {
+                        const uint32_t subresource = mipLevel + arraySlice * texture->desc.mipLevels;
+                        addImageBarrier(transfer.subresourceStates[subresource], mipLevel, 1, arraySlice, 1);
+                    }
+                }
+            }
+
+            trackedCmdBuf.referencedResources.add(texture);
+        }
+
+        if (imageBarriers.empty() && bufferBarriers.empty())
+            return;
+
+        // The transfer keeps layouts, so the barriers only need to order against all prior or subsequent work
+        cmdBuf.pipelineBarrier(
+            release ? vk::PipelineStageFlagBits::eAllCommands : vk::PipelineStageFlagBits::eTopOfPipe,
+            release ? vk::PipelineStageFlagBits::eBottomOfPipe : vk::PipelineStageFlagBits::eAllCommands,
+            vk::DependencyFlags(), {}, bufferBarriers, imageBarriers);
+    }
+
+    TrackedCommandBufferPtr Device::submitQueueOwnershipReleases(const std::vector<QueueOwnershipTransfer>& transfers, CommandQueue dstQueue)
+    {
+        Queue& queue = *m_Queues[uint32_t(dstQueue)];
+        const uint32_t dstFamily = queue.getQueueFamilyIndex();
+
+        auto beginInfo = vk::CommandBufferBeginInfo()
+            .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+        TrackedCommandBufferPtr acquires = queue.getOrCreateCommandBuffer();
+        (void)acquires->cmdBuf.begin(&beginInfo);
+
+        for (uint32_t srcQueueIndex = 0; srcQueueIndex < uint32_t(CommandQueue::Count); srcQueueIndex++)
+        {
+            const CommandQueue srcQueue = CommandQueue(srcQueueIndex);
+            if (srcQueue == dstQueue || !m_Queues[srcQueueIndex])
+                continue;
+
+            const bool anyTransfers = std::any_of(transfers.begin(), transfers.end(),
+                [srcQueue](const QueueOwnershipTransfer& transfer) { return transfer.srcQueue == srcQueue; });
+
+            if (!anyTransfers)
+                continue;
+
+            Queue& sourceQueue = *m_Queues[srcQueueIndex];
+            const uint32_t srcFamily = sourceQueue.getQueueFamilyIndex();
+
+            TrackedCommandBufferPtr releases = sourceQueue.getOrCreateCommandBuffer();
+            (void)releases->cmdBuf.begin(&beginInfo);
+            recordOwnershipTransferBarriers(releases->cmdBuf, *releases, transfers, srcQueue, srcFamily, dstFamily, true);
+            releases->cmdBuf.end();
+
+            const uint64_t releaseID = sourceQueue.submitInternal(releases);
+            queue.addWaitSemaphore(sourceQueue.trackingSemaphore, releaseID);
+
+            recordOwnershipTransferBarriers(acquires->cmdBuf, *acquires, transfers, srcQueue, srcFamily, dstFamily, false);
+        }
+
+        acquires->cmdBuf.end();
+
+        return acquires;
+    }
+
 } // namespace nvrhi::vulkan
@@ -24,6 +24,7 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <nvrhi/common/tiling.h>
 
 namespace nvrhi::vulkan
 {
@@ -212,6 +213,9 @@ namespace nvrhi::vulkan
         if (d.isTypeless)
             flags |= vk::ImageCreateFlagBits::eMutableFormat | vk::ImageCreateFlagBits::eExtendedUsage;
 
+        if (d.isTiled)
+            flags |= vk::ImageCreateFlagBits::eSparseBinding | vk::ImageCreateFlagBits::eSparseResidency;
+
         return flags;
     }
 
@@ -335,7 +339,18 @@ namespace nvrhi::vulkan
 
         m_Context.nameVKObject(texture->image, vk::DebugReportObjectTypeEXT::eImage, desc.debugName.c_str());
 
-        if (!desc.isVirtual)
+        if (desc.isTiled)
+        {
+            const std::vector<vk::SparseImageMemoryRequirements> sparseRequirements = m_Context.device.getImageSparseMemoryRequirements(texture->image);
+
+            // Depth-stencil formats may report one entry per aspect, they share the tile layout
+            if (!sparseRequirements.empty())
+                texture->sparseRequirements = sparseRequirements[0];
+
+            // The sparse block size is the alignment of the image memory
+            texture->tileSize = m_Context.device.getImageMemoryRequirements(texture->image).alignment;
+        }
+        else if (!desc.isVirtual)
         {
             res = m_Allocator.allocateTextureMemory(texture);
             ASSERT_VK_OK(res);
@@ -387,6 +402,216 @@ namespace nvrhi::vulkan
         return true;
     }
 
+    void Device::getTextureTiling(ITexture* _texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        const vk::SparseImageMemoryRequirements& requirements = texture->sparseRequirements;
+        const vk::Extent3D& granularity = requirements.formatProperties.imageGranularity;
+        const uint32_t numStandardMips = std::min(requirements.imageMipTailFirstLod, texture->desc.mipLevels);
+        const vk::DeviceSize tileSize = texture->tileSize ? texture->tileSize : 1;
+
+        if (numTiles)
+        {
+            const vk::MemoryRequirements memoryRequirements = m_Context.device.getImageMemoryRequirements(texture->image);
+            *numTiles = uint32_t(memoryRequirements.size / tileSize);
+        }
+
+        if (desc)
+        {
+            desc->numStandardMips = numStandardMips;
+            desc->numPackedMips = texture->desc.mipLevels - numStandardMips;
+            desc->numTilesForPackedMips = uint32_t(requirements.imageMipTailSize / tileSize);
+            desc->startTileIndexInOverallResource = uint32_t(requirements.imageMipTailOffset / tileSize);
+        }
+
+        TileShape shape;
+        shape.widthInTexels = granularity.width;
+        shape.heightInTexels = granularity.height;
+        shape.depthInTexels = granularity.depth;
+
+        if (tileShape)
+            *tileShape = shape;
+
+        if (subresourceTilingsNum)
+        {
+            const uint32_t count = std::min(*subresourceTilingsNum, numStandardMips);
+            if (subresourceTilings)
+                computeSubresourceTilings(texture->desc, shape, count, subresourceTilings);
+            *subresourceTilingsNum = numStandardMips;
+        }
+    }
+
+    void Device::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (!texture->desc.isTiled)
+        {
+            m_Context.error("updateTextureTileMappings: the texture was not created with isTiled = true");
+            return;
+        }
+
+        if (!m_QueueSupportsSparseBinding[uint32_t(executionQueue)])
+        {
+            m_Context.error("updateTextureTileMappings: the execution queue doesn't support sparse binding");
+            return;
+        }
+
+        const vk::SparseImageMemoryRequirements& requirements = texture->sparseRequirements;
+        const vk::Extent3D& granularity = requirements.formatProperties.imageGranularity;
+        const bool singleMipTail = bool(requirements.formatProperties.flags & vk::SparseImageFormatFlagBits::eSingleMiptail);
+        const uint32_t numStandardMips = std::min(requirements.imageMipTailFirstLod, texture->desc.mipLevels);
+
+        TileShape tileShape;
+        tileShape.widthInTexels = granularity.width;
+        tileShape.heightInTexels = granularity.height;
+        tileShape.depthInTexels = granularity.depth;
+
+        const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+        vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
+        if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
+        if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
+        if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
+
+        PendingSparseBinds binds;
+        binds.texture = texture;
+
+        for (uint32_t mappingIndex = 0; mappingIndex < numTileMappings; ++mappingIndex)
+        {
+            const TextureTilesMapping& mapping = tileMappings[mappingIndex];
+            const vk::DeviceMemory memory = mapping.heap ? checked_cast<Heap*>(mapping.heap)->memory : vk::DeviceMemory();
+
+            // The bind is issued later, keep the new heap alive until then even if the app releases it
+            if (mapping.heap && (binds.heaps.empty() || binds.heaps.back() != mapping.heap))
+                binds.heaps.push_back(mapping.heap);
+
+            for (uint32_t regionIndex = 0; regionIndex < mapping.numTextureRegions; ++regionIndex)
+            {
+                const TiledTextureCoordinate& coordinate = mapping.tiledTextureCoordinates[regionIndex];
+                const TiledTextureRegion& region = mapping.tiledTextureRegions[regionIndex];
+                const vk::DeviceSize memoryOffset = mapping.heap ? mapping.byteOffsets[regionIndex] : 0;
+
+                if (coordinate.mipLevel >= numStandardMips)
+                {
+                    // With a single mip tail, all array slices share the one at imageMipTailOffset
+                    if (singleMipTail && coordinate.arrayLevel != 0)
+                        continue;
+
+                    texture->tileHeaps.map(coordinate, region, true, mapping.heap, &binds.heaps);
+
+                    binds.mipTailBinds.push_back(vk::SparseMemoryBind()
+                        .setResourceOffset(requirements.imageMipTailOffset + coordinate.arrayLevel * requirements.imageMipTailStride)
+                        .setSize(requirements.imageMipTailSize)
+                        .setMemory(memory)
+                        .setMemoryOffset(memoryOffset));
+
+                    continue;
+                }
+
+                texture->tileHeaps.map(coordinate, region, false, mapping.heap, &binds.heaps);
+
+                const TextureSlice texels = getTexelsForTiles(texture->desc, tileShape, coordinate, region);
+
+                binds.imageBinds.push_back(vk::SparseImageMemoryBind()
+                    .setSubresource(vk::ImageSubresource()
+                        .setAspectMask(aspectMask)
+                        .setMipLevel(coordinate.mipLevel)
+                        .setArrayLayer(coordinate.arrayLevel))
+                    .setOffset(vk::Offset3D(int32_t(texels.x), int32_t(texels.y), int32_t(texels.z)))
+                    .setExtent(vk::Extent3D(texels.width, texels.height, texels.depth))
+                    .setMemory(memory)
+                    .setMemoryOffset(memoryOffset));
+            }
+        }
+
+        if (binds.imageBinds.empty() && binds.mipTailBinds.empty())
+            return;
+
+        std::lock_guard lockGuard(m_SparseBindMutex);
+        m_PendingSparseBinds[uint32_t(executionQueue)].push_back(std::move(binds));
+    }
+
+    void Device::flushSparseBinds(CommandQueue queue)
+    {
+        std::vector<PendingSparseBinds> pendingBinds;
+        {
+            std::lock_guard lockGuard(m_SparseBindMutex);
+            pendingBinds = std::move(m_PendingSparseBinds[uint32_t(queue)]);
+            m_PendingSparseBinds[uint32_t(queue)].clear();
+        }
+
+        if (pendingBinds.empty())
+            return;
+
+        std::vector<vk::SparseImageMemoryBindInfo> imageBindInfos;
+        std::vector<vk::SparseImageOpaqueMemoryBindInfo> opaqueBindInfos;
+
+        for (const PendingSparseBinds& binds : pendingBinds)
+        {
+            const vk::Image image = checked_cast<Texture*>(binds.texture.Get())->image;
+
+            if (!binds.imageBinds.empty())
+            {
+                imageBindInfos.push_back(vk::SparseImageMemoryBindInfo()
+                    .setImage(image)
+                    .setBindCount(uint32_t(binds.imageBinds.size()))
+                    .setPBinds(binds.imageBinds.data()));
+            }
+
+            if (!binds.mipTailBinds.empty())
+            {
+                opaqueBindInfos.push_back(vk::SparseImageOpaqueMemoryBindInfo()
+                    .setImage(image)
+                    .setBindCount(uint32_t(binds.mipTailBinds.size()))
+                    .setPBinds(binds.mipTailBinds.data()));
+            }
+        }
+
+        auto bindInfo = vk::BindSparseInfo()
+            .setImageBindCount(uint32_t(imageBindInfos.size()))
+            .setPImageBinds(imageBindInfos.data())
+            .setImageOpaqueBindCount(uint32_t(opaqueBindInfos.size()))
+            .setPImageOpaqueBinds(opaqueBindInfos.data());
+
+        const uint64_t bindSubmissionID = m_Queues[uint32_t(queue)]->bindSparse(bindInfo);
+
+        // The heaps that were replaced can still be read by work submitted to any queue before the bind,
+        // and the new heaps are in use from now on. Hold all of them until that work and the bind are finished;
+        // the texture keeps the heaps it currently maps alive by itself.
+        RetiredSparseHeaps retired;
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); ++queueIndex)
+        {
+            if (m_Queues[queueIndex])
+                retired.submissionIDs[queueIndex] = m_Queues[queueIndex]->getLastSubmittedID();
+        }
+        retired.submissionIDs[uint32_t(queue)] = bindSubmissionID;
+
+        for (PendingSparseBinds& binds : pendingBinds)
+            retired.heaps.insert(retired.heaps.end(), std::make_move_iterator(binds.heaps.begin()), std::make_move_iterator(binds.heaps.end()));
+
+        std::lock_guard lockGuard(m_SparseBindMutex);
+        m_RetiredSparseHeaps.push_back(std::move(retired));
+    }
+
+    void Device::releaseRetiredSparseHeaps()
+    {
+        std::lock_guard lockGuard(m_SparseBindMutex);
+
+        CompletedSubmissionCache cache;
+        m_RetiredSparseHeaps.erase(std::remove_if(m_RetiredSparseHeaps.begin(), m_RetiredSparseHeaps.end(),
+            [this, &cache](const RetiredSparseHeaps& retired)
+            {
+                for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); ++queueIndex)
+                {
+                    const uint64_t submissionID = retired.submissionIDs[queueIndex];
+                    if (submissionID != 0 && !isSubmissionCompleted(CommandQueue(queueIndex), submissionID, cache))
+                        return false;
+                }
+                return true;
+            }), m_RetiredSparseHeaps.end());
+    }
+
     void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice,
                                   ITexture* _src, const TextureSlice& srcSlice)
     {
@@ -398,8 +623,8 @@ namespace nvrhi::vulkan
 
         assert(m_CurrentCmdBuf);
 
-        m_CurrentCmdBuf->referencedResources.push_back(dst);
-        m_CurrentCmdBuf->referencedResources.push_back(src);
+        m_CurrentCmdBuf->referencedResources.add(dst);
+        m_CurrentCmdBuf->referencedResources.add(src);
 
         TextureSubresourceSet srcSubresource = TextureSubresourceSet(
             resolvedSrcSlice.mipLevel, 1,
@@ -441,7 +666,7 @@ namespace nvrhi::vulkan
                             .setDstOffset(vk::Offset3D(resolvedDstSlice.x, resolvedDstSlice.y, resolvedDstSlice.z))
                             .setExtent(extent);
         
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
             requireTextureState(dst, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::CopyDest);
@@ -495,17 +720,8 @@ namespace nvrhi::vulkan
             MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false));
 
         size_t minRowPitch = std::min(size_t(deviceRowPitch), rowPitch);
-        uint8_t* mappedPtr = (uint8_t*)uploadCpuVA;
-        for (uint32_t slice = 0; slice < mipDepth; slice++)
-        {
-            const uint8_t* sourcePtr = (const uint8_t*)data + depthPitch * slice;
-            for (uint32_t row = 0; row < deviceNumRows; row++)
-            {
-                memcpy(mappedPtr, sourcePtr, minRowPitch);
-                mappedPtr += deviceRowPitch;
-                sourcePtr += rowPitch;
-            }
-        }
+        m_Context.taskDispatcher->copyRows(uploadCpuVA, deviceRowPitch, size_t(deviceRowPitch) * deviceNumRows,
+            data, rowPitch, depthPitch, minRowPitch, deviceNumRows, mipDepth);
 
         auto imageCopy = vk::BufferImageCopy()
             .setBufferOffset(uploadOffset)
@@ -520,13 +736,13 @@ namespace nvrhi::vulkan
 
         assert(m_CurrentCmdBuf);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
         }
         commitBarriers();
 
-        m_CurrentCmdBuf->referencedResources.push_back(dest);
+        m_CurrentCmdBuf->referencedResources.add(dest);
 
         m_CurrentCmdBuf->cmdBuf.copyBufferToImage(uploadBuffer->buffer,
             dest->image, vk::ImageLayout::eTransferDstOptimal,
@@ -565,7 +781,7 @@ namespace nvrhi::vulkan
                     std::max(dest->desc.depth >> dstLayers.mipLevel, 1u))));
         }
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireTextureState(src, srcSR, ResourceStates::ResolveSource);
             requireTextureState(dest, dstSR, ResourceStates::ResolveDest);
@@ -585,7 +801,7 @@ namespace nvrhi::vulkan
         
         subresources = subresources.resolve(texture->desc, false);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireTextureState(texture, subresources, ResourceStates::CopyDest);
         }
@@ -627,7 +843,7 @@ namespace nvrhi::vulkan
         
         subresources = subresources.resolve(texture->desc, false);
 
-        if (m_EnableAutomaticBarriers)
+        if (isTrackingResources())
         {
             requireTextureState(texture, subresources, ResourceStates::CopyDest);
         }
@@ -789,6 +1005,14 @@ namespace nvrhi::vulkan
     }
 
     SamplerHandle Device::createSampler(const SamplerDesc& desc)
+    {
+        return m_SamplerTable.findOrCreate(desc, [this, &desc]() -> SamplerHandle
+        {
+            return createSamplerInternal(desc);
+        });
+    }
+
+    SamplerHandle Device::createSamplerInternal(const SamplerDesc& desc)
     {
         Sampler *sampler = new Sampler(m_Context);
 
@@ -26,9 +26,17 @@
 namespace nvrhi::vulkan
 {
 
+    UploadManager::UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+        : m_Device(pParent)
+        , m_DefaultChunkSize(defaultChunkSize)
+        , m_MemoryLimit(memoryLimit)
+        , m_IsScratchBuffer(isScratchBuffer)
+        , m_ChunkPool(decltype(m_ChunkPool)::allocator_type(pParent->getAllocationTracker(), AllocationCategory::Upload))
+    { }
+
     std::shared_ptr<BufferChunk> UploadManager::CreateChunk(uint64_t size)
     {
-        std::shared_ptr<BufferChunk> chunk = std::make_shared<BufferChunk>();
+        std::shared_ptr<BufferChunk> chunk = make_tracked_shared<BufferChunk>(m_Device->getAllocationTracker(), AllocationCategory::Upload);
 
         if (m_IsScratchBuffer)
         {
@@ -52,6 +60,8 @@ namespace nvrhi::vulkan
             // The upload manager buffers are used in buildTopLevelAccelStruct to store instance data, and SBT for shader entries
             desc.isAccelStructBuildInput = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
             desc.isShaderBindingTable = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
+            // and in allocateIndirectArguments
+            desc.isDrawIndirectArgs = true;
 
             chunk->buffer = m_Device->createBuffer(desc);
             chunk->mappedMemory = m_Device->mapBuffer(chunk->buffer, CpuAccessMode::Write);
@@ -149,4 +159,109 @@ namespace nvrhi::vulkan
         }
     }
 
-}
\ No newline at end of file
+    bool PushConstantBufferPool::createPage()
+    {
+        if (m_NumPages >= c_MaxPages)
+            return false;
+
+        BufferDesc desc;
+        desc.byteSize = c_BlockSize * c_BlocksPerPage;
+        desc.cpuAccess = CpuAccessMode::Write;
+        desc.isConstantBuffer = true;
+        desc.debugName = "PushConstantBufferPool";
+
+        auto page = std::make_unique<Page>();
+        page->buffer = m_Device->createBuffer(desc);
+        if (!page->buffer)
+            return false;
+
+        page->mappedMemory = m_Device->mapBuffer(page->buffer, CpuAccessMode::Write);
+        if (!page->mappedMemory)
+            return false;
+
+        m_Pages[m_NumPages] = std::move(page);
+        ++m_NumPages;
+        return true;
+    }
+
+    Buffer* PushConstantBufferPool::getBuffer(uint32_t page)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_NumPages == 0)
+            createPage();
+
+        if (page >= m_NumPages)
+            return nullptr;
+
+        return checked_cast<Buffer*>(m_Pages[page]->buffer.Get());
+    }
+
+    char* PushConstantBufferPool::getBlockData(uint32_t block) const
+    {
+        const Page& page = *m_Pages[getBlockPage(block)];
+        return static_cast<char*>(page.mappedMemory) + getBlockOffset(block);
+    }
+
+    bool PushConstantBufferPool::allocateBlock(uint64_t currentVersion, uint32_t& outBlock)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_NumPages == 0 && !createPage())
+            return false;
+
+        // Read the completed instance of each queue at most once per search
+        std::array<uint64_t, uint32_t(CommandQueue::Count)> completedInstances{};
+        std::array<bool, uint32_t(CommandQueue::Count)> completedInstanceValid{};
+
+        const uint32_t numBlocks = m_NumPages * c_BlocksPerPage;
+
+        for (uint32_t searchIndex = 0; searchIndex < numBlocks; ++searchIndex)
+        {
+            const uint32_t block = (m_SearchStart + searchIndex) % numBlocks;
+            uint64_t& blockVersion = m_Pages[getBlockPage(block)]->blockVersions[block % c_BlocksPerPage];
+            const uint64_t version = blockVersion;
+
+            if (version != 0)
+            {
+                // Blocks in command lists that are recorded but not submitted yet stay in use
+                if (!VersionGetSubmitted(version))
+                    continue;
+
+                const uint32_t queueIndex = uint32_t(VersionGetQueue(version));
+                if (!completedInstanceValid[queueIndex])
+                {
+                    completedInstances[queueIndex] = m_Device->queueGetCompletedInstance(VersionGetQueue(version));
+                    completedInstanceValid[queueIndex] = true;
+                }
+
+                if (VersionGetInstance(version) > completedInstances[queueIndex])
+                    continue;
+            }
+
+            blockVersion = currentVersion;
+            m_SearchStart = (block + 1) % numBlocks;
+            outBlock = block;
+            return true;
+        }
+
+        // Every block is in flight, grow the pool by another page instead of failing the write
+        if (!createPage())
+            return false;
+
+        const uint32_t block = numBlocks;
+        m_Pages[getBlockPage(block)]->blockVersions[0] = currentVersion;
+        m_SearchStart = block + 1;
+        outBlock = block;
+        return true;
+    }
+
+    void PushConstantBufferPool::submitBlocks(const std::vector<uint32_t>& blocks, uint64_t submittedVersion)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (uint32_t block : blocks)
+            m_Pages[getBlockPage(block)]->blockVersions[block % c_BlocksPerPage] = submittedVersion;
+    }
+
+}
@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+// Measures creating and destroying small objects from several threads, with and without the slab pools.
+// Usage: benchmark-object-pool [iterations]
+// ctest runs it with a small iteration count to check that it works; the timings are only printed.
+
+#include "src/common/object-pool.h"
+#include "test-utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    // The same payload with and without pooling, about the size of a small binding set
+    struct PlainObject
+    {
+        uint64_t values[24] = {};
+    };
+
+    struct PoolObject : public PooledObject<PoolObject>
+    {
+        uint64_t values[24] = {};
+    };
+
+    constexpr uint32_t c_ObjectsPerBatch = 64;
+
+    // Every thread creates a batch of objects and destroys it, like per-frame transient binding sets and queries.
+    // Every other batch is destroyed by the next thread instead, like objects released by the thread that retires a frame.
+    template<typename T>
+    double run(uint32_t numThreads, uint32_t iterations)
+    {
+        std::vector<std::vector<T*>> handoff(numThreads);
+        std::vector<std::thread> threads;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t round = 0; round < 2; round++)
+        {
+            threads.clear();
+            for (uint32_t threadIndex = 0; threadIndex < numThreads; threadIndex++)
+            {
+                threads.emplace_back([&handoff, threadIndex, numThreads, iterations, round]()
+                {
+                    // The second round starts by releasing the objects that another thread created in the first one
+                    if (round == 1)
+                    {
+                        for (T* object : handoff[(threadIndex + 1) % numThreads])
+                            delete object;
+                    }
+
+                    std::vector<T*> batch;
+                    batch.reserve(c_ObjectsPerBatch);
+
+                    for (uint32_t iteration = 0; iteration < iterations; iteration++)
+                    {
+                        for (uint32_t index = 0; index < c_ObjectsPerBatch; index++)
+                            batch.push_back(new T());
+
+                        if (round == 0 && iteration % 2 == 0)
+                        {
+                            handoff[threadIndex].insert(handoff[threadIndex].end(), batch.begin(), batch.end());
+                        }
+                        else
+                        {
+                            for (T* object : batch)
+                                delete object;
+                        }
+                        batch.clear();
+                    }
+                });
+            }
+
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        const double operations = double(numThreads) * 2.0 * iterations * c_ObjectsPerBatch;
+        return std::chrono::duration<double, std::nano>(end - start).count() / operations;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t iterations = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 20000;
+    const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("%u iterations of %u objects per thread\n", iterations, c_ObjectsPerBatch);
+    std::printf("threads   new/delete ns   pooled ns   speedup\n");
+
+    for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        const double plain = run<PlainObject>(numThreads, iterations);
+        const double pooled = run<PoolObject>(numThreads, iterations);
+        NVRHI_CHECK(plain > 0.0 && pooled > 0.0);
+
+        std::printf("%7u   %13.1f   %9.1f   %6.2fx\n", numThreads, plain, pooled, plain / pooled);
+    }
+
+    return NVRHI_TEST_RESULT();
+}
@@ -0,0 +1,414 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/aftermath.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// A device and command list that record what is done with them, for testing the backend-independent
+// utilities without a GPU. Only the calls those utilities make do anything; everything else is a no-op.
+//
+// Submissions get increasing IDs per queue. Nothing completes on its own: tests advance the completed
+// submission of a queue with completeSubmissions, and waitEventQuery completes the work it waits for.
+
+namespace nvrhi::tests
+{
+    class FakeShader : public RefCounter<IShader>
+    {
+    public:
+        ShaderDesc desc;
+        std::string bytecode;
+
+        const ShaderDesc& getDesc() const override { return desc; }
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override
+        {
+            if (ppBytecode) *ppBytecode = bytecode.data();
+            if (pSize) *pSize = bytecode.size();
+        }
+    };
+
+    class FakeGraphicsPipeline : public RefCounter<IGraphicsPipeline>
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+
+        const GraphicsPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class FakeComputePipeline : public RefCounter<IComputePipeline>
+    {
+    public:
+        ComputePipelineDesc desc;
+
+        const ComputePipelineDesc& getDesc() const override { return desc; }
+    };
+
+    class FakeBuffer : public RefCounter<IBuffer>
+    {
+    public:
+        BufferDesc desc;
+
+        const BufferDesc& getDesc() const override { return desc; }
+    };
+
+    class FakeEventQuery : public RefCounter<IEventQuery>
+    {
+    public:
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t submissionID = 0;
+        bool set = false;
+    };
+
+    class MessageCounter : public IMessageCallback
+    {
+    public:
+        std::atomic<uint32_t> warnings = 0;
+        std::atomic<uint32_t> errors = 0;
+
+        void message(MessageSeverity severity, const char* messageText) override
+        {
+            (void)messageText;
+            if (severity == MessageSeverity::Warning)
+                ++warnings;
+            else if (severity == MessageSeverity::Error || severity == MessageSeverity::Fatal)
+                ++errors;
+        }
+    };
+
+    struct RecordedDraw
+    {
+        enum class Type { Draw, DrawIndexed, DrawIndirect, DrawIndexedIndirect };
+
+        Type type = Type::Draw;
+        DrawArguments args;      // direct draws
+        uint32_t offsetBytes = 0; // indirect draws
+        uint32_t drawCount = 0;
+        IBuffer* argumentBuffer = nullptr;
+    };
+
+    class FakeCommandList : public RefCounter<ICommandList>
+    {
+    public:
+        explicit FakeCommandList(IDevice* device, const CommandListParameters& params = CommandListParameters())
+            : m_Device(device)
+            , m_Desc(params)
+        { }
+
+        std::vector<RecordedDraw> draws;
+        uint32_t bufferWrites = 0;
+
+        // When set, allocateIndirectArguments hands out memory from this buffer
+        BufferHandle indirectArgumentBuffer;
+        std::vector<uint8_t> indirectArgumentMemory;
+
+        IDevice* getDevice() override { return m_Device; }
+        const CommandListParameters& getDesc() override { return m_Desc; }
+
+        IBuffer* allocateIndirectArguments(size_t byteSize, uint64_t* outOffset, void** outCpuAddress) override
+        {
+            if (!indirectArgumentBuffer)
+                return nullptr;
+
+            indirectArgumentMemory.resize(byteSize);
+            *outOffset = 0;
+            *outCpuAddress = indirectArgumentMemory.data();
+            return indirectArgumentBuffer;
+        }
+
+        void setGraphicsState(const GraphicsState& state) override { m_IndirectParams = state.indirectParams; }
+        void draw(const DrawArguments& args) override { record(RecordedDraw::Type::Draw, args, 0, 1); }
+        void drawIndexed(const DrawArguments& args) override { record(RecordedDraw::Type::DrawIndexed, args, 0, 1); }
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override { record(RecordedDraw::Type::DrawIndirect, DrawArguments(), offsetBytes, drawCount); }
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override { record(RecordedDraw::Type::DrawIndexedIndirect, DrawArguments(), offsetBytes, drawCount); }
+        void writeBuffer(IBuffer*, const void*, size_t, uint64_t) override { ++bufferWrites; }
+
+        void open() override { }
+        void close() override { }
+        void clearState() override { }
+        void clearTextureFloat(ITexture*, TextureSubresourceSet, const Color&) override { }
+        void clearDepthStencilTexture(ITexture*, TextureSubresourceSet, bool, float, bool, uint8_t) override { }
+        void clearTextureUInt(ITexture*, TextureSubresourceSet, uint32_t) override { }
+        void copyTexture(ITexture*, const TextureSlice&, ITexture*, const TextureSlice&) override { }
+        void copyTexture(IStagingTexture*, const TextureSlice&, ITexture*, const TextureSlice&) override { }
+        void copyTexture(ITexture*, const TextureSlice&, IStagingTexture*, const TextureSlice&) override { }
+        void writeTexture(ITexture*, uint32_t, uint32_t, const void*, size_t, size_t) override { }
+        void resolveTexture(ITexture*, const TextureSubresourceSet&, ITexture*, const TextureSubresourceSet&) override { }
+        void clearBufferUInt(IBuffer*, uint32_t) override { }
+        void copyBuffer(IBuffer*, uint64_t, IBuffer*, uint64_t, uint64_t) override { }
+        void setPushConstants(const void*, size_t) override { }
+        void drawIndirectCount(uint32_t, uint32_t, uint32_t) override { }
+        void drawIndexedIndirectCount(uint32_t, uint32_t, uint32_t) override { }
+        void setComputeState(const ComputeState&) override { }
+        void dispatch(uint32_t, uint32_t, uint32_t) override { }
+        void dispatchIndirect(uint32_t) override { }
+        void setMeshletState(const MeshletState&) override { }
+        void dispatchMesh(uint32_t, uint32_t, uint32_t) override { }
+        void dispatchMeshIndirectCount(uint32_t, uint32_t, uint32_t) override { }
+        void setRayTracingState(const rt::State&) override { }
+        void dispatchRays(const rt::DispatchRaysArguments&) override { }
+        void buildOpacityMicromap(rt::IOpacityMicromap*, const rt::OpacityMicromapDesc&) override { }
+        void buildBottomLevelAccelStruct(rt::IAccelStruct*, const rt::GeometryDesc*, size_t, rt::AccelStructBuildFlags) override { }
+        void compactBottomLevelAccelStructs() override { }
+        void buildTopLevelAccelStruct(rt::IAccelStruct*, const rt::InstanceDesc*, size_t, rt::AccelStructBuildFlags) override { }
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct*, IBuffer*, uint64_t, size_t, rt::AccelStructBuildFlags) override { }
+        void beginTimerQuery(ITimerQuery*) override { }
+        void endTimerQuery(ITimerQuery*) override { }
+        void beginMarker(const char*) override { }
+        void endMarker() override { }
+        void setEnableAutomaticBarriers(bool) override { }
+        void setResourceStatesForBindingSet(IBindingSet*) override { }
+        void setEnableUavBarriersForTexture(ITexture*, bool) override { }
+        void setEnableUavBarriersForBuffer(IBuffer*, bool) override { }
+        void beginTrackingTextureState(ITexture*, TextureSubresourceSet, ResourceStates) override { }
+        void beginTrackingBufferState(IBuffer*, ResourceStates) override { }
+        void setTextureState(ITexture*, TextureSubresourceSet, ResourceStates) override { }
+        void setBufferState(IBuffer*, ResourceStates) override { }
+        void setAccelStructState(rt::IAccelStruct*, ResourceStates) override { }
+        void setPermanentTextureState(ITexture*, ResourceStates) override { }
+        void setPermanentBufferState(IBuffer*, ResourceStates) override { }
+        void commitBarriers() override { }
+        ResourceStates getTextureSubresourceState(ITexture*, ArraySlice, MipLevel) override { return ResourceStates::Common; }
+        ResourceStates getBufferState(IBuffer*) override { return ResourceStates::Common; }
+
+    private:
+        IDevice* m_Device;
+        CommandListParameters m_Desc;
+        IBuffer* m_IndirectParams = nullptr;
+
+        void record(RecordedDraw::Type type, const DrawArguments& args, uint32_t offsetBytes, uint32_t drawCount)
+        {
+            RecordedDraw draw;
+            draw.type = type;
+            draw.args = args;
+            draw.offsetBytes = offsetBytes;
+            draw.drawCount = drawCount;
+            draw.argumentBuffer = m_IndirectParams;
+            draws.push_back(draw);
+        }
+    };
+
+    struct RecordedSubmission
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t submissionID = 0;
+        std::vector<ICommandList*> commandLists;
+    };
+
+    struct RecordedWait
+    {
+        CommandQueue waitQueue = CommandQueue::Graphics;
+        CommandQueue executionQueue = CommandQueue::Graphics;
+        uint64_t instance = 0;
+    };
+
+    // Shader binaries that start with "fail" are rejected like invalid bytecode would be
+    class FakeDevice : public RefCounter<IDevice>
+    {
+    public:
+        MessageCounter messageCallback;
+        AftermathCrashDumpHelper aftermathHelper;
+
+        std::atomic<uint32_t> shadersCreated = 0;
+        std::atomic<uint32_t> graphicsPipelinesCreated = 0;
+        std::atomic<uint32_t> computePipelinesCreated = 0;
+        uint32_t buffersCreated = 0;
+        bool failBufferCreation = false;
+        std::vector<Feature> supportedFeatures;
+        ITaskScheduler* taskScheduler = nullptr;
+
+        std::vector<RecordedSubmission> submissions;
+        std::vector<RecordedWait> waits;
+        std::array<uint64_t, size_t(CommandQueue::Count)> lastSubmittedID{};
+        std::array<uint64_t, size_t(CommandQueue::Count)> completedID{};
+        uint32_t eventQueriesCreated = 0;
+        uint32_t eventQueryWaits = 0;
+        uint32_t garbageCollections = 0;
+
+        // Marks the submissions up to and including the given one as finished on the GPU
+        void completeSubmissions(CommandQueue queue, uint64_t submissionID)
+        {
+            uint64_t& completed = completedID[size_t(queue)];
+            completed = std::max(completed, submissionID);
+        }
+
+        void completeAllSubmissions()
+        {
+            completedID = lastSubmittedID;
+        }
+
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue) override
+        {
+            RecordedSubmission submission;
+            submission.queue = executionQueue;
+            submission.submissionID = ++lastSubmittedID[size_t(executionQueue)];
+            submission.commandLists.assign(pCommandLists, pCommandLists + numCommandLists);
+            submissions.push_back(std::move(submission));
+            return lastSubmittedID[size_t(executionQueue)];
+        }
+
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override
+        {
+            waits.push_back(RecordedWait{ waitQueue, executionQueue, instance });
+        }
+
+        EventQueryHandle createEventQuery() override
+        {
+            ++eventQueriesCreated;
+            return EventQueryHandle::Create(new FakeEventQuery());
+        }
+
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override
+        {
+            FakeEventQuery* fakeQuery = static_cast<FakeEventQuery*>(query);
+            fakeQuery->queue = queue;
+            fakeQuery->submissionID = lastSubmittedID[size_t(queue)];
+            fakeQuery->set = true;
+        }
+
+        bool pollEventQuery(IEventQuery* query) override
+        {
+            const FakeEventQuery* fakeQuery = static_cast<const FakeEventQuery*>(query);
+            return fakeQuery->set && completedID[size_t(fakeQuery->queue)] >= fakeQuery->submissionID;
+        }
+
+        void waitEventQuery(IEventQuery* query) override
+        {
+            const FakeEventQuery* fakeQuery = static_cast<const FakeEventQuery*>(query);
+            ++eventQueryWaits;
+            completeSubmissions(fakeQuery->queue, fakeQuery->submissionID);
+        }
+
+        void resetEventQuery(IEventQuery* query) override
+        {
+            static_cast<FakeEventQuery*>(query)->set = false;
+        }
+
+        void runGarbageCollection() override { ++garbageCollections; }
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override
+        {
+            std::string bytecode(static_cast<const char*>(binary), binarySize);
+            if (bytecode.compare(0, 4, "fail") == 0)
+                return nullptr;
+
+            FakeShader* shader = new FakeShader();
+            shader->desc = d;
+            shader->bytecode = std::move(bytecode);
+            ++shadersCreated;
+            return ShaderHandle::Create(shader);
+        }
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer*) override
+        {
+            FakeGraphicsPipeline* pipeline = new FakeGraphicsPipeline();
+            pipeline->desc = desc;
+            ++graphicsPipelinesCreated;
+            return GraphicsPipelineHandle::Create(pipeline);
+        }
+
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override
+        {
+            FakeComputePipeline* pipeline = new FakeComputePipeline();
+            pipeline->desc = desc;
+            ++computePipelinesCreated;
+            return ComputePipelineHandle::Create(pipeline);
+        }
+
+        BufferHandle createBuffer(const BufferDesc& d) override
+        {
+            if (failBufferCreation)
+                return nullptr;
+
+            FakeBuffer* buffer = new FakeBuffer();
+            buffer->desc = d;
+            ++buffersCreated;
+            return BufferHandle::Create(buffer);
+        }
+
+        CommandListHandle createCommandList(const CommandListParameters& params) override
+        {
+            return CommandListHandle::Create(new FakeCommandList(this, params));
+        }
+
+        bool queryFeatureSupport(Feature feature, void*, size_t) override
+        {
+            return std::find(supportedFeatures.begin(), supportedFeatures.end(), feature) != supportedFeatures.end();
+        }
+
+        IMessageCallback* getMessageCallback() override { return &messageCallback; }
+        AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return aftermathHelper; }
+
+        HeapHandle createHeap(const HeapDesc&) override { return nullptr; }
+        TextureHandle createTexture(const TextureDesc&) override { return nullptr; }
+        MemoryRequirements getTextureMemoryRequirements(ITexture*) override { return MemoryRequirements(); }
+        bool bindTextureMemory(ITexture*, IHeap*, uint64_t) override { return false; }
+        void getTextureTiling(ITexture*, uint32_t*, PackedMipDesc*, TileShape*, uint32_t*, SubresourceTiling*) override { }
+        void updateTextureTileMappings(ITexture*, const TextureTilesMapping*, uint32_t, CommandQueue) override { }
+        TextureHandle createHandleForNativeTexture(ObjectType, Object, const TextureDesc&) override { return nullptr; }
+        StagingTextureHandle createStagingTexture(const TextureDesc&, CpuAccessMode) override { return nullptr; }
+        void* mapStagingTexture(IStagingTexture*, const TextureSlice&, CpuAccessMode, size_t*) override { return nullptr; }
+        void unmapStagingTexture(IStagingTexture*) override { }
+        void* mapBuffer(IBuffer*, CpuAccessMode) override { return nullptr; }
+        void unmapBuffer(IBuffer*) override { }
+        MemoryRequirements getBufferMemoryRequirements(IBuffer*) override { return MemoryRequirements(); }
+        bool bindBufferMemory(IBuffer*, IHeap*, uint64_t) override { return false; }
+        BufferHandle createHandleForNativeBuffer(ObjectType, Object, const BufferDesc&) override { return nullptr; }
+        ShaderHandle createShaderSpecialization(IShader*, const ShaderSpecialization*, uint32_t) override { return nullptr; }
+        ShaderLibraryHandle createShaderLibrary(const void*, size_t) override { return nullptr; }
+        SamplerHandle createSampler(const SamplerDesc&) override { return nullptr; }
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc*, uint32_t, IShader*) override { return nullptr; }
+        TimerQueryHandle createTimerQuery() override { return nullptr; }
+        bool pollTimerQuery(ITimerQuery*) override { return true; }
+        float getTimerQueryTime(ITimerQuery*) override { return 0.f; }
+        void resetTimerQuery(ITimerQuery*) override { }
+        GraphicsAPI getGraphicsAPI() override { return GraphicsAPI::VULKAN; }
+        FramebufferHandle createFramebuffer(const FramebufferDesc&) override { return nullptr; }
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc&, IFramebuffer*) override { return nullptr; }
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc&) override { return nullptr; }
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc&) override { return nullptr; }
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc&) override { return nullptr; }
+        BindingSetHandle createBindingSet(const BindingSetDesc&, IBindingLayout*) override { return nullptr; }
+        DescriptorTableHandle createDescriptorTable(IBindingLayout*) override { return nullptr; }
+        void resizeDescriptorTable(IDescriptorTable*, uint32_t, bool) override { }
+        bool writeDescriptorTable(IDescriptorTable*, const BindingSetItem&) override { return false; }
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc&) override { return nullptr; }
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc&) override { return nullptr; }
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct*) override { return MemoryRequirements(); }
+        bool bindAccelStructMemory(rt::IAccelStruct*, IHeap*, uint64_t) override { return false; }
+        bool waitForIdle() override { completeAllSubmissions(); return true; }
+        FormatSupport queryFormatSupport(Format) override { return FormatSupport::None; }
+        Object getNativeQueue(ObjectType, CommandQueue) override { return nullptr; }
+        bool isAftermathEnabled() override { return false; }
+        AllocationStatistics getAllocationStatistics() override { return AllocationStatistics(); }
+        ITaskScheduler* getTaskScheduler() override { return taskScheduler; }
+    };
+}
@@ -0,0 +1,278 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/aftermath.h>
+#include <nvrhi/common/breadcrumbs.h>
+#include "test-utils.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <vector>
+
+// Counts heap allocations so that the tests can check that pushEvent and popEvent don't allocate
+static size_t g_AllocationCount = 0;
+
+void* operator new(size_t size)
+{
+    ++g_AllocationCount;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+using namespace nvrhi;
+
+namespace
+{
+    // The marker tracker used to hash and store the std::filesystem::path of the event stack, the resolved strings must not change
+    struct ReferenceTracker
+    {
+        std::filesystem::path stack;
+
+        std::string push(const char* name)
+        {
+            stack.append(name);
+            return stack.generic_string();
+        }
+
+        void pop()
+        {
+            stack = stack.parent_path();
+        }
+    };
+
+    bool resolvesTo(AftermathMarkerTracker& tracker, size_t hash, const std::string& expected)
+    {
+        auto [found, string] = tracker.getEventString(hash);
+        return found && string.get() == expected;
+    }
+
+    void testResolvedStringsMatchPathOutput()
+    {
+        AftermathMarkerTracker tracker;
+        ReferenceTracker reference;
+
+        const std::vector<std::pair<const char*, int>> script = {
+            { "Frame", 1 }, { "Shadows", 1 }, { "Cascade 0", 1 }, { nullptr, -1 }, { "Cascade 1", 1 }, { nullptr, -1 }, { nullptr, -1 },
+            { "GBuffer", 1 }, { "Opaque", 1 }, { nullptr, -1 }, { "Alpha Tested", 1 }, { nullptr, -1 }, { nullptr, -1 },
+            { "Post", 1 }, { "Tonemap", 1 }, { nullptr, -1 }, { nullptr, -1 }, { nullptr, -1 }
+        };
+
+        for (const auto& [name, direction] : script)
+        {
+            if (direction < 0)
+            {
+                tracker.popEvent();
+                reference.pop();
+                continue;
+            }
+
+            const size_t hash = tracker.pushEvent(name);
+            NVRHI_CHECK(resolvesTo(tracker, hash, reference.push(name)));
+        }
+    }
+
+    void testSameStackProducesSameHash()
+    {
+        AftermathMarkerTracker tracker;
+
+        tracker.pushEvent("Frame");
+        const size_t first = tracker.pushEvent("Draw");
+        tracker.popEvent();
+        const size_t sibling = tracker.pushEvent("Dispatch");
+        tracker.popEvent();
+        const size_t second = tracker.pushEvent("Draw");
+        tracker.popEvent();
+        tracker.popEvent();
+
+        NVRHI_CHECK(first == second);
+        NVRHI_CHECK(first != sibling);
+
+        // The same name at a different depth is a different event
+        const size_t topLevel = tracker.pushEvent("Draw");
+        NVRHI_CHECK(topLevel != first);
+        NVRHI_CHECK(resolvesTo(tracker, topLevel, "Draw"));
+        NVRHI_CHECK(resolvesTo(tracker, first, "Frame/Draw"));
+        NVRHI_CHECK(resolvesTo(tracker, sibling, "Frame/Dispatch"));
+    }
+
+    void testPushAndPopDontAllocate()
+    {
+        AftermathMarkerTracker tracker;
+        char frameName[16];
+
+        auto runFrame = [&](int frameIndex)
+        {
+            // A unique short name per frame, like apps that append the frame number
+            std::snprintf(frameName, sizeof(frameName), "Frame %d", frameIndex);
+            tracker.pushEvent(frameName);
+            for (int pass = 0; pass < 8; pass++)
+            {
+                tracker.pushEvent("Render Pass");
+                tracker.pushEvent("Draw Opaque Geometry With A Long Marker Name");
+                tracker.popEvent();
+                tracker.popEvent();
+            }
+            tracker.popEvent();
+        };
+
+        runFrame(0);
+
+        const size_t allocationsBefore = g_AllocationCount;
+        for (int frameIndex = 1; frameIndex < 1000; frameIndex++)
+            runFrame(frameIndex);
+
+        NVRHI_CHECK_EQUAL(g_AllocationCount - allocationsBefore, 0u);
+    }
+
+    void testStoredEventsAreBounded()
+    {
+        AftermathMarkerTracker tracker;
+        std::vector<size_t> hashes;
+
+        for (int index = 0; index < 1000; index++)
+        {
+            const std::string name = "Unique marker " + std::to_string(index);
+            hashes.push_back(tracker.pushEvent(name.c_str()));
+            tracker.popEvent();
+        }
+
+        // The most recent event is always resolvable, older ones are evicted by the fixed-capacity ring
+        NVRHI_CHECK(resolvesTo(tracker, hashes.back(), "Unique marker 999"));
+
+        size_t resolvable = 0;
+        for (size_t index = 0; index < hashes.size(); index++)
+        {
+            auto [found, string] = tracker.getEventString(hashes[index]);
+            if (found)
+            {
+                ++resolvable;
+                NVRHI_CHECK(string.get() == "Unique marker " + std::to_string(index));
+            }
+        }
+        NVRHI_CHECK(resolvable > 0);
+        NVRHI_CHECK(resolvable <= 128);
+    }
+
+    void testUnknownHashIsNotResolved()
+    {
+        AftermathMarkerTracker tracker;
+        const size_t hash = tracker.pushEvent("Frame");
+
+        NVRHI_CHECK(!tracker.getEventString(hash + 1).first);
+        NVRHI_CHECK(!tracker.getEventString(0).first);
+    }
+
+    void testDeepStacks()
+    {
+        AftermathMarkerTracker tracker;
+        std::string expected;
+        size_t hash = 0;
+
+        for (int level = 0; level < 40; level++)
+        {
+            const std::string name = "Level " + std::to_string(level);
+            if (!expected.empty())
+                expected += '/';
+            expected += name;
+
+            hash = tracker.pushEvent(name.c_str());
+            // Events deeper than the record capacity are not resolvable, but must not break the stack
+            if (level < 32)
+                NVRHI_CHECK(resolvesTo(tracker, hash, expected));
+        }
+
+        for (int level = 0; level < 40; level++)
+            tracker.popEvent();
+
+        // Popping more than was pushed is ignored
+        tracker.popEvent();
+
+        const size_t topLevel = tracker.pushEvent("Level 0");
+        NVRHI_CHECK(resolvesTo(tracker, topLevel, "Level 0"));
+    }
+
+    void testBreadcrumbLookup()
+    {
+        AftermathMarkerTracker tracker;
+        tracker.pushEvent("Frame");
+        const size_t hash = tracker.pushEvent("Lighting");
+
+        auto [found, string] = tracker.getEventStringByBreadcrumbID(BreadcrumbEncoder::getMarkerID(hash));
+        NVRHI_CHECK(found);
+        NVRHI_CHECK(string.get() == "Frame/Lighting");
+    }
+
+    void testDestroyedTrackersStillResolve()
+    {
+        AftermathCrashDumpHelper helper;
+        AftermathMarkerTracker tracker;
+        helper.registerAftermathMarkerTracker(&tracker);
+
+        tracker.pushEvent("Frame");
+        const size_t hash = tracker.pushEvent("Compute");
+
+        {
+            auto [found, string] = helper.ResolveMarker(hash);
+            NVRHI_CHECK(found);
+            NVRHI_CHECK(string.get() == "Frame/Compute");
+        }
+
+        // The helper keeps a copy of the tracker after it is unregistered
+        helper.unRegisterAftermathMarkerTracker(&tracker);
+        tracker.popEvent();
+        tracker.popEvent();
+
+        {
+            auto [found, string] = helper.ResolveMarker(hash);
+            NVRHI_CHECK(found);
+            NVRHI_CHECK(string.get() == "Frame/Compute");
+        }
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testResolvedStringsMatchPathOutput);
+    NVRHI_RUN_TEST(testSameStackProducesSameHash);
+    NVRHI_RUN_TEST(testPushAndPopDontAllocate);
+    NVRHI_RUN_TEST(testStoredEventsAreBounded);
+    NVRHI_RUN_TEST(testUnknownHashIsNotResolved);
+    NVRHI_RUN_TEST(testDeepStacks);
+    NVRHI_RUN_TEST(testBreadcrumbLookup);
+    NVRHI_RUN_TEST(testDestroyedTrackersStillResolve);
+
+    return NVRHI_TEST_RESULT();
+}
@@ -0,0 +1,182 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "src/common/allocator.h"
+#include "src/common/interning.h"
+#include "src/common/state-tracking.h"
+#include "fake-device.h"
+#include "test-utils.h"
+
+using namespace nvrhi;
+
+namespace
+{
+    // Counts the live allocations per category and checks that deallocate gets what allocate returned
+    class CountingAllocator : public IAllocator
+    {
+    public:
+        int liveAllocations[size_t(AllocationCategory::Count)] = {};
+        bool mismatchedFree = false;
+
+        void* allocate(size_t size, size_t alignment, AllocationCategory category) override
+        {
+            ++liveAllocations[size_t(category)];
+            (void)alignment;
+            return ::operator new(size);
+        }
+
+        void deallocate(void* pointer, size_t size, size_t alignment, AllocationCategory category) override
+        {
+            if (liveAllocations[size_t(category)] <= 0)
+                mismatchedFree = true;
+            --liveAllocations[size_t(category)];
+            (void)size;
+            (void)alignment;
+            ::operator delete(pointer);
+        }
+    };
+
+    class TestObject : public RefCounter<IResource>
+    {
+    };
+
+    typedef RefCountPtr<TestObject> TestObjectHandle;
+
+    void testTrackedContainersCountBytes()
+    {
+        CountingAllocator allocator;
+        AllocationTracker tracker(&allocator);
+
+        {
+            tracked_vector<uint64_t> vector(TrackedAllocator<uint64_t>(&tracker, AllocationCategory::StateTracking));
+            vector.resize(100);
+
+            NVRHI_CHECK(tracker.getStatistics().getBytesInUse(AllocationCategory::StateTracking) >= 100 * sizeof(uint64_t));
+            NVRHI_CHECK_EQUAL(tracker.getStatistics().getBytesInUse(AllocationCategory::Caches), 0);
+            NVRHI_CHECK(allocator.liveAllocations[size_t(AllocationCategory::StateTracking)] > 0);
+        }
+
+        NVRHI_CHECK_EQUAL(tracker.getStatistics().getTotalBytesInUse(), 0);
+        NVRHI_CHECK_EQUAL(allocator.liveAllocations[size_t(AllocationCategory::StateTracking)], 0);
+        NVRHI_CHECK(!allocator.mismatchedFree);
+    }
+
+    void testUntrackedContainersUseGlobalHeap()
+    {
+        tracked_unordered_map<int, int> map;
+        map[1] = 2;
+
+        NVRHI_CHECK(map.get_allocator().getTracker() == nullptr);
+        NVRHI_CHECK_EQUAL(map[1], 2);
+    }
+
+    void testAllocatorsCompareTrackerAndCategory()
+    {
+        AllocationTracker tracker;
+        AllocationTracker otherTracker;
+
+        TrackedAllocator<int> stateTracking(&tracker, AllocationCategory::StateTracking);
+        NVRHI_CHECK(stateTracking == TrackedAllocator<int>(&tracker, AllocationCategory::StateTracking));
+        NVRHI_CHECK(stateTracking == TrackedAllocator<char>(stateTracking));
+        NVRHI_CHECK(stateTracking != TrackedAllocator<int>(&tracker, AllocationCategory::Caches));
+        NVRHI_CHECK(stateTracking != TrackedAllocator<int>(&otherTracker, AllocationCategory::StateTracking));
+    }
+
+    void testResourceStatesAreTracked()
+    {
+        CountingAllocator allocator;
+        AllocationTracker tracker(&allocator);
+        tests::MessageCounter messageCallback;
+
+        TextureDesc desc;
+        desc.dimension = TextureDimension::Texture2DArray;
+        desc.mipLevels = 4;
+        desc.arraySize = 64;
+        desc.initialState = ResourceStates::ShaderResource;
+        desc.keepInitialState = true;
+        TextureStateExtension texture(desc);
+
+        {
+            CommandListResourceStateTracker stateTracker(&messageCallback, &tracker);
+
+            // Transitioning one subresource makes the tracker keep the state of each of them
+            stateTracker.requireTextureState(&texture, TextureSubresourceSet(0, 1, 0, 1), ResourceStates::UnorderedAccess);
+
+            const uint64_t subresourceStateBytes = desc.mipLevels * desc.arraySize * sizeof(ResourceStates);
+            NVRHI_CHECK(tracker.getStatistics().getBytesInUse(AllocationCategory::StateTracking) >= subresourceStateBytes);
+        }
+
+        NVRHI_CHECK_EQUAL(tracker.getStatistics().getTotalBytesInUse(), 0);
+        NVRHI_CHECK_EQUAL(allocator.liveAllocations[size_t(AllocationCategory::StateTracking)], 0);
+        NVRHI_CHECK(!allocator.mismatchedFree);
+        NVRHI_CHECK_EQUAL(messageCallback.errors.load(), 0u);
+    }
+
+    void testSharedObjectsAreTracked()
+    {
+        AllocationTracker tracker;
+
+        std::shared_ptr<uint64_t> value = make_tracked_shared<uint64_t>(&tracker, AllocationCategory::Upload, 42);
+        NVRHI_CHECK(tracker.getStatistics().getBytesInUse(AllocationCategory::Upload) >= sizeof(uint64_t));
+
+        value.reset();
+        NVRHI_CHECK_EQUAL(tracker.getStatistics().getBytesInUse(AllocationCategory::Upload), 0);
+    }
+
+    void testInterningTableIsTrackedAsCache()
+    {
+        CountingAllocator allocator;
+        AllocationTracker tracker(&allocator);
+
+        {
+            InterningTable<int, TestObjectHandle> table(&tracker);
+
+            TestObjectHandle first = table.findOrCreate(1, []() { return TestObjectHandle::Create(new TestObject()); });
+            TestObjectHandle second = table.findOrCreate(2, []() { return TestObjectHandle::Create(new TestObject()); });
+            NVRHI_CHECK(tracker.getStatistics().getBytesInUse(AllocationCategory::Caches) > 0);
+
+            // Entries are released once only the table references them
+            first = nullptr;
+            second = nullptr;
+            NVRHI_CHECK_EQUAL(table.collectUnused(), 2);
+            NVRHI_CHECK_EQUAL(table.getStatistics().numObjects, 0);
+        }
+
+        NVRHI_CHECK_EQUAL(tracker.getStatistics().getTotalBytesInUse(), 0);
+        NVRHI_CHECK_EQUAL(allocator.liveAllocations[size_t(AllocationCategory::Caches)], 0);
+        NVRHI_CHECK(!allocator.mismatchedFree);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testTrackedContainersCountBytes);
+    NVRHI_RUN_TEST(testUntrackedContainersUseGlobalHeap);
+    NVRHI_RUN_TEST(testAllocatorsCompareTrackerAndCategory);
+    NVRHI_RUN_TEST(testResourceStatesAreTracked);
+    NVRHI_RUN_TEST(testSharedObjectsAreTracked);
+    NVRHI_RUN_TEST(testInterningTableIsTrackedAsCache);
+
+    return NVRHI_TEST_RESULT();
+}
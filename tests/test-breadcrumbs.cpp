@@ -0,0 +1,255 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/breadcrumbs.h>
+#include "test-utils.h"
+
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    // Applies the writes the way the GPU would, in order, to a CPU copy of the breadcrumb buffer
+    void applyWrites(std::vector<uint32_t>& buffer, const BreadcrumbWrites& writes)
+    {
+        for (const BreadcrumbWrite& write : writes)
+        {
+            NVRHI_CHECK(write.offset % sizeof(uint32_t) == 0);
+            NVRHI_CHECK(write.size % sizeof(uint32_t) == 0);
+            NVRHI_CHECK(write.offset + write.size <= buffer.size() * sizeof(uint32_t));
+
+            for (uint32_t word = write.offset / 4; word < (write.offset + write.size) / 4; word++)
+                buffer[word] = write.value;
+        }
+    }
+
+    bool overlap(const BreadcrumbWrite& a, const BreadcrumbWrite& b)
+    {
+        return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+    }
+
+    std::vector<BreadcrumbCommandList> decode(const std::vector<uint32_t>& buffer)
+    {
+        std::vector<BreadcrumbCommandList> result;
+        decodeBreadcrumbs(buffer.data(), buffer.size(), result);
+        return result;
+    }
+
+    void testBeginClearsSlotWithoutOverlappingWrites()
+    {
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords * 2, 0xdeadbeef);
+
+        BreadcrumbEncoder encoder;
+        const BreadcrumbWrites writes = encoder.begin(1, 42);
+
+        for (size_t i = 0; i < writes.size(); i++)
+            for (size_t j = i + 1; j < writes.size(); j++)
+                NVRHI_CHECK(!overlap(writes[i], writes[j]));
+
+        applyWrites(buffer, writes);
+
+        // Slot 0 is untouched, slot 1 holds the ID followed by zeros
+        NVRHI_CHECK_EQUAL(buffer[0], 0xdeadbeefu);
+        NVRHI_CHECK_EQUAL(buffer[c_BreadcrumbSlotWords], 42u);
+        for (uint32_t word = 1; word < c_BreadcrumbSlotWords; word++)
+            NVRHI_CHECK_EQUAL(buffer[c_BreadcrumbSlotWords + word], 0u);
+    }
+
+    void testNestedScopes()
+    {
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords, 0);
+
+        BreadcrumbEncoder encoder;
+        applyWrites(buffer, encoder.begin(0, 7));
+        applyWrites(buffer, encoder.pushMarker(100));
+        applyWrites(buffer, encoder.pushMarker(200));
+        applyWrites(buffer, encoder.popMarker());
+
+        auto commandLists = decode(buffer);
+        NVRHI_CHECK_EQUAL(commandLists.size(), size_t(1));
+        if (commandLists.size() != 1)
+            return;
+
+        NVRHI_CHECK_EQUAL(commandLists[0].commandListID, 7u);
+        NVRHI_CHECK(!commandLists[0].finished);
+        NVRHI_CHECK_EQUAL(commandLists[0].scopes.size(), size_t(2));
+        if (commandLists[0].scopes.size() != 2)
+            return;
+
+        NVRHI_CHECK_EQUAL(commandLists[0].scopes[0].markerID, BreadcrumbEncoder::getMarkerID(100));
+        NVRHI_CHECK(!commandLists[0].scopes[0].finished);
+        NVRHI_CHECK_EQUAL(commandLists[0].scopes[1].markerID, BreadcrumbEncoder::getMarkerID(200));
+        NVRHI_CHECK(commandLists[0].scopes[1].finished);
+
+        applyWrites(buffer, encoder.popMarker());
+        applyWrites(buffer, encoder.end());
+
+        commandLists = decode(buffer);
+        NVRHI_CHECK_EQUAL(commandLists.size(), size_t(1));
+        if (commandLists.size() != 1)
+            return;
+
+        NVRHI_CHECK(commandLists[0].finished);
+        NVRHI_CHECK_EQUAL(commandLists[0].scopes.size(), size_t(1));
+        if (!commandLists[0].scopes.empty())
+            NVRHI_CHECK(commandLists[0].scopes[0].finished);
+    }
+
+    void testSiblingScopeResetsEndWord()
+    {
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords, 0);
+
+        // Two scopes with the same name at the same depth: the second one must not look finished
+        BreadcrumbEncoder encoder;
+        applyWrites(buffer, encoder.begin(0, 1));
+        applyWrites(buffer, encoder.pushMarker(5));
+        applyWrites(buffer, encoder.popMarker());
+        applyWrites(buffer, encoder.pushMarker(5));
+
+        const auto commandLists = decode(buffer);
+        NVRHI_CHECK_EQUAL(commandLists.size(), size_t(1));
+        if (commandLists.size() == 1 && commandLists[0].scopes.size() == 1)
+            NVRHI_CHECK(!commandLists[0].scopes[0].finished);
+        else
+            NVRHI_CHECK(false);
+    }
+
+    void testSlotReuseDropsOldScopes()
+    {
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords, 0);
+
+        BreadcrumbEncoder first;
+        applyWrites(buffer, first.begin(0, 1));
+        applyWrites(buffer, first.pushMarker(10));
+        applyWrites(buffer, first.pushMarker(20));
+
+        BreadcrumbEncoder second;
+        applyWrites(buffer, second.begin(0, 2));
+
+        const auto commandLists = decode(buffer);
+        NVRHI_CHECK_EQUAL(commandLists.size(), size_t(1));
+        if (commandLists.size() != 1)
+            return;
+
+        NVRHI_CHECK_EQUAL(commandLists[0].commandListID, 2u);
+        NVRHI_CHECK(commandLists[0].scopes.empty());
+    }
+
+    void testDepthOverflow()
+    {
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords, 0);
+
+        BreadcrumbEncoder encoder;
+        applyWrites(buffer, encoder.begin(0, 3));
+        for (uint32_t depth = 0; depth < c_BreadcrumbMaxDepth; depth++)
+            applyWrites(buffer, encoder.pushMarker(1000 + depth));
+
+        // Scopes past the maximum depth are not recorded, but they still have to be balanced
+        NVRHI_CHECK(encoder.pushMarker(1).empty());
+        NVRHI_CHECK(encoder.popMarker().empty());
+
+        applyWrites(buffer, encoder.popMarker());
+
+        const auto commandLists = decode(buffer);
+        NVRHI_CHECK_EQUAL(commandLists.size(), size_t(1));
+        if (commandLists.size() != 1)
+            return;
+
+        NVRHI_CHECK_EQUAL(commandLists[0].scopes.size(), size_t(c_BreadcrumbMaxDepth));
+        if (commandLists[0].scopes.size() == c_BreadcrumbMaxDepth)
+        {
+            NVRHI_CHECK(!commandLists[0].scopes[c_BreadcrumbMaxDepth - 2].finished);
+            NVRHI_CHECK(commandLists[0].scopes[c_BreadcrumbMaxDepth - 1].finished);
+        }
+
+        // Unbalanced pops are ignored
+        BreadcrumbEncoder empty;
+        empty.begin(0, 1);
+        NVRHI_CHECK(empty.popMarker().empty());
+    }
+
+    void testDecodeSkipsUnusedSlots()
+    {
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords * 3, 0);
+
+        BreadcrumbEncoder encoder;
+        applyWrites(buffer, encoder.begin(2, 9));
+        applyWrites(buffer, encoder.end());
+
+        const auto commandLists = decode(buffer);
+        NVRHI_CHECK_EQUAL(commandLists.size(), size_t(1));
+        if (commandLists.size() == 1)
+        {
+            NVRHI_CHECK_EQUAL(commandLists[0].commandListID, 9u);
+            NVRHI_CHECK(commandLists[0].finished);
+        }
+
+        // A partial slot at the end of the data is ignored
+        std::vector<BreadcrumbCommandList> partial;
+        decodeBreadcrumbs(buffer.data(), c_BreadcrumbSlotWords - 1, partial);
+        NVRHI_CHECK(partial.empty());
+    }
+
+    void testMarkerIDs()
+    {
+        NVRHI_CHECK(BreadcrumbEncoder::getMarkerID(0) != 0);
+        NVRHI_CHECK_EQUAL(BreadcrumbEncoder::getMarkerID(12345), BreadcrumbEncoder::getMarkerID(12345));
+
+        // Command list ID 0 would mark the slot as unused
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords, 0);
+        BreadcrumbEncoder encoder;
+        applyWrites(buffer, encoder.begin(0, 0));
+        NVRHI_CHECK_EQUAL(decode(buffer).size(), size_t(1));
+    }
+
+    void testFormat()
+    {
+        std::vector<uint32_t> buffer(c_BreadcrumbSlotWords, 0);
+
+        BreadcrumbEncoder encoder;
+        applyWrites(buffer, encoder.begin(0, 4));
+        applyWrites(buffer, encoder.pushMarker(77));
+
+        const std::string text = formatBreadcrumbs(decode(buffer), [](uint32_t markerID)
+        {
+            return markerID == BreadcrumbEncoder::getMarkerID(77) ? std::string("Shadows") : std::string();
+        });
+
+        NVRHI_CHECK(text == "Command list 4: not finished\n    Shadows (in progress)\n");
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testBeginClearsSlotWithoutOverlappingWrites);
+    NVRHI_RUN_TEST(testNestedScopes);
+    NVRHI_RUN_TEST(testSiblingScopeResetsEndWord);
+    NVRHI_RUN_TEST(testSlotReuseDropsOldScopes);
+    NVRHI_RUN_TEST(testDepthOverflow);
+    NVRHI_RUN_TEST(testDecodeSkipsUnusedSlots);
+    NVRHI_RUN_TEST(testMarkerIDs);
+    NVRHI_RUN_TEST(testFormat);
+
+    return NVRHI_TEST_RESULT();
+}
@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "src/common/content-hash.h"
+#include "test-utils.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    void testKnownValues()
+    {
+        // Reference values of MurmurHash3 x64_128 with seed 0
+        const ContentHash empty = hashContents(nullptr, 0);
+        NVRHI_CHECK(empty.low == 0 && empty.high == 0);
+
+        const ContentHash hello = hashContents("hello", 5);
+        NVRHI_CHECK(hello.low == 0xcbd8a7b341bd9b02ull);
+        NVRHI_CHECK(hello.high == 0x5b1e906a48ae1d19ull);
+    }
+
+    void testEveryByteMatters()
+    {
+        std::vector<char> data(1000);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = char(i * 7);
+
+        const ContentHash original = hashContents(data.data(), data.size());
+        NVRHI_CHECK(hashContents(data.data(), data.size() - 1) != original);
+
+        // Flip one bit in each position of the 16-byte blocks and of the tail
+        for (size_t i : { size_t(0), size_t(8), size_t(15), size_t(500), size_t(993), size_t(999) })
+        {
+            data[i] ^= 1;
+            NVRHI_CHECK(hashContents(data.data(), data.size()) != original);
+            data[i] ^= 1;
+        }
+
+        NVRHI_CHECK(hashContents(data.data(), data.size()) == original);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testKnownValues);
+    NVRHI_RUN_TEST(testEveryByteMatters);
+
+    return NVRHI_TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/draw-batcher.h>
+#include "fake-device.h"
+#include "test-utils.h"
+
+using namespace nvrhi;
+
+namespace
+{
+    using tests::FakeCommandList;
+    using tests::FakeDevice;
+    using tests::RecordedDraw;
+
+    DrawArguments makeDraw(uint32_t index)
+    {
+        DrawArguments args;
+        args.vertexCount = 3;
+        args.startVertexLocation = index * 3;
+        return args;
+    }
+
+    void recordDraws(DrawBatcher& batcher, ICommandList* commandList, uint32_t count, bool indexed = false)
+    {
+        batcher.begin(commandList);
+        batcher.setGraphicsState(GraphicsState());
+        for (uint32_t index = 0; index < count; index++)
+        {
+            if (indexed)
+                batcher.drawIndexed(makeDraw(index));
+            else
+                batcher.draw(makeDraw(index));
+        }
+        batcher.end();
+    }
+
+    void testDrawsAreMergedWithMultiDrawIndirect()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        device->supportedFeatures.push_back(Feature::MultiDrawIndirect);
+
+        RefCountPtr<FakeCommandList> commandList = RefCountPtr<FakeCommandList>::Create(new FakeCommandList(device));
+        commandList->indirectArgumentBuffer = device->createBuffer(BufferDesc());
+
+        DrawBatcher batcher(device);
+        recordDraws(batcher, commandList, 5);
+
+        NVRHI_CHECK_EQUAL(commandList->draws.size(), 1u);
+        NVRHI_CHECK(commandList->draws[0].type == RecordedDraw::Type::DrawIndirect);
+        NVRHI_CHECK_EQUAL(commandList->draws[0].drawCount, 5u);
+        NVRHI_CHECK(commandList->draws[0].argumentBuffer == commandList->indirectArgumentBuffer.Get());
+        NVRHI_CHECK_EQUAL(batcher.getStatistics().draws, 5u);
+        NVRHI_CHECK_EQUAL(batcher.getStatistics().indirectCalls, 1u);
+        NVRHI_CHECK_EQUAL(batcher.getStatistics().directCalls, 0u);
+    }
+
+    void testDrawsAreSplitWithoutMultiDrawIndirect()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+
+        RefCountPtr<FakeCommandList> commandList = RefCountPtr<FakeCommandList>::Create(new FakeCommandList(device));
+        commandList->indirectArgumentBuffer = device->createBuffer(BufferDesc());
+
+        DrawBatcher batcher(device);
+        recordDraws(batcher, commandList, 4);
+        recordDraws(batcher, commandList, 3, true);
+
+        // The arguments are still uploaded together, each call picks its own record
+        NVRHI_CHECK_EQUAL(commandList->draws.size(), 7u);
+        for (uint32_t index = 0; index < 4; index++)
+        {
+            const RecordedDraw& draw = commandList->draws[index];
+            NVRHI_CHECK(draw.type == RecordedDraw::Type::DrawIndirect);
+            NVRHI_CHECK_EQUAL(draw.drawCount, 1u);
+            NVRHI_CHECK_EQUAL(draw.offsetBytes, uint32_t(index * sizeof(DrawIndirectArguments)));
+        }
+        for (uint32_t index = 0; index < 3; index++)
+        {
+            const RecordedDraw& draw = commandList->draws[4 + index];
+            NVRHI_CHECK(draw.type == RecordedDraw::Type::DrawIndexedIndirect);
+            NVRHI_CHECK_EQUAL(draw.drawCount, 1u);
+            NVRHI_CHECK_EQUAL(draw.offsetBytes, uint32_t(index * sizeof(DrawIndexedIndirectArguments)));
+        }
+        NVRHI_CHECK_EQUAL(batcher.getStatistics().indirectCalls, 7u);
+    }
+
+    void testArgumentsAreStagedInOwnBuffers()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        device->supportedFeatures.push_back(Feature::MultiDrawIndirect);
+
+        // No upload memory for indirect arguments: the batcher writes them into its own buffer
+        RefCountPtr<FakeCommandList> commandList = RefCountPtr<FakeCommandList>::Create(new FakeCommandList(device));
+
+        DrawBatcher batcher(device);
+        recordDraws(batcher, commandList, 5);
+
+        NVRHI_CHECK_EQUAL(device->buffersCreated, 1u);
+        NVRHI_CHECK_EQUAL(commandList->bufferWrites, 1u);
+        NVRHI_CHECK_EQUAL(commandList->draws.size(), 1u);
+        NVRHI_CHECK_EQUAL(commandList->draws[0].drawCount, 5u);
+        NVRHI_CHECK(commandList->draws[0].argumentBuffer != nullptr);
+    }
+
+    void testFailedArgumentBufferFallsBackToDirectDraws()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        device->supportedFeatures.push_back(Feature::MultiDrawIndirect);
+        device->failBufferCreation = true;
+
+        RefCountPtr<FakeCommandList> commandList = RefCountPtr<FakeCommandList>::Create(new FakeCommandList(device));
+
+        DrawBatcher batcher(device);
+        recordDraws(batcher, commandList, 5);
+
+        // None of the draws are lost
+        NVRHI_CHECK_EQUAL(commandList->draws.size(), 5u);
+        for (uint32_t index = 0; index < 5; index++)
+        {
+            const RecordedDraw& draw = commandList->draws[index];
+            NVRHI_CHECK(draw.type == RecordedDraw::Type::Draw);
+            NVRHI_CHECK_EQUAL(draw.args.startVertexLocation, index * 3);
+        }
+        NVRHI_CHECK_EQUAL(commandList->bufferWrites, 0u);
+        NVRHI_CHECK_EQUAL(batcher.getStatistics().directCalls, 5u);
+        NVRHI_CHECK_EQUAL(batcher.getStatistics().indirectCalls, 0u);
+        NVRHI_CHECK_EQUAL(device->messageCallback.warnings.load(), 1u);
+
+        // The warning is only reported once, and the batcher recovers when buffers can be created again
+        recordDraws(batcher, commandList, 5, true);
+        NVRHI_CHECK_EQUAL(commandList->draws.size(), 10u);
+        NVRHI_CHECK(commandList->draws[9].type == RecordedDraw::Type::DrawIndexed);
+        NVRHI_CHECK_EQUAL(device->messageCallback.warnings.load(), 1u);
+
+        device->failBufferCreation = false;
+        recordDraws(batcher, commandList, 5);
+        NVRHI_CHECK_EQUAL(commandList->draws.size(), 11u);
+        NVRHI_CHECK(commandList->draws[10].type == RecordedDraw::Type::DrawIndirect);
+        NVRHI_CHECK_EQUAL(commandList->draws[10].drawCount, 5u);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testDrawsAreMergedWithMultiDrawIndirect);
+    NVRHI_RUN_TEST(testDrawsAreSplitWithoutMultiDrawIndirect);
+    NVRHI_RUN_TEST(testArgumentsAreStagedInOwnBuffers);
+    NVRHI_RUN_TEST(testFailedArgumentBufferFallsBackToDirectDraws);
+
+    return NVRHI_TEST_RESULT();
+}
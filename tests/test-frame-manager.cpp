@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/frame-manager.h>
+#include "fake-device.h"
+#include "test-utils.h"
+
+using namespace nvrhi;
+
+namespace
+{
+    using tests::FakeDevice;
+
+    void submit(FakeDevice* device, CommandQueue queue = CommandQueue::Graphics)
+    {
+        CommandListHandle commandList = device->createCommandList(CommandListParameters().setQueueType(queue));
+        device->executeCommandList(commandList, queue);
+    }
+
+    // Records a frame with one submission on each of the given queues
+    void runFrame(FrameManager& frameManager, FakeDevice* device, std::initializer_list<CommandQueue> queues = { CommandQueue::Graphics })
+    {
+        frameManager.beginFrame();
+        for (CommandQueue queue : queues)
+            submit(device, queue);
+        frameManager.endFrame();
+    }
+
+    void testDuplicateQueuesAreIgnored()
+    {
+        FrameManagerDesc desc;
+        desc.addQueue(CommandQueue::Graphics)
+            .addQueue(CommandQueue::Compute)
+            .addQueue(CommandQueue::Compute);
+        NVRHI_CHECK_EQUAL(desc.queues.size(), 2u);
+
+        // Queues listed directly are deduplicated by the manager
+        desc.queues = { CommandQueue::Graphics, CommandQueue::Graphics };
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        FrameManager frameManager(device, desc);
+        runFrame(frameManager, device);
+        NVRHI_CHECK_EQUAL(device->eventQueriesCreated, 1u);
+    }
+
+    void testFramesInFlightAreThrottled()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        FrameManager frameManager(device, FrameManagerDesc().setMaxFramesInFlight(2));
+
+        // The GPU doesn't finish anything: two frames go ahead without waiting
+        runFrame(frameManager, device);
+        runFrame(frameManager, device);
+        NVRHI_CHECK_EQUAL(frameManager.getFramesInFlight(), 2u);
+        NVRHI_CHECK_EQUAL(device->eventQueryWaits, 0u);
+        NVRHI_CHECK_EQUAL(device->garbageCollections, 0u);
+
+        // The third one waits for the first
+        frameManager.beginFrame();
+        NVRHI_CHECK_EQUAL(device->eventQueryWaits, 1u);
+        NVRHI_CHECK_EQUAL(frameManager.getFramesInFlight(), 1u);
+        NVRHI_CHECK_EQUAL(device->completedID[size_t(CommandQueue::Graphics)], 1u);
+        NVRHI_CHECK_EQUAL(device->garbageCollections, 1u);
+        submit(device);
+        frameManager.endFrame();
+        NVRHI_CHECK_EQUAL(frameManager.getFramesInFlight(), 2u);
+
+        // Frames that the GPU has finished are retired without waiting
+        device->completeAllSubmissions();
+        runFrame(frameManager, device);
+        NVRHI_CHECK_EQUAL(device->eventQueryWaits, 1u);
+        NVRHI_CHECK_EQUAL(frameManager.getFramesInFlight(), 1u);
+        NVRHI_CHECK_EQUAL(frameManager.getStatistics().framesCompleted, 3u);
+
+        // The event queries of retired frames are reused
+        NVRHI_CHECK_EQUAL(device->eventQueriesCreated, 2u);
+    }
+
+    void testFrameWaitsForAllQueues()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        FrameManager frameManager(device, FrameManagerDesc().setMaxFramesInFlight(1).addQueue(CommandQueue::Compute));
+
+        runFrame(frameManager, device, { CommandQueue::Graphics, CommandQueue::Compute });
+
+        // Finishing the graphics work is not enough, the frame is waited for on both queues
+        device->completeSubmissions(CommandQueue::Graphics, 1);
+        frameManager.beginFrame();
+        NVRHI_CHECK_EQUAL(device->eventQueryWaits, 2u);
+        NVRHI_CHECK_EQUAL(device->completedID[size_t(CommandQueue::Compute)], 1u);
+        NVRHI_CHECK_EQUAL(frameManager.getFramesInFlight(), 0u);
+        frameManager.endFrame();
+    }
+
+    void testDeferredWorkRunsWhenFrameCompletes()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        FrameManager frameManager(device, FrameManagerDesc().setMaxFramesInFlight(3));
+
+        BufferHandle buffer = device->createBuffer(BufferDesc());
+        bool called = false;
+
+        frameManager.beginFrame();
+        frameManager.deferRelease(buffer);
+        frameManager.deferCallback([&called]() { called = true; });
+        submit(device);
+        frameManager.endFrame();
+
+        buffer->AddRef();
+        NVRHI_CHECK_EQUAL(buffer->Release(), 2u);
+
+        runFrame(frameManager, device);
+        NVRHI_CHECK(!called);
+
+        device->completeSubmissions(CommandQueue::Graphics, 1);
+        runFrame(frameManager, device);
+        NVRHI_CHECK(called);
+        buffer->AddRef();
+        NVRHI_CHECK_EQUAL(buffer->Release(), 1u);
+        NVRHI_CHECK_EQUAL(frameManager.getFramesInFlight(), 2u);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testDuplicateQueuesAreIgnored);
+    NVRHI_RUN_TEST(testFramesInFlightAreThrottled);
+    NVRHI_RUN_TEST(testFrameWaitsForAllQueues);
+    NVRHI_RUN_TEST(testDeferredWorkRunsWhenFrameCompletes);
+
+    return NVRHI_TEST_RESULT();
+}
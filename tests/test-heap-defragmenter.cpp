@@ -0,0 +1,248 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/common/heap-defragmenter.h>
+#include "test-utils.h"
+
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    DefragmentationAllocation makeAllocation(uint32_t heap, uint64_t offset, uint64_t size, uint64_t alignment = 1)
+    {
+        DefragmentationAllocation allocation;
+        allocation.heap = heap;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.alignment = alignment;
+        return allocation;
+    }
+
+    bool overlap(uint64_t beginA, uint64_t sizeA, uint64_t beginB, uint64_t sizeB)
+    {
+        return beginA < beginB + sizeB && beginB < beginA + sizeA;
+    }
+
+    // Runs the planner and executes its moves pass by pass on a copy of the allocations, checking that every
+    // destination is inside its heap, aligned, and disjoint from the memory in use at the start of the pass
+    std::vector<DefragmentationMove> planAndExecute(const std::vector<uint64_t>& capacities,
+        std::vector<DefragmentationAllocation>& allocations, uint32_t maxPasses)
+    {
+        std::vector<DefragmentationMove> moves;
+        planHeapDefragmentation(capacities, allocations, maxPasses, moves);
+
+        size_t passBegin = 0;
+        while (passBegin < moves.size())
+        {
+            const uint32_t pass = moves[passBegin].pass;
+            NVRHI_CHECK(pass < maxPasses);
+
+            size_t passEnd = passBegin;
+            while (passEnd < moves.size() && moves[passEnd].pass == pass)
+                ++passEnd;
+
+            if (passEnd < moves.size())
+                NVRHI_CHECK(moves[passEnd].pass > pass);
+
+            for (size_t index = passBegin; index < passEnd; ++index)
+            {
+                const DefragmentationMove& move = moves[index];
+                const DefragmentationAllocation& moved = allocations[move.allocation];
+
+                NVRHI_CHECK(moved.movable);
+                NVRHI_CHECK(move.heap < capacities.size());
+                NVRHI_CHECK(move.offset + moved.size <= capacities[move.heap]);
+                NVRHI_CHECK_EQUAL(move.offset % moved.alignment, 0);
+
+                for (const DefragmentationAllocation& other : allocations)
+                {
+                    if (other.heap == move.heap)
+                        NVRHI_CHECK(!overlap(move.offset, moved.size, other.offset, other.size));
+                }
+
+                for (size_t otherIndex = passBegin; otherIndex < passEnd; ++otherIndex)
+                {
+                    const DefragmentationMove& other = moves[otherIndex];
+                    NVRHI_CHECK(other.allocation != move.allocation || otherIndex == index);
+
+                    if (otherIndex != index && other.heap == move.heap)
+                        NVRHI_CHECK(!overlap(move.offset, moved.size, other.offset, allocations[other.allocation].size));
+                }
+            }
+
+            for (size_t index = passBegin; index < passEnd; ++index)
+            {
+                allocations[moves[index].allocation].heap = moves[index].heap;
+                allocations[moves[index].allocation].offset = moves[index].offset;
+            }
+
+            passBegin = passEnd;
+        }
+
+        return moves;
+    }
+
+    uint64_t getUsedBytes(const std::vector<DefragmentationAllocation>& allocations, uint32_t heap)
+    {
+        uint64_t bytes = 0;
+        for (const DefragmentationAllocation& allocation : allocations)
+        {
+            if (allocation.heap == heap)
+                bytes += allocation.size;
+        }
+        return bytes;
+    }
+
+    void testCompactsTowardsOffsetZero()
+    {
+        std::vector<DefragmentationAllocation> allocations = {
+            makeAllocation(0, 0, 100),
+            makeAllocation(0, 300, 100)
+        };
+
+        const std::vector<DefragmentationMove> moves = planAndExecute({ 1000 }, allocations, 8);
+
+        NVRHI_CHECK_EQUAL(moves.size(), 1);
+        NVRHI_CHECK_EQUAL(allocations[1].offset, 100);
+    }
+
+    void testEmptiesLeastUsedHeap()
+    {
+        std::vector<DefragmentationAllocation> allocations = {
+            makeAllocation(0, 0, 300),
+            makeAllocation(1, 500, 100),
+            makeAllocation(1, 100, 50)
+        };
+
+        planAndExecute({ 1000, 1000 }, allocations, 8);
+
+        NVRHI_CHECK_EQUAL(getUsedBytes(allocations, 1), 0);
+        NVRHI_CHECK_EQUAL(allocations[0].offset, 0);
+        // The worst placement goes first and takes the lowest free offset
+        NVRHI_CHECK_EQUAL(allocations[1].offset, 300);
+        NVRHI_CHECK_EQUAL(allocations[2].offset, 400);
+    }
+
+    void testRespectsAlignment()
+    {
+        std::vector<DefragmentationAllocation> allocations = {
+            makeAllocation(0, 0, 10),
+            makeAllocation(0, 512, 64, 256)
+        };
+
+        planAndExecute({ 1024 }, allocations, 8);
+
+        NVRHI_CHECK_EQUAL(allocations[1].offset, 256);
+    }
+
+    void testImmovableAllocationsStay()
+    {
+        std::vector<DefragmentationAllocation> allocations = {
+            makeAllocation(0, 200, 100),
+            makeAllocation(0, 400, 100)
+        };
+        allocations[0].movable = false;
+
+        planAndExecute({ 1000 }, allocations, 8);
+
+        NVRHI_CHECK_EQUAL(allocations[0].offset, 200);
+        NVRHI_CHECK_EQUAL(allocations[1].offset, 0);
+    }
+
+    void testAliasedAllocationsStay()
+    {
+        std::vector<DefragmentationAllocation> allocations = {
+            makeAllocation(0, 200, 100),
+            makeAllocation(0, 250, 100)
+        };
+
+        const std::vector<DefragmentationMove> moves = planAndExecute({ 1000 }, allocations, 8);
+
+        NVRHI_CHECK(moves.empty());
+    }
+
+    void testSourcesAreFreedForTheNextPass()
+    {
+        // The large allocation only fits into the range that the second one leaves in the first pass
+        std::vector<DefragmentationAllocation> allocations = {
+            makeAllocation(0, 0, 100),
+            makeAllocation(0, 200, 100),
+            makeAllocation(1, 0, 200)
+        };
+
+        std::vector<DefragmentationAllocation> onePass = allocations;
+        std::vector<DefragmentationMove> moves = planAndExecute({ 400, 400 }, onePass, 1);
+
+        NVRHI_CHECK_EQUAL(moves.size(), 1);
+        NVRHI_CHECK_EQUAL(onePass[1].offset, 100);
+        NVRHI_CHECK_EQUAL(onePass[2].heap, 1);
+
+        moves = planAndExecute({ 400, 400 }, allocations, 8);
+
+        NVRHI_CHECK_EQUAL(moves.size(), 2);
+        NVRHI_CHECK_EQUAL(moves[1].pass, 1);
+        NVRHI_CHECK_EQUAL(allocations[2].heap, 0);
+        NVRHI_CHECK_EQUAL(allocations[2].offset, 200);
+        NVRHI_CHECK_EQUAL(getUsedBytes(allocations, 1), 0);
+    }
+
+    void testPlanIsDeterministic()
+    {
+        std::vector<DefragmentationAllocation> allocations;
+        for (uint32_t index = 0; index < 32; ++index)
+            allocations.push_back(makeAllocation(index % 3, uint64_t(index / 3) * 300 + (index % 5) * 16, 64 + (index % 4) * 32, 16));
+
+        std::vector<DefragmentationMove> first;
+        std::vector<DefragmentationMove> second;
+        planHeapDefragmentation({ 4096, 4096, 4096 }, allocations, 8, first);
+        planHeapDefragmentation({ 4096, 4096, 4096 }, allocations, 8, second);
+
+        NVRHI_CHECK_EQUAL(first.size(), second.size());
+        for (size_t index = 0; index < first.size() && index < second.size(); ++index)
+        {
+            NVRHI_CHECK_EQUAL(first[index].allocation, second[index].allocation);
+            NVRHI_CHECK_EQUAL(first[index].pass, second[index].pass);
+            NVRHI_CHECK_EQUAL(first[index].heap, second[index].heap);
+            NVRHI_CHECK_EQUAL(first[index].offset, second[index].offset);
+        }
+
+        planAndExecute({ 4096, 4096, 4096 }, allocations, 8);
+        NVRHI_CHECK_EQUAL(getUsedBytes(allocations, 2), 0);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testCompactsTowardsOffsetZero);
+    NVRHI_RUN_TEST(testEmptiesLeastUsedHeap);
+    NVRHI_RUN_TEST(testRespectsAlignment);
+    NVRHI_RUN_TEST(testImmovableAllocationsStay);
+    NVRHI_RUN_TEST(testAliasedAllocationsStay);
+    NVRHI_RUN_TEST(testSourcesAreFreedForTheNextPass);
+    NVRHI_RUN_TEST(testPlanIsDeterministic);
+
+    return NVRHI_TEST_RESULT();
+}
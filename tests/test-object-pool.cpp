@@ -0,0 +1,140 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "src/common/object-pool.h"
+#include "test-utils.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    class CountingAllocator : public IAllocator
+    {
+    public:
+        std::atomic<uint32_t> allocations = 0;
+        std::atomic<uint32_t> deallocations = 0;
+        std::atomic<uint32_t> otherCategories = 0;
+
+        void* allocate(size_t size, size_t alignment, AllocationCategory category) override
+        {
+            ++allocations;
+            if (category != AllocationCategory::Objects)
+                ++otherCategories;
+            return ::operator new(size, std::align_val_t(alignment));
+        }
+
+        void deallocate(void* pointer, size_t size, size_t alignment, AllocationCategory category) override
+        {
+            (void)size;
+            ++deallocations;
+            if (category != AllocationCategory::Objects)
+                ++otherCategories;
+            ::operator delete(pointer, std::align_val_t(alignment));
+        }
+    };
+
+    CountingAllocator g_Allocator;
+
+    struct alignas(32) PooledThing : public PooledObject<PooledThing>
+    {
+        uint64_t values[5] = {};
+
+        virtual ~PooledThing() = default;
+    };
+
+    // Objects of a derived class have a different size and bypass the slab pool
+    struct LargerPooledThing : public PooledThing
+    {
+        uint64_t extra[3] = {};
+    };
+
+    void testAllocatorSetBeforeFirstObjectIsUsed()
+    {
+        NVRHI_CHECK(setObjectAllocator(&g_Allocator));
+
+        // Replacing it again is fine while no object has been created
+        NVRHI_CHECK(setObjectAllocator(nullptr));
+        NVRHI_CHECK(setObjectAllocator(&g_Allocator));
+
+        PooledThing* thing = new PooledThing();
+        NVRHI_CHECK((reinterpret_cast<uintptr_t>(thing) & (alignof(PooledThing) - 1)) == 0);
+        NVRHI_CHECK_EQUAL(g_Allocator.allocations.load(), 1u);
+
+        delete thing;
+        NVRHI_CHECK_EQUAL(g_Allocator.deallocations.load(), 1u);
+        NVRHI_CHECK_EQUAL(g_Allocator.otherCategories.load(), 0u);
+    }
+
+    void testAllocatorCannotBeReplacedOnceObjectsExist()
+    {
+        PooledThing* thing = new PooledThing();
+
+        // The object above would be freed by the slab pool otherwise
+        NVRHI_CHECK(!setObjectAllocator(nullptr));
+
+        CountingAllocator otherAllocator;
+        NVRHI_CHECK(!setObjectAllocator(&otherAllocator));
+
+        delete thing;
+
+        // The refusal doesn't depend on the objects being alive, they could be held in caches the app can't see
+        NVRHI_CHECK(!setObjectAllocator(nullptr));
+        NVRHI_CHECK_EQUAL(g_Allocator.allocations.load(), g_Allocator.deallocations.load());
+        NVRHI_CHECK_EQUAL(otherAllocator.allocations.load(), 0u);
+    }
+
+    void testObjectsFromOtherThreadsUseTheSameAllocator()
+    {
+        const uint32_t allocationsBefore = g_Allocator.allocations.load();
+        std::vector<PooledThing*> things(64);
+
+        std::thread producer([&things]()
+        {
+            for (auto& thing : things)
+                thing = (&thing - things.data()) % 2 ? new PooledThing() : new LargerPooledThing();
+        });
+        producer.join();
+
+        for (PooledThing* thing : things)
+            delete thing;
+
+        NVRHI_CHECK_EQUAL(g_Allocator.allocations.load() - allocationsBefore, 64u);
+        NVRHI_CHECK_EQUAL(g_Allocator.allocations.load(), g_Allocator.deallocations.load());
+    }
+}
+
+int main()
+{
+    // The allocator is process-wide, so the order of these tests matters
+    NVRHI_RUN_TEST(testAllocatorSetBeforeFirstObjectIsUsed);
+    NVRHI_RUN_TEST(testAllocatorCannotBeReplacedOnceObjectsExist);
+    NVRHI_RUN_TEST(testObjectsFromOtherThreadsUseTheSameAllocator);
+
+    return NVRHI_TEST_RESULT();
+}
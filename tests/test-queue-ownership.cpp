@@ -0,0 +1,267 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "src/common/state-tracking.h"
+#include "test-utils.h"
+
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    class CountingMessageCallback : public IMessageCallback
+    {
+    public:
+        int numErrors = 0;
+
+        void message(MessageSeverity severity, const char* messageText) override
+        {
+            (void)messageText;
+            if (severity == MessageSeverity::Error)
+                ++numErrors;
+        }
+    };
+
+    // Graphics and compute share family 0, copy is family 1
+    QueueOwnershipTracker makeOwnershipTracker()
+    {
+        QueueOwnershipTracker tracker;
+        tracker.setQueueFamily(CommandQueue::Graphics, 0);
+        tracker.setQueueFamily(CommandQueue::Compute, 0);
+        tracker.setQueueFamily(CommandQueue::Copy, 1);
+        return tracker;
+    }
+
+    // Records one command list that requires 'state' on the buffer and submits it to 'queue'
+    std::vector<QueueOwnershipTransfer> submitBufferUse(QueueOwnershipTracker& ownership, CommandQueue queue,
+        BufferStateExtension& buffer, ResourceStates state, CountingMessageCallback& callback)
+    {
+        CommandListResourceStateTracker stateTracker(&callback);
+        stateTracker.setTrackPermanentResourceUses(true);
+        stateTracker.requireBufferState(&buffer, state);
+
+        std::vector<QueueOwnershipTransfer> transfers;
+        ownership.commandListSubmitted(queue, stateTracker, transfers);
+        stateTracker.commandListSubmitted();
+        return transfers;
+    }
+
+    BufferDesc makeBufferDesc()
+    {
+        return BufferDesc()
+            .setByteSize(256)
+            .setInitialState(ResourceStates::Common)
+            .setKeepInitialState(true);
+    }
+
+    void testTransferBetweenFamilies()
+    {
+        CountingMessageCallback callback;
+        QueueOwnershipTracker ownership = makeOwnershipTracker();
+        const BufferDesc desc = makeBufferDesc();
+        BufferStateExtension buffer(desc);
+
+        // The first use has no previous owner
+        NVRHI_CHECK(submitBufferUse(ownership, CommandQueue::Copy, buffer, ResourceStates::CopyDest, callback).empty());
+        NVRHI_CHECK(buffer.ownerQueue == CommandQueue::Copy);
+
+        // Copy -> graphics: one release on copy paired with one acquire on graphics, in the copy state
+        std::vector<QueueOwnershipTransfer> transfers = submitBufferUse(ownership, CommandQueue::Graphics, buffer, ResourceStates::ShaderResource, callback);
+        NVRHI_CHECK_EQUAL(transfers.size(), 1);
+        NVRHI_CHECK(transfers[0].buffer == &buffer);
+        NVRHI_CHECK(transfers[0].texture == nullptr);
+        NVRHI_CHECK(transfers[0].srcQueue == CommandQueue::Copy);
+        NVRHI_CHECK(transfers[0].dstQueue == CommandQueue::Graphics);
+        NVRHI_CHECK(transfers[0].state == ResourceStates::CopyDest);
+        NVRHI_CHECK(buffer.ownerQueue == CommandQueue::Graphics);
+        NVRHI_CHECK(buffer.ownerState == ResourceStates::ShaderResource);
+
+        // Graphics -> graphics: no transfer
+        NVRHI_CHECK(submitBufferUse(ownership, CommandQueue::Graphics, buffer, ResourceStates::ShaderResource, callback).empty());
+
+        // Graphics -> copy: the transfer goes back the other way
+        transfers = submitBufferUse(ownership, CommandQueue::Copy, buffer, ResourceStates::CopySource, callback);
+        NVRHI_CHECK_EQUAL(transfers.size(), 1);
+        NVRHI_CHECK(transfers[0].srcQueue == CommandQueue::Graphics);
+        NVRHI_CHECK(transfers[0].dstQueue == CommandQueue::Copy);
+        NVRHI_CHECK(transfers[0].state == ResourceStates::ShaderResource);
+
+        NVRHI_CHECK_EQUAL(callback.numErrors, 0);
+    }
+
+    void testNoTransferWithinFamily()
+    {
+        CountingMessageCallback callback;
+        QueueOwnershipTracker ownership = makeOwnershipTracker();
+        const BufferDesc desc = makeBufferDesc();
+        BufferStateExtension buffer(desc);
+
+        submitBufferUse(ownership, CommandQueue::Graphics, buffer, ResourceStates::UnorderedAccess, callback);
+        NVRHI_CHECK(submitBufferUse(ownership, CommandQueue::Compute, buffer, ResourceStates::UnorderedAccess, callback).empty());
+        NVRHI_CHECK(buffer.ownerQueue == CommandQueue::Compute);
+    }
+
+    void testNoTransferWithoutContents()
+    {
+        CountingMessageCallback callback;
+        QueueOwnershipTracker ownership = makeOwnershipTracker();
+        const BufferDesc desc = makeBufferDesc();
+        BufferStateExtension buffer(desc);
+
+        // Left in an unknown state, so there is nothing to preserve
+        buffer.ownerQueue = CommandQueue::Graphics;
+        buffer.ownerState = ResourceStates::Unknown;
+
+        NVRHI_CHECK(submitBufferUse(ownership, CommandQueue::Copy, buffer, ResourceStates::CopyDest, callback).empty());
+    }
+
+    void testTextureSubresourceStatesAreTransferred()
+    {
+        CountingMessageCallback callback;
+        QueueOwnershipTracker ownership = makeOwnershipTracker();
+        const TextureDesc desc = TextureDesc()
+            .setWidth(64)
+            .setHeight(64)
+            .setMipLevels(2)
+            .setFormat(Format::RGBA8_UNORM)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true);
+        TextureStateExtension texture(desc);
+        texture.stateInitialized = true;
+
+        {
+            CommandListResourceStateTracker stateTracker(&callback);
+            stateTracker.requireTextureState(&texture, TextureSubresourceSet(1, 1, 0, 1), ResourceStates::CopyDest);
+
+            std::vector<QueueOwnershipTransfer> transfers;
+            ownership.commandListSubmitted(CommandQueue::Copy, stateTracker, transfers);
+            NVRHI_CHECK(transfers.empty());
+        }
+
+        CommandListResourceStateTracker stateTracker(&callback);
+        stateTracker.requireTextureState(&texture, AllSubresources, ResourceStates::ShaderResource);
+
+        std::vector<QueueOwnershipTransfer> transfers;
+        ownership.commandListSubmitted(CommandQueue::Graphics, stateTracker, transfers);
+        NVRHI_CHECK_EQUAL(transfers.size(), 1);
+        NVRHI_CHECK(transfers[0].texture == &texture);
+        NVRHI_CHECK(transfers[0].srcQueue == CommandQueue::Copy);
+        NVRHI_CHECK_EQUAL(transfers[0].subresourceStates.size(), 2);
+        if (transfers[0].subresourceStates.size() == 2)
+        {
+            NVRHI_CHECK(transfers[0].subresourceStates[0] == ResourceStates::ShaderResource);
+            NVRHI_CHECK(transfers[0].subresourceStates[1] == ResourceStates::CopyDest);
+        }
+
+        NVRHI_CHECK(texture.ownerState == ResourceStates::ShaderResource);
+        NVRHI_CHECK(texture.ownerSubresourceStates.empty());
+        NVRHI_CHECK_EQUAL(callback.numErrors, 0);
+    }
+
+    void testRecordedUsesProduceTransfers()
+    {
+        CountingMessageCallback callback;
+        QueueOwnershipTracker ownership = makeOwnershipTracker();
+        const BufferDesc desc = BufferDesc().setByteSize(256);
+        BufferStateExtension buffer(desc);
+
+        {
+            CommandListResourceStateTracker stateTracker(&callback);
+            stateTracker.beginTrackingBufferState(&buffer, ResourceStates::Common);
+            stateTracker.requireBufferState(&buffer, ResourceStates::CopyDest);
+
+            std::vector<QueueOwnershipTransfer> transfers;
+            ownership.commandListSubmitted(CommandQueue::Copy, stateTracker, transfers);
+        }
+
+        // With automatic barriers disabled, the command list only records the use
+        CommandListResourceStateTracker stateTracker(&callback);
+        stateTracker.setTrackPermanentResourceUses(true);
+        stateTracker.recordBufferUse(&buffer);
+        NVRHI_CHECK(stateTracker.getBufferBarriers().empty());
+
+        std::vector<QueueOwnershipTransfer> transfers;
+        ownership.commandListSubmitted(CommandQueue::Graphics, stateTracker, transfers);
+        NVRHI_CHECK_EQUAL(transfers.size(), 1);
+        NVRHI_CHECK(transfers[0].srcQueue == CommandQueue::Copy);
+        NVRHI_CHECK(transfers[0].dstQueue == CommandQueue::Graphics);
+        NVRHI_CHECK(transfers[0].state == ResourceStates::CopyDest);
+
+        // The state set by the previous owner is kept, so the next transfer still has it
+        NVRHI_CHECK(buffer.ownerQueue == CommandQueue::Graphics);
+        NVRHI_CHECK(buffer.ownerState == ResourceStates::CopyDest);
+        NVRHI_CHECK_EQUAL(callback.numErrors, 0);
+    }
+
+    void testPermanentStateUsesAreTracked()
+    {
+        CountingMessageCallback callback;
+        QueueOwnershipTracker ownership = makeOwnershipTracker();
+        const BufferDesc desc = BufferDesc().setByteSize(256);
+        BufferStateExtension buffer(desc);
+        buffer.permanentState = ResourceStates::ShaderResource;
+
+        NVRHI_CHECK(submitBufferUse(ownership, CommandQueue::Graphics, buffer, ResourceStates::ShaderResource, callback).empty());
+
+        CommandListResourceStateTracker stateTracker(&callback);
+        stateTracker.setTrackPermanentResourceUses(true);
+        stateTracker.recordBufferUse(&buffer);
+
+        std::vector<QueueOwnershipTransfer> transfers;
+        ownership.commandListSubmitted(CommandQueue::Copy, stateTracker, transfers);
+        NVRHI_CHECK_EQUAL(transfers.size(), 1);
+        NVRHI_CHECK(transfers[0].state == ResourceStates::ShaderResource);
+        NVRHI_CHECK_EQUAL(callback.numErrors, 0);
+    }
+
+    void testUsesAreNotRecordedWithoutOwnershipTracking()
+    {
+        CountingMessageCallback callback;
+        QueueOwnershipTracker ownership = makeOwnershipTracker();
+        const BufferDesc desc = makeBufferDesc();
+        BufferStateExtension buffer(desc);
+
+        CommandListResourceStateTracker stateTracker(&callback);
+        stateTracker.recordBufferUse(&buffer);
+
+        std::vector<QueueOwnershipTransfer> transfers;
+        ownership.commandListSubmitted(CommandQueue::Copy, stateTracker, transfers);
+        NVRHI_CHECK(transfers.empty());
+        NVRHI_CHECK(buffer.ownerQueue == CommandQueue::Count);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testTransferBetweenFamilies);
+    NVRHI_RUN_TEST(testNoTransferWithinFamily);
+    NVRHI_RUN_TEST(testNoTransferWithoutContents);
+    NVRHI_RUN_TEST(testTextureSubresourceStatesAreTransferred);
+    NVRHI_RUN_TEST(testRecordedUsesProduceTransfers);
+    NVRHI_RUN_TEST(testPermanentStateUsesAreTracked);
+    NVRHI_RUN_TEST(testUsesAreNotRecordedWithoutOwnershipTracking);
+
+    return NVRHI_TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/queue-scheduler.h>
+#include "fake-device.h"
+#include "test-utils.h"
+
+using namespace nvrhi;
+
+namespace
+{
+    using tests::FakeDevice;
+
+    CommandListHandle createCommandList(FakeDevice* device, CommandQueue queue)
+    {
+        return device->createCommandList(CommandListParameters().setQueueType(queue));
+    }
+
+    BufferHandle createBuffer(FakeDevice* device)
+    {
+        return device->createBuffer(BufferDesc());
+    }
+
+    void testCrossQueueWaits()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        QueueScheduler scheduler(device);
+
+        BufferHandle a = createBuffer(device);
+        BufferHandle b = createBuffer(device);
+        CommandListHandle graphics0 = createCommandList(device, CommandQueue::Graphics);
+        CommandListHandle graphics1 = createCommandList(device, CommandQueue::Graphics);
+        CommandListHandle compute0 = createCommandList(device, CommandQueue::Compute);
+        CommandListHandle compute1 = createCommandList(device, CommandQueue::Compute);
+
+        scheduler.addCommandList(graphics0, {}, { a });
+        scheduler.addCommandList(graphics1, {}, { b });
+        uint32_t reader = scheduler.addCommandList(compute0, { a }, {});
+        uint32_t secondReader = scheduler.addCommandList(compute1, { a, b }, {});
+        scheduler.execute();
+
+        // Both graphics lists are submitted together, before compute waits for them once
+        NVRHI_CHECK_EQUAL(device->submissions.size(), 2u);
+        NVRHI_CHECK(device->submissions[0].queue == CommandQueue::Graphics);
+        NVRHI_CHECK_EQUAL(device->submissions[0].commandLists.size(), 2u);
+        NVRHI_CHECK(device->submissions[1].queue == CommandQueue::Compute);
+        NVRHI_CHECK_EQUAL(device->submissions[1].commandLists.size(), 2u);
+
+        NVRHI_CHECK_EQUAL(device->waits.size(), 1u);
+        NVRHI_CHECK(device->waits[0].waitQueue == CommandQueue::Compute);
+        NVRHI_CHECK(device->waits[0].executionQueue == CommandQueue::Graphics);
+        NVRHI_CHECK_EQUAL(device->waits[0].instance, device->submissions[0].submissionID);
+
+        const auto& nodes = scheduler.getNodes();
+        NVRHI_CHECK_EQUAL(nodes[reader].waits.size(), 1u);
+        NVRHI_CHECK_EQUAL(nodes[reader].dependencies.size(), 1u);
+        NVRHI_CHECK(nodes[secondReader].waits.empty());
+
+        // Writing a on graphics now has to wait for the compute reads from the previous execute call
+        CommandListHandle graphics2 = createCommandList(device, CommandQueue::Graphics);
+        uint32_t writer = scheduler.addCommandList(graphics2, {}, { a });
+        scheduler.execute();
+
+        NVRHI_CHECK_EQUAL(device->waits.size(), 2u);
+        NVRHI_CHECK(device->waits[1].waitQueue == CommandQueue::Graphics);
+        NVRHI_CHECK(device->waits[1].executionQueue == CommandQueue::Compute);
+        NVRHI_CHECK_EQUAL(device->waits[1].instance, device->submissions[1].submissionID);
+        NVRHI_CHECK_EQUAL(scheduler.getNodes()[writer].waits.size(), 1u);
+        NVRHI_CHECK(scheduler.getNodes()[writer].dependencies.empty());
+    }
+
+    void testRepeatedExecute()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        QueueScheduler scheduler(device);
+
+        BufferHandle a = createBuffer(device);
+        CommandListHandle graphics = createCommandList(device, CommandQueue::Graphics);
+        CommandListHandle compute = createCommandList(device, CommandQueue::Compute);
+
+        scheduler.addCommandList(graphics, {}, { a });
+        scheduler.addCommandList(compute, { a }, {});
+        scheduler.execute();
+
+        NVRHI_CHECK_EQUAL(device->submissions.size(), 2u);
+        NVRHI_CHECK_EQUAL(device->waits.size(), 1u);
+
+        // No command lists were added, so nothing is submitted again
+        scheduler.execute();
+
+        NVRHI_CHECK_EQUAL(device->submissions.size(), 2u);
+        NVRHI_CHECK_EQUAL(device->waits.size(), 1u);
+        NVRHI_CHECK(scheduler.getNodes().empty());
+        NVRHI_CHECK(scheduler.getBatches().empty());
+
+        scheduler.addCommandList(graphics, {}, {});
+        scheduler.execute();
+
+        NVRHI_CHECK_EQUAL(device->submissions.size(), 3u);
+        NVRHI_CHECK_EQUAL(scheduler.getNodes().size(), 1u);
+        NVRHI_CHECK_EQUAL(scheduler.getBatches().size(), 1u);
+    }
+
+    void testCompletedAccessesArePruned()
+    {
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        QueueScheduler scheduler(device);
+
+        BufferHandle a = createBuffer(device);
+        CommandListHandle graphics = createCommandList(device, CommandQueue::Graphics);
+        CommandListHandle compute = createCommandList(device, CommandQueue::Compute);
+
+        scheduler.addCommandList(graphics, {}, { a });
+        scheduler.execute();
+        NVRHI_CHECK_EQUAL(scheduler.getNumTrackedResources(), 1u);
+
+        // The scheduler keeps the resource alive while it remembers accesses to it
+        IBuffer* buffer = a;
+        buffer->AddRef();
+        NVRHI_CHECK_EQUAL(buffer->Release(), 2u);
+
+        // Not finished on the GPU yet, so the access is kept
+        scheduler.execute();
+        NVRHI_CHECK_EQUAL(scheduler.getNumTrackedResources(), 1u);
+
+        device->completeAllSubmissions();
+        scheduler.execute();
+        NVRHI_CHECK_EQUAL(scheduler.getNumTrackedResources(), 0u);
+
+        buffer->AddRef();
+        NVRHI_CHECK_EQUAL(buffer->Release(), 1u);
+
+        // The completed write no longer needs a wait
+        scheduler.addCommandList(compute, { a }, {});
+        scheduler.execute();
+        NVRHI_CHECK(device->waits.empty());
+
+        // Event queries are reused once they have signalled
+        device->completeAllSubmissions();
+        scheduler.execute();
+        scheduler.addCommandList(graphics, {}, { a });
+        scheduler.execute();
+        NVRHI_CHECK_EQUAL(device->eventQueriesCreated, 1u);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testCrossQueueWaits);
+    NVRHI_RUN_TEST(testRepeatedExecute);
+    NVRHI_RUN_TEST(testCompletedAccessesArePruned);
+
+    return NVRHI_TEST_RESULT();
+}
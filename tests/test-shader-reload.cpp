@@ -0,0 +1,396 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/shader-reload.h>
+#include "src/common/task-scheduler.h"
+#include "fake-device.h"
+#include "test-utils.h"
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace nvrhi;
+
+namespace
+{
+    using tests::FakeDevice;
+
+    // A directory under the system temp path that is removed with everything in it
+    class TempDirectory
+    {
+    public:
+        TempDirectory()
+        {
+            static std::atomic<uint32_t> counter = 0;
+            m_Path = std::filesystem::temp_directory_path() /
+                ("nvrhi-shader-reload-" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "-" + std::to_string(++counter));
+            std::filesystem::remove_all(m_Path);
+            std::filesystem::create_directories(m_Path);
+        }
+
+        ~TempDirectory()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(m_Path, ec);
+        }
+
+        [[nodiscard]] const std::filesystem::path& path() const { return m_Path; }
+
+        std::filesystem::path write(const char* fileName, const std::string& contents) const
+        {
+            const std::filesystem::path filePath = m_Path / fileName;
+            std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+            file << contents;
+            return filePath;
+        }
+
+    private:
+        std::filesystem::path m_Path;
+    };
+
+    std::string getBytecode(IShader* shader)
+    {
+        const void* data = nullptr;
+        size_t size = 0;
+        shader->getBytecode(&data, &size);
+        return std::string(static_cast<const char*>(data), size);
+    }
+
+    // Calls update until the expected number of pipelines has been replaced, file notifications may take a moment to arrive
+    uint32_t updateUntilReplaced(ShaderReloader& reloader, uint32_t expected)
+    {
+        uint32_t replaced = 0;
+        for (int attempt = 0; attempt < 200 && replaced < expected; attempt++)
+        {
+            replaced += reloader.update();
+            reloader.waitForRebuilds();
+            replaced += reloader.update();
+            if (replaced < expected)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return replaced;
+    }
+
+    // Calls update a few times to give the watcher a chance to report the files, for cases where nothing should be replaced
+    uint32_t updateForAWhile(ShaderReloader& reloader)
+    {
+        uint32_t replaced = 0;
+        for (int attempt = 0; attempt < 10; attempt++)
+        {
+            replaced += reloader.update();
+            reloader.waitForRebuilds();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return replaced + reloader.update();
+    }
+
+    ShaderDesc computeShaderDesc()
+    {
+        ShaderDesc desc;
+        desc.shaderType = ShaderType::Compute;
+        return desc;
+    }
+
+    // Builds a shader blob with one binary per value of PERM
+    std::string makeBlob(const std::vector<std::string>& binaries)
+    {
+        std::string blob = "NVSP";
+        for (size_t index = 0; index < binaries.size(); index++)
+        {
+            const std::string permutation = "PERM=" + std::to_string(index) + " ";
+
+            ShaderBlobEntry header;
+            header.permutationSize = uint32_t(permutation.size());
+            header.dataSize = uint32_t(binaries[index].size());
+
+            char headerBytes[sizeof(header)];
+            memcpy(headerBytes, &header, sizeof(header));
+            blob.append(headerBytes, sizeof(header));
+            blob += permutation;
+            blob += binaries[index];
+        }
+        return blob;
+    }
+
+    void testChangedShaderRebuildsPipeline(ITaskScheduler* taskScheduler)
+    {
+        TempDirectory directory;
+        const auto file = directory.write("blur_cs.bin", "compute shader v1");
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        device->taskScheduler = taskScheduler;
+        ShaderReloader reloader(device);
+        reloader.getFileWatcher().setPollingInterval(std::chrono::milliseconds(0));
+        NVRHI_CHECK(reloader.watchDirectory(directory.path()));
+
+        ShaderHandle shader = reloader.loadShader(file, computeShaderDesc());
+        NVRHI_CHECK(shader != nullptr);
+
+        ComputePipelineDesc pipelineDesc;
+        pipelineDesc.CS = shader;
+        ReloadableComputePipelineHandle pipeline = reloader.createComputePipeline(pipelineDesc);
+        NVRHI_CHECK(pipeline != nullptr);
+        NVRHI_CHECK_EQUAL(pipeline->version, 0u);
+        NVRHI_CHECK_EQUAL(reloader.update(), 0u);
+
+        directory.write("blur_cs.bin", "compute shader v2");
+        NVRHI_CHECK_EQUAL(updateUntilReplaced(reloader, 1), 1u);
+
+        NVRHI_CHECK_EQUAL(pipeline->version, 1u);
+        NVRHI_CHECK_EQUAL(device->computePipelinesCreated.load(), 2u);
+        NVRHI_CHECK(getBytecode(pipeline->pipeline->getDesc().CS) == "compute shader v2");
+        NVRHI_CHECK_EQUAL(device->messageCallback.warnings.load(), 0u);
+
+        // The dependency moved over to the new shader object, so a second change is picked up too
+        directory.write("blur_cs.bin", "compute shader v3");
+        NVRHI_CHECK_EQUAL(updateUntilReplaced(reloader, 1), 1u);
+        NVRHI_CHECK_EQUAL(pipeline->version, 2u);
+        NVRHI_CHECK(getBytecode(pipeline->pipeline->getDesc().CS) == "compute shader v3");
+    }
+
+    void testRebuildOnCallingThread()
+    {
+        testChangedShaderRebuildsPipeline(nullptr);
+    }
+
+    void testRebuildOnDeviceTaskScheduler()
+    {
+        WorkerPoolTaskScheduler scheduler(2);
+        testChangedShaderRebuildsPipeline(&scheduler);
+    }
+
+    void testOnlyChangedPermutationsAreRebuilt()
+    {
+        TempDirectory directory;
+        const auto file = directory.write("blur_cs.bin", makeBlob({ "blur 0 v1", "blur 1 v1", "blur 2 v1" }));
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        ShaderReloader reloader(device);
+        reloader.getFileWatcher().setPollingInterval(std::chrono::milliseconds(0));
+        reloader.watchDirectory(directory.path());
+
+        std::vector<ReloadableComputePipelineHandle> pipelines;
+        for (uint32_t index = 0; index < 3; index++)
+        {
+            const std::string value = std::to_string(index);
+            const ShaderConstant constant = { "PERM", value.c_str() };
+
+            ComputePipelineDesc pipelineDesc;
+            pipelineDesc.CS = reloader.loadShader(file, computeShaderDesc(), &constant, 1);
+            NVRHI_CHECK(pipelineDesc.CS != nullptr);
+            pipelines.push_back(reloader.createComputePipeline(pipelineDesc));
+        }
+        NVRHI_CHECK_EQUAL(device->shadersCreated.load(), 3u);
+
+        // The whole blob is rewritten, but only the second permutation's bytes differ
+        directory.write("blur_cs.bin", makeBlob({ "blur 0 v1", "blur 1 v2", "blur 2 v1" }));
+        NVRHI_CHECK_EQUAL(updateUntilReplaced(reloader, 1), 1u);
+        NVRHI_CHECK_EQUAL(updateForAWhile(reloader), 0u);
+
+        NVRHI_CHECK_EQUAL(device->shadersCreated.load(), 4u);
+        NVRHI_CHECK_EQUAL(device->computePipelinesCreated.load(), 4u);
+        NVRHI_CHECK_EQUAL(pipelines[0]->version, 0u);
+        NVRHI_CHECK_EQUAL(pipelines[1]->version, 1u);
+        NVRHI_CHECK_EQUAL(pipelines[2]->version, 0u);
+        NVRHI_CHECK(getBytecode(pipelines[1]->pipeline->getDesc().CS) == "blur 1 v2");
+    }
+
+    void testUnchangedContentsAreSkipped()
+    {
+        TempDirectory directory;
+        const auto file = directory.write("blur_cs.bin", "compute shader");
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        ShaderReloader reloader(device);
+        reloader.getFileWatcher().setPollingInterval(std::chrono::milliseconds(0));
+        reloader.watchDirectory(directory.path());
+
+        ComputePipelineDesc pipelineDesc;
+        pipelineDesc.CS = reloader.loadShader(file, computeShaderDesc());
+        ReloadableComputePipelineHandle pipeline = reloader.createComputePipeline(pipelineDesc);
+
+        // Build systems touch outputs without changing them
+        directory.write("blur_cs.bin", "compute shader");
+        NVRHI_CHECK_EQUAL(updateForAWhile(reloader), 0u);
+
+        NVRHI_CHECK_EQUAL(pipeline->version, 0u);
+        NVRHI_CHECK_EQUAL(device->shadersCreated.load(), 1u);
+        NVRHI_CHECK_EQUAL(device->computePipelinesCreated.load(), 1u);
+    }
+
+    void testFailedShaderKeepsPreviousVersion()
+    {
+        TempDirectory directory;
+        const auto file = directory.write("blur_cs.bin", "compute shader v1");
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        ShaderReloader reloader(device);
+        reloader.getFileWatcher().setPollingInterval(std::chrono::milliseconds(0));
+        reloader.watchDirectory(directory.path());
+
+        ComputePipelineDesc pipelineDesc;
+        pipelineDesc.CS = reloader.loadShader(file, computeShaderDesc());
+        ReloadableComputePipelineHandle pipeline = reloader.createComputePipeline(pipelineDesc);
+        IComputePipeline* originalPipeline = pipeline->pipeline;
+
+        directory.write("blur_cs.bin", "fail: syntax error");
+        NVRHI_CHECK_EQUAL(updateForAWhile(reloader), 0u);
+
+        NVRHI_CHECK_EQUAL(pipeline->version, 0u);
+        NVRHI_CHECK(pipeline->pipeline == originalPipeline);
+        NVRHI_CHECK(device->messageCallback.warnings.load() > 0u);
+
+        // Fixing the shader picks the pipeline up again
+        directory.write("blur_cs.bin", "compute shader v2");
+        NVRHI_CHECK_EQUAL(updateUntilReplaced(reloader, 1), 1u);
+        NVRHI_CHECK(getBytecode(pipeline->pipeline->getDesc().CS) == "compute shader v2");
+    }
+
+    void testPipelineWithSeveralChangedShadersIsRebuiltOnce()
+    {
+        TempDirectory directory;
+        const auto vsFile = directory.write("mesh_vs.bin", "vertex shader v1");
+        const auto psFile = directory.write("mesh_ps.bin", "pixel shader v1");
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        ShaderReloader reloader(device);
+        reloader.getFileWatcher().setPollingInterval(std::chrono::milliseconds(0));
+        reloader.watchDirectory(directory.path());
+
+        ShaderDesc vsDesc;
+        vsDesc.shaderType = ShaderType::Vertex;
+        ShaderDesc psDesc;
+        psDesc.shaderType = ShaderType::Pixel;
+
+        GraphicsPipelineDesc pipelineDesc;
+        pipelineDesc.VS = reloader.loadShader(vsFile, vsDesc);
+        pipelineDesc.PS = reloader.loadShader(psFile, psDesc);
+        ReloadableGraphicsPipelineHandle pipeline = reloader.createGraphicsPipeline(pipelineDesc, nullptr);
+        NVRHI_CHECK(pipeline != nullptr);
+
+        directory.write("mesh_vs.bin", "vertex shader v2");
+        directory.write("mesh_ps.bin", "pixel shader v2");
+        NVRHI_CHECK_EQUAL(updateUntilReplaced(reloader, 1), 1u);
+
+        // Both files are normally reported by the same update; if not, the second one causes another rebuild
+        updateForAWhile(reloader);
+        NVRHI_CHECK(getBytecode(pipeline->pipeline->getDesc().VS) == "vertex shader v2");
+        NVRHI_CHECK(getBytecode(pipeline->pipeline->getDesc().PS) == "pixel shader v2");
+        NVRHI_CHECK(device->graphicsPipelinesCreated.load() <= 3u);
+    }
+
+    void testReleasedPipelinesArePruned()
+    {
+        TempDirectory directory;
+        const auto file = directory.write("blur_cs.bin", "compute shader v1");
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        ShaderReloader reloader(device);
+        reloader.getFileWatcher().setPollingInterval(std::chrono::milliseconds(0));
+        reloader.watchDirectory(directory.path());
+
+        ComputePipelineDesc pipelineDesc;
+        pipelineDesc.CS = reloader.loadShader(file, computeShaderDesc());
+
+        std::vector<ReloadableComputePipelineHandle> pipelines;
+        for (int index = 0; index < 10; index++)
+            pipelines.push_back(reloader.createComputePipeline(pipelineDesc));
+        NVRHI_CHECK_EQUAL(reloader.getNumDependencies(), 10u);
+
+        // Released pipelines are dropped by the next update
+        pipelines.resize(4);
+        reloader.update();
+        NVRHI_CHECK_EQUAL(reloader.getNumDependencies(), 4u);
+
+        // Pipelines that are created and released between updates don't accumulate either
+        for (int index = 0; index < 1000; index++)
+        {
+            ReloadableComputePipelineHandle temporary = reloader.createComputePipeline(pipelineDesc);
+            NVRHI_CHECK(temporary != nullptr);
+        }
+        NVRHI_CHECK(reloader.getNumDependencies() < 20u);
+        reloader.update();
+        NVRHI_CHECK_EQUAL(reloader.getNumDependencies(), 4u);
+
+        // The remaining pipelines are still rebuilt
+        directory.write("blur_cs.bin", "compute shader v2");
+        NVRHI_CHECK_EQUAL(updateUntilReplaced(reloader, 4), 4u);
+        for (const auto& pipeline : pipelines)
+            NVRHI_CHECK_EQUAL(pipeline->version, 1u);
+        NVRHI_CHECK_EQUAL(reloader.getNumDependencies(), 4u);
+    }
+
+    void testReleasedShadersArePruned()
+    {
+        TempDirectory directory;
+        const auto file = directory.write("blur_cs.bin", "compute shader v1");
+
+        RefCountPtr<FakeDevice> device = RefCountPtr<FakeDevice>::Create(new FakeDevice());
+        ShaderReloader reloader(device);
+        reloader.getFileWatcher().setPollingInterval(std::chrono::milliseconds(0));
+        reloader.watchDirectory(directory.path());
+
+        ComputePipelineDesc pipelineDesc;
+        pipelineDesc.CS = reloader.loadShader(file, computeShaderDesc());
+        ReloadableComputePipelineHandle pipeline = reloader.createComputePipeline(pipelineDesc);
+
+        // Shaders loaded for a moment and dropped again
+        for (int index = 0; index < 100; index++)
+            NVRHI_CHECK(reloader.loadShader(file, computeShaderDesc()) != nullptr);
+        NVRHI_CHECK_EQUAL(reloader.getNumShaders(), 101u);
+        reloader.update();
+        NVRHI_CHECK_EQUAL(reloader.getNumShaders(), 1u);
+
+        // A shader that is still used by a pipeline is kept even if the application dropped its handle
+        pipelineDesc.CS = nullptr;
+        reloader.update();
+        NVRHI_CHECK_EQUAL(reloader.getNumShaders(), 1u);
+
+        directory.write("blur_cs.bin", "compute shader v2");
+        NVRHI_CHECK_EQUAL(updateUntilReplaced(reloader, 1), 1u);
+        NVRHI_CHECK_EQUAL(device->shadersCreated.load(), 102u);
+
+        // Once the pipeline is gone, so is the shader
+        pipeline = nullptr;
+        reloader.update();
+        NVRHI_CHECK_EQUAL(reloader.getNumShaders(), 0u);
+        NVRHI_CHECK_EQUAL(reloader.getNumDependencies(), 0u);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testRebuildOnCallingThread);
+    NVRHI_RUN_TEST(testRebuildOnDeviceTaskScheduler);
+    NVRHI_RUN_TEST(testOnlyChangedPermutationsAreRebuilt);
+    NVRHI_RUN_TEST(testUnchangedContentsAreSkipped);
+    NVRHI_RUN_TEST(testFailedShaderKeepsPreviousVersion);
+    NVRHI_RUN_TEST(testPipelineWithSeveralChangedShadersIsRebuiltOnce);
+    NVRHI_RUN_TEST(testReleasedPipelinesArePruned);
+    NVRHI_RUN_TEST(testReleasedShadersArePruned);
+
+    return NVRHI_TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/common/submission-future.h>
+#include "test-utils.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace nvrhi;
+
+namespace
+{
+    void testCompletion()
+    {
+        SubmissionFuture future(CommandQueue::Graphics, 1);
+        NVRHI_CHECK(!future.isReady());
+
+        future.getCompletionCallback()(true);
+
+        NVRHI_CHECK(future.isReady());
+        NVRHI_CHECK(!future.hasFailed());
+        NVRHI_CHECK(future.wait());
+    }
+
+    void testFailure()
+    {
+        SubmissionFuture future(CommandQueue::Compute, 2);
+        future.getCompletionCallback()(false);
+
+        NVRHI_CHECK(future.isReady());
+        NVRHI_CHECK(future.hasFailed());
+        NVRHI_CHECK(!future.wait());
+    }
+
+    void testEmptyFutureIsReady()
+    {
+        SubmissionFuture future;
+        NVRHI_CHECK(future.isReady());
+        NVRHI_CHECK(!future.hasFailed());
+        NVRHI_CHECK(future.wait());
+    }
+
+    void testContinuations()
+    {
+        SubmissionFuture future(CommandQueue::Graphics, 3);
+
+        int calls = 0;
+        bool failedInContinuation = false;
+        future.then([&]() { ++calls; failedInContinuation = future.hasFailed(); });
+        NVRHI_CHECK_EQUAL(calls, 0);
+
+        future.getCompletionCallback()(false);
+        NVRHI_CHECK_EQUAL(calls, 1);
+        NVRHI_CHECK(failedInContinuation);
+
+        // Runs immediately once the future is ready
+        future.then([&]() { ++calls; });
+        NVRHI_CHECK_EQUAL(calls, 2);
+    }
+
+    void testFailureWakesWaiters()
+    {
+        SubmissionFuture future(CommandQueue::Graphics, 4);
+
+        std::atomic<int> results = 0;
+        std::thread waiter([future, &results]() { results += future.wait() ? 1 : 2; });
+
+        future.getCompletionCallback()(false);
+        waiter.join();
+
+        NVRHI_CHECK_EQUAL(results.load(), 2);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testCompletion);
+    NVRHI_RUN_TEST(testFailure);
+    NVRHI_RUN_TEST(testEmptyFutureIsReady);
+    NVRHI_RUN_TEST(testContinuations);
+    NVRHI_RUN_TEST(testFailureWakesWaiters);
+
+    return NVRHI_TEST_RESULT();
+}
@@ -0,0 +1,145 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "src/common/task-scheduler.h"
+#include "test-utils.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace nvrhi;
+
+namespace
+{
+    // Occupies the only worker of a single-thread pool until released
+    class WorkerBlocker
+    {
+    public:
+        explicit WorkerBlocker(WorkerPoolTaskScheduler& scheduler)
+            : m_Scheduler(scheduler)
+        {
+            m_Task = scheduler.runAsync([this]()
+            {
+                m_Started = true;
+                while (!m_Released)
+                    std::this_thread::yield();
+            });
+
+            while (!m_Started)
+                std::this_thread::yield();
+        }
+
+        void release()
+        {
+            m_Released = true;
+            m_Scheduler.wait(m_Task);
+        }
+
+    private:
+        WorkerPoolTaskScheduler& m_Scheduler;
+        ITaskScheduler::TaskID m_Task = 0;
+        std::atomic<bool> m_Started = false;
+        std::atomic<bool> m_Released = false;
+    };
+
+    void testParallelForCoversAllRanges()
+    {
+        WorkerPoolTaskScheduler scheduler(3);
+
+        std::vector<std::atomic<int>> hits(1000);
+        scheduler.parallelFor(hits.size(), 7, [&hits](size_t begin, size_t end)
+        {
+            for (size_t index = begin; index < end; ++index)
+                ++hits[index];
+        });
+
+        int wrongCounts = 0;
+        for (const std::atomic<int>& hit : hits)
+            wrongCounts += hit.load() != 1;
+        NVRHI_CHECK_EQUAL(wrongCounts, 0);
+    }
+
+    void testParallelForDoesNotRunUnrelatedTasks()
+    {
+        WorkerPoolTaskScheduler scheduler(1);
+        WorkerBlocker blocker(scheduler);
+
+        std::atomic<bool> unrelatedRan = false;
+        const ITaskScheduler::TaskID unrelated = scheduler.runAsync([&unrelatedRan]() { unrelatedRan = true; });
+
+        // The worker is busy, so the calling thread executes all ranges and must not pick up the queued task
+        std::atomic<size_t> processed = 0;
+        scheduler.parallelFor(64, 1, [&processed](size_t begin, size_t end) { processed += end - begin; });
+
+        NVRHI_CHECK_EQUAL(processed.load(), 64);
+        NVRHI_CHECK(!unrelatedRan);
+
+        blocker.release();
+        scheduler.wait(unrelated);
+        NVRHI_CHECK(unrelatedRan);
+    }
+
+    void testWaitRunsOnlyTheAwaitedTask()
+    {
+        WorkerPoolTaskScheduler scheduler(1);
+        WorkerBlocker blocker(scheduler);
+
+        std::atomic<bool> firstRan = false;
+        std::atomic<bool> secondRan = false;
+        const ITaskScheduler::TaskID first = scheduler.runAsync([&firstRan]() { firstRan = true; });
+        const ITaskScheduler::TaskID second = scheduler.runAsync([&secondRan]() { secondRan = true; });
+
+        // Completes on this thread although the worker is busy, and leaves the task queued before it alone
+        scheduler.wait(second);
+        NVRHI_CHECK(secondRan);
+        NVRHI_CHECK(!firstRan);
+
+        blocker.release();
+        scheduler.wait(first);
+        NVRHI_CHECK(firstRan);
+    }
+
+    void testNestedParallelFor()
+    {
+        WorkerPoolTaskScheduler scheduler(2);
+
+        std::atomic<size_t> processed = 0;
+        scheduler.parallelFor(8, 1, [&](size_t, size_t)
+        {
+            scheduler.parallelFor(100, 10, [&processed](size_t begin, size_t end) { processed += end - begin; });
+        });
+
+        NVRHI_CHECK_EQUAL(processed.load(), 800);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testParallelForCoversAllRanges);
+    NVRHI_RUN_TEST(testParallelForDoesNotRunUnrelatedTasks);
+    NVRHI_RUN_TEST(testWaitRunsOnlyTheAwaitedTask);
+    NVRHI_RUN_TEST(testNestedParallelFor);
+
+    return NVRHI_TEST_RESULT();
+}
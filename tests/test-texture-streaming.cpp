@@ -0,0 +1,270 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/common/texture-streaming.h>
+#include "test-utils.h"
+
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    constexpr uint64_t c_Unlimited = ~0ull;
+
+    StreamingTextureState makeState(std::vector<uint64_t> mipSizes, MipLevel residentMip, MipLevel requestedMip,
+        MipLevel lockedMip, float priority)
+    {
+        StreamingTextureState state;
+        state.mipSizes = std::move(mipSizes);
+        state.residentMip = residentMip;
+        state.pendingMip = residentMip;
+        state.requestedMip = requestedMip;
+        state.lockedMip = lockedMip;
+        state.priority = priority;
+        state.active = true;
+        return state;
+    }
+
+    uint64_t getResidentBytes(const std::vector<StreamingTextureState>& textures)
+    {
+        uint64_t bytes = 0;
+        for (const StreamingTextureState& state : textures)
+        {
+            for (MipLevel mipLevel = state.pendingMip; mipLevel < MipLevel(state.mipSizes.size()); ++mipLevel)
+                bytes += state.mipSizes[mipLevel];
+        }
+        return bytes;
+    }
+
+    // Runs the planner and executes its actions on the states as if every upload completed immediately,
+    // checking that each action is valid for the residency at that point
+    std::vector<StreamingAction> planAndExecute(std::vector<StreamingTextureState>& textures,
+        uint64_t memoryBudget, uint64_t uploadBudget)
+    {
+        std::vector<StreamingAction> actions;
+        planTextureStreaming(textures, memoryBudget, uploadBudget, actions);
+
+        for (const StreamingAction& action : actions)
+        {
+            StreamingTextureState& state = textures[action.texture];
+            NVRHI_CHECK(state.pendingMip == state.residentMip);
+
+            if (action.type == StreamingAction::Type::Upload)
+            {
+                NVRHI_CHECK_EQUAL(action.mipLevel + 1, state.pendingMip);
+                state.residentMip = state.pendingMip = action.mipLevel;
+            }
+            else
+            {
+                NVRHI_CHECK_EQUAL(action.mipLevel, state.residentMip);
+                NVRHI_CHECK(action.mipLevel < state.lockedMip);
+                state.residentMip = state.pendingMip = action.mipLevel + 1;
+            }
+        }
+
+        return actions;
+    }
+
+    bool isUpload(const StreamingAction& action, uint32_t texture, MipLevel mipLevel)
+    {
+        return action.type == StreamingAction::Type::Upload && action.texture == texture && action.mipLevel == mipLevel;
+    }
+
+    bool isEviction(const StreamingAction& action, uint32_t texture, MipLevel mipLevel)
+    {
+        return action.type == StreamingAction::Type::Evict && action.texture == texture && action.mipLevel == mipLevel;
+    }
+
+    void testLockedMipsIgnoreBudgets()
+    {
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 64, 32, 16, 8 }, 4, 4, 2, 0.f)
+        };
+
+        const std::vector<StreamingAction> actions = planAndExecute(textures, 0, 0);
+
+        NVRHI_CHECK_EQUAL(actions.size(), 2);
+        NVRHI_CHECK(isUpload(actions[0], 0, 3));
+        NVRHI_CHECK(isUpload(actions[1], 0, 2));
+    }
+
+    void testHigherPriorityUploadsFirst()
+    {
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 64, 32, 16 }, 2, 0, 2, 1.f),
+            makeState({ 64, 32, 16 }, 2, 0, 2, 2.f)
+        };
+
+        const std::vector<StreamingAction> actions = planAndExecute(textures, c_Unlimited, c_Unlimited);
+
+        NVRHI_CHECK_EQUAL(actions.size(), 4);
+        NVRHI_CHECK(isUpload(actions[0], 1, 1));
+        NVRHI_CHECK(isUpload(actions[1], 1, 0));
+        NVRHI_CHECK(isUpload(actions[2], 0, 1));
+        NVRHI_CHECK(isUpload(actions[3], 0, 0));
+        NVRHI_CHECK_EQUAL(textures[0].residentMip, 0);
+        NVRHI_CHECK_EQUAL(textures[1].residentMip, 0);
+    }
+
+    void testUploadBudgetOverflow()
+    {
+        // The first mip is larger than the upload budget and goes through on its own
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 400, 300, 16 }, 2, 0, 2, 1.f)
+        };
+
+        std::vector<StreamingAction> actions = planAndExecute(textures, c_Unlimited, 200);
+        NVRHI_CHECK_EQUAL(actions.size(), 1);
+        NVRHI_CHECK(isUpload(actions[0], 0, 1));
+
+        // The rest waits for the next update
+        actions = planAndExecute(textures, c_Unlimited, 200);
+        NVRHI_CHECK_EQUAL(actions.size(), 1);
+        NVRHI_CHECK(isUpload(actions[0], 0, 0));
+
+        // Uploads that would exceed the budget together are spread over updates
+        textures = {
+            makeState({ 150, 16 }, 1, 0, 1, 2.f),
+            makeState({ 100, 16 }, 1, 0, 1, 1.f)
+        };
+
+        actions = planAndExecute(textures, c_Unlimited, 200);
+        NVRHI_CHECK_EQUAL(actions.size(), 1);
+        NVRHI_CHECK(isUpload(actions[0], 0, 0));
+
+        actions = planAndExecute(textures, c_Unlimited, 200);
+        NVRHI_CHECK_EQUAL(actions.size(), 1);
+        NVRHI_CHECK(isUpload(actions[0], 1, 0));
+    }
+
+    void testMemoryBudgetEvictsLowerPriority()
+    {
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 200, 100, 50 }, 1, 0, 2, 2.f),
+            makeState({ 200, 100, 50 }, 1, 1, 2, 1.f)
+        };
+
+        const uint64_t budget = getResidentBytes(textures) + 100;
+        const std::vector<StreamingAction> actions = planAndExecute(textures, budget, c_Unlimited);
+
+        NVRHI_CHECK_EQUAL(actions.size(), 2);
+        NVRHI_CHECK(isEviction(actions[0], 1, 1));
+        NVRHI_CHECK(isUpload(actions[1], 0, 0));
+        NVRHI_CHECK(getResidentBytes(textures) <= budget);
+    }
+
+    void testHigherPriorityIsNotEvicted()
+    {
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 200, 100, 50 }, 1, 0, 2, 1.f),
+            makeState({ 200, 100, 50 }, 1, 1, 2, 2.f)
+        };
+
+        const std::vector<StreamingAction> actions = planAndExecute(textures, getResidentBytes(textures) + 100, c_Unlimited);
+
+        NVRHI_CHECK(actions.empty());
+    }
+
+    void testUnneededMipsAreEvictedFirst()
+    {
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 200, 100, 50 }, 1, 0, 2, 10.f),
+            makeState({ 200, 100, 50 }, 1, 1, 2, 1.f),
+            makeState({ 200, 100, 50 }, 1, 2, 2, 5.f) // mip 1 is more detailed than requested
+        };
+
+        const uint64_t budget = getResidentBytes(textures) + 100;
+        const std::vector<StreamingAction> actions = planAndExecute(textures, budget, c_Unlimited);
+
+        NVRHI_CHECK_EQUAL(actions.size(), 2);
+        NVRHI_CHECK(isEviction(actions[0], 2, 1));
+        NVRHI_CHECK(isUpload(actions[1], 0, 0));
+    }
+
+    void testNothingIsEvictedWithoutMakingRoom()
+    {
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 400, 200, 100, 50 }, 1, 0, 3, 10.f),
+            makeState({ 400, 200, 100, 50 }, 2, 2, 3, 1.f)
+        };
+
+        // Evicting mip 2 of the second texture frees 100 bytes, the upload needs 300 more
+        const std::vector<StreamingAction> actions = planAndExecute(textures, getResidentBytes(textures) + 100, c_Unlimited);
+
+        NVRHI_CHECK(actions.empty());
+        NVRHI_CHECK_EQUAL(textures[1].residentMip, 2);
+    }
+
+    void testEvictionDropsQueuedUploads()
+    {
+        // Texture 2 has an upload queued when it is evicted from to make room for texture 0,
+        // and the queued mip would fit afterwards. Uploading it would leave mip 2 missing.
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 380, 200, 100, 50 }, 2, 0, 3, 10.f),
+            makeState({ 400, 200, 100, 50 }, 2, 2, 3, 3.f),
+            makeState({ 400, 20, 300, 50 }, 2, 1, 3, 5.f)
+        };
+
+        const uint64_t budget = getResidentBytes(textures) + 200;
+        const std::vector<StreamingAction> actions = planAndExecute(textures, budget, c_Unlimited);
+
+        NVRHI_CHECK_EQUAL(actions.size(), 4);
+        NVRHI_CHECK(isUpload(actions[0], 0, 1));
+        NVRHI_CHECK(isEviction(actions[1], 1, 2));
+        NVRHI_CHECK(isEviction(actions[2], 2, 2));
+        NVRHI_CHECK(isUpload(actions[3], 0, 0));
+        NVRHI_CHECK_EQUAL(textures[2].residentMip, 3);
+        NVRHI_CHECK(getResidentBytes(textures) <= budget);
+    }
+
+    void testInFlightUploadsAreNotEvicted()
+    {
+        std::vector<StreamingTextureState> textures = {
+            makeState({ 200, 100, 50 }, 1, 0, 2, 2.f),
+            makeState({ 200, 100, 50 }, 2, 1, 2, 1.f)
+        };
+        textures[1].pendingMip = 1; // mip 1 is being uploaded
+
+        std::vector<StreamingAction> actions;
+        planTextureStreaming(textures, getResidentBytes(textures) + 100, c_Unlimited, actions);
+
+        NVRHI_CHECK(actions.empty());
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testLockedMipsIgnoreBudgets);
+    NVRHI_RUN_TEST(testHigherPriorityUploadsFirst);
+    NVRHI_RUN_TEST(testUploadBudgetOverflow);
+    NVRHI_RUN_TEST(testMemoryBudgetEvictsLowerPriority);
+    NVRHI_RUN_TEST(testHigherPriorityIsNotEvicted);
+    NVRHI_RUN_TEST(testUnneededMipsAreEvictedFirst);
+    NVRHI_RUN_TEST(testNothingIsEvictedWithoutMakingRoom);
+    NVRHI_RUN_TEST(testEvictionDropsQueuedUploads);
+    NVRHI_RUN_TEST(testInFlightUploadsAreNotEvicted);
+
+    return NVRHI_TEST_RESULT();
+}
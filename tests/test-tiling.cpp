@@ -0,0 +1,283 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include <nvrhi/common/tiling.h>
+#include "src/common/tile-heap-references.h"
+#include "test-utils.h"
+
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    class TestHeap : public RefCounter<IHeap>
+    {
+    public:
+        const HeapDesc& getDesc() override { return m_Desc; }
+
+    private:
+        HeapDesc m_Desc;
+    };
+
+    TextureDesc makeTexture2D(uint32_t width, uint32_t height, uint32_t mipLevels)
+    {
+        return TextureDesc()
+            .setWidth(width)
+            .setHeight(height)
+            .setMipLevels(mipLevels)
+            .setFormat(Format::RGBA8_UNORM)
+            .setIsTiled(true);
+    }
+
+    TileShape makeTileShape(uint32_t width, uint32_t height, uint32_t depth = 1)
+    {
+        TileShape shape;
+        shape.widthInTexels = width;
+        shape.heightInTexels = height;
+        shape.depthInTexels = depth;
+        return shape;
+    }
+
+    void testNumStandardMips()
+    {
+        const TileShape shape = makeTileShape(128, 128);
+
+        // 512, 256, 128 have full tiles; 64 and below go into the mip tail
+        NVRHI_CHECK_EQUAL(computeNumStandardMips(makeTexture2D(512, 512, 10), shape), 3);
+        NVRHI_CHECK_EQUAL(computeNumStandardMips(makeTexture2D(512, 512, 2), shape), 2);
+        NVRHI_CHECK_EQUAL(computeNumStandardMips(makeTexture2D(512, 64, 4), shape), 0);
+        NVRHI_CHECK_EQUAL(computeNumStandardMips(makeTexture2D(512, 512, 10), makeTileShape(0, 0)), 0);
+
+        TextureDesc volume = makeTexture2D(256, 256, 4).setDimension(TextureDimension::Texture3D).setDepth(64);
+        NVRHI_CHECK_EQUAL(computeNumStandardMips(volume, makeTileShape(32, 32, 32)), 2);
+    }
+
+    void testSubresourceTilings()
+    {
+        const TextureDesc desc = makeTexture2D(300, 200, 3);
+        const TileShape shape = makeTileShape(128, 128);
+
+        SubresourceTiling tilings[2];
+        const uint32_t numTiles = computeSubresourceTilings(desc, shape, 2, tilings, 10);
+
+        // Mip 0 is 300x200: 3x2 tiles, mip 1 is 150x100: 2x1 tiles
+        NVRHI_CHECK_EQUAL(tilings[0].widthInTiles, 3);
+        NVRHI_CHECK_EQUAL(tilings[0].heightInTiles, 2);
+        NVRHI_CHECK_EQUAL(tilings[0].depthInTiles, 1);
+        NVRHI_CHECK_EQUAL(tilings[0].startTileIndexInOverallResource, 10);
+        NVRHI_CHECK_EQUAL(tilings[1].widthInTiles, 2);
+        NVRHI_CHECK_EQUAL(tilings[1].heightInTiles, 1);
+        NVRHI_CHECK_EQUAL(tilings[1].startTileIndexInOverallResource, 16);
+        NVRHI_CHECK_EQUAL(numTiles, 8);
+
+        NVRHI_CHECK_EQUAL(getTileIndex(tilings[0], 2, 1, 0), 15);
+        NVRHI_CHECK_EQUAL(getTileIndex(tilings[1], 1, 0, 0), 17);
+    }
+
+    void testTilesForTexels()
+    {
+        const TextureDesc desc = makeTexture2D(512, 512, 2);
+        const TileShape shape = makeTileShape(128, 64);
+
+        TiledTextureCoordinate coordinate;
+        TiledTextureRegion region;
+        getTilesForTexels(desc, shape, TextureSlice().setOrigin(100, 60).setSize(200, 10), coordinate, region);
+
+        // Texels 100..299 touch tile columns 0..2, rows 60..69 touch tile rows 0..1
+        NVRHI_CHECK_EQUAL(coordinate.x, 0);
+        NVRHI_CHECK_EQUAL(coordinate.y, 0);
+        NVRHI_CHECK_EQUAL(region.width, 3);
+        NVRHI_CHECK_EQUAL(region.height, 2);
+        NVRHI_CHECK_EQUAL(region.depth, 1);
+        NVRHI_CHECK_EQUAL(region.tilesNum, 6);
+
+        // The whole slice of mip 1
+        getTilesForTexels(desc, shape, TextureSlice().setMipLevel(1), coordinate, region);
+        NVRHI_CHECK_EQUAL(coordinate.mipLevel, 1);
+        NVRHI_CHECK_EQUAL(region.width, 2);
+        NVRHI_CHECK_EQUAL(region.height, 4);
+    }
+
+    void testTilesForTexelsWithoutTileShape()
+    {
+        const TextureDesc desc = makeTexture2D(512, 512, 1);
+
+        TiledTextureCoordinate coordinate;
+        TiledTextureRegion region;
+        region.tilesNum = 123;
+        getTilesForTexels(desc, TileShape(), TextureSlice(), coordinate, region);
+
+        NVRHI_CHECK_EQUAL(coordinate.x, 0);
+        NVRHI_CHECK_EQUAL(region.tilesNum, 0);
+        NVRHI_CHECK_EQUAL(region.width, 0);
+    }
+
+    void testTexelsForTilesClampsToMip()
+    {
+        const TextureDesc desc = makeTexture2D(300, 200, 2);
+        const TileShape shape = makeTileShape(128, 128);
+
+        TiledTextureCoordinate coordinate;
+        coordinate.x = 2;
+        coordinate.y = 1;
+        TiledTextureRegion region;
+        region.width = 1;
+        region.height = 1;
+        region.depth = 1;
+
+        const TextureSlice slice = getTexelsForTiles(desc, shape, coordinate, region);
+        NVRHI_CHECK_EQUAL(slice.x, 256);
+        NVRHI_CHECK_EQUAL(slice.y, 128);
+        NVRHI_CHECK_EQUAL(slice.width, 44);
+        NVRHI_CHECK_EQUAL(slice.height, 72);
+        NVRHI_CHECK_EQUAL(slice.depth, 1);
+    }
+
+    void testTilesAndTexelsRoundTrip()
+    {
+        const TextureDesc desc = makeTexture2D(1000, 700, 3);
+        const TileShape shape = makeTileShape(64, 32);
+
+        for (MipLevel mipLevel = 0; mipLevel < 3; ++mipLevel)
+        {
+            TiledTextureCoordinate coordinate;
+            TiledTextureRegion region;
+            getTilesForTexels(desc, shape, TextureSlice().setMipLevel(mipLevel), coordinate, region);
+
+            const TextureSlice slice = getTexelsForTiles(desc, shape, coordinate, region);
+            const TextureSlice expected = TextureSlice().setMipLevel(mipLevel).resolve(desc);
+
+            NVRHI_CHECK_EQUAL(slice.x, 0);
+            NVRHI_CHECK_EQUAL(slice.y, 0);
+            NVRHI_CHECK_EQUAL(slice.width, expected.width);
+            NVRHI_CHECK_EQUAL(slice.height, expected.height);
+        }
+    }
+
+    void testPackedMips()
+    {
+        PackedMipDesc packedMips;
+        packedMips.numStandardMips = 3;
+        packedMips.numPackedMips = 2;
+
+        NVRHI_CHECK(!isPackedMip(packedMips, 2));
+        NVRHI_CHECK(isPackedMip(packedMips, 3));
+    }
+
+    void testTileHeapReferences()
+    {
+        RefCountPtr<TestHeap> heapA = RefCountPtr<TestHeap>::Create(new TestHeap());
+        RefCountPtr<TestHeap> heapB = RefCountPtr<TestHeap>::Create(new TestHeap());
+
+        TileHeapReferences references;
+
+        TiledTextureCoordinate coordinate;
+        coordinate.x = 1;
+        TiledTextureRegion region;
+        region.width = 2;
+        region.height = 3;
+        region.depth = 1;
+
+        references.map(coordinate, region, false, heapA);
+        NVRHI_CHECK_EQUAL(references.getMappedTileCount(), 6);
+
+        // Remapping two of the tiles moves their references to the other heap
+        TiledTextureRegion column;
+        column.width = 1;
+        column.height = 2;
+        column.depth = 1;
+        references.map(coordinate, column, false, heapB);
+        NVRHI_CHECK_EQUAL(references.getMappedTileCount(), 6);
+
+        // The packed mips are one entry per array slice
+        coordinate.mipLevel = 5;
+        references.map(coordinate, TiledTextureRegion(), true, heapB);
+        NVRHI_CHECK_EQUAL(references.getMappedTileCount(), 7);
+
+        // The application's reference plus the tiles
+        NVRHI_CHECK_EQUAL(heapA->AddRef(), 6);
+        heapA->Release();
+        NVRHI_CHECK_EQUAL(heapB->AddRef(), 5);
+        heapB->Release();
+
+        coordinate.mipLevel = 0;
+        references.map(coordinate, region, false, nullptr);
+        NVRHI_CHECK_EQUAL(references.getMappedTileCount(), 1);
+        NVRHI_CHECK_EQUAL(heapA->AddRef(), 2);
+        heapA->Release();
+    }
+
+    void testReplacedTileHeapsAreReported()
+    {
+        RefCountPtr<TestHeap> heapA = RefCountPtr<TestHeap>::Create(new TestHeap());
+        RefCountPtr<TestHeap> heapB = RefCountPtr<TestHeap>::Create(new TestHeap());
+
+        TileHeapReferences references;
+        std::vector<HeapHandle> replaced;
+
+        TiledTextureCoordinate coordinate;
+        TiledTextureRegion region;
+        region.width = 4;
+        region.height = 1;
+        region.depth = 1;
+
+        // Mapping unmapped tiles replaces nothing
+        references.map(coordinate, region, false, heapA, &replaced);
+        NVRHI_CHECK(replaced.empty());
+
+        // Mapping the same heap again replaces nothing either
+        references.map(coordinate, region, false, heapA, &replaced);
+        NVRHI_CHECK(replaced.empty());
+
+        // Remapping to another heap reports the old one once, and keeps it alive after the tiles drop it
+        references.map(coordinate, region, false, heapB, &replaced);
+        NVRHI_CHECK_EQUAL(replaced.size(), 1);
+        NVRHI_CHECK(replaced[0] == heapA);
+        NVRHI_CHECK_EQUAL(heapA->AddRef(), 3);
+        heapA->Release();
+
+        // Unmapping reports the heap too
+        replaced.clear();
+        references.map(coordinate, region, false, nullptr, &replaced);
+        NVRHI_CHECK_EQUAL(replaced.size(), 1);
+        NVRHI_CHECK(replaced[0] == heapB);
+        NVRHI_CHECK_EQUAL(references.getMappedTileCount(), 0);
+    }
+}
+
+int main()
+{
+    NVRHI_RUN_TEST(testNumStandardMips);
+    NVRHI_RUN_TEST(testSubresourceTilings);
+    NVRHI_RUN_TEST(testTilesForTexels);
+    NVRHI_RUN_TEST(testTilesForTexelsWithoutTileShape);
+    NVRHI_RUN_TEST(testTexelsForTilesClampsToMip);
+    NVRHI_RUN_TEST(testTilesAndTexelsRoundTrip);
+    NVRHI_RUN_TEST(testPackedMips);
+    NVRHI_RUN_TEST(testTileHeapReferences);
+    NVRHI_RUN_TEST(testReplacedTileHeapsAreReported);
+
+    return NVRHI_TEST_RESULT();
+}
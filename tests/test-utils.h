@@ -0,0 +1,63 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdio>
+
+// Minimal checking helpers for the unit tests: failed checks are reported and counted,
+// NVRHI_CHECK_EQUAL is meant for integer values,
+// and the test executable returns the failure count from main through NVRHI_TEST_RESULT.
+
+namespace nvrhi::tests
+{
+    inline int g_Failures = 0;
+}
+
+#define NVRHI_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++nvrhi::tests::g_Failures; \
+        } \
+    } while (0)
+
+#define NVRHI_CHECK_EQUAL(actual, expected) \
+    do { \
+        const auto actualValue_ = (actual); \
+        const auto expectedValue_ = (expected); \
+        if (!(actualValue_ == expectedValue_)) { \
+            std::fprintf(stderr, "%s(%d): check failed: %s == %s (%lld vs %lld)\n", __FILE__, __LINE__, #actual, #expected, \
+                (long long)actualValue_, (long long)expectedValue_); \
+            ++nvrhi::tests::g_Failures; \
+        } \
+    } while (0)
+
+#define NVRHI_RUN_TEST(function) \
+    do { \
+        const int failuresBefore_ = nvrhi::tests::g_Failures; \
+        function(); \
+        std::printf("%s: %s\n", #function, nvrhi::tests::g_Failures == failuresBefore_ ? "passed" : "FAILED"); \
+    } while (0)
+
+#define NVRHI_TEST_RESULT() (nvrhi::tests::g_Failures == 0 ? 0 : 1)